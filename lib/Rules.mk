@@ -1,15 +1,15 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
 SRCS += $(addprefix $(d), \
-	lookup3.cc message.cc memory.cc \
-	latency.cc configuration.cc transport.cc \
+	lookup3.cc xxhash.cc message.cc memory.cc \
+	latency.cc histogram.cc configuration.cc transport.cc \
 	udptransport.cc tcptransport.cc simtransport.cc repltransport.cc \
 	persistent_register.cc)
 
 PROTOS += $(addprefix $(d), \
           latency-format.proto)
 
-LIB-hash := $(o)lookup3.o
+LIB-hash := $(o)lookup3.o $(o)xxhash.o
 
 LIB-message := $(o)message.o $(LIB-hash)
 
@@ -19,6 +19,8 @@ LIB-memory := $(o)memory.o
 
 LIB-latency := $(o)latency.o $(o)latency-format.o $(LIB-message)
 
+LIB-histogram := $(o)histogram.o
+
 LIB-configuration := $(o)configuration.o $(LIB-message)
 
 LIB-transport := $(o)transport.o $(LIB-message) $(LIB-configuration)
@@ -71,6 +71,8 @@
 #endif
 
 uint32_t hash(const void *key, size_t length, uint32_t initval);
+// XXH64: 64 bits, several times faster than lookup3 on long keys.
+uint64_t hash64(const void *key, size_t length, uint64_t seed);
 
 #endif // _LIB_HASH_H_
  
@@ -0,0 +1,183 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * lib/histogram.cc:
+ *   High dynamic range histogram of latencies.
+ *
+ **********************************************************************/
+
+#include "lib/histogram.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+static const uint64_t SUB_BUCKETS = 1ULL << Histogram::SUB_BUCKET_BITS;
+static const uint64_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+static const std::size_t NUM_BUCKETS =
+    SUB_BUCKETS + (64 - Histogram::SUB_BUCKET_BITS) * HALF_SUB_BUCKETS;
+
+Histogram::Histogram()
+    : counts(NUM_BUCKETS, 0), count(0), min(UINT64_MAX), max(0), sum(0)
+{
+}
+
+std::size_t
+Histogram::Index(uint64_t value)
+{
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+
+    // Keep the top SUB_BUCKET_BITS - 1 bits below the leading one.
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - SUB_BUCKET_BITS + 1;
+    return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS
+        + ((value >> shift) - HALF_SUB_BUCKETS);
+}
+
+uint64_t
+Histogram::HighestEquivalentValue(std::size_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+
+    index -= SUB_BUCKETS;
+    int shift = index / HALF_SUB_BUCKETS + 1;
+    uint64_t mantissa = index % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void
+Histogram::Record(uint64_t value, uint64_t n)
+{
+    if (n == 0) {
+        return;
+    }
+    counts[Index(value)] += n;
+    count += n;
+    sum += (double)value * n;
+    if (value < min) {
+        min = value;
+    }
+    if (value > max) {
+        max = value;
+    }
+}
+
+void
+Histogram::RecordCorrected(uint64_t value, uint64_t expectedInterval)
+{
+    Record(value);
+    if (expectedInterval == 0 || value <= expectedInterval) {
+        return;
+    }
+    for (uint64_t missing = value - expectedInterval;
+         missing >= expectedInterval;
+         missing -= expectedInterval) {
+        Record(missing);
+    }
+}
+
+void
+Histogram::Add(const Histogram &other)
+{
+    if (other.count == 0) {
+        return;
+    }
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    if (other.min < min) {
+        min = other.min;
+    }
+    if (other.max > max) {
+        max = other.max;
+    }
+}
+
+void
+Histogram::Reset()
+{
+    counts.assign(NUM_BUCKETS, 0);
+    count = 0;
+    min = UINT64_MAX;
+    max = 0;
+    sum = 0;
+}
+
+double
+Histogram::Mean() const
+{
+    return count == 0 ? 0.0 : sum / count;
+}
+
+uint64_t
+Histogram::Percentile(double p) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    // Allow for rounding error, so that e.g. p99.9 of 10000 values is the
+    // 9990th and not the 9991st.
+    uint64_t target = std::ceil(p / 100.0 * count - 1e-9);
+    if (target == 0) {
+        return Min();
+    }
+
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            uint64_t value = HighestEquivalentValue(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+std::string
+Histogram::Serialize() const
+{
+    std::ostringstream out;
+    bool first = true;
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        if (!first) {
+            out << ',';
+        }
+        out << HighestEquivalentValue(i) << ':' << counts[i];
+        first = false;
+    }
+    return out.str();
+}
+
+bool
+Histogram::Parse(const std::string &s)
+{
+    std::istringstream in(s);
+    std::string pair;
+    while (std::getline(in, pair, ',')) {
+        std::size_t colon = pair.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        char *end;
+        uint64_t value = strtoull(pair.c_str(), &end, 10);
+        if (end != pair.c_str() + colon) {
+            return false;
+        }
+        uint64_t n = strtoull(pair.c_str() + colon + 1, &end, 10);
+        if (*end != '\0') {
+            return false;
+        }
+        Record(value, n);
+    }
+    return true;
+}
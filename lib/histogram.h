@@ -0,0 +1,64 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * lib/histogram.h:
+ *   High dynamic range histogram of latencies.
+ *
+ **********************************************************************/
+
+#ifndef _LIB_HISTOGRAM_H_
+#define _LIB_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Records values from 0 to 2^64 - 1 with a relative error below
+// 2^-(SUB_BUCKET_BITS - 1), in constant time and without allocating.
+// Values below 2^SUB_BUCKET_BITS are kept exactly; every larger power of
+// two range is split into 2^(SUB_BUCKET_BITS - 1) equal buckets.
+class Histogram
+{
+public:
+    static const int SUB_BUCKET_BITS = 7;
+
+    Histogram();
+
+    void Record(uint64_t value, uint64_t count = 1);
+
+    // Record a value measured by a closed-loop client that issues a
+    // request every expectedInterval, filling in the requests that the
+    // client would have issued, and had to delay, while it waited.
+    void RecordCorrected(uint64_t value, uint64_t expectedInterval);
+
+    void Add(const Histogram &other);
+    void Reset();
+
+    uint64_t Count() const { return count; }
+    uint64_t Min() const { return count == 0 ? 0 : min; }
+    uint64_t Max() const { return max; }
+    double Mean() const;
+
+    // Smallest recorded value (up to the bucket resolution) that at
+    // least p percent of the recorded values are equal to or below.
+    uint64_t Percentile(double p) const;
+
+    // Nonzero buckets as "value:count" pairs separated by commas, where
+    // value is the largest value the bucket holds, and back again. Parse
+    // adds to the histogram, so its minimum, maximum and mean are only
+    // known up to the bucket resolution.
+    std::string Serialize() const;
+    bool Parse(const std::string &s);
+
+private:
+    std::vector<uint64_t> counts;
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+
+    static std::size_t Index(uint64_t value);
+    static uint64_t HighestEquivalentValue(std::size_t index);
+};
+
+#endif  /* _LIB_HISTOGRAM_H_ */
@@ -0,0 +1,41 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * lib/linearprobe.h:
+ *   Deletion from open-addressed tables probed linearly.
+ *
+ **********************************************************************/
+
+#ifndef _LIB_LINEARPROBE_H_
+#define _LIB_LINEARPROBE_H_
+
+#include <stddef.h>
+#include <vector>
+
+// Close the hole left by removing the entry at slot i of a table whose
+// entries are probed for linearly, wrapping around, from their home
+// slot. Any later entry of the run that would no longer be reachable
+// from its home slot across the hole is moved back into it, which
+// leaves a hole further on, and so on; so the table never needs
+// tombstones. empty(slot) tells whether a slot is free, and home(slot)
+// gives an occupied slot's home. Returns the slot left free at the end,
+// for the caller to clear.
+template <class SLOT, class EMPTY, class HOME>
+size_t
+LinearProbeRemove(std::vector<SLOT> &slots, size_t i, EMPTY empty, HOME home)
+{
+    auto next = [&slots](size_t j) {
+        return j + 1 == slots.size() ? 0 : j + 1;
+    };
+    for (size_t j = next(i); !empty(slots[j]); j = next(j)) {
+        size_t h = home(slots[j]);
+        bool stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+        if (!stays) {
+            slots[i] = slots[j];
+            i = j;
+        }
+    }
+    return i;
+}
+
+#endif /* _LIB_LINEARPROBE_H_ */
@@ -75,6 +75,7 @@ public:
     int Timer(uint64_t ms, timer_callback_t cb);
     bool CancelTimer(int id);
     void CancelAllTimers();
+    uint64_t NowMicros() { return vtime * 1000; }
 
 protected:
     bool SendMessageInternal(TransportReceiver *src,
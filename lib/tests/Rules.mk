@@ -5,6 +5,7 @@ d := $(dir $(lastword $(MAKEFILE_LIST)))
 #
 GTEST_SRCS += $(addprefix $(d), \
 		configuration-test.cc \
+		histogram-test.cc \
 	        simtransport-test.cc)
 
 PROTOS += $(d)simtransport-testmessage.proto
@@ -13,6 +14,10 @@ $(d)configuration-test: $(o)configuration-test.o $(LIB-configuration) $(GTEST_MA
 
 TEST_BINS += $(d)configuration-test
 
+$(d)histogram-test: $(o)histogram-test.o $(LIB-histogram) $(GTEST_MAIN)
+
+TEST_BINS += $(d)histogram-test
+
 $(d)simtransport-test: $(o)simtransport-test.o $(LIB-simtransport) $(o)simtransport-testmessage.o $(GTEST_MAIN)
 
 TEST_BINS += $(d)simtransport-test
@@ -0,0 +1,116 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * lib/tests/histogram-test.cc:
+ *   test cases for Histogram class
+ *
+ **********************************************************************/
+
+#include "lib/histogram.h"
+
+#include <gtest/gtest.h>
+
+TEST(Histogram, Empty)
+{
+    Histogram h;
+    EXPECT_EQ(0, h.Count());
+    EXPECT_EQ(0, h.Min());
+    EXPECT_EQ(0, h.Max());
+    EXPECT_EQ(0, h.Percentile(50));
+    EXPECT_EQ("", h.Serialize());
+}
+
+TEST(Histogram, SmallValuesAreExact)
+{
+    Histogram h;
+    for (uint64_t i = 1; i <= 100; i++) {
+        h.Record(i);
+    }
+    EXPECT_EQ(100, h.Count());
+    EXPECT_EQ(1, h.Min());
+    EXPECT_EQ(100, h.Max());
+    EXPECT_DOUBLE_EQ(50.5, h.Mean());
+    EXPECT_EQ(50, h.Percentile(50));
+    EXPECT_EQ(99, h.Percentile(99));
+    EXPECT_EQ(100, h.Percentile(99.9));
+    EXPECT_EQ(100, h.Percentile(100));
+}
+
+TEST(Histogram, RelativeError)
+{
+    // Every value comes back from its bucket within the resolution.
+    const double resolution = 1.0 / (1 << (Histogram::SUB_BUCKET_BITS - 1));
+    for (uint64_t v = 1; v < (1ULL << 40); v = v * 3 + 7) {
+        Histogram h;
+        h.Record(v);
+        h.Record(UINT64_MAX);
+        uint64_t p = h.Percentile(50);
+        EXPECT_GE(p, v);
+        EXPECT_LE(p - v, v * resolution);
+    }
+}
+
+TEST(Histogram, Percentiles)
+{
+    Histogram h;
+    for (int i = 0; i < 9990; i++) {
+        h.Record(1000);
+    }
+    for (int i = 0; i < 10; i++) {
+        h.Record(1000000);
+    }
+    EXPECT_NEAR(1000, h.Percentile(50), 10);
+    EXPECT_NEAR(1000, h.Percentile(99), 10);
+    EXPECT_NEAR(1000, h.Percentile(99.9), 10);
+    EXPECT_NEAR(1000000, h.Percentile(99.99), 10000);
+    EXPECT_EQ(1000000, h.Max());
+}
+
+TEST(Histogram, RecordCorrected)
+{
+    // A 100 stall of a client that expects to issue a request every 10
+    // also hides the requests that would have waited 90, 80, ... 10.
+    Histogram h;
+    h.RecordCorrected(100, 10);
+    EXPECT_EQ(10, h.Count());
+    EXPECT_EQ(10, h.Min());
+    EXPECT_EQ(100, h.Max());
+    EXPECT_EQ(50, h.Percentile(50));
+
+    Histogram fast;
+    fast.RecordCorrected(5, 10);
+    EXPECT_EQ(1, fast.Count());
+}
+
+TEST(Histogram, AddAndSerialize)
+{
+    Histogram a, b;
+    for (uint64_t i = 0; i < 1000; i++) {
+        a.Record(i * 37);
+        b.Record(i * 1013);
+    }
+    Histogram sum;
+    sum.Add(a);
+    sum.Add(b);
+    EXPECT_EQ(2000, sum.Count());
+    EXPECT_EQ(0, sum.Min());
+    EXPECT_EQ(999 * 1013, sum.Max());
+
+    // Serialized histograms merge to the same buckets; only the maximum
+    // is rounded up to the top of its bucket.
+    Histogram parsed;
+    ASSERT_TRUE(parsed.Parse(a.Serialize()));
+    ASSERT_TRUE(parsed.Parse(b.Serialize()));
+    EXPECT_EQ(sum.Count(), parsed.Count());
+    EXPECT_EQ(sum.Serialize(), parsed.Serialize());
+    for (double p : { 1.0, 50.0, 90.0, 99.0 }) {
+        EXPECT_EQ(sum.Percentile(p), parsed.Percentile(p));
+    }
+
+    EXPECT_FALSE(parsed.Parse("12"));
+    EXPECT_FALSE(parsed.Parse("1x:2"));
+
+    sum.Reset();
+    EXPECT_EQ(0, sum.Count());
+    EXPECT_EQ("", sum.Serialize());
+}
@@ -31,8 +31,11 @@
  **********************************************************************/
 
 #include "lib/assert.h"
+#include "lib/message.h"
 #include "lib/transport.h"
 
+#include <time.h>
+
 TransportReceiver::~TransportReceiver()
 {
     delete this->myAddress;
@@ -50,6 +53,16 @@ TransportReceiver::GetAddress()
     return *(this->myAddress);
 }
 
+uint64_t
+Transport::NowMicros()
+{
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) < 0) {
+        PPanic("Failed to get CLOCK_MONOTONIC");
+    }
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 Timeout::Timeout(Transport *transport, uint64_t ms, timer_callback_t cb)
     : transport(transport), ms(ms), cb(cb)
 {
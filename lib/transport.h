@@ -38,7 +38,6 @@
 
 #define CLIENT_NETWORK_DELAY 0
 #define REPLICA_NETWORK_DELAY 0
-#define READ_AT_LEADER 1
 
 class TransportAddress
 {
@@ -83,6 +82,8 @@ public:
     virtual int Timer(uint64_t ms, timer_callback_t cb) = 0;
     virtual bool CancelTimer(int id) = 0;
     virtual void CancelAllTimers() = 0;
+    // Monotonic clock that timers run on, in microseconds.
+    virtual uint64_t NowMicros();
 };
 
 class Timeout
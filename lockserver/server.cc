@@ -167,8 +167,8 @@ LockServer::Sync(const std::map<opid_t, RecordEntry>& record) {
 }
 
 std::map<opid_t, std::string>
-LockServer::Merge(const std::map<opid_t, std::vector<RecordEntry>> &d,
-                  const std::map<opid_t, std::vector<RecordEntry>> &u,
+LockServer::Merge(const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+                  const std::map<opid_t, std::vector<const RecordEntry *>> &u,
                   const std::map<opid_t, std::string> &majority_results_in_d) {
     // First note that d and u only contain consensus operations, and lock
     // requests are the only consensus operations (unlock is an inconsistent
@@ -178,13 +178,13 @@ LockServer::Merge(const std::map<opid_t, std::vector<RecordEntry>> &d,
 
     std::map<opid_t, std::string> results;
 
-    using EntryVec = std::vector<RecordEntry>;
+    using EntryVec = std::vector<const RecordEntry *>;
     for (const std::pair<const opid_t, EntryVec>& p: d) {
         const opid_t &opid = p.first;
         const EntryVec &entries = p.second;
 
         // Get the request and reply.
-        const RecordEntry &entry = *std::begin(entries);
+        const RecordEntry &entry = **std::begin(entries);
 
         Request request;
         request.ParseFromString(entry.request.op());
@@ -226,7 +226,7 @@ LockServer::Merge(const std::map<opid_t, std::vector<RecordEntry>> &d,
         const opid_t &opid = p.first;
         const EntryVec &entries = p.second;
 
-        const RecordEntry &entry = *std::begin(entries);
+        const RecordEntry &entry = **std::begin(entries);
         Request request;
         request.ParseFromString(entry.request.op());
 
@@ -63,8 +63,8 @@ public:
 
     // Merge
     std::map<opid_t, std::string> Merge(
-        const std::map<opid_t, std::vector<RecordEntry>> &d,
-        const std::map<opid_t, std::vector<RecordEntry>> &u,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &u,
         const std::map<opid_t, std::string> &majority_results_in_d) override;
 
 private:
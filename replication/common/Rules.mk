@@ -8,6 +8,8 @@ PROTOS += $(addprefix $(d), \
 
 LIB-request := $(o)request.o
 
+LIB-log := $(o)log.o $(LIB-request) $(LIB-message)
+
 OBJS-client := $(o)client.o \
                $(LIB-message) $(LIB-configuration) \
                $(LIB-transport) $(LIB-request)
@@ -54,6 +54,12 @@ Log::Dump(opnum_t from, T out)
 template <class iter> void
 Log::Install(iter start, iter end)
 {
+    // Entries before the log starts are covered by a checkpoint, so
+    // they are committed here already.
+    while (start != end && start->opnum() < this->start) {
+        start++;
+    }
+
     // Find the first divergence in the log
     iter it = start;
     for (it = start; it != end; it++) {
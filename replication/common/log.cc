@@ -31,18 +31,23 @@
 #include "replication/common/log.h"
 #include "replication/common/request.pb.h"
 #include "lib/assert.h"
+#include "lib/hash.h"
 
 #include <openssl/sha.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace replication {
 
 const string Log::EMPTY_HASH = string(SHA_DIGEST_LENGTH, '\0');
 
-Log::Log(bool useHash, opnum_t start, string initialHash)
-    : useHash(useHash)
+Log::Log(LogHashMode hashMode, opnum_t start, string initialHash)
+    : hashMode(hashMode)
 {
     this->initialHash = initialHash;
     this->start = start;
+    this->startView = 0;
     if (start == 1) {
         ASSERT(initialHash == EMPTY_HASH);
     }
@@ -62,8 +67,15 @@ Log::Append(viewstamp_t vs, const Request &req, LogEntryState state)
     entry.viewstamp = vs;
     entry.request = req;
     entry.state = state;
-    if (useHash) {
-        entry.hash = ComputeHash(LastHash(), entry);        
+    switch (hashMode) {
+    case LOG_HASH_NONE:
+        break;
+    case LOG_HASH_SHA1:
+        entry.hash = ComputeHash(LastHash(), entry);
+        break;
+    case LOG_HASH_FAST:
+        entry.hash = ComputeFastHash(LastHash(), entry);
+        break;
     }
 
     entries.push_back(entry);
@@ -107,7 +119,7 @@ Log::SetStatus(opnum_t op, LogEntryState state)
 bool
 Log::SetRequest(opnum_t op, const Request &req)
 {
-    if (useHash) {
+    if (hashMode != LOG_HASH_NONE) {
         Panic("Log::SetRequest on hashed log not supported.");
     }
     
@@ -133,6 +145,7 @@ Log::RemoveAfter(opnum_t op)
     if (op > LastOpnum()) {
         return;
     }
+    ASSERT(op >= start);
 
     Debug("Removing log entries after " FMT_OPNUM, op);
 
@@ -142,6 +155,27 @@ Log::RemoveAfter(opnum_t op)
     ASSERT(LastOpnum() == op-1);
 }
 
+void
+Log::RemoveUpTo(viewstamp_t vs, const string &lastHash)
+{
+    if (vs.opnum < start) {
+        return;
+    }
+
+    Debug("Removing log entries up to " FMT_OPNUM, vs.opnum);
+
+    // Before erasing, since lastHash may be an entry's own.
+    initialHash = lastHash;
+    if (vs.opnum >= LastOpnum()) {
+        entries.clear();
+    } else {
+        entries.erase(entries.begin(),
+                      entries.begin() + (vs.opnum - start + 1));
+    }
+    start = vs.opnum + 1;
+    startView = vs.view;
+}
+
 LogEntry *
 Log::Last()
 {
@@ -156,7 +190,7 @@ viewstamp_t
 Log::LastViewstamp() const
 {
     if (entries.empty()) {
-        return viewstamp_t(0, start-1);
+        return viewstamp_t(startView, start-1);
     } else {
         return entries.back().viewstamp;
     }
@@ -197,7 +231,7 @@ Log::LastHash() const
 }
 
 string
-Log::ComputeHash(string lastHash, const LogEntry &entry)
+Log::ComputeHash(const string &lastHash, const LogEntry &entry)
 {
     SHA_CTX ctx;
     unsigned char out[SHA_DIGEST_LENGTH];
@@ -219,4 +253,21 @@ Log::ComputeHash(string lastHash, const LogEntry &entry)
     return string((char *)out, SHA_DIGEST_LENGTH);
 }
 
+string
+Log::ComputeFastHash(const string &lastHash, const LogEntry &entry)
+{
+    // Chain by seeding with the previous hash; the fixed-size fields
+    // and the op are hashed in two passes to avoid copying the op.
+    uint64_t seed = 0;
+    memcpy(&seed, lastHash.data(), std::min(sizeof(seed), lastHash.size()));
+
+    uint64_t header[4] = { entry.viewstamp.view, entry.viewstamp.opnum,
+                           entry.request.clientid(),
+                           entry.request.clientreqid() };
+    uint64_t h = hash64(header, sizeof(header), seed);
+    h = hash64(entry.request.op().data(), entry.request.op().size(), h);
+
+    return string((char *)&h, sizeof(h));
+}
+
 } // namespace replication
@@ -37,6 +37,7 @@
 #include "lib/transport.h"
 #include "replication/common/viewstamp.h"
 
+#include <deque>
 #include <map>
 #include <google/protobuf/message.h>
 
@@ -49,6 +50,15 @@ enum LogEntryState {
     LOG_STATE_FASTPREPARED      // fastpaxos only
 };
 
+// How each entry's hash chains from the one before it: not at all,
+// with SHA-1, or with a 64-bit XXH64 that is much cheaper but only
+// guards against accidental divergence, not a malicious replica.
+enum LogHashMode {
+    LOG_HASH_NONE,
+    LOG_HASH_SHA1,
+    LOG_HASH_FAST
+};
+
 struct LogEntry
 {
     viewstamp_t viewstamp;
@@ -86,12 +96,18 @@ struct LogEntry
 class Log
 {
 public:
-    Log(bool useHash, opnum_t start = 1, string initialHash = EMPTY_HASH);
+    Log(LogHashMode hashMode, opnum_t start = 1,
+        string initialHash = EMPTY_HASH);
     LogEntry & Append(viewstamp_t vs, const Request &req, LogEntryState state);
     LogEntry * Find(opnum_t opnum);
     bool SetStatus(opnum_t opnum, LogEntryState state);
     bool SetRequest(opnum_t op, const Request &req);
     void RemoveAfter(opnum_t opnum);
+    // Drop the entries up to and including vs, which a checkpoint now
+    // covers. The log then starts after vs, even if it held no entry
+    // that far, and chains later hashes from lastHash, the hash of the
+    // entry at vs.
+    void RemoveUpTo(viewstamp_t vs, const string &lastHash);
     LogEntry * Last();
     viewstamp_t LastViewstamp() const; // deprecated
     opnum_t LastOpnum() const;
@@ -101,15 +117,19 @@ public:
     template <class iter> void Install(iter start, iter end);
     const string &LastHash() const;
 
-    static string ComputeHash(string lastHash, const LogEntry &entry);
+    static string ComputeHash(const string &lastHash, const LogEntry &entry);
+    static string ComputeFastHash(const string &lastHash,
+                                  const LogEntry &entry);
     static const string EMPTY_HASH;
 
     
 private:
-    std::vector<LogEntry> entries;
+    std::deque<LogEntry> entries;
     string initialHash;
     opnum_t start;
-    bool useHash;
+    // View of the entry before start.
+    view_t startView;
+    LogHashMode hashMode;
 };
 
 #include "replication/common/log-impl.h"
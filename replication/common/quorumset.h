@@ -34,6 +34,13 @@
 #ifndef _COMMON_QUORUMSET_H_
 #define _COMMON_QUORUMSET_H_
 
+#include "lib/assert.h"
+#include "replication/common/replyset.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
 namespace replication {
 
 template <class IDTYPE, class MSGTYPE>
@@ -127,6 +134,173 @@ private:
     std::map<IDTYPE, std::map<int, MSGTYPE> > messages;
 };
 
+// A QuorumSet for replies keyed by replica index, with at most
+// MAX_REPLICAS replicas. Each id's replies are a QuorumReplies, as in a
+// client's ReplySet, so counting a quorum is a popcount. The sets for
+// ids that are cleared are kept for later ids, along with their
+// messages' buffers, so adding a reply does not allocate once a few ids
+// have come and gone. Ids are found by a linear scan, so only a handful
+// should be open at once; ClearUpTo retires the ones that are done.
+template <class IDTYPE, class MSGTYPE>
+class ReplicaQuorumSet
+{
+public:
+    typedef QuorumReplies<MSGTYPE> Replies;
+    static const int MAX_REPLICAS = Replies::MAX_REPLICAS;
+
+    ReplicaQuorumSet(int numRequired)
+        : numRequired(numRequired)
+    {
+
+    }
+
+    void
+    Clear()
+    {
+        for (auto &e : entries) {
+            Release(*e);
+        }
+    }
+
+    void
+    Clear(IDTYPE vs)
+    {
+        Entry *e = Find(vs);
+        if (e != NULL) {
+            Release(*e);
+        }
+    }
+
+    // Forget every id up to and including vs.
+    void
+    ClearUpTo(IDTYPE vs)
+    {
+        for (auto &e : entries) {
+            if (e->used && !(vs < e->id)) {
+                Release(*e);
+            }
+        }
+    }
+
+    int
+    NumRequired() const
+    {
+        return numRequired;
+    }
+
+    const Replies &
+    GetMessages(IDTYPE vs) const
+    {
+        const Entry *e = Find(vs);
+        return e == NULL ? none : e->replies;
+    }
+
+    const Replies *
+    CheckForQuorum(IDTYPE vs) const
+    {
+        const Entry *e = Find(vs);
+        if (e != NULL && (int)e->replies.size() >= numRequired) {
+            return &e->replies;
+        } else {
+            return NULL;
+        }
+    }
+
+    const Replies *
+    CheckForQuorum() const
+    {
+        for (const auto &e : entries) {
+            if (e->used && (int)e->replies.size() >= numRequired) {
+                return &e->replies;
+            }
+        }
+        return nullptr;
+    }
+
+    // A later message from the same replica replaces its earlier one.
+    const Replies *
+    AddAndCheckForQuorum(IDTYPE vs, int replicaIdx, const MSGTYPE &msg)
+    {
+        Replies &r = Open(vs).replies;
+        r.Set(replicaIdx, msg);
+        if ((int)r.size() >= numRequired) {
+            return &r;
+        } else {
+            return NULL;
+        }
+    }
+
+    void
+    Add(IDTYPE vs, int replicaIdx, const MSGTYPE &msg)
+    {
+        AddAndCheckForQuorum(vs, replicaIdx, msg);
+    }
+
+public:
+    int numRequired;
+private:
+    struct Entry {
+        IDTYPE id;
+        bool used;
+        Replies replies;
+        Entry() : id(), used(false) { }
+    };
+
+    // Entries live as long as the set, so that pointers to their
+    // replies stay good while other ids come and go.
+    std::vector<std::unique_ptr<Entry> > entries;
+    Replies none;
+
+    const Entry *
+    Find(IDTYPE vs) const
+    {
+        for (const auto &e : entries) {
+            if (e->used && !(e->id < vs) && !(vs < e->id)) {
+                return e.get();
+            }
+        }
+        return NULL;
+    }
+
+    Entry *
+    Find(IDTYPE vs)
+    {
+        return const_cast<Entry *>(
+            static_cast<const ReplicaQuorumSet *>(this)->Find(vs));
+    }
+
+    Entry &
+    Open(IDTYPE vs)
+    {
+        Entry *free = NULL;
+        for (auto &e : entries) {
+            if (!e->used) {
+                if (free == NULL) {
+                    free = e.get();
+                }
+            } else if (!(e->id < vs) && !(vs < e->id)) {
+                return *e;
+            }
+        }
+        if (free == NULL) {
+            entries.emplace_back(new Entry());
+            free = entries.back().get();
+        }
+        free->id = vs;
+        free->used = true;
+        return *free;
+    }
+
+    // The messages stay as they are, so that a caller can still use a
+    // quorum it was handed while it clears the set.
+    void
+    Release(Entry &e)
+    {
+        e.used = false;
+        e.replies.Clear();
+    }
+};
+
 }      // namespace replication
 
 #endif  // _COMMON_QUORUMSET_H_
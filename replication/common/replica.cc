@@ -76,4 +76,23 @@ Replica::UnloggedUpcall(const string &op, string &res)
     app->UnloggedUpcall(op, res);
 }
 
+void
+Replica::LeaderUnloggedUpcall(const string &op, string &res)
+{
+    app->LeaderUnloggedUpcall(op, res);
+}
+
+bool
+Replica::SnapshotUpcall(string &state)
+{
+    return app->SnapshotUpcall(state);
+}
+
+void
+Replica::RestoreUpcall(const string &state)
+{
+    Debug("Restoring a %zu byte snapshot", state.size());
+    app->RestoreUpcall(state);
+}
+
 } // namespace replication
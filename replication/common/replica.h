@@ -61,6 +61,14 @@ public:
     virtual void ReplicaUpcall(opnum_t opnum, const string &str1, string &str2) { };
     // Invoke call back for unreplicated operations run on only one replica
     virtual void UnloggedUpcall(const string &str1, string &str2) { };
+    // Invoke call back for unreplicated operations run on a leader
+    // that knows no other replica has since become leader
+    virtual void LeaderUnloggedUpcall(const string &str1, string &str2) { UnloggedUpcall(str1, str2); };
+    // Save the state left by every operation executed so far, so the
+    // log before it can be dropped; return false if the app cannot
+    virtual bool SnapshotUpcall(string &state) { return false; };
+    // Replace the state with one saved by SnapshotUpcall on any replica
+    virtual void RestoreUpcall(const string &state) { };
 };
 
 class Replica : public TransportReceiver
@@ -76,6 +84,9 @@ protected:
                                      const Request & msg,
                                      MSG &reply);
     void UnloggedUpcall(const string &op, string &res);
+    void LeaderUnloggedUpcall(const string &op, string &res);
+    bool SnapshotUpcall(string &state);
+    void RestoreUpcall(const string &state);
     template<class MSG> void ExecuteUnlogged(const UnloggedRequest & msg,
                                                MSG &reply);
     
@@ -0,0 +1,140 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/replyset.h:
+ *   The replicas that have replied to a request, as a bitmap, with
+ *   the latest reply from each
+ *
+ **********************************************************************/
+
+#ifndef _COMMON_REPLYSET_H_
+#define _COMMON_REPLYSET_H_
+
+#include "lib/assert.h"
+#include "replication/common/viewstamp.h"
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace replication {
+
+// The latest reply from each replica that has replied: a bitmap of the
+// replicas and an array of replies, by replica index. Iterating yields
+// (replica index, reply) pairs in index order. Clearing keeps the array,
+// so a set reused for later requests does not allocate again.
+template <class MSGTYPE>
+class QuorumReplies
+{
+public:
+    static const int MAX_REPLICAS = 64;
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const QuorumReplies *r, uint64_t rest)
+            : r(r), rest(rest) { }
+        std::pair<int, const MSGTYPE &>
+        operator*() const
+        {
+            int i = __builtin_ctzll(rest);
+            return std::pair<int, const MSGTYPE &>(i, r->msgs[i]);
+        }
+        const_iterator &operator++() { rest &= rest - 1; return *this; }
+        bool operator!=(const const_iterator &o) const { return rest != o.rest; }
+    private:
+        const QuorumReplies *r;
+        uint64_t rest;
+    };
+
+    QuorumReplies() : replied(0) { }
+    // With room for replies from n replicas from the start.
+    explicit QuorumReplies(int n) : replied(0), msgs(n)
+    {
+        ASSERT(n <= MAX_REPLICAS);
+    }
+
+    // Record msg from replicaIdx, in place of any earlier reply.
+    void
+    Set(int replicaIdx, const MSGTYPE &msg)
+    {
+        ASSERT(replicaIdx >= 0 && replicaIdx < MAX_REPLICAS);
+        if ((int)msgs.size() <= replicaIdx) {
+            msgs.resize(replicaIdx + 1);
+        }
+        msgs[replicaIdx] = msg;
+        replied |= (uint64_t)1 << replicaIdx;
+    }
+
+    // The replies themselves stay until overwritten, so a caller can
+    // still read ones it was handed.
+    void Clear() { replied = 0; }
+
+    size_t size() const { return __builtin_popcountll(replied); }
+    bool empty() const { return replied == 0; }
+    bool Has(int replicaIdx) const { return (replied >> replicaIdx) & 1; }
+    const MSGTYPE &Get(int replicaIdx) const { return msgs[replicaIdx]; }
+    const_iterator begin() const { return const_iterator(this, replied); }
+    const_iterator end() const { return const_iterator(this, 0); }
+
+private:
+    uint64_t replied;
+    // Grown to the highest replica index once, then reused.
+    std::vector<MSGTYPE> msgs;
+};
+
+// Which replicas have replied to a request, and the view of each one's
+// latest reply, for a client to count quorums with. The views are kept
+// as QuorumReplies sized once for the configuration, so a set can be
+// cleared and reused for another request without allocating.
+class ReplySet
+{
+public:
+    explicit ReplySet(int n) : views(n) { }
+
+    void Clear() { views.Clear(); }
+
+    // Record a reply from replicaIdx in view, in place of any earlier
+    // one; return how many replicas have replied in that view.
+    int
+    Add(int replicaIdx, view_t view)
+    {
+        views.Set(replicaIdx, view);
+        return Count(view);
+    }
+
+    // The replicas whose latest reply was in view.
+    uint64_t
+    InView(view_t view) const
+    {
+        uint64_t in = 0;
+        for (const auto &r : views) {
+            if (r.second == view) {
+                in |= (uint64_t)1 << r.first;
+            }
+        }
+        return in;
+    }
+
+    int Count(view_t view) const { return __builtin_popcountll(InView(view)); }
+
+    // Find a view in which at least needed replicas have replied.
+    bool
+    FindQuorum(int needed, view_t &view) const
+    {
+        for (const auto &r : views) {
+            if (Count(r.second) >= needed) {
+                view = r.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    QuorumReplies<view_t> views;
+};
+
+} // namespace replication
+
+#endif  /* _COMMON_REPLYSET_H_ */
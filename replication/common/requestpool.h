@@ -0,0 +1,151 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/requestpool.h:
+ *   Recycled storage for a client's pending requests, by request id
+ *
+ **********************************************************************/
+
+#ifndef _COMMON_REQUESTPOOL_H_
+#define _COMMON_REQUESTPOOL_H_
+
+#include "lib/linearprobe.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace replication {
+
+// A client's pending requests of one kind, by request id. A request is
+// made once and, when it finishes, goes on a free list for a later one
+// to reuse, along with its buffers, timers and reply sets. The index is
+// an open-addressed array probed linearly from the id, which a client
+// hands out in sequence. Once the pool has grown to the most requests
+// ever in flight, starting and finishing one allocates nothing.
+//
+// REQ must have a Clear() that readies a finished request for reuse,
+// stopping its timers. Ids must be nonzero.
+template <class REQ>
+class RequestPool
+{
+public:
+    // make constructs a request for the pool; it lives as long as the
+    // pool.
+    explicit RequestPool(std::function<REQ *()> make)
+        : make(make), slots(MIN_SLOTS), count(0) { }
+
+    // Take a free request and file it under id, which is not pending.
+    REQ *
+    Start(uint64_t id)
+    {
+        REQ *req;
+        if (freeReqs.empty()) {
+            req = make();
+            reqs.emplace_back(req);
+        } else {
+            req = freeReqs.back();
+            freeReqs.pop_back();
+        }
+
+        // Keep the index at most half full.
+        if ((count + 1) * 2 > slots.size()) {
+            Grow();
+        }
+        size_t i = Home(id);
+        while (slots[i].id != 0) {
+            i = Next(i);
+        }
+        slots[i].id = id;
+        slots[i].req = req;
+        count++;
+        return req;
+    }
+
+    REQ *
+    Find(uint64_t id) const
+    {
+        for (size_t i = Home(id); slots[i].id != 0; i = Next(i)) {
+            if (slots[i].id == id) {
+                return slots[i].req;
+            }
+        }
+        return NULL;
+    }
+
+    // Take id out of the index. Its request stays as it is, so that its
+    // continuation can still run, until it is freed.
+    void
+    Erase(uint64_t id)
+    {
+        size_t i = Home(id);
+        while (slots[i].id != id) {
+            if (slots[i].id == 0) {
+                return;
+            }
+            i = Next(i);
+        }
+
+        i = LinearProbeRemove(slots, i,
+            [](const Slot &s) { return s.id == 0; },
+            [this](const Slot &s) { return Home(s.id); });
+        slots[i].id = 0;
+        slots[i].req = NULL;
+        count--;
+    }
+
+    // Return a request that is no longer in the index for reuse.
+    void
+    Free(REQ *req)
+    {
+        req->Clear();
+        freeReqs.push_back(req);
+    }
+
+    size_t Size() const { return count; }
+
+private:
+    static const size_t MIN_SLOTS = 16;
+
+    struct Slot {
+        uint64_t id;
+        REQ *req;
+        Slot() : id(0), req(NULL) { }
+    };
+
+    std::function<REQ *()> make;
+    std::vector<std::unique_ptr<REQ> > reqs;
+    std::vector<REQ *> freeReqs;
+    // A power of two in size, so that ids map straight to slots.
+    std::vector<Slot> slots;
+    size_t count;
+
+    size_t Home(uint64_t id) const { return id & (slots.size() - 1); }
+    size_t Next(size_t i) const { return (i + 1) & (slots.size() - 1); }
+
+    void
+    Grow()
+    {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        for (const Slot &s : old) {
+            if (s.id == 0) {
+                continue;
+            }
+            size_t i = Home(s.id);
+            while (slots[i].id != 0) {
+                i = Next(i);
+            }
+            slots[i] = s;
+        }
+    }
+
+    RequestPool(const RequestPool &) = delete;
+    RequestPool &operator=(const RequestPool &) = delete;
+};
+
+} // namespace replication
+
+#endif  /* _COMMON_REQUESTPOOL_H_ */
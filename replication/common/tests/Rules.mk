@@ -1,2 +1,25 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
+GTEST_SRCS += $(d)log-test.cc
+
+$(d)log-test: $(o)log-test.o $(LIB-log) $(GTEST_MAIN)
+
+TEST_BINS += $(d)log-test
+
+SRCS += $(d)log-benchmark.cc
+
+$(d)log-benchmark: $(o)log-benchmark.o $(LIB-log)
+
+BINS += $(d)log-benchmark
+
+GTEST_SRCS += $(d)requestpool-test.cc
+
+$(d)requestpool-test: $(o)requestpool-test.o $(GTEST_MAIN)
+
+TEST_BINS += $(d)requestpool-test
+
+GTEST_SRCS += $(d)quorumset-test.cc
+
+$(d)quorumset-test: $(o)quorumset-test.o $(GTEST_MAIN)
+
+TEST_BINS += $(d)quorumset-test
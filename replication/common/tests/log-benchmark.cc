@@ -0,0 +1,81 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/tests/log-benchmark.cc:
+ *   Measures the cost of appending to the replication log with each
+ *   way of hashing its entries.
+ *
+ **********************************************************************/
+
+#include "replication/common/log.h"
+
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace replication;
+
+int
+main(int argc, char **argv)
+{
+    uint64_t numAppends = 1000000;
+    std::vector<uint64_t> sizes;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        char *strtolPtr;
+        uint64_t value = strtoull(optarg, &strtolPtr, 10);
+        if ((*optarg == '\0') || (*strtolPtr != '\0') || (value == 0)) {
+            fprintf(stderr, "option -%c requires a positive integer\n", opt);
+            return 1;
+        }
+        switch (opt) {
+        case 'n': numAppends = value; break;    // Entries to append.
+        case 's': sizes.push_back(value); break; // Request size; repeatable.
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            return 1;
+        }
+    }
+    if (sizes.empty()) {
+        sizes = { 64, 4096 };
+    }
+
+    struct { LogHashMode mode; const char *name; } modes[] = {
+        { LOG_HASH_NONE, "none" },
+        { LOG_HASH_SHA1, "sha1" },
+        { LOG_HASH_FAST, "fast" },
+    };
+
+    for (uint64_t size : sizes) {
+        Request req;
+        req.set_op(std::string(size, 'x'));
+        req.set_clientid(1);
+
+        for (auto m : modes) {
+            // Truncate as checkpoints would, so that only appending
+            // is timed and memory stays small.
+            Log log(m.mode);
+            auto start = std::chrono::steady_clock::now();
+            for (opnum_t op = 1; op <= numAppends; op++) {
+                req.set_clientreqid(op);
+                log.Append(viewstamp_t(1, op), req, LOG_STATE_PREPARED);
+                if (op % 1000 == 0) {
+                    log.RemoveUpTo(viewstamp_t(1, op), log.LastHash());
+                }
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(
+                end - start).count() / numAppends;
+            printf("%6" PRIu64 " byte requests, %-4s hash: %8.1f ns/append\n",
+                   size, m.name, ns);
+        }
+    }
+    return 0;
+}
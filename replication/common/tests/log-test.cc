@@ -0,0 +1,98 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/tests/log-test.cc:
+ *   test cases for the replication log and its hash chains
+ *
+ **********************************************************************/
+
+#include "lib/hash.h"
+#include "replication/common/log.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace replication;
+using std::string;
+
+static Request
+MakeRequest(opnum_t op, const string &body = "")
+{
+    Request r;
+    r.set_op(body.empty() ? "op " + std::to_string(op) : body);
+    r.set_clientid(op % 7);
+    r.set_clientreqid(op);
+    return r;
+}
+
+static void
+Fill(Log &log, opnum_t from, opnum_t to)
+{
+    for (opnum_t i = from; i <= to; i++) {
+        log.Append(viewstamp_t(1, i), MakeRequest(i), LOG_STATE_PREPARED);
+    }
+}
+
+TEST(Log, Hash64KnownValues)
+{
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, hash64("", 0, 0));
+    EXPECT_EQ(0xD24EC4F1A98C6E5BULL, hash64("a", 1, 0));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, hash64("abc", 3, 0));
+    const string s = "Nobody inspects the spammish repetition";
+    EXPECT_EQ(0xFBCEA83C8A378BF1ULL, hash64(s.data(), s.size(), 0));
+}
+
+TEST(Log, HashModes)
+{
+    struct { LogHashMode mode; size_t size; } modes[] = {
+        { LOG_HASH_NONE, 0 },
+        { LOG_HASH_SHA1, 20 },
+        { LOG_HASH_FAST, 8 },
+    };
+
+    for (auto m : modes) {
+        Log a(m.mode), b(m.mode), c(m.mode);
+        Fill(a, 1, 100);
+        Fill(b, 1, 100);
+        Fill(c, 1, 49);
+        c.Append(viewstamp_t(1, 50), MakeRequest(50, "changed"),
+                 LOG_STATE_PREPARED);
+        Fill(c, 51, 100);
+
+        for (opnum_t i = 1; i <= 100; i++) {
+            EXPECT_EQ(m.size, a.Find(i)->hash.size());
+            EXPECT_EQ(a.Find(i)->hash, b.Find(i)->hash);
+            if (m.mode != LOG_HASH_NONE) {
+                // A change shows in every later hash.
+                EXPECT_EQ(i >= 50, a.Find(i)->hash != c.Find(i)->hash);
+            }
+        }
+    }
+}
+
+TEST(Log, RemoveUpTo)
+{
+    Log a(LOG_HASH_FAST);
+    Fill(a, 1, 100);
+
+    // Truncate within the log.
+    Log b(LOG_HASH_FAST);
+    Fill(b, 1, 60);
+    b.RemoveUpTo(viewstamp_t(1, 50), b.Find(50)->hash);
+    EXPECT_EQ(51, b.FirstOpnum());
+    EXPECT_EQ(NULL, b.Find(50));
+    EXPECT_EQ(60, b.LastOpnum());
+    Fill(b, 61, 100);
+    EXPECT_EQ(a.Find(100)->hash, b.Find(100)->hash);
+
+    // Truncate past the end, as when installing a checkpoint.
+    Log c(LOG_HASH_FAST);
+    Fill(c, 1, 10);
+    c.RemoveUpTo(viewstamp_t(1, 50), a.Find(50)->hash);
+    EXPECT_TRUE(c.Empty());
+    EXPECT_EQ(1, c.LastViewstamp().view);
+    EXPECT_EQ(50, c.LastViewstamp().opnum);
+    Fill(c, 51, 100);
+    EXPECT_EQ(a.Find(100)->hash, c.Find(100)->hash);
+}
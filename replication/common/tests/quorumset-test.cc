@@ -0,0 +1,77 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/tests/quorumset-test.cc:
+ *   test cases for the bitmap quorum set
+ *
+ **********************************************************************/
+
+#include "replication/common/quorumset.h"
+#include "replication/common/viewstamp.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace replication;
+using std::string;
+
+typedef ReplicaQuorumSet<viewstamp_t, string> StringQuorumSet;
+
+TEST(ReplicaQuorumSet, QuorumAndMessages)
+{
+    StringQuorumSet q(2);
+    viewstamp_t vs(1, 5);
+
+    EXPECT_EQ(NULL, q.AddAndCheckForQuorum(vs, 3, "three"));
+    EXPECT_EQ(NULL, q.CheckForQuorum(vs));
+    // A second message from the same replica replaces the first.
+    EXPECT_EQ(NULL, q.AddAndCheckForQuorum(vs, 3, "three again"));
+
+    auto msgs = q.AddAndCheckForQuorum(vs, 1, "one");
+    ASSERT_NE((void *)NULL, (void *)msgs);
+    EXPECT_EQ(2U, msgs->size());
+    EXPECT_TRUE(msgs->Has(1));
+    EXPECT_FALSE(msgs->Has(2));
+
+    std::vector<int> idxs;
+    std::vector<string> bodies;
+    for (const auto &kv : *msgs) {
+        idxs.push_back(kv.first);
+        bodies.push_back(kv.second);
+    }
+    EXPECT_EQ((std::vector<int>{ 1, 3 }), idxs);
+    EXPECT_EQ((std::vector<string>{ "one", "three again" }), bodies);
+
+    EXPECT_EQ(msgs, q.CheckForQuorum(vs));
+    EXPECT_EQ(msgs, q.CheckForQuorum());
+    EXPECT_TRUE(q.GetMessages(viewstamp_t(1, 6)).empty());
+
+    q.Clear(vs);
+    EXPECT_EQ(NULL, q.CheckForQuorum(vs));
+    EXPECT_TRUE(q.GetMessages(vs).empty());
+}
+
+TEST(ReplicaQuorumSet, ClearUpToReusesEntries)
+{
+    StringQuorumSet q(2);
+    for (opnum_t op = 1; op <= 4; op++) {
+        q.Add(viewstamp_t(1, op), 0, "a");
+    }
+    const void *first = &q.GetMessages(viewstamp_t(1, 1));
+
+    q.ClearUpTo(viewstamp_t(1, 3));
+    for (opnum_t op = 1; op <= 3; op++) {
+        EXPECT_TRUE(q.GetMessages(viewstamp_t(1, op)).empty());
+    }
+    EXPECT_EQ(1U, q.GetMessages(viewstamp_t(1, 4)).size());
+
+    // A new id takes a freed entry rather than a new one.
+    q.Add(viewstamp_t(1, 5), 2, "b");
+    EXPECT_EQ(first, (const void *)&q.GetMessages(viewstamp_t(1, 5)));
+    EXPECT_FALSE(q.GetMessages(viewstamp_t(1, 5)).Has(0));
+
+    q.Clear();
+    EXPECT_EQ(NULL, q.CheckForQuorum());
+}
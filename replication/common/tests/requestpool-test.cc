@@ -0,0 +1,180 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/common/tests/requestpool-test.cc:
+ *   test cases for the client's pending request pool and reply sets
+ *
+ **********************************************************************/
+
+#include "replication/common/replyset.h"
+#include "replication/common/requestpool.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace replication;
+
+struct TestRequest
+{
+    uint64_t id = 0;
+    std::string body;
+    int cleared = 0;
+
+    void Clear() { body.clear(); cleared++; }
+};
+
+static RequestPool<TestRequest> *
+MakePool(int &made)
+{
+    return new RequestPool<TestRequest>([&made]() {
+        made++;
+        return new TestRequest();
+    });
+}
+
+TEST(RequestPool, StartFindErase)
+{
+    int made = 0;
+    std::unique_ptr<RequestPool<TestRequest> > pool(MakePool(made));
+
+    TestRequest *a = pool->Start(1);
+    a->id = 1;
+    TestRequest *b = pool->Start(2);
+    b->id = 2;
+    EXPECT_NE(a, b);
+    EXPECT_EQ(2U, pool->Size());
+    EXPECT_EQ(a, pool->Find(1));
+    EXPECT_EQ(b, pool->Find(2));
+    EXPECT_EQ(NULL, pool->Find(3));
+
+    pool->Erase(1);
+    EXPECT_EQ(NULL, pool->Find(1));
+    EXPECT_EQ(b, pool->Find(2));
+    EXPECT_EQ(1U, pool->Size());
+
+    // Erasing an id that is not there does nothing.
+    pool->Erase(1);
+    EXPECT_EQ(1U, pool->Size());
+}
+
+TEST(RequestPool, FreedRequestsAreReused)
+{
+    int made = 0;
+    std::unique_ptr<RequestPool<TestRequest> > pool(MakePool(made));
+
+    for (uint64_t id = 1; id <= 1000; id++) {
+        TestRequest *req = pool->Start(id);
+        req->body = "request";
+        pool->Erase(id);
+        pool->Free(req);
+        EXPECT_TRUE(req->body.empty());
+    }
+    EXPECT_EQ(1, made);
+    EXPECT_EQ(0U, pool->Size());
+
+    // The most ever in flight at once.
+    std::vector<TestRequest *> live;
+    for (uint64_t id = 1001; id <= 1008; id++) {
+        live.push_back(pool->Start(id));
+    }
+    for (uint64_t id = 1001; id <= 1008; id++) {
+        TestRequest *req = pool->Find(id);
+        pool->Erase(id);
+        pool->Free(req);
+    }
+    for (uint64_t id = 2001; id <= 2008; id++) {
+        pool->Start(id);
+    }
+    EXPECT_EQ(8, made);
+}
+
+TEST(RequestPool, GrowAndCollide)
+{
+    int made = 0;
+    std::unique_ptr<RequestPool<TestRequest> > pool(MakePool(made));
+
+    // Ids that share home slots, in a small and then a grown index.
+    std::set<uint64_t> ids;
+    for (uint64_t i = 1; i <= 200; i++) {
+        uint64_t id = i * 16 + (i % 3);
+        TestRequest *req = pool->Start(id);
+        req->id = id;
+        ids.insert(id);
+    }
+    EXPECT_EQ(200U, pool->Size());
+    for (uint64_t id : ids) {
+        ASSERT_NE((TestRequest *)NULL, pool->Find(id));
+        EXPECT_EQ(id, pool->Find(id)->id);
+    }
+
+    // Erase every other id and check the rest stay reachable.
+    bool erase = true;
+    for (auto it = ids.begin(); it != ids.end(); ) {
+        if (erase) {
+            TestRequest *req = pool->Find(*it);
+            pool->Erase(*it);
+            pool->Free(req);
+            it = ids.erase(it);
+        } else {
+            ++it;
+        }
+        erase = !erase;
+    }
+    EXPECT_EQ(ids.size(), pool->Size());
+    for (uint64_t id : ids) {
+        ASSERT_NE((TestRequest *)NULL, pool->Find(id));
+        EXPECT_EQ(id, pool->Find(id)->id);
+    }
+}
+
+TEST(RequestPool, EraseAcrossWraparound)
+{
+    int made = 0;
+    std::unique_ptr<RequestPool<TestRequest> > pool(MakePool(made));
+
+    // A run that starts in the last slot and wraps to the front of the
+    // 16-slot index.
+    uint64_t ids[] = { 15, 31, 47, 16, 1 };
+    for (uint64_t id : ids) {
+        pool->Start(id)->id = id;
+    }
+    pool->Erase(15);
+    for (uint64_t id : { 31, 47, 16, 1 }) {
+        ASSERT_NE((TestRequest *)NULL, pool->Find(id));
+        EXPECT_EQ(id, pool->Find(id)->id);
+    }
+    pool->Erase(47);
+    pool->Erase(16);
+    EXPECT_EQ(31U, pool->Find(31)->id);
+    EXPECT_EQ(1U, pool->Find(1)->id);
+    EXPECT_EQ(NULL, pool->Find(15));
+    EXPECT_EQ(NULL, pool->Find(47));
+    EXPECT_EQ(2U, pool->Size());
+}
+
+TEST(ReplySet, QuorumByView)
+{
+    ReplySet replies(5);
+    EXPECT_EQ(1, replies.Add(0, 1));
+    EXPECT_EQ(2, replies.Add(1, 1));
+    EXPECT_EQ(1, replies.Add(2, 2));
+
+    view_t view;
+    EXPECT_FALSE(replies.FindQuorum(3, view));
+
+    // A later reply replaces the replica's earlier one.
+    EXPECT_EQ(3, replies.Add(2, 1));
+    EXPECT_EQ(3, replies.Add(2, 1));
+    EXPECT_EQ(0, replies.Count(2));
+    ASSERT_TRUE(replies.FindQuorum(3, view));
+    EXPECT_EQ(1U, view);
+    EXPECT_EQ(0x7U, replies.InView(1));
+
+    replies.Clear();
+    EXPECT_EQ(0, replies.Count(1));
+    EXPECT_FALSE(replies.FindQuorum(1, view));
+}
@@ -48,16 +48,23 @@ IRClient::IRClient(const transport::Configuration &config,
                    Transport *transport,
                    uint64_t clientid)
     : Client(config, transport, clientid),
-      lastReqId(0)
+      lastReqId(0),
+      pendingUnloggedReqs([this]() {
+          return new PendingUnloggedRequest(this);
+      }),
+      pendingInconsistentReqs([this]() {
+          return new PendingInconsistentRequest(this);
+      }),
+      pendingConsensusReqs([this]() {
+          return new PendingConsensusRequest(this);
+      })
 {
 
 }
 
 IRClient::~IRClient()
 {
-    for (auto kv : pendingReqs) {
-	delete kv.second;
-    }
+
 }
 
 void
@@ -78,21 +85,15 @@ IRClient::InvokeInconsistent(const string &request,
 
     // Bump the request ID
     uint64_t reqId = ++lastReqId;
-    // Create new timer
-    auto timer = std::unique_ptr<Timeout>(new Timeout(
-        transport, 500, [this, reqId]() { ResendInconsistent(reqId); }));
-    PendingInconsistentRequest *req =
-	new PendingInconsistentRequest(request,
-                                   reqId,
-                                   continuation,
-                                   std::move(timer),
-                                   config.QuorumSize());
-    pendingReqs[reqId] = req;
+    PendingInconsistentRequest *req = pendingInconsistentReqs.Start(reqId);
+    req->request = request;
+    req->clientReqId = reqId;
+    req->continuation = continuation;
     SendInconsistent(req);
 }
 
 void
-IRClient::SendInconsistent(const PendingInconsistentRequest *req)
+IRClient::SendInconsistent(PendingInconsistentRequest *req)
 {
 
     proto::ProposeInconsistentMessage reqMsg;
@@ -101,11 +102,11 @@ IRClient::SendInconsistent(const PendingInconsistentRequest *req)
     reqMsg.mutable_req()->set_clientreqid(req->clientReqId);
 
     if (transport->SendMessageToAll(this, reqMsg)) {
-        req->timer->Reset();
+        req->timer.Reset();
     } else {
         Warning("Could not send inconsistent request to replicas");
-        pendingReqs.erase(req->clientReqId);
-        delete req;
+        pendingInconsistentReqs.Erase(req->clientReqId);
+        pendingInconsistentReqs.Free(req);
     }
 }
 
@@ -116,36 +117,19 @@ IRClient::InvokeConsensus(const string &request,
                           error_continuation_t error_continuation)
 {
     uint64_t reqId = ++lastReqId;
-    auto timer = std::unique_ptr<Timeout>(new Timeout(
-        transport, 500, [this, reqId]() { ResendConsensus(reqId); }));
-    auto transition_to_slow_path_timer =
-        std::unique_ptr<Timeout>(new Timeout(transport, 500, [this, reqId]() {
-            TransitionToConsensusSlowPath(reqId);
-        }));
-
-    PendingConsensusRequest *req =
-	new PendingConsensusRequest(request,
-				    reqId,
-				    continuation,
-				    std::move(timer),
-				    std::move(transition_to_slow_path_timer),
-				    config.QuorumSize(),
-				    config.FastQuorumSize(),
-				    decide,
-                    error_continuation);
-
-    proto::ProposeConsensusMessage reqMsg;
-    reqMsg.mutable_req()->set_op(request);
-    reqMsg.mutable_req()->set_clientid(clientid);
-    reqMsg.mutable_req()->set_clientreqid(reqId);
-
-	pendingReqs[reqId] = req;
-    req->transition_to_slow_path_timer->Start();
+    PendingConsensusRequest *req = pendingConsensusReqs.Start(reqId);
+    req->request = request;
+    req->clientReqId = reqId;
+    req->continuation = continuation;
+    req->decide = decide;
+    req->error_continuation = error_continuation;
+
+    req->transition_to_slow_path_timer.Start();
     SendConsensus(req);
 }
 
 void
-IRClient::SendConsensus(const PendingConsensusRequest *req)
+IRClient::SendConsensus(PendingConsensusRequest *req)
 {
     proto::ProposeConsensusMessage reqMsg;
     reqMsg.mutable_req()->set_op(req->request);
@@ -153,11 +137,11 @@ IRClient::SendConsensus(const PendingConsensusRequest *req)
     reqMsg.mutable_req()->set_clientreqid(req->clientReqId);
 
     if (transport->SendMessageToAll(this, reqMsg)) {
-        req->timer->Reset();
+        req->timer.Reset();
     } else {
         Warning("Could not send consensus request to replicas");
-        pendingReqs.erase(req->clientReqId);
-        delete req;
+        pendingConsensusReqs.Erase(req->clientReqId);
+        pendingConsensusReqs.Free(req);
     }
 }
 
@@ -169,16 +153,6 @@ IRClient::InvokeUnlogged(int replicaIdx,
                          uint32_t timeout)
 {
     uint64_t reqId = ++lastReqId;
-    auto timer = std::unique_ptr<Timeout>(new Timeout(
-        transport, timeout,
-        [this, reqId]() { UnloggedRequestTimeoutCallback(reqId); }));
-
-    PendingUnloggedRequest *req =
-	new PendingUnloggedRequest(request,
-				   reqId,
-				   continuation,
-				   error_continuation,
-				   std::move(timer));
 
     proto::UnloggedRequestMessage reqMsg;
     reqMsg.mutable_req()->set_op(request);
@@ -186,11 +160,15 @@ IRClient::InvokeUnlogged(int replicaIdx,
     reqMsg.mutable_req()->set_clientreqid(reqId);
 
     if (transport->SendMessageToReplica(this, replicaIdx, reqMsg)) {
-	req->timer->Start();
-	pendingReqs[reqId] = req;
+        PendingUnloggedRequest *req = pendingUnloggedReqs.Start(reqId);
+        req->request = request;
+        req->clientReqId = reqId;
+        req->continuation = continuation;
+        req->error_continuation = error_continuation;
+        req->timer.SetTimeout(timeout);
+        req->timer.Start();
     } else {
         Warning("Could not send unlogged request to replica");
-	delete req;
     }
 }
 
@@ -199,7 +177,12 @@ IRClient::ResendInconsistent(const uint64_t reqId)
 {
 
     Warning("Client timeout; resending inconsistent request: %lu", reqId);
-    SendInconsistent((PendingInconsistentRequest *)pendingReqs[reqId]);
+    PendingInconsistentRequest *req = pendingInconsistentReqs.Find(reqId);
+    if (req == NULL) {
+        Debug("Received resend request when no request was pending");
+        return;
+    }
+    SendInconsistent(req);
 }
 
 void
@@ -207,55 +190,50 @@ IRClient::ResendConsensus(const uint64_t reqId)
 {
 
     Warning("Client timeout; resending consensus request: %lu", reqId);
-    SendConsensus((PendingConsensusRequest *)pendingReqs[reqId]);
+    PendingConsensusRequest *req = pendingConsensusReqs.Find(reqId);
+    if (req == NULL) {
+        Debug("Received resend request when no request was pending");
+        return;
+    }
+    SendConsensus(req);
 }
 
 void
 IRClient::TransitionToConsensusSlowPath(const uint64_t reqId)
 {
     Debug("Client timeout; taking consensus slow path: reqId=%lu", reqId);
-    PendingConsensusRequest *req =
-        dynamic_cast<PendingConsensusRequest *>(pendingReqs[reqId]);
+    PendingConsensusRequest *req = pendingConsensusReqs.Find(reqId);
     ASSERT(req != NULL);
     req->on_slow_path = true;
 
     // We've already transitioned into the slow path, so don't transition into
     // the slow-path again.
-    ASSERT(req->transition_to_slow_path_timer);
-    req->transition_to_slow_path_timer.reset();
+    req->transition_to_slow_path_timer.Stop();
 
     // It's possible that we already have a quorum of responses (but not a
     // super quorum).
-    const std::map<int, proto::ReplyConsensusMessage> *quorum =
-        req->consensusReplyQuorum.CheckForQuorum();
-    if (quorum != nullptr) {
-        HandleSlowPathConsensus(reqId, *quorum, false, req);
+    view_t view;
+    if (req->replies.FindQuorum(req->quorumSize, view)) {
+        HandleSlowPathConsensus(reqId, view, false, req);
     }
 }
 
 void IRClient::HandleSlowPathConsensus(
     const uint64_t reqid,
-    const std::map<int, proto::ReplyConsensusMessage> &msgs,
+    const view_t view,
     const bool finalized_result_found,
     PendingConsensusRequest *req)
 {
-    ASSERT(finalized_result_found || msgs.size() >= req->quorumSize);
+    ASSERT(finalized_result_found ||
+           (size_t)req->replies.Count(view) >= req->quorumSize);
     Debug("Handling slow path for request %lu.", reqid);
 
     // If a finalized result wasn't found, call decide to determine the
     // finalized result.
     if (!finalized_result_found) {
-        uint64_t view = 0;
         std::map<string, std::size_t> results;
-        for (const auto &p : msgs) {
-            const proto::ReplyConsensusMessage &msg = p.second;
-            results[msg.result()] += 1;
-
-            // All messages should have the same view.
-            if (view == 0) {
-                view = msg.view();
-            }
-            ASSERT(msg.view() == view);
+        for (uint64_t in = req->replies.InView(view); in != 0; in &= in - 1) {
+            results[req->results[__builtin_ctzll(in)]] += 1;
         }
 
         // Upcall into the application, and put the result in the request
@@ -265,11 +243,9 @@ void IRClient::HandleSlowPathConsensus(
         req->reply_consensus_view = view;
     }
 
-    // Set up a new timer for the finalize phase.
-    req->timer = std::unique_ptr<Timeout>(
-        new Timeout(transport, 500, [this, reqid]() {  //
-            ResendConfirmation(reqid, true);
-        }));
+    // The timer now resends the finalize message.
+    req->sent_confirms = true;
+    req->timer.Stop();
 
     // Send finalize message.
     proto::FinalizeConsensusMessage response;
@@ -278,29 +254,27 @@ void IRClient::HandleSlowPathConsensus(
     response.set_result(req->decideResult);
     if (transport->SendMessageToAll(this, response)) {
         Debug("FinalizeConsensusMessages sent for request %lu.", reqid);
-        req->sent_confirms = true;
-        req->timer->Start();
+        req->timer.Start();
     } else {
         Warning("Could not send finalize message to replicas");
-        pendingReqs.erase(reqid);
-        delete req;
+        pendingConsensusReqs.Erase(reqid);
+        pendingConsensusReqs.Free(req);
     }
 }
 
 void IRClient::HandleFastPathConsensus(
     const uint64_t reqid,
-    const std::map<int, proto::ReplyConsensusMessage> &msgs,
+    const view_t view,
     PendingConsensusRequest *req)
 {
-    ASSERT(msgs.size() >= req->superQuorumSize);
+    ASSERT((size_t)req->replies.Count(view) >= req->superQuorumSize);
     Debug("Handling fast path for request %lu.", reqid);
 
     // We've received a super quorum of responses. Now, we have to check to see
     // if we have a super quorum of _matching_ responses.
     map<string, std::size_t> results;
-    for (const auto &m : msgs) {
-        const std::string &result = m.second.result();
-        results[result]++;
+    for (uint64_t in = req->replies.InView(view); in != 0; in &= in - 1) {
+        results[req->results[__builtin_ctzll(in)]]++;
     }
 
     for (const auto &result : results) {
@@ -313,30 +287,31 @@ void IRClient::HandleFastPathConsensus(
               reqid);
         req->decideResult = result.first;
 
-        // Set up a new timeout for the finalize phase.
-        req->timer = std::unique_ptr<Timeout>(new Timeout(
-            transport, 500,
-            [this, reqid]() { ResendConfirmation(reqid, true); }));
+        // The timer now resends the finalize message.
+        req->sent_confirms = true;
+        req->timer.Stop();
 
         // Asynchronously send the finalize message.
         proto::FinalizeConsensusMessage response;
         response.mutable_opid()->set_clientid(clientid);
         response.mutable_opid()->set_clientreqid(reqid);
         response.set_result(result.first);
-        if (transport->SendMessageToAll(this, response)) {
+        bool sent = transport->SendMessageToAll(this, response);
+        if (sent) {
             Debug("FinalizeConsensusMessages sent for request %lu.", reqid);
-            req->sent_confirms = true;
-            req->timer->Start();
+            req->timer.Start();
         } else {
             Warning("Could not send finalize message to replicas");
-            pendingReqs.erase(reqid);
-            delete req;
+            pendingConsensusReqs.Erase(reqid);
         }
 
         // Return to the client.
         if (!req->continuationInvoked) {
-            req->continuation(req->request, req->decideResult);
             req->continuationInvoked = true;
+            req->continuation(req->request, req->decideResult);
+        }
+        if (!sent) {
+            pendingConsensusReqs.Free(req);
         }
         return;
     }
@@ -346,23 +321,19 @@ void IRClient::HandleFastPathConsensus(
     Debug("A super quorum of matching requests was NOT found for request %lu.",
           reqid);
     req->on_slow_path = true;
-    if (req->transition_to_slow_path_timer) {
-        req->transition_to_slow_path_timer.reset();
-    }
-    HandleSlowPathConsensus(reqid, msgs, false, req);
+    req->transition_to_slow_path_timer.Stop();
+    HandleSlowPathConsensus(reqid, view, false, req);
 }
 
 void
 IRClient::ResendConfirmation(const uint64_t reqId, bool isConsensus)
 {
-    if (pendingReqs.find(reqId) == pendingReqs.end()) {
-        Debug("Received resend request when no request was pending");
-        return;
-    }
-
     if (isConsensus) {
-	PendingConsensusRequest *req = static_cast<PendingConsensusRequest *>(pendingReqs[reqId]);
-	ASSERT(req != NULL);
+        PendingConsensusRequest *req = pendingConsensusReqs.Find(reqId);
+        if (req == NULL) {
+            Debug("Received resend request when no request was pending");
+            return;
+        }
 
         proto::FinalizeConsensusMessage response;
         response.mutable_opid()->set_clientid(clientid);
@@ -370,27 +341,30 @@ IRClient::ResendConfirmation(const uint64_t reqId, bool isConsensus)
         response.set_result(req->decideResult);
 
         if(transport->SendMessageToAll(this, response)) {
-            req->timer->Reset();
+            req->timer.Reset();
         } else {
             Warning("Could not send finalize message to replicas");
-	    // give up and clean up
-	    pendingReqs.erase(reqId);
-	    delete req;
+            // give up and clean up
+            pendingConsensusReqs.Erase(reqId);
+            pendingConsensusReqs.Free(req);
         }
     } else {
-	PendingInconsistentRequest *req = static_cast<PendingInconsistentRequest *>(pendingReqs[reqId]);
-	ASSERT(req != NULL);
+        PendingInconsistentRequest *req = pendingInconsistentReqs.Find(reqId);
+        if (req == NULL) {
+            Debug("Received resend request when no request was pending");
+            return;
+        }
 
-	proto::FinalizeInconsistentMessage response;
+        proto::FinalizeInconsistentMessage response;
         response.mutable_opid()->set_clientid(clientid);
         response.mutable_opid()->set_clientreqid(req->clientReqId);
 
         if (transport->SendMessageToAll(this, response)) {
-	    req->timer->Reset();
-	} else {
+            req->timer.Reset();
+        } else {
             Warning("Could not send finalize message to replicas");
-	    pendingReqs.erase(reqId);
-	    delete req;
+            pendingInconsistentReqs.Erase(reqId);
+            pendingInconsistentReqs.Free(req);
         }
 
     }
@@ -429,23 +403,16 @@ IRClient::HandleInconsistentReply(const TransportAddress &remote,
                                   const proto::ReplyInconsistentMessage &msg)
 {
     uint64_t reqId = msg.opid().clientreqid();
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingInconsistentRequest *req = pendingInconsistentReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received reply when no request was pending");
         return;
     }
 
-    PendingInconsistentRequest *req =
-        dynamic_cast<PendingInconsistentRequest *>(it->second);
-    // Make sure the dynamic cast worked
-    ASSERT(req != NULL);
-
-    Debug("Client received reply: %lu %i", reqId,
-          req->inconsistentReplyQuorum.NumRequired());
+    Debug("Client received reply: %lu %i", reqId, config.QuorumSize());
 
     // Record replies
-    viewstamp_t vs = { msg.view(), reqId };
-    if (req->inconsistentReplyQuorum.AddAndCheckForQuorum(vs, msg.replicaidx(), msg)) {
+    if (req->replies.Add(msg.replicaidx(), msg.view()) >= config.QuorumSize()) {
         // TODO: Some of the ReplyInconsistentMessages might already be
         // finalized. If this is the case, then we don't have to send finalize
         // messages to them. It's not incorrect to send them anyway (which this
@@ -454,22 +421,21 @@ IRClient::HandleInconsistentReply(const TransportAddress &remote,
         // If all quorum received, then send finalize and return to client
         // Return to client
         if (!req->continuationInvoked) {
-            req->timer = std::unique_ptr<Timeout>(new Timeout(
-                transport, 500,
-                [this, reqId]() { ResendConfirmation(reqId, false); }));
+            // The timer now resends the finalize message.
+            req->continuationInvoked = true;
+            req->timer.Stop();
 
             // asynchronously send the finalize message
             proto::FinalizeInconsistentMessage response;
             *(response.mutable_opid()) = msg.opid();
 
             if (transport->SendMessageToAll(this, response)) {
-                req->timer->Start();
+                req->timer.Start();
             } else {
                 Warning("Could not send finalize message to replicas");
             }
 
             req->continuation(req->request, "");
-            req->continuationInvoked = true;
         }
     }
 }
@@ -484,8 +450,8 @@ IRClient::HandleConsensusReply(const TransportAddress &remote,
         "request %lu.",
         msg.replicaidx(), msg.view(), reqId);
 
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingConsensusRequest *req = pendingConsensusReqs.Find(reqId);
+    if (req == NULL) {
         Debug(
             "Client was not expecting a ReplyConsensusMessage for request %lu, "
             "so it is ignoring the request.",
@@ -493,10 +459,6 @@ IRClient::HandleConsensusReply(const TransportAddress &remote,
         return;
     }
 
-    PendingConsensusRequest *req =
-        dynamic_cast<PendingConsensusRequest *>(it->second);
-    ASSERT(req != nullptr);
-
     if (req->sent_confirms) {
         Debug(
             "Client has already received a quorum or super quorum of "
@@ -506,26 +468,23 @@ IRClient::HandleConsensusReply(const TransportAddress &remote,
         return;
     }
 
-    req->consensusReplyQuorum.Add(msg.view(), msg.replicaidx(), msg);
-    const std::map<int, proto::ReplyConsensusMessage> &msgs =
-        req->consensusReplyQuorum.GetMessages(msg.view());
+    req->results[msg.replicaidx()] = msg.result();
+    size_t replies = req->replies.Add(msg.replicaidx(), msg.view());
 
     if (msg.finalized()) {
         Debug("The HandleConsensusReply for request %lu was finalized.", reqId);
         // If we receive a finalized message, then we immediately transition
         // into the slow path.
         req->on_slow_path = true;
-        if (req->transition_to_slow_path_timer) {
-            req->transition_to_slow_path_timer.reset();
-        }
+        req->transition_to_slow_path_timer.Stop();
 
         req->decideResult = msg.result();
         req->reply_consensus_view = msg.view();
-        HandleSlowPathConsensus(reqId, msgs, true, req);
-    } else if (req->on_slow_path && msgs.size() >= req->quorumSize) {
-        HandleSlowPathConsensus(reqId, msgs, false, req);
-    } else if (!req->on_slow_path && msgs.size() >= req->superQuorumSize) {
-        HandleFastPathConsensus(reqId, msgs, req);
+        HandleSlowPathConsensus(reqId, msg.view(), true, req);
+    } else if (req->on_slow_path && replies >= req->quorumSize) {
+        HandleSlowPathConsensus(reqId, msg.view(), false, req);
+    } else if (!req->on_slow_path && replies >= req->superQuorumSize) {
+        HandleFastPathConsensus(reqId, msg.view(), req);
     }
 }
 
@@ -534,8 +493,15 @@ IRClient::HandleConfirm(const TransportAddress &remote,
                         const proto::ConfirmMessage &msg)
 {
     uint64_t reqId = msg.opid().clientreqid();
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    // Confirms answer the finalize messages of both inconsistent and
+    // consensus requests.
+    PendingInconsistentRequest *ireq = pendingInconsistentReqs.Find(reqId);
+    PendingConsensusRequest *creq = NULL;
+    PendingRequest *req = ireq;
+    if (req == NULL) {
+        req = creq = pendingConsensusReqs.Find(reqId);
+    }
+    if (req == NULL) {
         Debug(
             "We received a ConfirmMessage for operation %lu, but we weren't "
             "waiting for any ConfirmMessages. We are ignoring the message.",
@@ -543,37 +509,40 @@ IRClient::HandleConfirm(const TransportAddress &remote,
         return;
     }
 
-    PendingRequest *req = it->second;
-
-    viewstamp_t vs = { msg.view(), reqId };
-    if (req->confirmQuorum.AddAndCheckForQuorum(vs, msg.replicaidx(), msg)) {
-        req->timer->Stop();
-        pendingReqs.erase(it);
+    if (req->confirms.Add(msg.replicaidx(), msg.view()) >= config.QuorumSize()) {
+        req->timer.Stop();
+        if (ireq != NULL) {
+            pendingInconsistentReqs.Erase(reqId);
+        } else {
+            pendingConsensusReqs.Erase(reqId);
+        }
         if (!req->continuationInvoked) {
             // Return to the client. ConfirmMessages are sent by replicas in
             // response to FinalizeInconsistentMessages and
             // FinalizeConsensusMessage, but inconsistent operations are
             // invoked before FinalizeInconsistentMessages are ever sent. Thus,
             // req->continuationInvoked can only be false if req is a
-            // PendingConsensusRequest, so it's safe to cast it here.
-            PendingConsensusRequest *r2 =
-                dynamic_cast<PendingConsensusRequest *>(req);
-            ASSERT(r2 != nullptr);
-            if (vs.view == r2->reply_consensus_view) {
-                r2->continuation(r2->request, r2->decideResult);
+            // PendingConsensusRequest.
+            ASSERT(creq != nullptr);
+            if (msg.view() == creq->reply_consensus_view) {
+                creq->continuation(creq->request, creq->decideResult);
             } else {
                 Debug(
                     "We received a majority of ConfirmMessages for request %lu "
                     "with view %lu, but the view from ReplyConsensusMessages "
                     "was %lu.",
-                    reqId, vs.view, r2->reply_consensus_view);
-                if (r2->error_continuation) {
-                    r2->error_continuation(
-                        r2->request, ErrorCode::MISMATCHED_CONSENSUS_VIEWS);
+                    reqId, msg.view(), creq->reply_consensus_view);
+                if (creq->error_continuation) {
+                    creq->error_continuation(
+                        creq->request, ErrorCode::MISMATCHED_CONSENSUS_VIEWS);
                 }
             }
         }
-        delete req;
+        if (ireq != NULL) {
+            pendingInconsistentReqs.Free(ireq);
+        } else {
+            pendingConsensusReqs.Free(creq);
+        }
     }
 }
 
@@ -582,44 +551,40 @@ IRClient::HandleUnloggedReply(const TransportAddress &remote,
                               const proto::UnloggedReplyMessage &msg)
 {
     uint64_t reqId = msg.clientreqid();
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received reply when no request was pending");
         return;
     }
 
-    PendingRequest *req = it->second;
     // delete timer event
-    req->timer->Stop();
+    req->timer.Stop();
     // remove from pending list
-    pendingReqs.erase(it);
+    pendingUnloggedReqs.Erase(reqId);
     // invoke application callback
     req->continuation(req->request, msg.reply());
-    delete req;
+    pendingUnloggedReqs.Free(req);
 }
 
 void
 IRClient::UnloggedRequestTimeoutCallback(const uint64_t reqId)
 {
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received timeout when no request was pending");
         return;
     }
 
-    PendingUnloggedRequest *req = static_cast<PendingUnloggedRequest *>(it->second);
-    ASSERT(req != NULL);
-
     Warning("Unlogged request timed out");
     // delete timer event
-    req->timer->Stop();
+    req->timer.Stop();
     // remove from pending list
-    pendingReqs.erase(it);
+    pendingUnloggedReqs.Erase(reqId);
     // invoke application callback
     if (req->error_continuation) {
         req->error_continuation(req->request, ErrorCode::TIMEOUT);
     }
-    delete req;
+    pendingUnloggedReqs.Free(req);
 }
 
 } // namespace ir
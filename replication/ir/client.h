@@ -33,15 +33,14 @@
 #define _IR_CLIENT_H_
 
 #include "replication/common/client.h"
-#include "replication/common/quorumset.h"
+#include "replication/common/replyset.h"
+#include "replication/common/requestpool.h"
 #include "lib/configuration.h"
 #include "replication/ir/ir-proto.pb.h"
 
 #include <functional>
 #include <map>
-#include <memory>
-#include <set>
-#include <unordered_map>
+#include <vector>
 
 namespace replication {
 namespace ir {
@@ -83,52 +82,68 @@ public:
         error_continuation_t error_continuation = nullptr);
 
 protected:
+    // Requests are pooled, and reused with their timers and reply sets
+    // once they finish; see RequestPool.
     struct PendingRequest {
         string request;
         uint64_t clientReqId;
         continuation_t continuation;
         bool continuationInvoked = false;
-        std::unique_ptr<Timeout> timer;
-        QuorumSet<viewstamp_t, proto::ConfirmMessage> confirmQuorum;
-
-        inline PendingRequest(string request, uint64_t clientReqId,
-                              continuation_t continuation,
-                              std::unique_ptr<Timeout> timer, int quorumSize)
-            : request(request),
-              clientReqId(clientReqId),
-              continuation(continuation),
-              timer(std::move(timer)),
-              confirmQuorum(quorumSize){};
-        virtual ~PendingRequest(){};
+        Timeout timer;
+        ReplySet confirms;
+
+        inline PendingRequest(Transport *transport, uint64_t ms,
+                              timer_callback_t cb, int n)
+            : clientReqId(0),
+              timer(transport, ms, cb),
+              confirms(n){};
+        inline void Clear() {
+            timer.Stop();
+            request.clear();
+            continuation = nullptr;
+            continuationInvoked = false;
+            confirms.Clear();
+        }
     };
 
     struct PendingUnloggedRequest : public PendingRequest {
         error_continuation_t error_continuation;
 
-        inline PendingUnloggedRequest(
-            string request, uint64_t clientReqId, continuation_t continuation,
-            error_continuation_t error_continuation,
-            std::unique_ptr<Timeout> timer)
-            : PendingRequest(request, clientReqId, continuation,
-                             std::move(timer), 1),
-              error_continuation(error_continuation){};
+        inline PendingUnloggedRequest(IRClient *client)
+            : PendingRequest(client->transport, 0, [client, this]() {
+                      client->UnloggedRequestTimeoutCallback(clientReqId);
+                  }, client->config.n){};
+        inline void Clear() {
+            PendingRequest::Clear();
+            error_continuation = nullptr;
+        }
     };
 
     struct PendingInconsistentRequest : public PendingRequest {
-        QuorumSet<viewstamp_t, proto::ReplyInconsistentMessage>
-            inconsistentReplyQuorum;
-
-        inline PendingInconsistentRequest(string request, uint64_t clientReqId,
-                                          continuation_t continuation,
-                                          std::unique_ptr<Timeout> timer,
-                                          int quorumSize)
-            : PendingRequest(request, clientReqId, continuation,
-                             std::move(timer), quorumSize),
-              inconsistentReplyQuorum(quorumSize){};
+        ReplySet replies;
+
+        // The timer resends the request until a quorum replies, and then
+        // the finalize message, once the continuation has run, until a
+        // quorum confirms.
+        inline PendingInconsistentRequest(IRClient *client)
+            : PendingRequest(client->transport, 500, [client, this]() {
+                      if (continuationInvoked) {
+                          client->ResendConfirmation(clientReqId, false);
+                      } else {
+                          client->ResendInconsistent(clientReqId);
+                      }
+                  }, client->config.n),
+              replies(client->config.n){};
+        inline void Clear() {
+            PendingRequest::Clear();
+            replies.Clear();
+        }
     };
 
     struct PendingConsensusRequest : public PendingRequest {
-        QuorumSet<opnum_t, proto::ReplyConsensusMessage> consensusReplyQuorum;
+        ReplySet replies;
+        // The result in each replica's latest reply, by replica index.
+        std::vector<string> results;
         decide_t decide;
         string decideResult;
         const std::size_t quorumSize;
@@ -137,8 +152,8 @@ protected:
         error_continuation_t error_continuation;
 
         // The timer to give up on the fast path and transition to the slow
-        // path. After this timer is run for the first time, it is nulled.
-        std::unique_ptr<Timeout> transition_to_slow_path_timer;
+        // path. It is stopped once the request is on the slow path.
+        Timeout transition_to_slow_path_timer;
 
         // The view for which a majority result (or finalized result) was
         // found. The view of a majority of confirms must match this view.
@@ -149,30 +164,46 @@ protected:
         // phase.
         bool sent_confirms = false;
 
-        inline PendingConsensusRequest(
-            string request, uint64_t clientReqId, continuation_t continuation,
-            std::unique_ptr<Timeout> timer,
-            std::unique_ptr<Timeout> transition_to_slow_path_timer,
-            int quorumSize, int superQuorum, decide_t decide,
-            error_continuation_t error_continuation)
-            : PendingRequest(request, clientReqId, continuation,
-                             std::move(timer), quorumSize),
-              consensusReplyQuorum(quorumSize),
-              decide(decide),
-              quorumSize(quorumSize),
-              superQuorumSize(superQuorum),
+        // The timer resends the request until it is decided, and then
+        // the finalize message until a quorum confirms.
+        inline PendingConsensusRequest(IRClient *client)
+            : PendingRequest(client->transport, 500, [client, this]() {
+                      if (sent_confirms) {
+                          client->ResendConfirmation(clientReqId, true);
+                      } else {
+                          client->ResendConsensus(clientReqId);
+                      }
+                  }, client->config.n),
+              replies(client->config.n),
+              results(client->config.n),
+              quorumSize(client->config.QuorumSize()),
+              superQuorumSize(client->config.FastQuorumSize()),
               on_slow_path(false),
-              error_continuation(error_continuation),
-              transition_to_slow_path_timer(
-                  std::move(transition_to_slow_path_timer)){};
+              transition_to_slow_path_timer(client->transport, 500,
+                  [client, this]() {
+                      client->TransitionToConsensusSlowPath(clientReqId);
+                  }){};
+        inline void Clear() {
+            PendingRequest::Clear();
+            replies.Clear();
+            decide = nullptr;
+            decideResult.clear();
+            on_slow_path = false;
+            error_continuation = nullptr;
+            transition_to_slow_path_timer.Stop();
+            reply_consensus_view = 0;
+            sent_confirms = false;
+        }
     };
 
     uint64_t lastReqId;
-    std::unordered_map<uint64_t, PendingRequest *> pendingReqs;
+    RequestPool<PendingUnloggedRequest> pendingUnloggedReqs;
+    RequestPool<PendingInconsistentRequest> pendingInconsistentReqs;
+    RequestPool<PendingConsensusRequest> pendingConsensusReqs;
 
-    void SendInconsistent(const PendingInconsistentRequest *req);
+    void SendInconsistent(PendingInconsistentRequest *req);
     void ResendInconsistent(const uint64_t reqId);
-    void SendConsensus(const PendingConsensusRequest *req);
+    void SendConsensus(PendingConsensusRequest *req);
     void ResendConsensus(const uint64_t reqId);
 
     // `TransitionToConsensusSlowPath` is called after a timeout to end the
@@ -191,10 +222,10 @@ protected:
     //      decide to determine the final result.
     //
     // In either case, HandleSlowPathConsensus intitiates the finalize phase of
-    // a consensus request.
+    // a consensus request. The replies considered are those in view.
     void HandleSlowPathConsensus(
         const uint64_t reqid,
-        const std::map<int, proto::ReplyConsensusMessage> &msgs,
+        const view_t view,
         const bool finalized_result_found,
         PendingConsensusRequest *req);
 
@@ -208,7 +239,7 @@ protected:
     // user.
     void HandleFastPathConsensus(
         const uint64_t reqid,
-        const std::map<int, proto::ReplyConsensusMessage> &msgs,
+        const view_t view,
         PendingConsensusRequest *req);
 
     void ResendConfirmation(const uint64_t reqId, bool isConsensus);
@@ -33,32 +33,98 @@
 #include <utility>
 
 #include "lib/assert.h"
+#include "lib/hash.h"
 
 namespace replication {
 namespace ir {
 
-Record::Record(const proto::RecordProto &record_proto) {
+namespace {
+
+RecordEntry
+EntryFromProto(const proto::RecordEntryProto &entry_proto)
+{
+    const view_t view = entry_proto.view();
+    const opid_t opid = std::make_pair(entry_proto.opid().clientid(),
+                                       entry_proto.opid().clientreqid());
+    Request request;
+    request.set_op(entry_proto.op());
+    request.set_clientid(entry_proto.opid().clientid());
+    request.set_clientreqid(entry_proto.opid().clientreqid());
+    return RecordEntry(view, opid, entry_proto.state(), entry_proto.type(),
+                       request, entry_proto.result());
+}
+
+void
+EntryToProto(const RecordEntry &entry, proto::RecordEntryProto *entry_proto)
+{
+    entry_proto->set_view(entry.view);
+    entry_proto->mutable_opid()->set_clientid(entry.opid.first);
+    entry_proto->mutable_opid()->set_clientreqid(entry.opid.second);
+    entry_proto->set_state(entry.state);
+    entry_proto->set_type(entry.type);
+    entry_proto->set_op(entry.request.op());
+    entry_proto->set_result(entry.result);
+}
+
+// Digests are only used to detect that two replicas' checkpoints have
+// diverged, so a fast non-cryptographic hash is enough. Each entry is hashed
+// with lookup3 and folded into a 64-bit FNV-style accumulator.
+const uint64_t EMPTY_DIGEST = 14695981039346656037ULL;
+
+uint64_t
+AccumulateDigest(uint64_t digest, const RecordEntry &entry)
+{
+    const uint64_t fixed[] = {entry.view, entry.opid.first, entry.opid.second,
+                              (uint64_t)entry.state, (uint64_t)entry.type};
+    uint32_t h = hash(fixed, sizeof(fixed), 0);
+    h = hash(entry.request.op().data(), entry.request.op().size(), h);
+    h = hash(entry.result.data(), entry.result.size(), h);
+    return (digest ^ h) * 1099511628211ULL;
+}
+
+} // namespace
+
+Record::Record() : checkpoint_digest(EMPTY_DIGEST), checkpoint_empty(true) { }
+
+Record::Record(const proto::RecordProto &record_proto) : Record() {
     for (const proto::RecordEntryProto &entry_proto : record_proto.entry()) {
-        const view_t view = entry_proto.view();
-        const opid_t opid = std::make_pair(entry_proto.opid().clientid(),
-                                     entry_proto.opid().clientreqid());
-        Request request;
-        request.set_op(entry_proto.op());
-        request.set_clientid(entry_proto.opid().clientid());
-        request.set_clientreqid(entry_proto.opid().clientreqid());
-        proto::RecordEntryState state = entry_proto.state();
-        proto::RecordEntryType type = entry_proto.type();
-        const std::string& result = entry_proto.result();
-        Add(view, opid, request, state, type, result);
+        Add(EntryFromProto(entry_proto));
+    }
+}
+
+void
+Record::MarkModified(opid_t opid)
+{
+    if (checkpoint_empty) {
+        return;
+    }
+
+    if (!modified.insert(opid).second) {
+        // Already modified since the checkpoint; the checkpointed version (if
+        // any) has been saved.
+        return;
+    }
+
+    auto it = entries.find(opid);
+    if (it != entries.end()) {
+        checkpointed.insert(*it);
     }
 }
 
 RecordEntry &
 Record::Add(const RecordEntry& entry) {
+    return Add(RecordEntry(entry));
+}
+
+RecordEntry &
+Record::Add(RecordEntry &&entry) {
     // Make sure this isn't a duplicate
     ASSERT(entries.count(entry.opid) == 0);
-    entries[entry.opid] = entry;
-    return entries[entry.opid];
+    MarkModified(entry.opid);
+    // Entries are usually added in opid order (e.g. when building a record
+    // from a proto or merging records), so hint at the end of the map.
+    const opid_t opid = entry.opid;
+    return entries.emplace_hint(entries.end(), opid, std::move(entry))->second;
 }
 
 RecordEntry &
@@ -73,20 +139,19 @@ Record::Add(view_t view, opid_t opid, const Request &request,
             proto::RecordEntryState state, proto::RecordEntryType type,
             const string &result)
 {
-    RecordEntry &entry = Add(view, opid, request, state, type);
-    entry.result = result;
-    return entries[opid];
+    return Add(RecordEntry(view, opid, state, type, request, result));
 }
 
 // This really ought to be const
 RecordEntry *
 Record::Find(opid_t opid)
 {
-    if (entries.empty() || entries.count(opid) == 0) {
+    auto it = entries.find(opid);
+    if (it == entries.end()) {
         return NULL;
     }
 
-    RecordEntry *entry = &entries[opid];
+    RecordEntry *entry = &it->second;
     ASSERT(entry->opid == opid);
     return entry;
 }
@@ -100,6 +165,7 @@ Record::SetStatus(opid_t op, proto::RecordEntryState state)
         return false;
     }
 
+    MarkModified(op);
     entry->state = state;
     return true;
 }
@@ -112,6 +178,7 @@ Record::SetResult(opid_t op, const string &result)
         return false;
     }
 
+    MarkModified(op);
     entry->result = result;
     return true;
 }
@@ -124,6 +191,7 @@ Record::SetRequest(opid_t op, const Request &req)
         return false;
     }
 
+    MarkModified(op);
     entry->request = req;
     return true;
 }
@@ -131,6 +199,10 @@ Record::SetRequest(opid_t op, const Request &req)
 void
 Record::Remove(opid_t opid)
 {
+    if (entries.count(opid) == 0) {
+        return;
+    }
+    MarkModified(opid);
     entries.erase(opid);
 }
 
@@ -144,16 +216,7 @@ void
 Record::ToProto(proto::RecordProto *proto) const
 {
     for (const std::pair<const opid_t, RecordEntry> &p : entries) {
-        const RecordEntry &entry = p.second;
-        proto::RecordEntryProto *entry_proto = proto->add_entry();
-
-        entry_proto->set_view(entry.view);
-        entry_proto->mutable_opid()->set_clientid(entry.opid.first);
-        entry_proto->mutable_opid()->set_clientreqid(entry.opid.second);
-        entry_proto->set_state(entry.state);
-        entry_proto->set_type(entry.type);
-        entry_proto->set_op(entry.request.op());
-        entry_proto->set_result(entry.result);
+        EntryToProto(p.second, proto->add_entry());
     }
 }
 
@@ -161,5 +224,154 @@ const std::map<opid_t, RecordEntry> &Record::Entries() const {
     return entries;
 }
 
+std::map<opid_t, RecordEntry>
+Record::ReleaseEntries()
+{
+    std::map<opid_t, RecordEntry> released;
+    std::swap(released, entries);
+    modified.clear();
+    checkpointed.clear();
+    checkpoint_digest = EMPTY_DIGEST;
+    checkpoint_empty = true;
+    return released;
+}
+
+void
+Record::Checkpoint()
+{
+    modified.clear();
+    checkpointed.clear();
+    checkpoint_empty = entries.empty();
+
+    checkpoint_digest = EMPTY_DIGEST;
+    for (const std::pair<const opid_t, RecordEntry> &p : entries) {
+        checkpoint_digest = AccumulateDigest(checkpoint_digest, p.second);
+    }
+}
+
+uint64_t
+Record::CheckpointDigest() const
+{
+    return checkpoint_digest;
+}
+
+const RecordEntry *
+Record::FindCheckpointed(opid_t opid) const
+{
+    if (checkpoint_empty) {
+        return NULL;
+    }
+
+    if (modified.count(opid) == 0) {
+        auto it = entries.find(opid);
+        return it == entries.end() ? NULL : &it->second;
+    }
+
+    auto it = checkpointed.find(opid);
+    return it == checkpointed.end() ? NULL : &it->second;
+}
+
+void
+Record::DeltaToProto(proto::RecordProto *proto) const
+{
+    proto->set_checkpoint_digest(checkpoint_digest);
+    if (checkpoint_empty) {
+        ToProto(proto);
+        return;
+    }
+
+    for (const opid_t &opid : modified) {
+        auto it = entries.find(opid);
+        if (it != entries.end()) {
+            EntryToProto(it->second, proto->add_entry());
+        } else {
+            proto::OpID *removed = proto->add_removed();
+            removed->set_clientid(opid.first);
+            removed->set_clientreqid(opid.second);
+        }
+    }
+}
+
+void
+Record::DeltaToProto(const Record &base, proto::RecordProto *proto) const
+{
+    proto->set_checkpoint_digest(base.checkpoint_digest);
+    for (const std::pair<const opid_t, RecordEntry> &p : entries) {
+        const RecordEntry &entry = p.second;
+        const RecordEntry *old = base.FindCheckpointed(p.first);
+        if (old == NULL || old->view != entry.view ||
+            old->state != entry.state || old->type != entry.type ||
+            old->request.op() != entry.request.op() ||
+            old->result != entry.result) {
+            EntryToProto(entry, proto->add_entry());
+        }
+    }
+
+    auto removed = [&](const opid_t &opid) {
+        if (entries.count(opid) == 0) {
+            proto::OpID *opid_proto = proto->add_removed();
+            opid_proto->set_clientid(opid.first);
+            opid_proto->set_clientreqid(opid.second);
+        }
+    };
+    if (base.checkpoint_empty) {
+        return;
+    }
+    for (const std::pair<const opid_t, RecordEntry> &p : base.entries) {
+        if (base.modified.count(p.first) == 0) {
+            removed(p.first);
+        }
+    }
+    for (const std::pair<const opid_t, RecordEntry> &p : base.checkpointed) {
+        removed(p.first);
+    }
+}
+
+void
+Record::CheckpointToProto(proto::RecordProto *proto) const
+{
+    if (checkpoint_empty) {
+        return;
+    }
+
+    for (const std::pair<const opid_t, RecordEntry> &p : entries) {
+        if (modified.count(p.first) == 0) {
+            EntryToProto(p.second, proto->add_entry());
+        }
+    }
+    for (const std::pair<const opid_t, RecordEntry> &p : checkpointed) {
+        EntryToProto(p.second, proto->add_entry());
+    }
+}
+
+Record
+Record::ApplyDelta(const proto::RecordProto &delta) const
+{
+    ASSERT(delta.has_checkpoint_digest() &&
+           delta.checkpoint_digest() == checkpoint_digest);
+
+    // Start from our checkpoint...
+    Record r;
+    if (!checkpoint_empty) {
+        for (const std::pair<const opid_t, RecordEntry> &p : entries) {
+            if (modified.count(p.first) == 0) {
+                r.entries.emplace_hint(r.entries.end(), p);
+            }
+        }
+        r.entries.insert(checkpointed.begin(), checkpointed.end());
+    }
+
+    // ...and replay the peer's changes on top of it.
+    for (const proto::OpID &opid : delta.removed()) {
+        r.entries.erase(std::make_pair(opid.clientid(), opid.clientreqid()));
+    }
+    for (const proto::RecordEntryProto &entry_proto : delta.entry()) {
+        RecordEntry entry = EntryFromProto(entry_proto);
+        const opid_t opid = entry.opid;
+        r.entries[opid] = std::move(entry);
+    }
+    return r;
+}
+
 } // namespace ir
 } // namespace replication
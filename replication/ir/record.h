@@ -32,6 +32,7 @@
 #define _IR_RECORD_H_
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -64,6 +65,15 @@ struct RecordEntry
           type(x.type),
           request(x.request),
           result(x.result) {}
+    RecordEntry(RecordEntry &&x)
+        : view(x.view),
+          opid(x.opid),
+          state(x.state),
+          type(x.type),
+          request(std::move(x.request)),
+          result(std::move(x.result)) {}
+    RecordEntry &operator=(const RecordEntry &x) = default;
+    RecordEntry &operator=(RecordEntry &&x) = default;
     RecordEntry(view_t view, opid_t opid, proto::RecordEntryState state,
                 proto::RecordEntryType type, const Request &request,
                 const std::string &result)
@@ -83,7 +93,7 @@ public:
     // [1]. We make it non-copyable to avoid unnecessary copies.
     //
     // [1]: https://stackoverflow.com/a/3279550/3187068
-    Record(){};
+    Record();
     Record(const proto::RecordProto &record_proto);
     Record(Record &&other) : Record() { swap(*this, other); }
     Record(const Record &) = delete;
@@ -94,9 +104,14 @@ public:
     }
     friend void swap(Record &x, Record &y) {
         std::swap(x.entries, y.entries);
+        std::swap(x.modified, y.modified);
+        std::swap(x.checkpointed, y.checkpointed);
+        std::swap(x.checkpoint_digest, y.checkpoint_digest);
+        std::swap(x.checkpoint_empty, y.checkpoint_empty);
     }
 
     RecordEntry &Add(const RecordEntry& entry);
+    RecordEntry &Add(RecordEntry &&entry);
     RecordEntry &Add(view_t view, opid_t opid, const Request &request,
                      proto::RecordEntryState state,
                      proto::RecordEntryType type);
@@ -111,9 +126,44 @@ public:
     bool Empty() const;
     void ToProto(proto::RecordProto *proto) const;
     const std::map<opid_t, RecordEntry> &Entries() const;
+    // Moves all entries out of the record, leaving it empty.
+    std::map<opid_t, RecordEntry> ReleaseEntries();
+
+    // A checkpoint is a snapshot of the record that other replicas are known
+    // to share, e.g. the master record installed at the end of a view change.
+    // After a checkpoint, the record only needs to ship the entries that were
+    // added, modified, or removed since then (its delta), along with the
+    // checkpoint's digest so the receiver can detect that its own checkpoint
+    // has diverged.
+    void Checkpoint();
+    uint64_t CheckpointDigest() const;
+    // Returns the entry for opid as it was at the last checkpoint, or NULL if
+    // there was no such entry.
+    const RecordEntry *FindCheckpointed(opid_t opid) const;
+    void DeltaToProto(proto::RecordProto *proto) const;
+    // Like DeltaToProto, but computes the delta of this record against the
+    // last checkpoint of base.
+    void DeltaToProto(const Record &base, proto::RecordProto *proto) const;
+    void CheckpointToProto(proto::RecordProto *proto) const;
+    // Reconstructs a peer's record from a delta computed against our last
+    // checkpoint. The caller must first check that the delta's
+    // checkpoint_digest matches CheckpointDigest().
+    Record ApplyDelta(const proto::RecordProto &delta) const;
 
 private:
     std::map<opid_t, RecordEntry> entries;
+
+    // Opids of the entries added, modified, or removed since the last
+    // checkpoint, and the checkpointed version of those that existed then.
+    // If the checkpoint is empty, every entry is new and none of this is
+    // tracked.
+    std::set<opid_t> modified;
+    std::map<opid_t, RecordEntry> checkpointed;
+    uint64_t checkpoint_digest;
+    bool checkpoint_empty;
+
+    // Must be called before entry opid is added, changed, or removed.
+    void MarkModified(opid_t opid);
 };
 
 }      // namespace ir
@@ -18,6 +18,14 @@ namespace ir {
 using namespace std;
 using namespace proto;
 
+// START-VIEW records, and whole records resent in DO-VIEW-CHANGE messages,
+// are streamed in chunks of roughly RECORD_CHUNK_BYTES, with at most
+// RECORD_STREAM_WINDOW chunks per replica unacknowledged at a time.
+// Unacknowledged chunks are resent every RECORD_RETRANSMIT_MS.
+static const std::size_t RECORD_CHUNK_BYTES = 32 * 1024;
+static const std::size_t RECORD_STREAM_WINDOW = 16;
+static const uint64_t RECORD_RETRANSMIT_MS = 100;
+
 IRReplica::IRReplica(transport::Configuration config, int myIdx,
                      Transport *transport, IRAppReplica *app)
     : config(std::move(config)), myIdx(myIdx), transport(transport), app(app),
@@ -28,7 +36,8 @@ IRReplica::IRReplica(transport::Configuration config, int myIdx,
                            std::to_string(myIdx) + ".bin"),
       // Note that a leader waits for DO-VIEW-CHANGE messages from f other
       // replicas (as opposed to f + 1) for a total of f + 1 replicas.
-      do_view_change_quorum(config.f)
+      do_view_change_quorum(config.f),
+      next_record_stream(1)
 {
     transport->Register(this, config, myIdx);
 
@@ -81,6 +90,8 @@ IRReplica::HandleMessage(const TransportAddress &remote,
     UnloggedRequestMessage unloggedRequest;
     DoViewChangeMessage doViewChange;
     StartViewMessage startView;
+    RecordRequestMessage recordRequest;
+    RecordChunkAckMessage recordChunkAck;
 
     if (type == proposeInconsistent.GetTypeName()) {
         proposeInconsistent.ParseFromString(data);
@@ -103,6 +114,12 @@ IRReplica::HandleMessage(const TransportAddress &remote,
     } else if (type == unloggedRequest.GetTypeName()) {
         unloggedRequest.ParseFromString(data);
         HandleUnlogged(remote, unloggedRequest);
+    } else if (type == recordRequest.GetTypeName()) {
+        recordRequest.ParseFromString(data);
+        HandleRecordRequest(remote, recordRequest);
+    } else if (type == recordChunkAck.GetTypeName()) {
+        recordChunkAck.ParseFromString(data);
+        HandleRecordChunkAck(remote, recordChunkAck);
     } else {
         Panic("Received unexpected message type in IR proto: %s",
               type.c_str());
@@ -244,7 +261,7 @@ IRReplica::HandleFinalizeConsensus(const TransportAddress &remote,
 
         if (msg.result() != entry->result) {
             // Update the result
-            entry->result = msg.result();
+            record.SetResult(opid, msg.result());
         }
 
         // Send the reply
@@ -298,6 +315,7 @@ IRReplica::HandleDoViewChange(const TransportAddress &remote,
         // Update and persist our view.
         view = msg.new_view();
         PersistViewInfo();
+        record_streams.clear();
 
         // Update our status. If we're NORMAL, then we transition into
         // VIEW_CHANGE.  If we're VIEW_CHANGE or RECOVERING, we want to stay in
@@ -326,44 +344,102 @@ IRReplica::HandleDoViewChange(const TransportAddress &remote,
 
     // Replicas should send their records to the leader.
     ASSERT(msg.has_record());
+
+    // A whole record resent at our request arrives in chunks. Acknowledge
+    // each, and go on once we have them all.
+    DoViewChangeMessage whole;
+    const DoViewChangeMessage *dvc = &msg;
+    if (msg.has_stream()) {
+        IncomingRecord &in = incoming_do_view_changes[msg.replicaidx()];
+        if (!AddRecordChunk(in, msg.new_view(), msg.stream(), msg.chunk(),
+                            msg.num_chunks(), msg.record())) {
+            return;
+        }
+        RecordChunkAckMessage ack;
+        ack.set_replicaidx(myIdx);
+        ack.set_new_view(msg.new_view());
+        ack.set_stream(msg.stream());
+        ack.set_chunk(msg.chunk());
+        if (!transport->SendMessage(this, remote, ack)) {
+            Warning("Could not send RecordChunkAckMessage to replica %d.",
+                    msg.replicaidx());
+        }
+        if (in.chunks.size() < msg.num_chunks()) {
+            return;
+        }
+
+        whole.set_replicaidx(msg.replicaidx());
+        whole.set_new_view(msg.new_view());
+        whole.set_latest_normal_view(msg.latest_normal_view());
+        TakeRecord(in, whole.mutable_record());
+        dvc = &whole;
+    }
+
     const std::map<int, DoViewChangeMessage> *quorum =
-        do_view_change_quorum.AddAndCheckForQuorum(msg.new_view(),
-                                                   msg.replicaidx(), msg);
+        do_view_change_quorum.AddAndCheckForQuorum(dvc->new_view(),
+                                                   dvc->replicaidx(), *dvc);
     if (quorum == nullptr) {
         // There is no quorum yet.
         return;
     }
+
+    // Peers send their records as deltas against their last checkpoint. If a
+    // peer that takes part in the merge has a different checkpoint than we
+    // do, we can't reconstruct its record, so ask it for the whole record and
+    // wait for it to arrive.
+    view_t max_latest_normal_view = latest_normal_view;
+    for (const std::pair<const int, DoViewChangeMessage> &p : *quorum) {
+        max_latest_normal_view =
+            std::max(max_latest_normal_view, p.second.latest_normal_view());
+    }
+    bool missing_records = false;
+    for (const std::pair<const int, DoViewChangeMessage> &p : *quorum) {
+        const DoViewChangeMessage &dvc = p.second;
+        if (dvc.latest_normal_view() == max_latest_normal_view &&
+            dvc.record().has_checkpoint_digest() &&
+            dvc.record().checkpoint_digest() != record.CheckpointDigest()) {
+            Debug("Checkpoint of replica %d diverges from ours. Requesting "
+                  "its full record.", p.first);
+            RecordRequestMessage request;
+            request.set_replicaidx(myIdx);
+            request.set_new_view(view);
+            if (!transport->SendMessageToReplica(this, p.first, request)) {
+                Warning("Could not send RecordRequestMessage to replica %d.",
+                        p.first);
+            }
+            missing_records = true;
+        }
+    }
+    if (missing_records) {
+        return;
+    }
+
     Debug("Received a quourum of DoViewChangeMessages. Initiating "
           "IR-MERGE-RECORDS.");
 
-    // Update our record, status, and view.
-    record = IrMergeRecords(*quorum);
+    // Update our status and view.
+    Record merged = IrMergeRecords(*quorum);
     status = STATUS_NORMAL;
     view = msg.new_view();
     latest_normal_view = view;
     PersistViewInfo();
 
-    // Notify all replicas of the new view.
-    StartViewMessage start_view_msg;
-    record.ToProto(start_view_msg.mutable_record());
-    start_view_msg.set_new_view(view);
-    // TODO: Don't send this message to myself. It's not incorrect, but it's
-    // unnecessary.
-    // TODO: Acknowledge StartViewMessage messages, and rebroadcast them after
-    // a timeout.
-    Debug("Sending StartViewMessages to all replicas.");
-    bool success = transport->SendMessageToAll(this, start_view_msg);
-    if (!success) {
-        Warning("Could not send StartViewMessage.");
-    }
+    // Notify all replicas of the new view. This must happen before we
+    // replace our record, since the deltas are computed against its
+    // checkpoint.
+    BroadcastStartViewMessages(merged, *quorum);
+    record = std::move(merged);
+    record.Checkpoint();
+    incoming_do_view_changes.clear();
 }
 
 void
 IRReplica::HandleStartView(const TransportAddress &remote,
                            const proto::StartViewMessage &msg)
 {
-    Debug("Received StartViewMessage with new_view = %" PRIu64 ".",
-          msg.new_view());
+    Debug("Received StartViewMessage with new_view = %" PRIu64
+          ", chunk %u/%u of stream %" PRIu64 ".",
+          msg.new_view(), msg.chunk() + 1, msg.num_chunks(), msg.stream());
 
     // A leader should not be sending START-VIEW messages to themselves.
     ASSERT(myIdx != config.GetLeaderIndex(msg.new_view()));
@@ -374,26 +450,110 @@ IRReplica::HandleStartView(const TransportAddress &remote,
         return;
     }
 
+    RecordChunkAckMessage ack;
+    ack.set_replicaidx(myIdx);
+    ack.set_new_view(msg.new_view());
+    ack.set_stream(msg.stream());
+    ack.set_chunk(msg.chunk());
+
     // If new_view == view and we're NORMAL, then we've already completed this
-    // view change, and we don't want to do it again.
+    // view change, and we don't want to do it again. The leader may have
+    // missed our acknowledgement though, so send it again.
     if (msg.new_view() == view && status == STATUS_NORMAL) {
         Debug("Ignoring START-VIEW for view %" PRIu64
               " because our status is NORMAL.",
               view);
+        if (!transport->SendMessage(this, remote, ack)) {
+            Warning("Could not send RecordChunkAckMessage to leader.");
+        }
         return;
     }
 
     ASSERT((msg.new_view() >= view) ||
            (msg.new_view() == view && status != STATUS_NORMAL));
 
-    // Throw away our record for the new master record and call sync.
-    record = Record(msg.record());
+    if (!AddRecordChunk(incoming_start_view, msg.new_view(), msg.stream(),
+                        msg.chunk(), msg.num_chunks(), msg.record())) {
+        return;
+    }
+    if (!transport->SendMessage(this, remote, ack)) {
+        Warning("Could not send RecordChunkAckMessage to leader.");
+    }
+    if (incoming_start_view.chunks.size() < msg.num_chunks()) {
+        return;
+    }
+
+    // We have the whole stream.
+    RecordProto master_record;
+    TakeRecord(incoming_start_view, &master_record);
+    InstallStartView(remote, msg.new_view(), master_record);
+}
+
+bool
+IRReplica::AddRecordChunk(IncomingRecord &in, view_t new_view,
+                          uint64_t stream, uint32_t chunk,
+                          uint32_t num_chunks, const RecordProto &record)
+{
+    // Chunks of a newer stream replace those we have collected so far, and
+    // chunks of an older one are stale.
+    if (new_view < in.view || (new_view == in.view && stream < in.stream)) {
+        Debug("Ignoring stale record chunk.");
+        return false;
+    }
+    if (new_view > in.view || stream > in.stream) {
+        in.view = new_view;
+        in.stream = stream;
+        in.chunks.clear();
+    }
+    if (chunk >= num_chunks) {
+        Warning("Received record chunk %u of %u.", chunk, num_chunks);
+        return false;
+    }
+
+    in.chunks.insert(std::make_pair(chunk, record));
+    return true;
+}
+
+void
+IRReplica::TakeRecord(IncomingRecord &in, RecordProto *record)
+{
+    for (const std::pair<const uint32_t, RecordProto> &p : in.chunks) {
+        record->MergeFrom(p.second);
+    }
+    in.chunks.clear();
+}
+
+void
+IRReplica::InstallStartView(const TransportAddress &remote, view_t new_view,
+                            const proto::RecordProto &master_record)
+{
+    // Throw away our record for the new master record and call sync. If the
+    // leader sent a delta against a checkpoint we don't share, ask for the
+    // whole record instead.
+    if (master_record.has_checkpoint_digest()) {
+        if (master_record.checkpoint_digest() != record.CheckpointDigest()) {
+            Debug("Cannot apply START-VIEW delta for view %" PRIu64
+                  ". Requesting the full record.", new_view);
+            RecordRequestMessage request;
+            request.set_replicaidx(myIdx);
+            request.set_new_view(new_view);
+            if (!transport->SendMessage(this, remote, request)) {
+                Warning("Could not send RecordRequestMessage to leader.");
+            }
+            return;
+        }
+        record = record.ApplyDelta(master_record);
+    } else {
+        record = Record(master_record);
+    }
+    record.Checkpoint();
     app->Sync(record.Entries());
 
     status = STATUS_NORMAL;
-    view = msg.new_view();
+    view = new_view;
     latest_normal_view = view;
     PersistViewInfo();
+    record_streams.clear();
 }
 
 void
@@ -412,6 +572,72 @@ IRReplica::HandleUnlogged(const TransportAddress &remote,
         Warning("Failed to send reply message");
 }
 
+void
+IRReplica::HandleRecordRequest(const TransportAddress &remote,
+                               const RecordRequestMessage &msg)
+{
+    Debug("Received RecordRequestMessage from replica %d for view %" PRIu64
+          ".", msg.replicaidx(), msg.new_view());
+
+    if (msg.new_view() != view) {
+        Debug("Ignoring RECORD-REQUEST for view %" PRIu64 " != %" PRIu64 ".",
+              msg.new_view(), view);
+        return;
+    }
+
+    if (myIdx == config.GetLeaderIndex(view)) {
+        // A replica could not apply our START-VIEW delta. Our checkpoint is
+        // still the master record of this view, so send it whole.
+        if (status != STATUS_NORMAL) {
+            return;
+        }
+        RecordProto full_record;
+        record.CheckpointToProto(&full_record);
+        StartRecordStream(msg.replicaidx(), true, ChunkRecord(full_record));
+    } else {
+        // The leader could not apply our DO-VIEW-CHANGE delta.
+        if (status == STATUS_NORMAL) {
+            return;
+        }
+        RecordProto full_record;
+        record.ToProto(&full_record);
+        StartRecordStream(msg.replicaidx(), false, ChunkRecord(full_record));
+    }
+}
+
+void
+IRReplica::HandleRecordChunkAck(const TransportAddress &remote,
+                                const RecordChunkAckMessage &msg)
+{
+    auto it = record_streams.find(msg.replicaidx());
+    if (msg.new_view() != view || it == record_streams.end() ||
+        msg.stream() != it->second.stream ||
+        msg.chunk() >= it->second.acked.size()) {
+        Debug("Ignoring RecordChunkAckMessage from replica %d for view %"
+              PRIu64 ".", msg.replicaidx(), msg.new_view());
+        return;
+    }
+
+    OutgoingRecord &out = it->second;
+    if (out.acked[msg.chunk()]) {
+        return;
+    }
+    out.acked[msg.chunk()] = true;
+    out.num_acked++;
+
+    if (out.num_acked == out.acked.size()) {
+        Debug("Replica %d received all of %s for view %" PRIu64 ".",
+              msg.replicaidx(),
+              out.start_view ? "START-VIEW" : "DO-VIEW-CHANGE", view);
+        record_streams.erase(it);
+        return;
+    }
+
+    // The stream is making progress, so hold off on retransmitting.
+    out.retransmit_timeout->Reset();
+    SendRecordChunks(msg.replicaidx(), false);
+}
+
 void IRReplica::HandleViewChangeTimeout() {
     Debug("HandleViewChangeTimeout fired.");
     if (status == STATUS_NORMAL) {
@@ -419,9 +645,15 @@ void IRReplica::HandleViewChangeTimeout() {
     }
     ++view;
     PersistViewInfo();
+    record_streams.clear();
     BroadcastDoViewChangeMessages();
 }
 
+void IRReplica::HandleRecordStreamTimeout(int replicaIdx) {
+    Debug("Retransmitting record chunks to replica %d.", replicaIdx);
+    SendRecordChunks(replicaIdx, true);
+}
+
 void IRReplica::PersistViewInfo() {
     PersistedViewInfo view_info;
     view_info.set_view(view);
@@ -466,8 +698,8 @@ void IRReplica::BroadcastDoViewChangeMessages() {
 
     // Send a DoViewChangeMessage _with_ our record to the leader (unless we
     // are the leader).
-    record.ToProto(msg.mutable_record());
     if (leader_idx != myIdx) {
+        record.DeltaToProto(msg.mutable_record());
         bool success = transport->SendMessageToReplica(this, leader_idx, msg);
         if (!success) {
             Warning("Could not send DoViewChangeMessage to leader %d.",
@@ -476,14 +708,155 @@ void IRReplica::BroadcastDoViewChangeMessages() {
     }
 }
 
+void
+IRReplica::BroadcastStartViewMessages(
+    const Record &merged, const std::map<int, DoViewChangeMessage> &records)
+{
+    std::shared_ptr<const std::vector<RecordProto>> full_chunks;
+    std::shared_ptr<const std::vector<RecordProto>> delta_chunks;
+
+    Debug("Sending StartViewMessages to all replicas.");
+    for (int i = 0; i < config.n; ++i) {
+        if (i == myIdx) {
+            continue;
+        }
+
+        auto it = records.find(i);
+        const bool shares_checkpoint =
+            it != records.end() &&
+            it->second.record().has_checkpoint_digest() &&
+            it->second.record().checkpoint_digest() ==
+                record.CheckpointDigest();
+
+        if (shares_checkpoint) {
+            if (!delta_chunks) {
+                RecordProto delta;
+                merged.DeltaToProto(record, &delta);
+                delta_chunks = ChunkRecord(delta);
+            }
+            StartRecordStream(i, true, delta_chunks);
+        } else {
+            if (!full_chunks) {
+                RecordProto full;
+                merged.ToProto(&full);
+                full_chunks = ChunkRecord(full);
+            }
+            StartRecordStream(i, true, full_chunks);
+        }
+    }
+}
+
+std::shared_ptr<const std::vector<RecordProto>>
+IRReplica::ChunkRecord(const RecordProto &whole) const
+{
+    auto chunks = std::make_shared<std::vector<RecordProto>>();
+    std::size_t bytes = RECORD_CHUNK_BYTES;
+    auto next_chunk = [&](std::size_t size) {
+        if (bytes >= RECORD_CHUNK_BYTES) {
+            chunks->emplace_back();
+            if (whole.has_checkpoint_digest()) {
+                chunks->back().set_checkpoint_digest(
+                    whole.checkpoint_digest());
+            }
+            bytes = 0;
+        }
+        bytes += size;
+        return &chunks->back();
+    };
+
+    for (const OpID &opid : whole.removed()) {
+        *next_chunk(opid.ByteSizeLong())->add_removed() = opid;
+    }
+    for (const RecordEntryProto &entry : whole.entry()) {
+        *next_chunk(entry.ByteSizeLong())->add_entry() = entry;
+    }
+    // An empty record still takes one chunk.
+    if (chunks->empty()) {
+        next_chunk(0);
+    }
+    return chunks;
+}
+
+void
+IRReplica::StartRecordStream(
+    int replicaIdx, bool start_view,
+    std::shared_ptr<const std::vector<RecordProto>> chunks)
+{
+    OutgoingRecord &out = record_streams[replicaIdx];
+    out.stream = next_record_stream++;
+    out.start_view = start_view;
+    out.chunks = std::move(chunks);
+    out.acked.assign(out.chunks->size(), false);
+    out.num_acked = 0;
+    out.next = 0;
+    if (!out.retransmit_timeout) {
+        out.retransmit_timeout = std::unique_ptr<Timeout>(
+            new Timeout(transport, RECORD_RETRANSMIT_MS,
+                        [this, replicaIdx]() {
+                            this->HandleRecordStreamTimeout(replicaIdx);
+                        }));
+    }
+    out.retransmit_timeout->Start();
+
+    Debug("Streaming %s for view %" PRIu64 " to replica %d in %zu chunks.",
+          start_view ? "START-VIEW" : "DO-VIEW-CHANGE", view, replicaIdx,
+          out.chunks->size());
+    SendRecordChunks(replicaIdx, false);
+}
+
+void
+IRReplica::SendRecordChunks(int replicaIdx, bool retransmit)
+{
+    // The stream is dropped whenever our view changes, so its chunks are
+    // always sent for the current one.
+    OutgoingRecord &out = record_streams[replicaIdx];
+    auto send = [&](std::size_t i) {
+        bool sent;
+        if (out.start_view) {
+            StartViewMessage msg;
+            *msg.mutable_record() = (*out.chunks)[i];
+            msg.set_new_view(view);
+            msg.set_stream(out.stream);
+            msg.set_chunk(i);
+            msg.set_num_chunks(out.chunks->size());
+            sent = transport->SendMessageToReplica(this, replicaIdx, msg);
+        } else {
+            DoViewChangeMessage msg;
+            msg.set_replicaidx(myIdx);
+            *msg.mutable_record() = (*out.chunks)[i];
+            msg.set_new_view(view);
+            msg.set_latest_normal_view(latest_normal_view);
+            msg.set_stream(out.stream);
+            msg.set_chunk(i);
+            msg.set_num_chunks(out.chunks->size());
+            sent = transport->SendMessageToReplica(this, replicaIdx, msg);
+        }
+        if (!sent) {
+            Warning("Could not send record chunk to replica %d.", replicaIdx);
+        }
+    };
+
+    if (retransmit) {
+        for (std::size_t i = 0; i < out.next; ++i) {
+            if (!out.acked[i]) {
+                send(i);
+            }
+        }
+    }
+
+    // Every acknowledged chunk has been sent, so next - num_acked chunks are
+    // in flight.
+    while (out.next < out.chunks->size() &&
+           out.next - out.num_acked < RECORD_STREAM_WINDOW) {
+        send(out.next++);
+    }
+}
+
 Record
 IRReplica::IrMergeRecords(const std::map<int, DoViewChangeMessage>& records) {
-    // TODO: This implementation of IrMergeRecords is not the most efficient in
-    // the world. It could be optimized a bit if it happens to be a bottleneck.
-    // For example, Merge could take in pointers to the record entry vectors.
-
-    // Create a type alias to save some typing.
-    using RecordEntryVec = std::vector<RecordEntry>;
+    // Create some type aliases to save some typing.
+    using EntryMap = std::map<opid_t, RecordEntry>;
+    using RecordEntryPtrVec = std::vector<const RecordEntry *>;
 
     // Find the largest latest_normal_view.
     view_t max_latest_normal_view = latest_normal_view;
@@ -493,85 +866,123 @@ IRReplica::IrMergeRecords(const std::map<int, DoViewChangeMessage>& records) {
             std::max(max_latest_normal_view, msg.latest_normal_view());
     }
 
-    // Collect the records with largest latest_normal_view.
-    std::vector<Record> latest_records;
+    // Collect the records with largest latest_normal_view, reconstructing
+    // them from their deltas where necessary. The reconstructed records are
+    // ours to consume, so their entries are moved rather than copied below.
+    // Our own record is left intact since its checkpoint is needed to send
+    // START-VIEW deltas.
+    std::vector<EntryMap> peer_entries;
+    peer_entries.reserve(records.size());
     for (const std::pair<const int, DoViewChangeMessage>& p : records) {
         const DoViewChangeMessage& msg = p.second;
         if (msg.latest_normal_view() == max_latest_normal_view) {
             ASSERT(msg.has_record());
-            latest_records.push_back(Record(msg.record()));
+            if (msg.record().has_checkpoint_digest()) {
+                peer_entries.push_back(
+                    record.ApplyDelta(msg.record()).ReleaseEntries());
+            } else {
+                peer_entries.push_back(Record(msg.record()).ReleaseEntries());
+            }
         }
     }
+    std::vector<std::pair<EntryMap::iterator, EntryMap::iterator>> cursors;
+    for (EntryMap &entries : peer_entries) {
+        cursors.emplace_back(entries.begin(), entries.end());
+    }
+    EntryMap::const_iterator own_it = record.Entries().end();
+    const EntryMap::const_iterator own_end = record.Entries().end();
     if (latest_normal_view == max_latest_normal_view) {
-        latest_records.push_back(std::move(record));
+        own_it = record.Entries().begin();
     }
 
-    // Group together all the entries from all the records in latest_records.
-    // We'll use this to build d and u. Simultaneously populate R.
-    // TODO: Avoid redundant copies.
+    // All records are sorted by opid, so we group the versions of each
+    // operation with a single k-way merge over them, adding inconsistent and
+    // finalized operations to R and sorting tentative consensus operations
+    // into d and u as we go. Since opids come out in order, every insertion
+    // is at the end of its map.
     Record R;
-    std::map<opid_t, RecordEntryVec> entries_by_opid;
-    for (const Record &r : latest_records) {
-        for (const std::pair<const opid_t, RecordEntry> &p : r.Entries()) {
-            const opid_t &opid = p.first;
-            const RecordEntry &entry = p.second;
-            ASSERT(opid == entry.opid);
-
-            if (entry.type == RECORD_TYPE_INCONSISTENT) {
-                // TODO: Do we have to update the view here?
-                if (R.Find(opid) == nullptr) {
-                    R.Add(entry);
-                }
-            } else if (entry.state == RECORD_STATE_FINALIZED) {
-                // TODO: Do we have to update the view here?
-                if (R.Find(opid) == nullptr) {
-                    R.Add(entry);
-                }
-                entries_by_opid.erase(opid);
-            } else {
-                ASSERT(entry.type == RECORD_TYPE_CONSENSUS &&
-                       entry.state == RECORD_STATE_TENTATIVE);
-                // If R already contains this operation, then we don't group
-                // it.
-                if (R.Entries().count(entry.opid) == 0) {
-                    entries_by_opid[entry.opid].push_back(entry);
-                }
+    std::map<opid_t, RecordEntryPtrVec> d;
+    std::map<opid_t, RecordEntryPtrVec> u;
+    std::map<opid_t, std::string> majority_results_in_d;
+    RecordEntryPtrVec versions;
+    std::vector<RecordEntry *> movable;
+    const std::size_t majority = ceil(0.5 * config.f) + 1;
+    while (true) {
+        // Find the smallest opid we haven't grouped yet.
+        const opid_t *next = nullptr;
+        for (const auto &c : cursors) {
+            if (c.first != c.second &&
+                (next == nullptr || c.first->first < *next)) {
+                next = &c.first->first;
             }
         }
-    }
+        if (own_it != own_end && (next == nullptr || own_it->first < *next)) {
+            next = &own_it->first;
+        }
+        if (next == nullptr) {
+            break;
+        }
+        const opid_t opid = *next;
+
+        // Gather its versions, in the same order as the records.
+        versions.clear();
+        movable.clear();
+        for (auto &c : cursors) {
+            if (c.first != c.second && c.first->first == opid) {
+                versions.push_back(&c.first->second);
+                movable.push_back(&c.first->second);
+                ++c.first;
+            }
+        }
+        if (own_it != own_end && own_it->first == opid) {
+            versions.push_back(&own_it->second);
+            movable.push_back(nullptr);
+            ++own_it;
+        }
 
-    // Build d and u.
-    std::map<opid_t, RecordEntryVec> d;
-    std::map<opid_t, RecordEntryVec> u;
-    std::map<opid_t, std::string> majority_results_in_d;
-    for (const std::pair<const opid_t, RecordEntryVec> &p : entries_by_opid) {
-        const opid_t &opid = p.first;
-        const RecordEntryVec &entries = p.second;
-
-        // Count the frequency of each response.
-        std::map<std::string, std::size_t> result_counts;
-        for (const RecordEntry& entry : entries) {
-            result_counts[entry.result] += 1;
-        }
-
-        // Check if any response occurs ceil(f/2) + 1 times or more.
-        bool in_d = false;
-        std::string majority_result_in_d = "";
-        for (const std::pair<const std::string, std::size_t> &c :
-             result_counts) {
-            if (c.second >= ceil(0.5 * config.f) + 1) {
-                majority_result_in_d = c.first;
-                in_d = true;
+        // If any replica has an inconsistent or finalized version, it goes
+        // straight into R.
+        // TODO: Do we have to update the view here?
+        std::size_t settled = versions.size();
+        for (std::size_t i = 0; i < versions.size(); ++i) {
+            if (versions[i]->type == RECORD_TYPE_INCONSISTENT ||
+                versions[i]->state == RECORD_STATE_FINALIZED) {
+                settled = i;
                 break;
             }
         }
+        if (settled < versions.size()) {
+            if (movable[settled] != nullptr) {
+                R.Add(std::move(*movable[settled]));
+            } else {
+                R.Add(*versions[settled]);
+            }
+            continue;
+        }
 
-        // TODO: Avoid redundant copies.
-        if (in_d) {
-            d[opid] = entries;
-            majority_results_in_d[opid] = majority_result_in_d;
+        // Otherwise, check if any response occurs ceil(f/2) + 1 times or
+        // more. At most one response can, and there are at most f + 1
+        // versions, so comparing them pairwise is cheap.
+        const RecordEntry *majority_entry = nullptr;
+        for (std::size_t i = 0;
+             i < versions.size() && majority_entry == nullptr; ++i) {
+            std::size_t count = 0;
+            for (const RecordEntry *entry : versions) {
+                if (entry->result == versions[i]->result) {
+                    count++;
+                }
+            }
+            if (count >= majority) {
+                majority_entry = versions[i];
+            }
+        }
+
+        if (majority_entry != nullptr) {
+            d.emplace_hint(d.end(), opid, versions);
+            majority_results_in_d.emplace_hint(majority_results_in_d.end(),
+                                               opid, majority_entry->result);
         } else {
-            u[opid] = entries;
+            u.emplace_hint(u.end(), opid, versions);
         }
     }
 
@@ -589,25 +1000,25 @@ IRReplica::IrMergeRecords(const std::map<int, DoViewChangeMessage>& records) {
         ASSERT(d.count(opid) + u.count(opid) == 1);
     }
 
-    // Convert Merge results into a Record.
-    Record merged;
+    // R = R cup Merge results. The results, d and u are all sorted by opid,
+    // so we find each result's entries by walking d and u alongside them.
+    auto d_it = d.begin();
+    auto u_it = u.begin();
     for (std::pair<const opid_t, std::string> &p : results_by_opid) {
         const opid_t &opid = p.first;
         std::string &result = p.second;
 
-        const std::vector<RecordEntry> entries = entries_by_opid[opid];
-        ASSERT(records.size() > 0);
-        const RecordEntry &entry = entries[0];
+        const RecordEntry *entry;
+        if (d_it != d.end() && d_it->first == opid) {
+            entry = (d_it++)->second[0];
+        } else {
+            ASSERT(u_it != u.end() && u_it->first == opid);
+            entry = (u_it++)->second[0];
+        }
 
         // TODO: Is this view correct?
-        merged.Add(view, opid, entry.request, RECORD_STATE_FINALIZED,
-                   entry.type, std::move(result));
-    }
-
-    // R = R cup merged.
-    for (const std::pair<const opid_t, RecordEntry> &r : merged.Entries()) {
-        // TODO: Avoid copy.
-        R.Add(r.second);
+        R.Add(view, opid, entry->request, RECORD_STATE_FINALIZED,
+              entry->type, std::move(result));
     }
     return R;
 }
@@ -9,7 +9,9 @@
 #ifndef _IR_REPLICA_H_
 #define _IR_REPLICA_H_
 
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "lib/assert.h"
 #include "lib/configuration.h"
@@ -40,8 +42,8 @@ public:
     virtual void Sync(const std::map<opid_t, RecordEntry>& record) { };
     // Merge
     virtual std::map<opid_t, std::string> Merge(
-        const std::map<opid_t, std::vector<RecordEntry>> &d,
-        const std::map<opid_t, std::vector<RecordEntry>> &u,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &u,
         const std::map<opid_t, std::string> &majority_results_in_d) {
         return {};
     };
@@ -74,9 +76,14 @@ public:
                          const proto::StartViewMessage &msg);
     void HandleUnlogged(const TransportAddress &remote,
                         const proto::UnloggedRequestMessage &msg);
+    void HandleRecordRequest(const TransportAddress &remote,
+                             const proto::RecordRequestMessage &msg);
+    void HandleRecordChunkAck(const TransportAddress &remote,
+                              const proto::RecordChunkAckMessage &msg);
 
     // Timeout handlers.
     void HandleViewChangeTimeout();
+    void HandleRecordStreamTimeout(int replicaIdx);
 
 private:
     // Persist `view` and `latest_normal_view` to disk using
@@ -88,9 +95,38 @@ private:
     void RecoverViewInfo();
 
     // Broadcast DO-VIEW-CHANGE messages to all other replicas with our record
-    // included only in the message to the leader.
+    // included only in the message to the leader. The record is sent as a
+    // delta against our last checkpoint.
     void BroadcastDoViewChangeMessages();
 
+    // Send START-VIEW messages carrying the merged record to all other
+    // replicas. Replicas that told us they share our current checkpoint only
+    // get the delta of merged against it.
+    void BroadcastStartViewMessages(
+        const Record &merged,
+        const std::map<int, proto::DoViewChangeMessage> &records);
+
+    // Split a record into chunks small enough to be sent as single
+    // messages.
+    std::shared_ptr<const std::vector<proto::RecordProto>>
+    ChunkRecord(const proto::RecordProto &record) const;
+
+    // Stream chunks to replicaIdx as START-VIEW messages if start_view is
+    // set and as DO-VIEW-CHANGE messages otherwise, replacing any stream
+    // already sent to it.
+    void StartRecordStream(
+        int replicaIdx, bool start_view,
+        std::shared_ptr<const std::vector<proto::RecordProto>> chunks);
+
+    // Send the chunks of replicaIdx's stream that fit in its window,
+    // resending the unacknowledged ones first if retransmit is set.
+    void SendRecordChunks(int replicaIdx, bool retransmit);
+
+    // Replace our record with the master record of new_view, or ask the
+    // leader for the whole record if record is a delta we can't apply.
+    void InstallStartView(const TransportAddress &remote, view_t new_view,
+                          const proto::RecordProto &record);
+
     // IrMergeRecords implements Figure 5 of the TAPIR paper.
     Record IrMergeRecords(
         const std::map<int, proto::DoViewChangeMessage> &records);
@@ -109,6 +145,9 @@ private:
     view_t latest_normal_view;
     PersistentRegister persistent_view_info;
 
+    // Our record. It is checkpointed whenever we install the master record
+    // at the end of a view change, so that later view changes only need to
+    // exchange what happened since.
     Record record;
     std::unique_ptr<Timeout> view_change_timeout;
 
@@ -120,6 +159,45 @@ private:
     // v, we should be able to garbage collect all quorums for views less than
     // v.
     QuorumSet<view_t, proto::DoViewChangeMessage> do_view_change_quorum;
+
+    // The leader of a view streams START-VIEW messages to each replica in
+    // chunks, keeping a bounded window of them unacknowledged and
+    // retransmitting those until they are acknowledged. A replica asked
+    // for its whole record streams its DO-VIEW-CHANGE to the leader the
+    // same way.
+    struct OutgoingRecord {
+        uint64_t stream;
+        bool start_view;
+        std::shared_ptr<const std::vector<proto::RecordProto>> chunks;
+        std::vector<bool> acked;
+        std::size_t num_acked;
+        std::size_t next; // First chunk not sent yet.
+        std::unique_ptr<Timeout> retransmit_timeout;
+    };
+    std::map<int, OutgoingRecord> record_streams;
+    uint64_t next_record_stream;
+
+    // The chunks of a record stream we are receiving, by index.
+    struct IncomingRecord {
+        view_t view;
+        uint64_t stream;
+        std::map<uint32_t, proto::RecordProto> chunks;
+
+        IncomingRecord() : view(0), stream(0) { }
+    };
+    IncomingRecord incoming_start_view;
+    // As leader, the DO-VIEW-CHANGE streams we are receiving, by sender.
+    std::map<int, IncomingRecord> incoming_do_view_changes;
+
+    // Add a chunk to the stream in, starting over if it belongs to a newer
+    // stream. Returns false, and the chunk goes unacknowledged, if it
+    // belongs to an older stream or is out of range.
+    bool AddRecordChunk(IncomingRecord &in, view_t new_view, uint64_t stream,
+                        uint32_t chunk, uint32_t num_chunks,
+                        const proto::RecordProto &record);
+
+    // Reassemble the record of a complete stream into record.
+    void TakeRecord(IncomingRecord &in, proto::RecordProto *record);
 };
 
 } // namespace ir
@@ -1,6 +1,6 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
-GTEST_SRCS += $(d)ir-test.cc
+GTEST_SRCS += $(d)ir-test.cc $(d)record-test.cc
 
 $(d)ir-test: $(o)ir-test.o \
 	$(OBJS-ir-replica) $(OBJS-ir-client) \
@@ -8,3 +8,17 @@ $(d)ir-test: $(o)ir-test.o \
 	$(GTEST_MAIN)
 
 TEST_BINS += $(d)ir-test
+
+$(d)record-test: $(o)record-test.o \
+	$(OBJS-ir-replica) \
+	$(LIB-simtransport) \
+	$(GTEST_MAIN)
+
+TEST_BINS += $(d)record-test
+
+SRCS += $(d)merge-benchmark.cc
+
+$(d)merge-benchmark: $(o)merge-benchmark.o \
+	$(OBJS-ir-replica)
+
+BINS += $(d)merge-benchmark
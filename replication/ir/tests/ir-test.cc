@@ -46,6 +46,7 @@
 #include <vector>
 #include <set>
 #include <sstream>
+#include <tuple>
 #include <memory>
 
 using google::protobuf::Message;
@@ -59,9 +60,11 @@ class IRApp : public IRAppReplica {
     std::vector<string> *unloggedOps;
 
 public:
+    std::size_t synced;
+
     IRApp(std::vector<string> *i, std::vector<string> *c,
           std::vector<string> *u)
-        : iOps(i), cOps(c), unloggedOps(u) {}
+        : iOps(i), cOps(c), unloggedOps(u), synced(0) {}
 
     void ExecInconsistentUpcall(const string &req) {
         iOps->push_back(req);
@@ -76,6 +79,10 @@ public:
         unloggedOps->push_back(req);
         reply = "unlreply: " + req;
     }
+
+    void Sync(const std::map<opid_t, RecordEntry> &record) {
+        synced = record.size();
+    }
 };
 
 class IRTest : public  ::testing::Test
@@ -270,6 +277,104 @@ TEST_F(IRTest, UnloggedTimeout)
 }
 
 
+TEST_F(IRTest, StartViewRetransmission)
+{
+    // Build up records too large for a single START-VIEW message.
+    const std::size_t numOps = 32;
+    std::size_t sent = 1;
+    Client::continuation_t upcall =
+        [&](const string &req, const string &reply) {
+            if (sent < numOps) {
+                client->InvokeInconsistent(string(4096, 'a' + sent++ % 26),
+                                           upcall);
+            }
+        };
+    client->InvokeInconsistent(string(4096, 'a'), upcall);
+
+    // Drop the first transmission of every START-VIEW chunk to replica 2.
+    std::set<std::pair<uint64_t, uint32_t>> seen;
+    int dropped = 0;
+    transport.AddFilter(10, [&](TransportReceiver *src, int srcIdx,
+                                TransportReceiver *dst, int dstIdx,
+                                Message &m, uint64_t &delay) {
+        StartViewMessage *msg = dynamic_cast<StartViewMessage *>(&m);
+        if (msg == nullptr || dstIdx != 2) {
+            return true;
+        }
+        if (seen.insert(std::make_pair(msg->stream(), msg->chunk())).second) {
+            dropped++;
+            return false;
+        }
+        return true;
+    });
+
+    // The view change timeout fires after 10 seconds. Stop well before the
+    // next one, so the view change must complete by retransmission.
+    transport.Timer(15000, [&]() {
+        transport.CancelAllTimers();
+    });
+    transport.Run();
+
+    EXPECT_GT(dropped, 1);
+    for (int i = 0; i < config->n; i++) {
+        EXPECT_EQ(numOps, iOps[i].size());
+        EXPECT_EQ(numOps, apps[i]->synced);
+    }
+}
+
+TEST_F(IRTest, DoViewChangeRecordRetransmission)
+{
+    // Build up records too large for a single DO-VIEW-CHANGE message.
+    const std::size_t numOps = 32;
+    std::size_t sent = 1;
+    Client::continuation_t upcall =
+        [&](const string &req, const string &reply) {
+            if (sent < numOps) {
+                client->InvokeInconsistent(string(4096, 'a' + sent++ % 26),
+                                           upcall);
+            }
+        };
+    client->InvokeInconsistent(string(4096, 'a'), upcall);
+
+    // Make the leader of the next view unable to apply the record deltas
+    // it is sent, so it asks for the whole records, and drop the first
+    // transmission of every chunk of them.
+    std::set<std::tuple<int, uint64_t, uint32_t>> seen;
+    int dropped = 0;
+    transport.AddFilter(10, [&](TransportReceiver *src, int srcIdx,
+                                TransportReceiver *dst, int dstIdx,
+                                Message &m, uint64_t &delay) {
+        DoViewChangeMessage *msg = dynamic_cast<DoViewChangeMessage *>(&m);
+        if (msg == nullptr || !msg->has_record()) {
+            return true;
+        }
+        if (!msg->has_stream()) {
+            msg->mutable_record()->set_checkpoint_digest(
+                msg->record().checkpoint_digest() + 1);
+            return true;
+        }
+        if (seen.insert(std::make_tuple(srcIdx, msg->stream(),
+                                        msg->chunk())).second) {
+            dropped++;
+            return false;
+        }
+        return true;
+    });
+
+    // The view change timeout fires after 10 seconds. Stop well before the
+    // next one, so the view change must complete by retransmission.
+    transport.Timer(15000, [&]() {
+        transport.CancelAllTimers();
+    });
+    transport.Run();
+
+    EXPECT_GT(dropped, 1);
+    for (int i = 0; i < config->n; i++) {
+        EXPECT_EQ(numOps, iOps[i].size());
+        EXPECT_EQ(numOps, apps[i]->synced);
+    }
+}
+
 // TEST_F(IRTest, ManyOps)
 // {
 //     Client::continuation_t upcall = [&](const string &req, const string &reply) {
@@ -0,0 +1,230 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/ir/tests/merge-benchmark.cc:
+ *   Measures how long the leader of an IR view change takes to merge
+ *   the records of f + 1 replicas.
+ *
+ **********************************************************************/
+
+#include "lib/configuration.h"
+#include "lib/message.h"
+#include "lib/transport.h"
+#include "replication/ir/replica.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace replication;
+using namespace replication::ir;
+using namespace replication::ir::proto;
+
+namespace {
+
+// A transport that drops every message and never fires its timers, so that
+// the benchmark measures the replica alone.
+class NullTransportAddress : public TransportAddress
+{
+public:
+    NullTransportAddress *clone() const override {
+        return new NullTransportAddress();
+    }
+};
+
+class NullTransport : public Transport
+{
+public:
+    NullTransport() : lastTimerId(0) { }
+    void Register(TransportReceiver *receiver,
+                  const transport::Configuration &config,
+                  int replicaIdx) override {
+        receiver->SetAddress(new NullTransportAddress());
+    }
+    bool SendMessage(TransportReceiver *src, const TransportAddress &dst,
+                     const Message &m) override { return true; }
+    bool SendMessageToReplica(TransportReceiver *src, int replicaIdx,
+                              const Message &m) override { return true; }
+    bool SendMessageToAll(TransportReceiver *src,
+                          const Message &m) override { return true; }
+    int Timer(uint64_t ms, timer_callback_t cb) override {
+        return ++lastTimerId;
+    }
+    bool CancelTimer(int id) override { return true; }
+    void CancelAllTimers() override { }
+
+private:
+    int lastTimerId;
+};
+
+class MergeApp : public IRAppReplica
+{
+public:
+    void ExecConsensusUpcall(const string &req, string &reply) override {
+        reply = "ok";
+    }
+
+    std::map<opid_t, std::string> Merge(
+        const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &u,
+        const std::map<opid_t, std::string> &majority_results_in_d) override {
+        std::map<opid_t, std::string> results = majority_results_in_d;
+        for (const auto &p : u) {
+            results.emplace_hint(results.end(), p.first,
+                                 p.second.front()->result);
+        }
+        return results;
+    }
+};
+
+// Operations cycle through the four cases IR-MERGE-RECORDS distinguishes:
+// inconsistent, finalized consensus, tentative consensus with a majority
+// result (d) and tentative consensus without one (u).
+enum OpKind { INCONSISTENT = 0, FINALIZED, MAJORITY, NO_MAJORITY, NUM_KINDS };
+
+void
+MakeRequest(uint64_t i, Request *request)
+{
+    request->set_op("op" + std::to_string(i));
+    request->set_clientid(i % 64 + 1);
+    request->set_clientreqid(i);
+}
+
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    int f = 1;
+    uint64_t numEntries = 1000000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:n:")) != -1) {
+        switch (opt) {
+        case 'f':
+        {
+            char *strtolPtr;
+            f = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (f <= 0)) {
+                fprintf(stderr, "option -f requires a positive integer\n");
+                return 1;
+            }
+            break;
+        }
+
+        case 'n':
+        {
+            char *strtolPtr;
+            numEntries = strtoull(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0')) {
+                fprintf(stderr, "option -n requires a numeric arg\n");
+                return 1;
+            }
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            return 1;
+        }
+    }
+
+    const int n = 2 * f + 1;
+    std::vector<transport::ReplicaAddress> replicas;
+    for (int i = 0; i < n; ++i) {
+        replicas.emplace_back("localhost", std::to_string(51800 + i));
+    }
+    transport::Configuration config(n, f, replicas);
+
+    // The leader of view 1 persists its view info next to the benchmark.
+    const int leaderIdx = config.GetLeaderIndex(1);
+    const std::string viewInfo = "localhost:" + std::to_string(51800 + leaderIdx)
+        + "_" + std::to_string(leaderIdx) + ".bin";
+    unlink(viewInfo.c_str());
+
+    NullTransport transport;
+    NullTransportAddress client;
+    MergeApp app;
+    IRReplica leader(config, leaderIdx, &transport, &app);
+
+    // Fill the leader's record through the normal request path.
+    for (uint64_t i = 0; i < numEntries; ++i) {
+        if (i % NUM_KINDS == INCONSISTENT) {
+            ProposeInconsistentMessage msg;
+            MakeRequest(i, msg.mutable_req());
+            leader.HandleProposeInconsistent(client, msg);
+        } else {
+            ProposeConsensusMessage msg;
+            MakeRequest(i, msg.mutable_req());
+            leader.HandleProposeConsensus(client, msg);
+        }
+    }
+
+    // The other f replicas of the quorum hold the same operations, with the
+    // consensus ones in the states above.
+    std::vector<DoViewChangeMessage> dvcs;
+    for (int i = 0, sent = 0; i < n && sent < f; ++i) {
+        if (i == leaderIdx) {
+            continue;
+        }
+        sent++;
+
+        DoViewChangeMessage dvc;
+        dvc.set_replicaidx(i);
+        dvc.set_new_view(1);
+        dvc.set_latest_normal_view(0);
+        RecordProto *record = dvc.mutable_record();
+        for (uint64_t j = 0; j < numEntries; ++j) {
+            Request request;
+            MakeRequest(j, &request);
+
+            RecordEntryProto *entry = record->add_entry();
+            entry->set_view(0);
+            entry->mutable_opid()->set_clientid(request.clientid());
+            entry->mutable_opid()->set_clientreqid(request.clientreqid());
+            entry->set_op(request.SerializeAsString());
+            switch (j % NUM_KINDS) {
+            case INCONSISTENT:
+                entry->set_state(RECORD_STATE_TENTATIVE);
+                entry->set_type(RECORD_TYPE_INCONSISTENT);
+                entry->set_result("");
+                break;
+            case FINALIZED:
+                entry->set_state(RECORD_STATE_FINALIZED);
+                entry->set_type(RECORD_TYPE_CONSENSUS);
+                entry->set_result("ok");
+                break;
+            case MAJORITY:
+                entry->set_state(RECORD_STATE_TENTATIVE);
+                entry->set_type(RECORD_TYPE_CONSENSUS);
+                entry->set_result("ok");
+                break;
+            case NO_MAJORITY:
+                entry->set_state(RECORD_STATE_TENTATIVE);
+                entry->set_type(RECORD_TYPE_CONSENSUS);
+                entry->set_result("r" + std::to_string(i));
+                break;
+            }
+        }
+        dvcs.push_back(std::move(dvc));
+    }
+
+    // The last DO-VIEW-CHANGE completes the quorum and triggers the merge.
+    auto start = std::chrono::steady_clock::now();
+    for (const DoViewChangeMessage &dvc : dvcs) {
+        leader.HandleDoViewChange(client, dvc);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("Merged %" PRIu64 " entries from %d replicas in %.1f ms "
+           "(%.1f ns/entry)\n",
+           numEntries, f + 1, ms, ms * 1e6 / (numEntries * (f + 1)));
+
+    unlink(viewInfo.c_str());
+    return 0;
+}
@@ -0,0 +1,119 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * replication/ir/tests/record-test.cc:
+ *   test cases for IR records and record deltas
+ *
+ **********************************************************************/
+
+#include "replication/ir/record.h"
+
+#include <gtest/gtest.h>
+
+using namespace replication;
+using namespace replication::ir;
+using namespace replication::ir::proto;
+
+static Request
+MakeRequest(opid_t opid, const std::string &op)
+{
+    Request request;
+    request.set_op(op);
+    request.set_clientid(opid.first);
+    request.set_clientreqid(opid.second);
+    return request;
+}
+
+static void
+ExpectSameEntries(const Record &x, const Record &y)
+{
+    ASSERT_EQ(x.Entries().size(), y.Entries().size());
+    for (const auto &p : x.Entries()) {
+        auto it = y.Entries().find(p.first);
+        ASSERT_TRUE(it != y.Entries().end());
+        EXPECT_EQ(p.second.view, it->second.view);
+        EXPECT_EQ(p.second.state, it->second.state);
+        EXPECT_EQ(p.second.type, it->second.type);
+        EXPECT_EQ(p.second.request.op(), it->second.request.op());
+        EXPECT_EQ(p.second.result, it->second.result);
+    }
+}
+
+TEST(Record, DeltaRoundTrip)
+{
+    Record base;
+    for (uint64_t i = 0; i < 10; i++) {
+        opid_t opid(1, i);
+        base.Add(0, opid, MakeRequest(opid, "op"), RECORD_STATE_FINALIZED,
+                 RECORD_TYPE_CONSENSUS, "ok");
+    }
+    base.Checkpoint();
+
+    // Two replicas share the checkpoint and then diverge.
+    RecordProto base_proto;
+    base.ToProto(&base_proto);
+    Record peer(base_proto);
+    peer.Checkpoint();
+    EXPECT_EQ(base.CheckpointDigest(), peer.CheckpointDigest());
+
+    opid_t added(2, 0);
+    peer.Add(1, added, MakeRequest(added, "new"), RECORD_STATE_TENTATIVE,
+             RECORD_TYPE_INCONSISTENT);
+    peer.SetResult(opid_t(1, 3), "changed");
+    peer.Remove(opid_t(1, 7));
+    base.SetResult(opid_t(1, 5), "local");
+
+    RecordProto delta;
+    peer.DeltaToProto(&delta);
+    EXPECT_EQ(delta.entry_size(), 2);
+    EXPECT_EQ(delta.removed_size(), 1);
+
+    // The base reconstructs the peer's record from its own checkpoint, even
+    // though it has local changes of its own.
+    Record rebuilt = base.ApplyDelta(delta);
+    ExpectSameEntries(peer, rebuilt);
+}
+
+TEST(Record, CheckpointToProto)
+{
+    Record record;
+    opid_t a(1, 1), b(1, 2);
+    record.Add(0, a, MakeRequest(a, "a"), RECORD_STATE_TENTATIVE,
+               RECORD_TYPE_INCONSISTENT);
+    record.Checkpoint();
+    const uint64_t digest = record.CheckpointDigest();
+
+    record.SetStatus(a, RECORD_STATE_FINALIZED);
+    record.Add(1, b, MakeRequest(b, "b"), RECORD_STATE_TENTATIVE,
+               RECORD_TYPE_INCONSISTENT);
+
+    RecordProto proto;
+    record.CheckpointToProto(&proto);
+    Record checkpoint(proto);
+    checkpoint.Checkpoint();
+    EXPECT_EQ(digest, checkpoint.CheckpointDigest());
+    ASSERT_EQ(checkpoint.Entries().size(), 1);
+    EXPECT_EQ(checkpoint.Entries().begin()->second.state,
+              RECORD_STATE_TENTATIVE);
+
+    // A delta against the checkpoint turns it back into the current record.
+    RecordProto delta;
+    record.DeltaToProto(checkpoint, &delta);
+    EXPECT_EQ(delta.entry_size(), 2);
+    ExpectSameEntries(record, checkpoint.ApplyDelta(delta));
+}
+
+TEST(Record, DivergentCheckpoints)
+{
+    Record x, y;
+    EXPECT_EQ(x.CheckpointDigest(), y.CheckpointDigest());
+
+    opid_t opid(1, 1);
+    x.Add(0, opid, MakeRequest(opid, "op"), RECORD_STATE_FINALIZED,
+          RECORD_TYPE_CONSENSUS, "yes");
+    y.Add(0, opid, MakeRequest(opid, "op"), RECORD_STATE_FINALIZED,
+          RECORD_TYPE_CONSENSUS, "no");
+    x.Checkpoint();
+    y.Checkpoint();
+    EXPECT_NE(x.CheckpointDigest(), y.CheckpointDigest());
+}
@@ -28,6 +28,7 @@
  *
  **********************************************************************/
 
+
 #include "replication/common/client.h"
 #include "replication/common/request.pb.h"
 #include "lib/assert.h"
@@ -42,16 +43,18 @@ namespace vr {
 VRClient::VRClient(const transport::Configuration &config,
                    Transport *transport,
                    uint64_t clientid)
-    : Client(config, transport, clientid)
+    : Client(config, transport, clientid),
+      pendingReqs([this]() { return new PendingRequest(this); }),
+      pendingUnloggedReqs([this]() {
+              return new PendingUnloggedRequest(this);
+          })
 {
+    view = 0;
     lastReqId = 0;
 }
 
 VRClient::~VRClient()
 {
-    for (auto kv : pendingReqs) {
-	delete kv.second;
-    }
 }
 
 void
@@ -64,13 +67,12 @@ VRClient::Invoke(const string &request,
     (void) error_continuation;
 
     uint64_t reqId = ++lastReqId;
-    Timeout *timer = new Timeout(transport, 500, [this, reqId]() {
-            ResendRequest(reqId);
-        });
-    PendingRequest *req =
-	new PendingRequest(request, reqId, continuation, timer);
+    PendingRequest *req = pendingReqs.Start(reqId);
+    req->request = request;
+    req->clientReqId = reqId;
+    req->continuation = continuation;
+    req->timer.SetTimeout(500);
 
-    pendingReqs[reqId] = req;
     SendRequest(req);
 }
 
@@ -88,16 +90,14 @@ VRClient::InvokeUnlogged(int replicaIdx,
     reqMsg.mutable_req()->set_clientreqid(reqId);
 
     if (transport->SendMessageToReplica(this, replicaIdx, reqMsg)) {
-	Timeout *timer =
-	    new Timeout(transport, timeout, [this, reqId]() {
-		    UnloggedRequestTimeoutCallback(reqId);
-		});
-	PendingUnloggedRequest *req =
-	    new PendingUnloggedRequest(request, reqId,
-				       continuation, timer,
-				       error_continuation);
-	pendingReqs[reqId] = req;
-	req->timer->Start();
+	PendingUnloggedRequest *req = pendingUnloggedReqs.Start(reqId);
+	req->request = request;
+	req->clientReqId = reqId;
+	req->continuation = continuation;
+	req->error_continuation = error_continuation;
+	req->replicaIdx = replicaIdx;
+	req->timer.SetTimeout(timeout);
+	req->timer.Start();
     } else {
 	Warning("Could not send unlogged request to replica %u.",
 		replicaIdx);
@@ -105,7 +105,77 @@ VRClient::InvokeUnlogged(int replicaIdx,
 }
 
 void
-VRClient::SendRequest(const PendingRequest *req)
+VRClient::InvokeUnloggedAtLeader(const string &request,
+                                 continuation_t continuation,
+                                 error_continuation_t error_continuation,
+                                 uint32_t timeout)
+{
+    uint64_t reqId = ++lastReqId;
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Start(reqId);
+    req->request = request;
+    req->clientReqId = reqId;
+    req->continuation = continuation;
+    req->error_continuation = error_continuation;
+    req->timer.SetTimeout(timeout);
+    req->timer.Start();
+    TryLeader(req, config.GetLeaderIndex(view));
+}
+
+void
+VRClient::TryLeader(PendingUnloggedRequest *req, int replicaIdx)
+{
+    req->replicaIdx = replicaIdx;
+    uint64_t tries = ++req->tries;
+    SendUnloggedAtLeader(req);
+
+    uint64_t reqId = req->clientReqId;
+    transport->Timer(LEASE_LEADER_TIMEOUT, [this, reqId, tries]() {
+            LeaderTimeoutCallback(reqId, tries);
+        });
+}
+
+void
+VRClient::SendUnloggedAtLeader(const PendingUnloggedRequest *req)
+{
+    proto::UnloggedRequestMessage reqMsg;
+    reqMsg.mutable_req()->set_op(req->request);
+    reqMsg.mutable_req()->set_clientid(clientid);
+    reqMsg.mutable_req()->set_clientreqid(req->clientReqId);
+    reqMsg.set_atleader(true);
+
+    if (!transport->SendMessageToReplica(this, req->replicaIdx, reqMsg)) {
+        Warning("Could not send unlogged request to leader %d.",
+                req->replicaIdx);
+    }
+}
+
+void
+VRClient::ResendUnloggedAtLeader(const uint64_t reqId)
+{
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL) {
+        return;
+    }
+    SendUnloggedAtLeader(req);
+}
+
+void
+VRClient::LeaderTimeoutCallback(const uint64_t reqId, const uint64_t tries)
+{
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL || req->tries != tries) {
+        return;
+    }
+
+    // The replica we took for leader has failed, or has lost its lease
+    // to a view change we have not heard of; the next one can tell.
+    Debug("No answer from leader %d; trying the next replica",
+          req->replicaIdx);
+    TryLeader(req, (req->replicaIdx + 1) % config.n);
+}
+
+void
+VRClient::SendRequest(PendingRequest *req)
 {
     proto::RequestMessage reqMsg;
     reqMsg.mutable_req()->set_op(req->request);
@@ -115,24 +185,25 @@ VRClient::SendRequest(const PendingRequest *req)
     //Debug("SENDING REQUEST: %lu %lu", clientid, pendingRequest->clientReqId);
     // XXX Try sending only to (what we think is) the leader first
     if (transport->SendMessageToAll(this, reqMsg)) {
-	req->timer->Reset();
+	req->timer.Reset();
     } else {
 	Warning("Could not send request to replicas.");
-	pendingReqs.erase(req->clientReqId);
-	delete req;
+	pendingReqs.Erase(req->clientReqId);
+	pendingReqs.Free(req);
     }
 }
 
 void
 VRClient::ResendRequest(const uint64_t reqId)
 {
-    if (pendingReqs.find(reqId) == pendingReqs.end()) {
+    PendingRequest *req = pendingReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received resend request when no request was pending");
         return;
     }
 
     Warning("Client timeout; resending request: %lu", reqId);
-    SendRequest(pendingReqs[reqId]);
+    SendRequest(req);
 }
 
 
@@ -160,18 +231,21 @@ VRClient::HandleReply(const TransportAddress &remote,
                       const proto::ReplyMessage &msg)
 {
     uint64_t reqId = msg.clientreqid();
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingRequest *req = pendingReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received reply when no request was pending");
         return;
     }
 
-    PendingRequest *req = it->second;
+    if (msg.view() > view) {
+        view = msg.view();
+    }
+
     Debug("Client received reply: %lu", reqId);
-    req->timer->Stop();
-    pendingReqs.erase(it);
+    req->timer.Stop();
+    pendingReqs.Erase(reqId);
     req->continuation(req->request, msg.reply());
-    delete req;
+    pendingReqs.Free(req);
 }
 
 void
@@ -179,38 +253,51 @@ VRClient::HandleUnloggedReply(const TransportAddress &remote,
                               const proto::UnloggedReplyMessage &msg)
 {
     uint64_t reqId = msg.clientreqid();
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received reply when no request was pending");
         return;
     }
 
-    PendingRequest *req = it->second;
+    if (msg.has_view() && msg.view() > view) {
+        view = msg.view();
+    }
+
+    if (msg.notleader()) {
+        // Go to the leader of the replica's view if that is another
+        // replica; otherwise wait for it to get its lease.
+        if (config.GetLeaderIndex(view) != req->replicaIdx) {
+            TryLeader(req, config.GetLeaderIndex(view));
+        } else {
+            transport->Timer(LEASE_RETRY_DELAY, [this, reqId]() {
+                    ResendUnloggedAtLeader(reqId);
+                });
+        }
+        return;
+    }
 
     Debug("Client received unloggedReply %lu", reqId);
-    req->timer->Stop();
-    pendingReqs.erase(it);
+    req->timer.Stop();
+    pendingUnloggedReqs.Erase(reqId);
     req->continuation(req->request, msg.reply());
-    delete req;
+    pendingUnloggedReqs.Free(req);
 }
 
 void
 VRClient::UnloggedRequestTimeoutCallback(const uint64_t reqId)
 {
-    auto it = pendingReqs.find(reqId);
-    if (it == pendingReqs.end()) {
+    PendingUnloggedRequest *req = pendingUnloggedReqs.Find(reqId);
+    if (req == NULL) {
         Debug("Received reply when no request was pending");
         return;
     }
     Warning("Unlogged request timed out");
-    PendingUnloggedRequest *req =
-	static_cast<PendingUnloggedRequest *>(it->second);
-    req->timer->Stop();
-    pendingReqs.erase(it);
+    req->timer.Stop();
+    pendingUnloggedReqs.Erase(reqId);
     if (req->error_continuation) {
         req->error_continuation(req->request, ErrorCode::TIMEOUT);
     }
-    delete req;
+    pendingUnloggedReqs.Free(req);
 }
 
 } // namespace vr
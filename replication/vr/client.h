@@ -33,11 +33,10 @@
 #define _VR_CLIENT_H_
 
 #include "replication/common/client.h"
+#include "replication/common/requestpool.h"
 #include "lib/configuration.h"
 #include "replication/vr/vr-proto.pb.h"
 
-#include <unordered_map>
-
 namespace replication {
 namespace vr {
 
@@ -56,45 +55,76 @@ public:
                                 continuation_t continuation,
                                 error_continuation_t error_continuation = nullptr,
                                 uint32_t timeout = DEFAULT_UNLOGGED_OP_TIMEOUT);
+    // Run an unlogged request at the leader, which answers only while
+    // it holds its read lease; the request follows the leader through
+    // view changes until it is answered or times out.
+    virtual void InvokeUnloggedAtLeader(const string &request,
+                                        continuation_t continuation,
+                                        error_continuation_t error_continuation = nullptr,
+                                        uint32_t timeout = DEFAULT_UNLOGGED_OP_TIMEOUT);
     virtual void ReceiveMessage(const TransportAddress &remote,
                                 const string &type, const string &data);
 
 protected:
-    int view;
+    // How long to wait before asking a leader without a lease again,
+    // and before giving up on it and asking the next replica which
+    // view it is in, in milliseconds.
+    static const uint64_t LEASE_RETRY_DELAY = 5;
+    static const uint64_t LEASE_LEADER_TIMEOUT = 500;
+
+    view_t view;
     int opnumber;
     uint64_t lastReqId;
 
+    // Requests are pooled, and reused with their timers once they
+    // finish; see RequestPool.
     struct PendingRequest
     {
         string request;
         uint64_t clientReqId;
         continuation_t continuation;
-	Timeout *timer;
-        inline PendingRequest(string request,
-			      uint64_t clientReqId,
-                              continuation_t continuation,
-			      Timeout *timer)
-            : request(request), clientReqId(clientReqId),
-              continuation(continuation), timer(timer) { };
-	inline ~PendingRequest() { delete timer; }
+        Timeout timer;
+        inline PendingRequest(VRClient *client)
+            : PendingRequest(client->transport, [client, this]() {
+                    client->ResendRequest(clientReqId);
+                }) { };
+        inline PendingRequest(Transport *transport, timer_callback_t cb)
+            : clientReqId(0), timer(transport, 0, cb) { };
+        inline void Clear() {
+            timer.Stop();
+            request.clear();
+            continuation = nullptr;
+        }
     };
 
     struct PendingUnloggedRequest : public PendingRequest
     {
 	error_continuation_t error_continuation;
-        inline PendingUnloggedRequest(string request,
-				      uint64_t clientReqId,
-				      continuation_t continuation,
-				      Timeout *timer,
-				      error_continuation_t error_continuation)
-            : PendingRequest(request, clientReqId, continuation, timer),
-              error_continuation(error_continuation) { };
+        int replicaIdx;
+        // Replicas tried so far, for requests sent to the leader.
+        uint64_t tries;
+        inline PendingUnloggedRequest(VRClient *client)
+            : PendingRequest(client->transport, [client, this]() {
+                    client->UnloggedRequestTimeoutCallback(clientReqId);
+                }),
+              replicaIdx(-1), tries(0) { };
+        inline void Clear() {
+            PendingRequest::Clear();
+            error_continuation = nullptr;
+            replicaIdx = -1;
+            tries = 0;
+        }
     };
 
-    std::unordered_map<uint64_t, PendingRequest *> pendingReqs;
+    RequestPool<PendingRequest> pendingReqs;
+    RequestPool<PendingUnloggedRequest> pendingUnloggedReqs;
 
-    void SendRequest(const PendingRequest *req);
+    void SendRequest(PendingRequest *req);
     void ResendRequest(const uint64_t reqId);
+    void TryLeader(PendingUnloggedRequest *req, int replicaIdx);
+    void SendUnloggedAtLeader(const PendingUnloggedRequest *req);
+    void ResendUnloggedAtLeader(const uint64_t reqId);
+    void LeaderTimeoutCallback(const uint64_t reqId, const uint64_t tries);
     void HandleReply(const TransportAddress &remote,
                      const proto::ReplyMessage &msg);
     void HandleUnloggedReply(const TransportAddress &remote,
@@ -38,12 +38,22 @@
 #include "lib/transport.h"
 
 #include <algorithm>
+#include <functional>
+#include <vector>
 
 #define RDebug(fmt, ...) Debug("[%d] " fmt, myIdx, ##__VA_ARGS__)
 #define RNotice(fmt, ...) Notice("[%d] " fmt, myIdx, ##__VA_ARGS__)
 #define RWarning(fmt, ...) Warning("[%d] " fmt, myIdx, ##__VA_ARGS__)
 #define RPanic(fmt, ...) Panic("[%d] " fmt, myIdx, ##__VA_ARGS__)
 
+// How many prepares a backup holds while it waits for a missing one
+// before it gives up and asks for a state transfer.
+static const size_t MAX_EARLY_PREPARES = 64;
+
+// The leader gives up its lease this much of LEASE_DURATION early, to
+// allow for clocks that run at different rates.
+static const uint64_t LEASE_DRIFT_DIVISOR = 10;
+
 namespace replication {
 namespace vr {
 
@@ -51,10 +61,16 @@ using namespace proto;
     
 VRReplica::VRReplica(transport::Configuration config, int myIdx,
                      Transport *transport, unsigned int batchSize,
-                     AppReplica *app)
+                     AppReplica *app, unsigned int pipelineWindow,
+                     opnum_t checkpointInterval,
+                     LogHashMode logHash)
     : Replica(config, myIdx, transport, app),
       batchSize(batchSize),
-      log(false),
+      pipelineWindow(pipelineWindow),
+      checkpointInterval(checkpointInterval),
+      leaseGrantedUntil(0),
+      leaseStartOp(0),
+      log(logHash),
       prepareOKQuorum(config.QuorumSize()-1),
       startViewChangeQuorum(config.QuorumSize()-1),
       doViewChangeQuorum(config.QuorumSize()-1)
@@ -66,9 +82,13 @@ VRReplica::VRReplica(transport::Configuration config, int myIdx,
     this->lastRequestStateTransferView = 0;
     this->lastRequestStateTransferOpnum = 0;
     lastBatchEnd = 0;
+    checkpoint.set_view(0);
+    checkpoint.set_opnum(0);
+    checkpoint.set_state("");
 
     if (batchSize > 1) {
-        Notice("Batching enabled; batch size %d", batchSize);
+        Notice("Batching enabled; batch size %d, window %d",
+               batchSize, pipelineWindow);
     }
 
     this->viewChangeTimeout = new Timeout(transport, 5000, [this]() {
@@ -85,9 +105,6 @@ VRReplica::VRReplica(transport::Configuration config, int myIdx,
     this->resendPrepareTimeout = new Timeout(transport, 500, [this]() {
             ResendPrepare();
         });
-    this->closeBatchTimeout = new Timeout(transport, 300, [this]() {
-            CloseBatch();
-        });
 
     if (AmLeader()) {
         nullCommitTimeout->Start();
@@ -102,7 +119,6 @@ VRReplica::~VRReplica()
     delete nullCommitTimeout;
     delete stateTransferTimeout;
     delete resendPrepareTimeout;
-    delete closeBatchTimeout;
     
     for (auto &kv : pendingPrepares) {
         delete kv.first;
@@ -115,6 +131,53 @@ VRReplica::AmLeader() const
     return (configuration.GetLeaderIndex(view) == myIdx);
 }
 
+bool
+VRReplica::HoldsLease() const
+{
+    if (status != STATUS_NORMAL || !AmLeader() ||
+        lastCommitted < leaseStartOp) {
+        return false;
+    }
+    if (configuration.f == 0) {
+        return true;
+    }
+
+    // The lease runs from the f-th latest time the backups granted.
+    if (leaseGrants.size() < (size_t)configuration.f) {
+        return false;
+    }
+    std::vector<uint64_t> grants;
+    for (const auto &kv : leaseGrants) {
+        grants.push_back(kv.second);
+    }
+    std::nth_element(grants.begin(), grants.begin() + configuration.f - 1,
+                     grants.end(), std::greater<uint64_t>());
+    uint64_t since = grants[configuration.f - 1];
+    uint64_t length = LEASE_DURATION - LEASE_DURATION / LEASE_DRIFT_DIVISOR;
+    return transport->NowMicros() < since + length;
+}
+
+bool
+VRReplica::LeaseBlocksViewChange() const
+{
+    return transport->NowMicros() < leaseGrantedUntil;
+}
+
+void
+VRReplica::GrantLease()
+{
+    leaseGrantedUntil = transport->NowMicros() + LEASE_DURATION;
+}
+
+void
+VRReplica::RecordLeaseGrant(int replicaIdx, uint64_t leasetime)
+{
+    auto kv = leaseGrants.insert(std::make_pair(replicaIdx, leasetime));
+    if (!kv.second && kv.first->second < leasetime) {
+        kv.first->second = leasetime;
+    }
+}
+
 void
 VRReplica::CommitUpTo(opnum_t upto)
 {
@@ -158,7 +221,79 @@ VRReplica::CommitUpTo(opnum_t upto)
         if (iter != clientAddresses.end()) {
             transport->SendMessage(this, *iter->second, reply);
         }
+
+        if (checkpointInterval > 0 &&
+            lastCommitted - checkpoint.opnum() >= checkpointInterval) {
+            TakeCheckpoint();
+        }
+    }
+}
+
+void
+VRReplica::TakeCheckpoint()
+{
+    string state;
+    if (!SnapshotUpcall(state)) {
+        return;
+    }
+
+    const LogEntry *entry = log.Find(lastCommitted);
+    ASSERT(entry != NULL);
+    viewstamp_t vs = entry->viewstamp;
+
+    proto::Checkpoint cp;
+    cp.set_view(vs.view);
+    cp.set_opnum(vs.opnum);
+    cp.set_state(state);
+    cp.set_hash(entry->hash);
+    // Only replies are kept: an entry still waiting on one is for an
+    // operation after the checkpoint, which the log still has.
+    for (const auto &kv : clientTable) {
+        if (kv.second.replied) {
+            proto::Checkpoint::ClientReply *c = cp.add_clients();
+            c->set_clientid(kv.first);
+            c->set_clientreqid(kv.second.lastReqId);
+            *c->mutable_reply() = kv.second.reply;
+        }
     }
+    checkpoint.Swap(&cp);
+
+    RDebug("Took checkpoint at " FMT_VIEWSTAMP " of %zu bytes",
+           vs.view, vs.opnum, state.size());
+    log.RemoveUpTo(vs, checkpoint.hash());
+}
+
+void
+VRReplica::InstallCheckpoint(const proto::Checkpoint &cp)
+{
+    if (cp.opnum() <= lastCommitted) {
+        return;
+    }
+
+    RNotice("Installing checkpoint at " FMT_VIEWSTAMP,
+            cp.view(), cp.opnum());
+
+    RestoreUpcall(cp.state());
+    for (const auto &c : cp.clients()) {
+        ClientTableEntry &cte = clientTable[c.clientid()];
+        if (cte.lastReqId <= c.clientreqid()) {
+            cte.lastReqId = c.clientreqid();
+            cte.replied = true;
+            cte.reply = c.reply();
+        }
+    }
+
+    // Whatever the log held up to the checkpoint is now committed, and
+    // anything after it is still only prepared.
+    log.RemoveUpTo(viewstamp_t(cp.view(), cp.opnum()), cp.hash());
+    lastCommitted = cp.opnum();
+    if (lastOp < lastCommitted) {
+        lastOp = lastCommitted;
+    }
+    if (lastBatchEnd < lastCommitted) {
+        lastBatchEnd = lastCommitted;
+    }
+    checkpoint = cp;
 }
 
 void
@@ -227,6 +362,9 @@ VRReplica::EnterView(view_t newview)
     view = newview;
     status = STATUS_NORMAL;
     lastBatchEnd = lastOp;
+    inFlightBatches.clear();
+    earlyPrepares.clear();
+    leaseGrants.clear();
 
     if (AmLeader()) {
         viewChangeTimeout->Stop();
@@ -235,7 +373,6 @@ VRReplica::EnterView(view_t newview)
         viewChangeTimeout->Start();
         nullCommitTimeout->Stop();
         resendPrepareTimeout->Stop();
-        closeBatchTimeout->Stop();
     }
 
     prepareOKQuorum.Clear();
@@ -250,11 +387,13 @@ VRReplica::StartViewChange(view_t newview)
 
     view = newview;
     status = STATUS_VIEW_CHANGE;
+    inFlightBatches.clear();
+    earlyPrepares.clear();
+    leaseGrants.clear();
 
     viewChangeTimeout->Reset();
     nullCommitTimeout->Stop();
     resendPrepareTimeout->Stop();
-    closeBatchTimeout->Stop();
 
     StartViewChangeMessage m;
     m.set_view(newview);
@@ -272,6 +411,8 @@ VRReplica::SendNullCommit()
     CommitMessage cm;
     cm.set_view(this->view);
     cm.set_opnum(this->lastCommitted);
+    // Renews the lease while there is nothing to prepare.
+    cm.set_leasetime(transport->NowMicros());
 
     ASSERT(AmLeader());
 
@@ -296,53 +437,112 @@ VRReplica::UpdateClientTable(const Request &req)
     entry.reply.Clear();
 }
 
+void
+VRReplica::BuildPrepare(opnum_t first, opnum_t last,
+                        PrepareMessage &msg)
+{
+    msg.set_view(view);
+    msg.set_opnum(last);
+    msg.set_batchstart(first);
+
+    for (opnum_t i = first; i <= last; i++) {
+        Request *r = msg.add_request();
+        const LogEntry *entry = log.Find(i);
+        ASSERT(entry != NULL);
+        ASSERT(entry->viewstamp.view == view);
+        ASSERT(entry->viewstamp.opnum == i);
+        *r = entry->request;
+    }
+}
+
 void
 VRReplica::ResendPrepare()
 {
     ASSERT(AmLeader());
-    if (lastOp == lastCommitted) {
+    if (lastBatchEnd <= lastCommitted) {
+        return;
+    }
+
+    // Resend every batch still in flight as one prepare, leaving out
+    // operations from earlier views, which the backups got in the
+    // STARTVIEW message.
+    opnum_t first = lastCommitted+1;
+    while (first <= lastBatchEnd && log.Find(first)->viewstamp.view < view) {
+        first++;
+    }
+    if (first > lastBatchEnd) {
         return;
     }
-    RNotice("Resending prepare");
-    if (!(transport->SendMessageToAll(this, lastPrepare))) {
+
+    RNotice("Resending prepare from " FMT_OPNUM " to " FMT_OPNUM,
+            first, lastBatchEnd);
+    PrepareMessage p;
+    BuildPrepare(first, lastBatchEnd, p);
+    p.set_leasetime(transport->NowMicros());
+    if (!(transport->SendMessageToAll(this, p))) {
         RWarning("Failed to ressend prepare message to all replicas");
     }
 }
 
 void
-VRReplica::CloseBatch()
+VRReplica::CloseBatch(opnum_t last)
 {
     ASSERT(AmLeader());
-    ASSERT(lastBatchEnd < lastOp);
+    ASSERT(lastBatchEnd < last);
+    ASSERT(last <= lastOp);
 
     opnum_t batchStart = lastBatchEnd+1;
     
     RDebug("Sending batched prepare from " FMT_OPNUM
-           " to " FMT_OPNUM,
-           batchStart, lastOp);
+           " to " FMT_OPNUM " with %zu batches in flight",
+           batchStart, last, inFlightBatches.size());
     /* Send prepare messages */
     PrepareMessage p;
-    p.set_view(view);
-    p.set_opnum(lastOp);
-    p.set_batchstart(batchStart);
-
-    for (opnum_t i = batchStart; i <= lastOp; i++) {
-        Request *r = p.add_request();
-        const LogEntry *entry = log.Find(i);
-        ASSERT(entry != NULL);
-        ASSERT(entry->viewstamp.view == view);
-        ASSERT(entry->viewstamp.opnum == i);
-        *r = entry->request;
-    }
-    lastPrepare = p;
+    BuildPrepare(batchStart, last, p);
+    p.set_leasetime(transport->NowMicros());
 
     if (!(transport->SendMessageToAll(this, p))) {
         RWarning("Failed to send prepare message to all replicas");
     }
-    lastBatchEnd = lastOp;
+    lastBatchEnd = last;
+    inFlightBatches.push_back(last);
     
-    resendPrepareTimeout->Reset();
-    closeBatchTimeout->Stop();
+    if (!resendPrepareTimeout->Active()) {
+        resendPrepareTimeout->Start();
+    }
+}
+
+/* Send the requests not yet prepared, in batches of up to batchSize, for
+ * as long as the pipeline has room. */
+void
+VRReplica::SendBatches()
+{
+    // A backup that caught up by state transfer may have acknowledged
+    // ops we had not yet sent; those are committed and need no prepare.
+    if (lastBatchEnd < lastCommitted) {
+        lastBatchEnd = lastCommitted;
+    }
+    while (lastBatchEnd < lastOp &&
+           inFlightBatches.size() < pipelineWindow) {
+        CloseBatch(std::min(lastOp, lastBatchEnd + batchSize));
+    }
+}
+
+void
+VRReplica::BatchesCommitted()
+{
+    while (!inFlightBatches.empty() &&
+           inFlightBatches.front() <= lastCommitted) {
+        inFlightBatches.pop_front();
+        // Progress, so there is no need to resend yet.
+        resendPrepareTimeout->Reset();
+    }
+    if (inFlightBatches.empty() && lastBatchEnd == lastOp) {
+        resendPrepareTimeout->Stop();
+    }
+
+    // Requests that gathered while the window was full go out now.
+    SendBatches();
 }
 
 void
@@ -354,6 +554,7 @@ VRReplica::ReceiveMessage(const TransportAddress &remote,
     PrepareMessage prepare;
     PrepareOKMessage prepareOK;
     CommitMessage commit;
+    LeaseGrantMessage leaseGrant;
     RequestStateTransferMessage requestStateTransfer;
     StateTransferMessage stateTransfer;
     StartViewChangeMessage startViewChange;
@@ -375,6 +576,9 @@ VRReplica::ReceiveMessage(const TransportAddress &remote,
     } else if (type == commit.GetTypeName()) {
         commit.ParseFromString(data);
         HandleCommit(remote, commit);
+    } else if (type == leaseGrant.GetTypeName()) {
+        leaseGrant.ParseFromString(data);
+        HandleLeaseGrant(remote, leaseGrant);
     } else if (type == requestStateTransfer.GetTypeName()) {
         requestStateTransfer.ParseFromString(data);
         HandleRequestStateTransfer(remote, requestStateTransfer);
@@ -484,13 +688,10 @@ VRReplica::HandleRequest(const TransportAddress &remote,
         /* Add the request to my log */
         log.Append(v, request, LOG_STATE_PREPARED);
 
-        if (lastOp - lastBatchEnd+1 > batchSize) {
-            CloseBatch();
+        if (inFlightBatches.size() < pipelineWindow) {
+            SendBatches();
         } else {
             RDebug("Keeping in batch");
-            if (!closeBatchTimeout->Active()) {
-                closeBatchTimeout->Start();
-            }
         }
 
         nullCommitTimeout->Reset();
@@ -501,6 +702,25 @@ void
 VRReplica::HandleUnloggedRequest(const TransportAddress &remote,
                                  const UnloggedRequestMessage &msg)
 {
+    UnloggedReplyMessage reply;
+    reply.set_clientreqid(msg.req().clientreqid());
+    reply.set_view(view);
+
+    if (msg.atleader()) {
+        if (!HoldsLease()) {
+            RDebug("Refusing leader read without a lease");
+            reply.set_reply("");
+            reply.set_notleader(true);
+        } else {
+            string res;
+            LeaderUnloggedUpcall(msg.req().op(), res);
+            reply.set_reply(res);
+        }
+        if (!(transport->SendMessage(this, remote, reply)))
+            Warning("Failed to send reply message");
+        return;
+    }
+
     if (status != STATUS_NORMAL) {
         // Not clear if we should ignore this or just let the request
         // go ahead, but this seems reasonable.
@@ -508,12 +728,9 @@ VRReplica::HandleUnloggedRequest(const TransportAddress &remote,
         return;
     }
 
-    UnloggedReplyMessage reply;
-    
     Debug("Received unlogged request %s", (char *)msg.req().op().c_str());
 
     ExecuteUnlogged(msg.req(), reply);
-    reply.set_clientreqid(msg.req().clientreqid());
 
     if (!(transport->SendMessage(this, remote, reply)))
         Warning("Failed to send reply message");
@@ -550,6 +767,9 @@ VRReplica::HandlePrepare(const TransportAddress &remote,
     ASSERT_EQ(msg.opnum()-msg.batchstart()+1, (unsigned int)msg.request_size());
               
     viewChangeTimeout->Reset();
+    if (msg.has_leasetime()) {
+        GrantLease();
+    }
     
     if (msg.opnum() <= this->lastOp) {
         RDebug("Ignoring PREPARE; already prepared that operation");
@@ -558,6 +778,9 @@ VRReplica::HandlePrepare(const TransportAddress &remote,
         reply.set_view(msg.view());
         reply.set_opnum(msg.opnum());
         reply.set_replicaidx(myIdx);
+        if (msg.has_leasetime()) {
+            reply.set_leasetime(msg.leasetime());
+        }
         if (!(transport->SendMessageToReplica(this,
                                               configuration.GetLeaderIndex(view),
                                               reply))) {
@@ -567,11 +790,41 @@ VRReplica::HandlePrepare(const TransportAddress &remote,
     }
 
     if (msg.batchstart() > this->lastOp+1) {
+        // The leader pipelines batches, so an earlier one may just
+        // have been reordered or dropped; hold this one until it
+        // arrives or is resent, up to a point.
+        if (earlyPrepares.size() < MAX_EARLY_PREPARES) {
+            RDebug("Holding PREPARE until " FMT_OPNUM " arrives",
+                   this->lastOp+1);
+            earlyPrepares[msg.batchstart()] = msg;
+            return;
+        }
         RequestStateTransfer();
         pendingPrepares.push_back(std::pair<TransportAddress *, PrepareMessage>(remote.clone(), msg));
         return;
     }
-    
+
+    AppendPrepare(msg);
+    AppendEarlyPrepares();
+}
+
+void
+VRReplica::AppendEarlyPrepares()
+{
+    // Apply any held prepares that now follow on from the log.
+    while (!earlyPrepares.empty() &&
+           earlyPrepares.begin()->first <= this->lastOp+1) {
+        PrepareMessage next = earlyPrepares.begin()->second;
+        earlyPrepares.erase(earlyPrepares.begin());
+        if (next.opnum() > this->lastOp) {
+            AppendPrepare(next);
+        }
+    }
+}
+
+void
+VRReplica::AppendPrepare(const PrepareMessage &msg)
+{
     /* Add operations to the log */
     opnum_t op = msg.batchstart()-1;
     for (auto &req : msg.request()) {
@@ -591,6 +844,9 @@ VRReplica::HandlePrepare(const TransportAddress &remote,
     reply.set_view(msg.view());
     reply.set_opnum(msg.opnum());
     reply.set_replicaidx(myIdx);
+    if (msg.has_leasetime()) {
+        reply.set_leasetime(msg.leasetime());
+    }
     
     if (!(transport->SendMessageToReplica(this,
                                           configuration.GetLeaderIndex(view),
@@ -627,25 +883,28 @@ VRReplica::HandlePrepareOK(const TransportAddress &remote,
         RWarning("Ignoring PREPAREOK because I'm not the leader");
         return;        
     }
+
+    if (msg.has_leasetime()) {
+        RecordLeaseGrant(msg.replicaidx(), msg.leasetime());
+    }
     
+    if (msg.opnum() <= lastCommitted) {
+        // A quorum already formed for this opnumber or a later one,
+        // and the COMMIT for it has gone out.
+        return;
+    }
+
     viewstamp_t vs = { msg.view(), msg.opnum() };
-    if (auto msgs =
-        (prepareOKQuorum.AddAndCheckForQuorum(vs, msg.replicaidx(), msg))) {
+    if (prepareOKQuorum.AddAndCheckForQuorum(vs, msg.replicaidx(), msg)) {
         /*
          * We have a quorum of PrepareOK messages for this
          * opnumber. Execute it and all previous operations.
          *
-         * (Note that we might have already executed it. That's fine,
-         * we just won't do anything.)
-         *
          * This also notifies the client of the result.
          */
         CommitUpTo(msg.opnum());
+        prepareOKQuorum.ClearUpTo(vs);
 
-        if (msgs->size() >= (unsigned int)configuration.QuorumSize()) {
-            return;
-        }
-        
         /*
          * Send COMMIT message to the other replicas.
          *
@@ -661,6 +920,10 @@ VRReplica::HandlePrepareOK(const TransportAddress &remote,
         }
 
         nullCommitTimeout->Reset();
+
+        // The window has room again; the COMMIT goes out ahead of the
+        // batches that fill it.
+        BatchesCommitted();
     }
 }
 
@@ -690,6 +953,19 @@ VRReplica::HandleCommit(const TransportAddress &remote,
     }
 
     viewChangeTimeout->Reset();
+
+    if (msg.has_leasetime()) {
+        GrantLease();
+        LeaseGrantMessage grant;
+        grant.set_view(view);
+        grant.set_replicaidx(myIdx);
+        grant.set_leasetime(msg.leasetime());
+        if (!(transport->SendMessageToReplica(this,
+                                              configuration.GetLeaderIndex(view),
+                                              grant))) {
+            RWarning("Failed to send LeaseGrant message to leader");
+        }
+    }
     
     if (msg.opnum() <= this->lastCommitted) {
         RDebug("Ignoring COMMIT; already committed that operation");
@@ -704,6 +980,17 @@ VRReplica::HandleCommit(const TransportAddress &remote,
     CommitUpTo(msg.opnum());
 }
 
+void
+VRReplica::HandleLeaseGrant(const TransportAddress &remote,
+                            const LeaseGrantMessage &msg)
+{
+    if (status != STATUS_NORMAL || msg.view() != view || !AmLeader()) {
+        RDebug("Ignoring LEASEGRANT for view " FMT_VIEW, msg.view());
+        return;
+    }
+
+    RecordLeaseGrant(msg.replicaidx(), msg.leasetime());
+}
 
 void
 VRReplica::HandleRequestStateTransfer(const TransportAddress &remote,
@@ -730,6 +1017,10 @@ VRReplica::HandleRequestStateTransfer(const TransportAddress &remote,
     reply.set_view(view);
     reply.set_opnum(lastCommitted);
     
+    // Operations the log no longer has come as the checkpoint.
+    if (msg.opnum()+1 < log.FirstOpnum()) {
+        *reply.mutable_checkpoint() = checkpoint;
+    }
     log.Dump(msg.opnum()+1, reply.mutable_entries());
 
     transport->SendMessage(this, remote, reply);
@@ -746,6 +1037,10 @@ VRReplica::HandleStateTransfer(const TransportAddress &remote,
         return;
     }
     
+    if (msg.has_checkpoint()) {
+        InstallCheckpoint(msg.checkpoint());
+    }
+
     opnum_t oldLastOp = lastOp;
     
     /* Install the new log entries */
@@ -802,11 +1097,14 @@ VRReplica::HandleStateTransfer(const TransportAddress &remote,
     ASSERT(msg.opnum() <= lastOp);
     CommitUpTo(msg.opnum());
     SendPrepareOKs(oldLastOp);
+    if (view == msg.view()) {
+        AppendEarlyPrepares();
+    }
 
     // Process pending prepares
     std::list<std::pair<TransportAddress *, PrepareMessage> >pending = pendingPrepares;
     pendingPrepares.clear();
-    for (auto & msgpair : pendingPrepares) {
+    for (auto & msgpair : pending) {
         RDebug("Processing pending prepare message");
         HandlePrepare(*msgpair.first, msgpair.second);
         delete msgpair.first;
@@ -830,6 +1128,11 @@ VRReplica::HandleStartViewChange(const TransportAddress &remote,
         return;
     }
 
+    if ((msg.view() > view) && LeaseBlocksViewChange()) {
+        RDebug("Ignoring STARTVIEWCHANGE while the leader's lease holds");
+        return;
+    }
+
     if ((status != STATUS_VIEW_CHANGE) || (msg.view() > view)) {
         StartViewChange(msg.view());
     }
@@ -851,14 +1154,15 @@ VRReplica::HandleStartViewChange(const TransportAddress &remote,
             dvc.set_replicaidx(myIdx);
 
             // Figure out how much of the log to include
-            opnum_t minCommitted = std::min_element(
-                msgs->begin(), msgs->end(),
-                [](decltype(*msgs->begin()) a,
-                   decltype(*msgs->begin()) b) {
-                    return a.second.lastcommitted() < b.second.lastcommitted();
-                })->second.lastcommitted();
-            minCommitted = std::min(minCommitted, lastCommitted);
+            opnum_t minCommitted = lastCommitted;
+            for (const auto &kv : *msgs) {
+                minCommitted = std::min(minCommitted,
+                                        kv.second.lastcommitted());
+            }
             
+            if (log.FirstOpnum() > minCommitted+1) {
+                *dvc.mutable_checkpoint() = checkpoint;
+            }
             log.Dump(minCommitted,
                      dvc.mutable_entries());
 
@@ -889,6 +1193,11 @@ VRReplica::HandleDoViewChange(const TransportAddress &remote,
         return;
     }
 
+    if ((msg.view() > view) && LeaseBlocksViewChange()) {
+        RDebug("Ignoring DOVIEWCHANGE while the leader's lease holds");
+        return;
+    }
+
     if ((status != STATUS_VIEW_CHANGE) || (msg.view() > view)) {
         // It's superfluous to send the StartViewChange messages here,
         // but harmless...
@@ -905,10 +1214,10 @@ VRReplica::HandleDoViewChange(const TransportAddress &remote,
         // one with the latest viewstamp
         view_t latestView = log.LastViewstamp().view;
         opnum_t latestOp = log.LastViewstamp().opnum;
-        DoViewChangeMessage *latestMsg = NULL;
+        const DoViewChangeMessage *latestMsg = NULL;
 
-        for (auto kv : *msgs) {
-            DoViewChangeMessage &x = kv.second;
+        for (const auto &kv : *msgs) {
+            const DoViewChangeMessage &x = kv.second;
             if ((x.lastnormalview() > latestView) ||
                 (((x.lastnormalview() == latestView) &&
                   (x.lastop() > latestOp)))) {
@@ -923,6 +1232,9 @@ VRReplica::HandleDoViewChange(const TransportAddress &remote,
         if (latestMsg != NULL) {
             RDebug("Selected log from replica %d with lastop=" FMT_OPNUM,
                    latestMsg->replicaidx(), latestMsg->lastop());
+            if (latestMsg->has_checkpoint()) {
+                InstallCheckpoint(latestMsg->checkpoint());
+            }
             if (latestMsg->entries_size() == 0) {
                 // There weren't actually any entries in the
                 // log. That should only happen in the corner case
@@ -950,27 +1262,20 @@ VRReplica::HandleDoViewChange(const TransportAddress &remote,
         //
         // We need to compute this before we enter the new view
         // because the saved messages will go away.
-        auto svcs = startViewChangeQuorum.GetMessages(view);
-        opnum_t minCommittedSVC = std::min_element(
-            svcs.begin(), svcs.end(),
-            [](decltype(*svcs.begin()) a,
-               decltype(*svcs.begin()) b) {
-                return a.second.lastcommitted() < b.second.lastcommitted();
-            })->second.lastcommitted();
-        opnum_t minCommittedDVC = std::min_element(
-            msgs->begin(), msgs->end(),
-            [](decltype(*msgs->begin()) a,
-               decltype(*msgs->begin()) b) {
-                return a.second.lastcommitted() < b.second.lastcommitted();
-            })->second.lastcommitted();
-        opnum_t minCommitted = std::min(minCommittedSVC, minCommittedDVC);
-        minCommitted = std::min(minCommitted, lastCommitted);
+        opnum_t minCommitted = lastCommitted;
+        for (const auto &kv : startViewChangeQuorum.GetMessages(view)) {
+            minCommitted = std::min(minCommitted, kv.second.lastcommitted());
+        }
+        for (const auto &kv : *msgs) {
+            minCommitted = std::min(minCommitted, kv.second.lastcommitted());
+        }
 
         EnterView(msg.view());
 
         ASSERT(AmLeader());
         
         lastOp = latestOp;
+        leaseStartOp = lastOp;
         if (latestMsg != NULL) {
             CommitUpTo(latestMsg->lastcommitted());
         }
@@ -981,6 +1286,9 @@ VRReplica::HandleDoViewChange(const TransportAddress &remote,
         sv.set_lastop(lastOp);
         sv.set_lastcommitted(lastCommitted);
         
+        if (log.FirstOpnum() > minCommitted+1) {
+            *sv.mutable_checkpoint() = checkpoint;
+        }
         log.Dump(minCommitted, sv.mutable_entries());
 
         if (!(transport->SendMessageToAll(this, sv))) {
@@ -1011,6 +1319,10 @@ VRReplica::HandleStartView(const TransportAddress &remote,
 
     ASSERT(configuration.GetLeaderIndex(msg.view()) != myIdx);
 
+    if (msg.has_checkpoint()) {
+        InstallCheckpoint(msg.checkpoint());
+    }
+
     if (msg.entries_size() == 0) {
         ASSERT(msg.lastcommitted() == lastCommitted);
         ASSERT(msg.lastop() == msg.lastcommitted());
@@ -37,6 +37,7 @@
 #include "replication/common/quorumset.h"
 #include "replication/vr/vr-proto.pb.h"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <list>
@@ -44,12 +45,39 @@
 namespace replication {
 namespace vr {
 
+// Batching at the leader adapts to load. At most pipelineWindow batches
+// await their quorum at once. A request that arrives while there is room
+// is sent right away, in a batch of its own; otherwise requests gather
+// until a batch commits, and then go out in batches of up to batchSize.
+// An idle leader thus adds no delay, and a busy one sends batches as
+// large as the requests that arrive in a round trip.
+//
+// Every checkpointInterval operations, a replica takes a checkpoint of
+// the application, if it supports SnapshotUpcall, and drops the log up
+// to it. A replica that needs operations from before another's log
+// starts is sent that replica's checkpoint along with the log after it.
+//
+// The leader holds a read lease, so it can answer unlogged requests
+// sent to it as leader without a round of messages. Prepares and null
+// commits carry the leader's clock; a backup that gets one promises not
+// to join a later view for LEASE_DURATION and echoes the time back. Once
+// f backups have echoed a time, no other leader can take over until
+// that time plus the lease has passed, less a margin for clock drift.
 class VRReplica : public Replica
 {
 public:
+    static const unsigned int DEFAULT_PIPELINE_WINDOW = 8;
+    static const opnum_t DEFAULT_CHECKPOINT_INTERVAL = 10000;
+    // In microseconds; well under the view change timeout, and over
+    // the null commit interval that renews it when idle.
+    static const uint64_t LEASE_DURATION = 2500000;
+
     VRReplica(transport::Configuration config, int myIdx,
               Transport *transport, unsigned int batchSize,
-              AppReplica *app);
+              AppReplica *app,
+              unsigned int pipelineWindow = DEFAULT_PIPELINE_WINDOW,
+              opnum_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL,
+              LogHashMode logHash = LOG_HASH_NONE);
     ~VRReplica();
     
     void ReceiveMessage(const TransportAddress &remote,
@@ -63,9 +91,25 @@ private:
     opnum_t lastRequestStateTransferOpnum;
     std::list<std::pair<TransportAddress *,
                         proto::PrepareMessage> > pendingPrepares;
-    proto::PrepareMessage lastPrepare;
+    // Prepares of this view that arrived ahead of a gap in the log, by
+    // first opnum.
+    std::map<opnum_t, proto::PrepareMessage> earlyPrepares;
     unsigned int batchSize;
+    unsigned int pipelineWindow;
     opnum_t lastBatchEnd;
+    // Last opnum of each batch sent and not yet committed.
+    std::deque<opnum_t> inFlightBatches;
+    opnum_t checkpointInterval;
+    // Latest checkpoint; the log starts right after it.
+    proto::Checkpoint checkpoint;
+    // Latest leasetime each backup has granted in this view, by index.
+    std::map<int, uint64_t> leaseGrants;
+    // Until when, on our clock, we have promised the leader of this
+    // view not to join another.
+    uint64_t leaseGrantedUntil;
+    // Last operation inherited from earlier views, which the leader
+    // must have executed before it reads under its lease.
+    opnum_t leaseStartOp;
     
     Log log;
     std::map<uint64_t, std::unique_ptr<TransportAddress> > clientAddresses;
@@ -77,17 +121,20 @@ private:
     };
     std::map<uint64_t, ClientTableEntry> clientTable;
     
-    QuorumSet<viewstamp_t, proto::PrepareOKMessage> prepareOKQuorum;
-    QuorumSet<view_t, proto::StartViewChangeMessage> startViewChangeQuorum;
-    QuorumSet<view_t, proto::DoViewChangeMessage> doViewChangeQuorum;
+    ReplicaQuorumSet<viewstamp_t, proto::PrepareOKMessage> prepareOKQuorum;
+    ReplicaQuorumSet<view_t, proto::StartViewChangeMessage> startViewChangeQuorum;
+    ReplicaQuorumSet<view_t, proto::DoViewChangeMessage> doViewChangeQuorum;
 
     Timeout *viewChangeTimeout;
     Timeout *nullCommitTimeout;
     Timeout *stateTransferTimeout;
     Timeout *resendPrepareTimeout;
-    Timeout *closeBatchTimeout;
     
     bool AmLeader() const;
+    bool HoldsLease() const;
+    bool LeaseBlocksViewChange() const;
+    void GrantLease();
+    void RecordLeaseGrant(int replicaIdx, uint64_t leasetime);
     void CommitUpTo(opnum_t upto);
     void SendPrepareOKs(opnum_t oldLastOp);
     void RequestStateTransfer();
@@ -96,7 +143,15 @@ private:
     void SendNullCommit();
     void UpdateClientTable(const Request &req);
     void ResendPrepare();
-    void CloseBatch();
+    void CloseBatch(opnum_t last);
+    void SendBatches();
+    void BatchesCommitted();
+    void BuildPrepare(opnum_t first, opnum_t last,
+                      proto::PrepareMessage &msg);
+    void AppendPrepare(const proto::PrepareMessage &msg);
+    void AppendEarlyPrepares();
+    void TakeCheckpoint();
+    void InstallCheckpoint(const proto::Checkpoint &cp);
     
     void HandleRequest(const TransportAddress &remote,
                        const proto::RequestMessage &msg);
@@ -109,6 +164,8 @@ private:
                          const proto::PrepareOKMessage &msg);
     void HandleCommit(const TransportAddress &remote,
                       const proto::CommitMessage &msg);
+    void HandleLeaseGrant(const TransportAddress &remote,
+                          const proto::LeaseGrantMessage &msg);
     void HandleRequestStateTransfer(const TransportAddress &remote,
                                     const proto::RequestStateTransferMessage &msg);
     void HandleStateTransfer(const TransportAddress &remote,
@@ -38,10 +38,12 @@
 #include "replication/vr/client.h"
 #include "replication/vr/replica.h"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <stdio.h>
 #include <gtest/gtest.h>
 #include <vector>
+#include <set>
 #include <sstream>
 
 static string replicaLastOp;
@@ -57,9 +59,11 @@ class VRApp : public AppReplica {
 
     std::vector<string> *ops;
     std::vector<string> *unloggedOps;
+    int *restores;
 
 public:
-    VRApp(std::vector<string> *o, std::vector<string> *u) : ops(o), unloggedOps(u) { }
+    VRApp(std::vector<string> *o, std::vector<string> *u, int *r)
+        : ops(o), unloggedOps(u), restores(r) { }
 
     void ReplicaUpcall(opnum_t opnum, const string &req, string &reply) {
         ops->push_back(req);
@@ -70,6 +74,29 @@ public:
         unloggedOps->push_back(req);
         reply = "unlreply: " + req;
     }
+
+    // The state is the list of operations executed, each prefixed by
+    // its length.
+    bool SnapshotUpcall(string &state) {
+        std::ostringstream stream;
+        for (const string &op : *ops) {
+            stream << op.size() << ":" << op;
+        }
+        state = stream.str();
+        return true;
+    }
+
+    void RestoreUpcall(const string &state) {
+        ops->clear();
+        size_t pos = 0;
+        while (pos < state.size()) {
+            size_t colon = state.find(':', pos);
+            size_t len = std::stoul(state.substr(pos, colon - pos));
+            ops->push_back(state.substr(colon + 1, len));
+            pos = colon + 1 + len;
+        }
+        (*restores)++;
+    }
 };
 
 class VRTest : public  ::testing::TestWithParam<int>
@@ -81,8 +108,11 @@ protected:
     transport::Configuration *config;
     std::vector<std::vector<string> > ops;
     std::vector<std::vector<string> > unloggedOps;
+    std::vector<int> restores;
     int requestNum;
 
+    static const opnum_t CHECKPOINT_INTERVAL = 10;
+
     virtual void SetUp() {
         std::vector<transport::ReplicaAddress> replicaAddrs =
             { { "localhost", "12345" },
@@ -94,9 +124,13 @@ protected:
 
         ops.resize(config->n);
         unloggedOps.resize(config->n);
+        restores.resize(config->n);
 
         for (int i = 0; i < config->n; i++) {
-            replicas.push_back(new VRReplica(*config, i, transport, GetParam(), new VRApp(&ops[i], &unloggedOps[i])));
+            replicas.push_back(new VRReplica(*config, i, transport, GetParam(),
+                                             new VRApp(&ops[i], &unloggedOps[i], &restores[i]),
+                                             VRReplica::DEFAULT_PIPELINE_WINDOW,
+                                             CHECKPOINT_INTERVAL));
         }
 
         client = new VRClient(*config, transport);
@@ -229,6 +263,84 @@ TEST_P(VRTest, UnloggedTimeout)
 }
 
 
+TEST_P(VRTest, LeaseRead)
+{
+    int timeouts = 0;
+    auto timeout = [&](const string &req, ErrorCode) {
+        timeouts++;
+    };
+    Client::continuation_t readUpcall = [&](const string &req,
+                                            const string &reply) {
+        EXPECT_EQ(req, LastRequestOp());
+        EXPECT_EQ(reply, "unlreply: "+LastRequestOp());
+        transport->CancelAllTimers();
+    };
+    // The prepare for the write gets the leader its lease.
+    Client::continuation_t upcall = [&](const string &req,
+                                        const string &reply) {
+        EXPECT_EQ(reply, "reply: "+LastRequestOp());
+        requestNum++;
+        client->InvokeUnloggedAtLeader(LastRequestOp(), readUpcall, timeout);
+    };
+    transport->Timer(10000, [&]() {
+            transport->CancelAllTimers();
+        });
+
+    ClientSendNext(upcall);
+    transport->Run();
+
+    EXPECT_EQ(1, unloggedOps[0].size());
+    EXPECT_EQ(0, unloggedOps[1].size());
+    EXPECT_EQ(0, unloggedOps[2].size());
+    EXPECT_EQ(0, timeouts);
+}
+
+TEST_P(VRTest, LeaseReadAfterFailedLeader)
+{
+    int timeouts = 0;
+    auto timeout = [&](const string &req, ErrorCode) {
+        timeouts++;
+    };
+    Client::continuation_t readUpcall = [&](const string &req,
+                                            const string &reply) {
+        EXPECT_EQ(req, LastRequestOp());
+        EXPECT_EQ(reply, "unlreply: "+LastRequestOp());
+        transport->CancelAllTimers();
+    };
+    Client::continuation_t upcall = [&](const string &req,
+                                        const string &reply) {
+        // Cut replica 0 off from the other replicas, but not from the
+        // client, and read once its lease has run out.
+        transport->AddFilter(10, [](TransportReceiver *src, int srcIdx,
+                                    TransportReceiver *dst, int dstIdx,
+                                    Message &m, uint64_t &delay) {
+                                 if ((srcIdx == 0 && dstIdx >= 0) ||
+                                     (dstIdx == 0 && srcIdx >= 0)) {
+                                     return false;
+                                 }
+                                 return true;
+                             });
+        transport->Timer(3000, [&]() {
+                requestNum++;
+                client->InvokeUnloggedAtLeader(LastRequestOp(), readUpcall,
+                                               timeout, 20000);
+            });
+    };
+    transport->Timer(30000, [&]() {
+            transport->CancelAllTimers();
+        });
+
+    ClientSendNext(upcall);
+    transport->Run();
+
+    // The old leader, which no longer knows whether it is leader, has
+    // refused the read, and the new one has served it.
+    EXPECT_EQ(0, unloggedOps[0].size());
+    EXPECT_EQ(1, unloggedOps[1].size());
+    EXPECT_EQ(0, unloggedOps[2].size());
+    EXPECT_EQ(0, timeouts);
+}
+
 TEST_P(VRTest, ManyOps)
 {
     Client::continuation_t upcall = [&](const string &req, const string &reply) {
@@ -346,6 +458,50 @@ TEST_P(VRTest, StateTransfer)
     }
 }
 
+TEST_P(VRTest, StateTransferFromCheckpoint)
+{
+    Client::continuation_t upcall = [&](const string &req, const string &reply) {
+        EXPECT_EQ(req, LastRequestOp());
+        EXPECT_EQ(reply, "reply: "+LastRequestOp());
+
+        if (requestNum == 35) {
+            // Restore replica 1, by now far behind the others'
+            // checkpoints
+            transport->RemoveFilter(10);
+        }
+
+        if (requestNum < 49) {
+            ClientSendNext(upcall);
+        } else {
+            transport->CancelAllTimers();
+        }
+    };
+
+    ClientSendNext(upcall);
+
+    // Drop messages to or from replica 1
+    transport->AddFilter(10, [](TransportReceiver *src, int srcIdx,
+                                TransportReceiver *dst, int dstIdx,
+                                Message &m, uint64_t &delay) {
+                             if ((srcIdx == 1) || (dstIdx == 1)) {
+                                 return false;
+                             }
+                             return true;
+                         });
+
+    transport->Run();
+
+    // Replica 1 caught up from a checkpoint rather than by executing
+    // every operation.
+    EXPECT_EQ(0, restores[0]);
+    EXPECT_EQ(1, restores[1]);
+    for (int i = 0; i < config->n; i++) {
+        EXPECT_EQ(50, ops[i].size());
+        for (int j = 0; j < 50; j++) {
+            EXPECT_EQ(RequestOp(j), ops[i][j]);
+        }
+    }
+}
 
 TEST_P(VRTest, FailedLeader)
 {
@@ -387,6 +543,43 @@ TEST_P(VRTest, FailedLeader)
     }
 }
 
+TEST_P(VRTest, FailedLeaderAfterCheckpoint)
+{
+    Client::continuation_t upcall = [&](const string &req, const string &reply) {
+        EXPECT_EQ(req, LastRequestOp());
+        EXPECT_EQ(reply, "reply: "+LastRequestOp());
+
+        if (requestNum == 25) {
+            // Drop messages to or from replica 0
+            transport->AddFilter(10, [](TransportReceiver *src, int srcIdx,
+                                        TransportReceiver *dst, int dstIdx,
+                                        Message &m, uint64_t &delay) {
+                                     if ((srcIdx == 0) || (dstIdx == 0)) {
+                                         return false;
+                                     }
+                                     return true;
+                                 });
+        }
+        if (requestNum < 39) {
+            ClientSendNext(upcall);
+        } else {
+            transport->CancelAllTimers();
+        }
+    };
+
+    ClientSendNext(upcall);
+
+    transport->Run();
+
+    // The new view starts from logs truncated at a checkpoint.
+    for (int i = 1; i < config->n; i++) {
+        EXPECT_EQ(40, ops[i].size());
+        for (int j = 0; j < 40; j++) {
+            EXPECT_EQ(RequestOp(j), ops[i][j]);
+        }
+    }
+}
+
 TEST_P(VRTest, DroppedReply)
 {
     bool received = false;
@@ -574,6 +767,147 @@ TEST_P(VRTest, Stress)
     }
 }
 
+TEST_P(VRTest, ReorderedPrepares)
+{
+    const int NUM_CLIENTS = 10;
+    const int MAX_REQS = 20;
+
+    std::vector<VRClient *> clients;
+    std::vector<int> lastReq;
+    std::vector<Client::continuation_t> upcalls;
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        clients.push_back(new VRClient(*config, transport));
+        lastReq.push_back(0);
+        upcalls.push_back([&, i](const string &req, const string &reply) {
+                EXPECT_EQ("reply: "+RequestOp(lastReq[i]), reply);
+                lastReq[i] += 1;
+                if (lastReq[i] < MAX_REQS) {
+                    clients[i]->Invoke(RequestOp(lastReq[i]), upcalls[i]);
+                }
+            });
+        clients[i]->Invoke(RequestOp(lastReq[i]), upcalls[i]);
+    }
+
+    // Hold back every third prepare to replica 2, so that the ones
+    // pipelined behind it arrive first, and count the prepares sent.
+    int prepares = 0;
+    int requests = 0;
+    transport->AddFilter(10, [&](TransportReceiver *src, int srcIdx,
+                                 TransportReceiver *dst, int dstIdx,
+                                 Message &m, uint64_t &delay) {
+                             if (m.GetTypeName() == "replication.vr.proto.PrepareMessage" &&
+                                 srcIdx == 0) {
+                                 prepares++;
+                                 if (dstIdx == 2 && prepares % 3 == 0) {
+                                     delay = 5;
+                                 }
+                             }
+                             if (m.GetTypeName() == "replication.vr.proto.RequestMessage") {
+                                 requests++;
+                             }
+                             return true;
+                         });
+
+    transport->Timer(7200000, [&]() {
+            transport->CancelAllTimers();
+        });
+
+    transport->Run();
+
+    for (int i = 0; i < config->n; i++) {
+        ASSERT_EQ(NUM_CLIENTS * MAX_REQS, ops[i].size());
+    }
+    for (int i = 0; i < NUM_CLIENTS*MAX_REQS; i++) {
+        for (int j = 0; j < config->n; j++) {
+            ASSERT_EQ(ops[0][i], ops[j][i]);
+        }
+    }
+
+    // Each prepare goes to both backups. With batching, requests that
+    // arrive while the pipeline is full share a prepare.
+    if (GetParam() > 1) {
+        EXPECT_LT(prepares / 2, requests);
+    }
+
+    for (VRClient *c : clients) {
+        delete c;
+    }
+}
+
+TEST_P(VRTest, BurstBeyondWindow)
+{
+    // More requests at once than the pipeline holds, even in full
+    // batches.
+    const int NUM_CLIENTS = 5 * VRReplica::DEFAULT_PIPELINE_WINDOW *
+        GetParam();
+
+    std::vector<VRClient *> clients;
+    int replies = 0;
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        clients.push_back(new VRClient(*config, transport));
+        clients[i]->Invoke(RequestOp(i), [&, i](const string &req,
+                                                const string &reply) {
+                EXPECT_EQ("reply: "+RequestOp(i), reply);
+                replies++;
+            });
+    }
+
+    // Drop the first prepare to replica 2. Track the batches the leader
+    // has sent but not yet committed, by last opnum; the window bounds
+    // them.
+    bool dropped = false;
+    std::set<opnum_t> outstanding;
+    size_t maxOutstanding = 0;
+    int largestBatch = 0;
+    transport->AddFilter(10, [&](TransportReceiver *src, int srcIdx,
+                                 TransportReceiver *dst, int dstIdx,
+                                 Message &m, uint64_t &delay) {
+                             if (m.GetTypeName() == "replication.vr.proto.PrepareMessage" &&
+                                 srcIdx == 0) {
+                                 auto &p = dynamic_cast<PrepareMessage &>(m);
+                                 largestBatch = std::max(largestBatch,
+                                                         p.request_size());
+                                 outstanding.insert(p.opnum());
+                                 maxOutstanding = std::max(maxOutstanding,
+                                                           outstanding.size());
+                                 if (dstIdx == 2 && !dropped) {
+                                     dropped = true;
+                                     return false;
+                                 }
+                             }
+                             if (m.GetTypeName() == "replication.vr.proto.CommitMessage" &&
+                                 srcIdx == 0) {
+                                 auto &c = dynamic_cast<CommitMessage &>(m);
+                                 outstanding.erase(outstanding.begin(),
+                                                   outstanding.upper_bound(c.opnum()));
+                             }
+                             return true;
+                         });
+
+    transport->Timer(7200000, [&]() {
+            transport->CancelAllTimers();
+        });
+
+    transport->Run();
+
+    EXPECT_TRUE(dropped);
+    EXPECT_EQ(NUM_CLIENTS, replies);
+    EXPECT_LE(maxOutstanding, (size_t)VRReplica::DEFAULT_PIPELINE_WINDOW);
+    EXPECT_LE(largestBatch, GetParam());
+    for (int i = 0; i < config->n; i++) {
+        ASSERT_EQ(NUM_CLIENTS, ops[i].size());
+    }
+    for (int i = 0; i < NUM_CLIENTS; i++) {
+        for (int j = 0; j < config->n; j++) {
+            ASSERT_EQ(ops[0][i], ops[j][i]);
+        }
+    }
+
+    for (VRClient *c : clients) {
+        delete c;
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(Batching,
                         VRTest,
                         ::testing::Values(1, 8));
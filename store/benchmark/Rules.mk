@@ -1,13 +1,38 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
-SRCS += $(addprefix $(d), benchClient.cc retwisClient.cc terminalClient.cc)
+SRCS += $(addprefix $(d), benchClient.cc retwisClient.cc terminalClient.cc \
+	openLoopClient.cc latencystats.cc workload.cc loadbatch.cc tpcc.cc \
+	tpccClient.cc ycsb.cc ycsbClient.cc keyGenerator.cc)
 
 OBJS-all-clients := $(OBJS-strong-client) $(OBJS-weak-client) $(OBJS-tapir-client)
 
-$(d)benchClient: $(OBJS-all-clients) $(o)benchClient.o
+OBJS-latency-stats := $(LIB-histogram) $(o)latencystats.o
 
-$(d)retwisClient: $(OBJS-all-clients) $(o)retwisClient.o
+LIB-workload := $(o)workload.o
+
+OBJS-ycsb := $(o)ycsb.o $(o)loadbatch.o $(LIB-workload)
+
+$(d)benchClient: $(OBJS-all-clients) $(OBJS-latency-stats) $(LIB-workload) \
+	$(o)benchClient.o
+
+$(d)retwisClient: $(OBJS-all-clients) $(OBJS-latency-stats) $(LIB-workload) \
+	$(o)retwisClient.o
 
 $(d)terminalClient: $(OBJS-all-clients) $(o)terminalClient.o
 
-BINS += $(d)benchClient $(d)retwisClient $(d)terminalClient
+$(d)openLoopClient: $(OBJS-tapir-async-client) $(OBJS-latency-stats) \
+	$(LIB-workload) $(o)openLoopClient.o
+
+$(d)tpccClient: $(OBJS-all-clients) $(OBJS-latency-stats) $(o)loadbatch.o \
+	$(o)tpcc.o $(o)tpccClient.o
+
+$(d)ycsbClient: $(OBJS-all-clients) $(OBJS-latency-stats) $(OBJS-ycsb) \
+	$(o)ycsbClient.o
+
+$(d)keyGenerator: $(LIB-message) $(LIB-store-common) $(LIB-workload) \
+	$(o)keyGenerator.o
+
+BINS += $(d)benchClient $(d)retwisClient $(d)terminalClient \
+	$(d)openLoopClient $(d)tpccClient $(d)ycsbClient $(d)keyGenerator
+
+include $(d)tests/Rules.mk
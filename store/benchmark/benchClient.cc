@@ -6,6 +6,9 @@
  *
  **********************************************************************/
 
+#include "store/benchmark/latencystats.h"
+#include "store/benchmark/workload.h"
+#include "store/common/keyset.h"
 #include "store/common/truetime.h"
 #include "store/common/frontend/client.h"
 #include "store/strongstore/client.h"
@@ -14,14 +17,12 @@
 
 using namespace std;
 
-// Function to pick a random key according to some distribution.
-int rand_key();
-
-bool ready = false;
 double alpha = -1;
-double *zipf;
+// Picks indices into keys: zipfian with coefficient alpha, or uniform if
+// alpha is negative.
+workload::IntegerGenerator *keyChooser;
 
-vector<string> keys;
+KeySet keys;
 int nKeys = 100;
 
 int
@@ -36,6 +37,7 @@ main(int argc, char **argv)
     int closestReplica = -1; // Closest replica id.
     int skew = 0; // difference between real clock and TrueTime
     int error = 0; // error bars
+    int interval = 1; // Seconds between latency reports.
 
     Client *client;
     enum {
@@ -49,7 +51,7 @@ main(int argc, char **argv)
     strongstore::Mode strongmode;
 
     int opt;
-    while ((opt = getopt(argc, argv, "c:d:N:l:w:k:f:m:e:s:z:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "c:d:N:l:w:k:f:m:e:s:z:r:i:")) != -1) {
         switch (opt) {
         case 'c': // Configuration path
         { 
@@ -166,6 +168,17 @@ main(int argc, char **argv)
             break;
         }
 
+        case 'i': // Seconds between latency reports.
+        {
+            char *strtolPtr;
+            interval = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') ||
+                (interval <= 0)) {
+                fprintf(stderr, "option -i requires a numeric arg\n");
+            }
+            break;
+        }
+
         case 'm': // Mode to run in [occ/lock/...]
         {
             if (strcasecmp(optarg, "txn-l") == 0) {
@@ -213,140 +226,63 @@ main(int argc, char **argv)
         exit(0);
     }
 
+    keyChooser = workload::NewKeyChooser(nKeys, alpha);
+
     // Read in the keys from a file.
-    string key, value;
-    ifstream in;
-    in.open(keysPath);
-    if (!in) {
-        fprintf(stderr, "Could not read keys from: %s\n", keysPath);
+    if (!keys.Open(keysPath) || (int)keys.Size() < nKeys) {
+        fprintf(stderr, "Could not read %d keys from: %s\n", nKeys, keysPath);
         exit(0);
     }
-    for (int i = 0; i < nKeys; i++) {
-        getline(in, key);
-        keys.push_back(key);
-    }
-    in.close();
-
+    string key, value;
 
-    struct timeval t0, t1, t2, t3, t4;
+    typedef chrono::steady_clock Clock;
+    auto us = [](Clock::time_point a, Clock::time_point b) -> uint64_t {
+        return chrono::duration_cast<chrono::microseconds>(b - a).count();
+    };
 
-    int nTransactions = 0;
-    int tCount = 0;
-    double tLatency = 0.0;
-    int getCount = 0;
-    double getLatency = 0.0;
-    int putCount = 0;
-    double putLatency = 0.0;
-    int beginCount = 0;
-    double beginLatency = 0.0;
-    int commitCount = 0;
-    double commitLatency = 0.0;
+    // Latencies of each operation, and of whole transactions by outcome.
+    LatencyStats stats(stderr, interval);
+    Clock::time_point t0, t1, t2, t3, t4;
 
-    gettimeofday(&t0, NULL);
-    srand(t0.tv_sec + t0.tv_usec);
+    t0 = Clock::now();
 
     while (1) {
-        gettimeofday(&t4, NULL);
+        t4 = Clock::now();
         client->Begin();
-        gettimeofday(&t1, NULL);
-        
-        beginCount++;
-        beginLatency += ((t1.tv_sec - t4.tv_sec)*1000000 + (t1.tv_usec - t4.tv_usec));
-        
+        t1 = Clock::now();
+        stats.Record("begin", us(t4, t1));
+
         for (int j = 0; j < tLen; j++) {
-            key = keys[rand_key()];
+            key = keys[keyChooser->Next()];
 
-            if (rand() % 100 < wPer) {
-                gettimeofday(&t3, NULL);
+            if ((int)workload::RandomInt(0, 99) < wPer) {
+                t3 = Clock::now();
                 client->Put(key, key);
-                gettimeofday(&t4, NULL);
-                
-                putCount++;
-                putLatency += ((t4.tv_sec - t3.tv_sec)*1000000 + (t4.tv_usec - t3.tv_usec));
+                t4 = Clock::now();
+                stats.Record("put", us(t3, t4));
             } else {
-                gettimeofday(&t3, NULL);
+                t3 = Clock::now();
                 client->Get(key, value);
-                gettimeofday(&t4, NULL);
-
-                getCount++;
-                getLatency += ((t4.tv_sec - t3.tv_sec)*1000000 + (t4.tv_usec - t3.tv_usec));
+                t4 = Clock::now();
+                stats.Record("get", us(t3, t4));
             }
         }
 
-        gettimeofday(&t3, NULL);
+        t3 = Clock::now();
         bool status = client->Commit();
-        gettimeofday(&t2, NULL);
+        t2 = Clock::now();
+        stats.Record("commit", us(t3, t2));
+        stats.Record(status ? "txn.commit" : "txn.abort", us(t1, t2));
+        stats.Tick();
 
-        commitCount++;
-        commitLatency += ((t2.tv_sec - t3.tv_sec)*1000000 + (t2.tv_usec - t3.tv_usec));
-
-        long latency = (t2.tv_sec - t1.tv_sec)*1000000 + (t2.tv_usec - t1.tv_usec);
-
-        fprintf(stderr, "%d %ld.%06ld %ld.%06ld %ld %d\n", nTransactions+1, t1.tv_sec,
-                t1.tv_usec, t2.tv_sec, t2.tv_usec, latency, status?1:0);
-
-        if (status) {
-            tCount++;
-            tLatency += latency;
-        }
-        nTransactions++;
-
-        gettimeofday(&t1, NULL);
-        if ( ((t1.tv_sec-t0.tv_sec)*1000000 + (t1.tv_usec-t0.tv_usec)) > duration*1000000) 
+        if (t2 - t0 > chrono::seconds(duration))
             break;
     }
+    stats.Finish();
 
-    fprintf(stderr, "# Commit_Ratio: %lf\n", (double)tCount/nTransactions);
-    fprintf(stderr, "# Overall_Latency: %lf\n", tLatency/tCount);
-    fprintf(stderr, "# Begin: %d, %lf\n", beginCount, beginLatency/beginCount);
-    fprintf(stderr, "# Get: %d, %lf\n", getCount, getLatency/getCount);
-    fprintf(stderr, "# Put: %d, %lf\n", putCount, putLatency/putCount);
-    fprintf(stderr, "# Commit: %d, %lf\n", commitCount, commitLatency/commitCount);
-    
-    return 0;
-}
-
-int rand_key()
-{
-    if (alpha < 0) {
-        // Uniform selection of keys.
-        return (rand() % nKeys);
-    } else {
-        // Zipf-like selection of keys.
-        if (!ready) {
-            zipf = new double[nKeys];
-
-            double c = 0.0;
-            for (int i = 1; i <= nKeys; i++) {
-                c = c + (1.0 / pow((double) i, alpha));
-            }
-            c = 1.0 / c;
-
-            double sum = 0.0;
-            for (int i = 1; i <= nKeys; i++) {
-                sum += (c / pow((double) i, alpha));
-                zipf[i-1] = sum;
-            }
-            ready = true;
-        }
-
-        double random = 0.0;
-        while (random == 0.0 || random == 1.0) {
-            random = (1.0 + rand())/RAND_MAX;
-        }
+    uint64_t nCommitted = stats.Count("txn.commit");
+    uint64_t nTransactions = nCommitted + stats.Count("txn.abort");
+    fprintf(stderr, "# Commit_Ratio: %lf\n", (double)nCommitted/nTransactions);
 
-        // binary search to find key;
-        int l = 0, r = nKeys, mid;
-        while (l < r) {
-            mid = (l + r) / 2;
-            if (random > zipf[mid]) {
-                l = mid + 1;
-            } else if (random < zipf[mid]) {
-                r = mid - 1;
-            } else {
-                break;
-            }
-        }
-        return mid;
-    } 
+    return 0;
 }
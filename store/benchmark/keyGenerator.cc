@@ -0,0 +1,109 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/keyGenerator.cc:
+ *   Writes a binary key set, of random keys or of the keys of a text
+ *   file, for servers to preload and benchmark clients to use.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/workload.h"
+#include "store/common/keyset.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void
+Usage(const char *progName)
+{
+    fprintf(stderr, "usage: %s -o out-file -N n-shards "
+            "(-k n-keys [-l key-length] | -f text-key-file)\n", progName);
+    exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *outPath = NULL;
+    const char *textPath = NULL;
+    long nKeys = -1;
+    long keyLength = 64;
+    long nShards = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:f:k:l:N:")) != -1) {
+        switch (opt) {
+        case 'o': // Binary key set to write.
+            outPath = optarg;
+            break;
+
+        case 'f': // Text file of keys to convert, one per line.
+            textPath = optarg;
+            break;
+
+        case 'k': // Number of random keys to generate.
+        case 'l': // Length of each random key.
+        case 'N': // Number of shards to place the keys in.
+        {
+            char *strtolPtr;
+            long value = strtol(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (value <= 0)) {
+                fprintf(stderr, "option -%c requires a positive arg\n", opt);
+                Usage(argv[0]);
+            }
+            switch (opt) {
+            case 'k': nKeys = value; break;
+            case 'l': keyLength = value; break;
+            case 'N': nShards = value; break;
+            }
+            break;
+        }
+
+        default:
+            Usage(argv[0]);
+        }
+    }
+
+    if (outPath == NULL || nShards <= 0 ||
+        (textPath == NULL) == (nKeys <= 0)) {
+        Usage(argv[0]);
+    }
+
+    vector<string> keys;
+    if (textPath != NULL) {
+        KeySet text;
+        if (!text.Open(textPath)) {
+            fprintf(stderr, "Could not read keys from: %s\n", textPath);
+            exit(1);
+        }
+        keys.reserve(text.Size());
+        for (size_t i = 0; i < text.Size(); i++) {
+            keys.push_back(text[i]);
+        }
+    } else {
+        // Random keys, as store/tools/key_generator.py makes them.
+        static const char charset[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+            "abcdefghijklmnopqrstuvwxyz0123456789";
+        keys.reserve(nKeys);
+        for (long i = 0; i < nKeys; i++) {
+            string key(keyLength, ' ');
+            for (long j = 0; j < keyLength; j++) {
+                key[j] = charset[workload::RandomInt(0, sizeof(charset) - 2)];
+            }
+            keys.push_back(key);
+        }
+    }
+
+    if (!KeySet::Write(outPath, keys, nShards)) {
+        fprintf(stderr, "Could not write keys to: %s\n", outPath);
+        exit(1);
+    }
+    fprintf(stderr, "# Wrote %lu keys\n", keys.size());
+    return 0;
+}
@@ -0,0 +1,81 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/latencystats.cc:
+ *   Latency histograms of a benchmark client, reported periodically.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/latencystats.h"
+
+#include <inttypes.h>
+
+using namespace std;
+
+LatencyStats::LatencyStats(FILE *out, int intervalSec)
+    : out(out), interval(chrono::seconds(intervalSec > 0 ? intervalSec : 1))
+{
+    start = Clock::now();
+    intervalEnd = start + interval;
+}
+
+void
+LatencyStats::Record(const string &name, uint64_t latency)
+{
+    current[name].Record(latency);
+    total[name].Record(latency);
+}
+
+uint64_t
+LatencyStats::Count(const string &name) const
+{
+    auto it = total.find(name);
+    return it == total.end() ? 0 : it->second.Count();
+}
+
+void
+LatencyStats::Tick()
+{
+    Clock::time_point now = Clock::now();
+    if (now < intervalEnd) {
+        return;
+    }
+
+    WriteInterval(now);
+    while (intervalEnd <= now) {
+        intervalEnd += interval;
+    }
+}
+
+void
+LatencyStats::WriteInterval(Clock::time_point now)
+{
+    double elapsed = chrono::duration<double>(now - start).count();
+    for (auto &h : current) {
+        if (h.second.Count() == 0) {
+            continue;
+        }
+        fprintf(out, "# Interval %.3f %s %" PRIu64 " %.1f %" PRIu64
+                " %" PRIu64 " %" PRIu64 " %" PRIu64 " %s\n",
+                elapsed, h.first.c_str(), h.second.Count(), h.second.Mean(),
+                h.second.Percentile(50), h.second.Percentile(99),
+                h.second.Percentile(99.9), h.second.Max(),
+                h.second.Serialize().c_str());
+        h.second.Reset();
+    }
+    fflush(out);
+}
+
+void
+LatencyStats::Finish()
+{
+    WriteInterval(Clock::now());
+    for (auto &h : total) {
+        fprintf(out, "# Summary %s %" PRIu64 " %.1f %" PRIu64 " %" PRIu64
+                " %" PRIu64 " %" PRIu64 "\n",
+                h.first.c_str(), h.second.Count(), h.second.Mean(),
+                h.second.Percentile(50), h.second.Percentile(99),
+                h.second.Percentile(99.9), h.second.Max());
+    }
+    fflush(out);
+}
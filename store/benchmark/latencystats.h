@@ -0,0 +1,60 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/latencystats.h:
+ *   Latency histograms of a benchmark client, reported periodically.
+ *
+ **********************************************************************/
+
+#ifndef _BENCHMARK_LATENCY_STATS_H_
+#define _BENCHMARK_LATENCY_STATS_H_
+
+#include "lib/histogram.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+
+// Keeps a histogram per operation type or transaction outcome, by name,
+// and writes them to out as "#" lines that store/tools/process_logs.py
+// reads back. Every interval, and once more at the end, each histogram
+// that recorded anything in the interval is written as
+//
+//   # Interval <seconds since start> <name> <count> <mean> <p50> <p99>
+//       <p99.9> <max> <buckets>
+//
+// with buckets as in Histogram::Serialize, and at the end each histogram
+// over the whole run as
+//
+//   # Summary <name> <count> <mean> <p50> <p99> <p99.9> <max>
+//
+// Latencies are in microseconds.
+class LatencyStats
+{
+public:
+    LatencyStats(FILE *out, int intervalSec);
+
+    void Record(const std::string &name, uint64_t latency);
+    uint64_t Count(const std::string &name) const;
+
+    // Write out the interval histograms, if an interval has passed.
+    void Tick();
+
+    // Write out the last interval and the summary.
+    void Finish();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    FILE *out;
+    Clock::duration interval;
+    Clock::time_point start;
+    Clock::time_point intervalEnd;
+    std::map<std::string, Histogram> total;
+    std::map<std::string, Histogram> current;
+
+    void WriteInterval(Clock::time_point now);
+};
+
+#endif /* _BENCHMARK_LATENCY_STATS_H_ */
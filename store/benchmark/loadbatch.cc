@@ -0,0 +1,75 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/loadbatch.cc:
+ *   Loads benchmark data through a transactional client in batches.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/loadbatch.h"
+#include "store/common/transaction.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+// Writes per transaction.
+static const size_t LOAD_BATCH = 100;
+static const int LOAD_RETRIES = 10;
+static const int LOAD_SYNC_WAIT_US = 10000;
+
+void
+LoadBatch::Put(const string &key, const string &value)
+{
+    writes.push_back(make_pair(key, value));
+    lastKey = key;
+    if (writes.size() >= LOAD_BATCH) {
+        Flush();
+    }
+}
+
+void
+LoadBatch::Flush()
+{
+    if (writes.empty()) {
+        return;
+    }
+    for (int attempt = 0; attempt < LOAD_RETRIES; attempt++) {
+        client->Begin();
+        for (auto &write : writes) {
+            client->Put(write.first, write.second);
+        }
+        if (client->Commit()) {
+            writes.clear();
+            return;
+        }
+        Warning("Load transaction of %lu writes aborted", writes.size());
+    }
+    Panic("Unable to load %s", writes.front().first.c_str());
+}
+
+void
+LoadBatch::Sync()
+{
+    Flush();
+    if (lastKey.empty()) {
+        return;
+    }
+    for (int attempt = 0; attempt < LOAD_RETRIES; attempt++) {
+        string value;
+        client->Begin();
+        int status = client->Get(lastKey, value);
+        client->Commit();
+        if (status == REPLY_OK) {
+            // Strong store shard clients wait for the previous commit
+            // when beginning, so this makes sure the read above released
+            // its locks. TAPIR's do not wait, and need not: they track
+            // each request by id, so the read's commit may still be in
+            // flight, but it holds nothing a later load could block on.
+            client->Begin();
+            return;
+        }
+        usleep(LOAD_SYNC_WAIT_US);
+    }
+    Panic("Unable to read back %s", lastKey.c_str());
+}
@@ -0,0 +1,39 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/loadbatch.h:
+ *   Loads benchmark data through a transactional client in batches.
+ *
+ **********************************************************************/
+
+#ifndef _BENCHMARK_LOAD_BATCH_H_
+#define _BENCHMARK_LOAD_BATCH_H_
+
+#include "store/common/frontend/client.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Buffers a loader's writes and commits them in transactions of a
+// bounded number of writes, retrying the ones that abort.
+class LoadBatch
+{
+public:
+    LoadBatch(Client *client) : client(client) { }
+
+    void Put(const std::string &key, const std::string &value);
+    void Flush();
+
+    // Flush, and wait until the last write can be read. Commits go out
+    // asynchronously, so returning sooner could leave the last of them
+    // unsent when the loader exits.
+    void Sync();
+
+private:
+    Client *client;
+    std::vector<std::pair<std::string, std::string> > writes;
+    std::string lastKey;
+};
+
+#endif /* _BENCHMARK_LOAD_BATCH_H_ */
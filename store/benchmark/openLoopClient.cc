@@ -0,0 +1,364 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/openLoopClient.cc:
+ *   Benchmarking client that runs many virtual clients in one process
+ *   on the asynchronous tapir client, with open-loop Poisson arrivals.
+ *
+ **********************************************************************/
+
+#include "lib/udptransport.h"
+#include "store/benchmark/latencystats.h"
+#include "store/benchmark/workload.h"
+#include "store/common/keyset.h"
+#include "store/common/truetime.h"
+#include "store/tapirstore/asyncclient.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+namespace {
+
+// Workload and run parameters.
+int duration = 10;
+int tLen = 10;
+int wPer = 50; // Out of 100
+double rate = 0; // Transactions per second; 0 runs closed-loop.
+int nClients = 1000;
+int interval = 1; // Seconds between latency reports.
+
+KeySet keys;
+double alpha = -1;
+// Picks indices into keys: zipfian with coefficient alpha, or uniform if
+// alpha is negative.
+workload::IntegerGenerator *keyChooser;
+
+tapirstore::AsyncClient *client;
+UDPTransport *eventTransport;
+
+// Virtual clients not running a transaction, and the arrivals waiting for
+// one of them, by intended start time.
+int idle;
+deque<Clock::time_point> arrivals;
+Clock::time_point nextArrival;
+Clock::time_point startTime;
+Clock::time_point endTime;
+bool stopping = false;
+int inFlight = 0;
+
+// Results. Latencies are measured from the intended start time, so that
+// time spent waiting for a free virtual client counts against the system
+// rather than silently lowering the offered load.
+LatencyStats *stats;
+
+// A transaction of tLen operations; consecutive reads go out as one batch.
+struct ClientTxn
+{
+    tapirstore::AsyncClient::Txn *txn;
+    Clock::time_point intended;
+    int op;
+};
+
+// Transactions started and not yet finished.
+unordered_set<ClientTxn *> running;
+
+// How long to wait for transactions still running at the end.
+const int DRAIN_TIMEOUT_MS = 5000;
+
+void StartTransaction(Clock::time_point intended);
+void Dispatch();
+
+// Stop starting transactions, and the transport once the ones running
+// have finished. Whatever is still running or waiting for a virtual client
+// now is counted as incomplete, with its latency so far: leaving it out
+// would hide exactly the slowest transactions.
+void
+Stop()
+{
+    if (stopping) {
+        return;
+    }
+    stopping = true;
+
+    Clock::time_point now = Clock::now();
+    auto incomplete = [now](Clock::time_point intended) {
+        stats->Record("txn.incomplete",
+                      chrono::duration_cast<chrono::microseconds>(
+                          now - intended).count());
+    };
+    for (ClientTxn *t : running) {
+        incomplete(t->intended);
+    }
+    for (Clock::time_point intended : arrivals) {
+        incomplete(intended);
+    }
+    arrivals.clear();
+
+    if (inFlight == 0) {
+        eventTransport->Stop();
+    } else {
+        eventTransport->Timer(DRAIN_TIMEOUT_MS, []() { eventTransport->Stop(); });
+    }
+}
+
+void
+FinishTransaction(ClientTxn *t, bool committed)
+{
+    uint64_t latency = chrono::duration_cast<chrono::microseconds>(
+        Clock::now() - t->intended).count();
+    running.erase(t);
+    delete t;
+    inFlight--;
+
+    if (!stopping) {
+        stats->Record(committed ? "txn.commit" : "txn.abort", latency);
+        stats->Tick();
+    }
+
+    idle++;
+    if (stopping) {
+        if (inFlight == 0) {
+            eventTransport->Stop();
+        }
+        return;
+    }
+
+    // A closed-loop client starts its next transaction right away.
+    if (rate <= 0) {
+        StartTransaction(Clock::now());
+    } else {
+        Dispatch();
+    }
+}
+
+void
+RunOperations(ClientTxn *t)
+{
+    vector<string> reads;
+    while (t->op < tLen) {
+        const string &key = keys[keyChooser->Next()];
+        if ((int)workload::RandomInt(0, 99) < wPer) {
+            if (!reads.empty()) {
+                // Leave the write for after the pending reads.
+                break;
+            }
+            client->Put(t->txn, key, key);
+        } else {
+            reads.push_back(key);
+        }
+        t->op++;
+    }
+
+    if (!reads.empty()) {
+        client->Get(t->txn, reads,
+            [t](int status, const vector<string> &values) {
+                if (status != REPLY_OK) {
+                    client->Abort(t->txn);
+                    FinishTransaction(t, false);
+                } else {
+                    RunOperations(t);
+                }
+            });
+        return;
+    }
+
+    client->Commit(t->txn, [t](bool committed) {
+        FinishTransaction(t, committed);
+    });
+}
+
+void
+StartTransaction(Clock::time_point intended)
+{
+    idle--;
+    inFlight++;
+
+    ClientTxn *t = new ClientTxn();
+    t->txn = client->Begin();
+    t->intended = intended;
+    t->op = 0;
+    running.insert(t);
+    RunOperations(t);
+}
+
+// Hand waiting arrivals to idle virtual clients.
+void
+Dispatch()
+{
+    while (idle > 0 && !arrivals.empty()) {
+        Clock::time_point intended = arrivals.front();
+        arrivals.pop_front();
+        StartTransaction(intended);
+    }
+}
+
+// Generate the arrivals due by now. Transport timers only have
+// millisecond resolution, so this runs every millisecond and catches up
+// on however many arrivals fell into it.
+void
+Tick()
+{
+    Clock::time_point now = Clock::now();
+    if (now >= endTime) {
+        Stop();
+        return;
+    }
+
+    exponential_distribution<double> interarrival(rate);
+    while (nextArrival <= now) {
+        arrivals.push_back(nextArrival);
+        nextArrival += chrono::duration_cast<Clock::duration>(
+            chrono::duration<double>(interarrival(workload::ThreadRandom())));
+    }
+    Dispatch();
+
+    eventTransport->Timer(1, Tick);
+}
+
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    const char *configPath = NULL;
+    const char *keysPath = NULL;
+    int nKeys = 100;
+    int nShards = 1;
+    int closestReplica = -1; // Closest replica id.
+    int skew = 0; // difference between real clock and TrueTime
+    int error = 0; // error bars
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:N:l:w:k:f:e:s:z:r:R:C:i:")) != -1) {
+        switch (opt) {
+        case 'c': // Configuration path
+            configPath = optarg;
+            break;
+
+        case 'f': // Generated keys path
+            keysPath = optarg;
+            break;
+
+        case 'N': // Number of shards.
+        case 'd': // Duration in seconds to run.
+        case 'l': // Length of each transaction (deterministic!)
+        case 'w': // Percentage of writes (out of 100)
+        case 'k': // Number of keys to operate on.
+        case 's': // Simulated clock skew.
+        case 'e': // Simulated clock error.
+        case 'r': // Preferred closest replica.
+        case 'C': // Number of virtual clients.
+        case 'i': // Seconds between latency reports.
+        {
+            char *strtolPtr;
+            long value = strtol(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (value < 0)) {
+                fprintf(stderr, "option -%c requires a numeric arg\n", opt);
+                exit(0);
+            }
+            switch (opt) {
+            case 'N': nShards = value; break;
+            case 'd': duration = value; break;
+            case 'l': tLen = value; break;
+            case 'w': wPer = value; break;
+            case 'k': nKeys = value; break;
+            case 's': skew = value; break;
+            case 'e': error = value; break;
+            case 'r': closestReplica = value; break;
+            case 'C': nClients = value; break;
+            case 'i': interval = value; break;
+            }
+            break;
+        }
+
+        case 'z': // Zipf coefficient for key selection.
+        case 'R': // Arrival rate in transactions per second.
+        {
+            char *strtodPtr;
+            double value = strtod(optarg, &strtodPtr);
+            if ((*optarg == '\0') || (*strtodPtr != '\0')) {
+                fprintf(stderr, "option -%c requires a numeric arg\n", opt);
+                exit(0);
+            }
+            if (opt == 'z') {
+                alpha = value;
+            } else {
+                rate = value;
+            }
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            break;
+        }
+    }
+
+    if (configPath == NULL || keysPath == NULL) {
+        fprintf(stderr, "options -c and -f are required\n");
+        exit(0);
+    }
+    if (nClients <= 0) {
+        fprintf(stderr, "option -C requires a positive number\n");
+        exit(0);
+    }
+
+    keyChooser = workload::NewKeyChooser(nKeys, alpha);
+
+    // Read in the keys from a file.
+    if (!keys.Open(keysPath) || (int)keys.Size() < nKeys) {
+        fprintf(stderr, "Could not read %d keys from: %s\n", nKeys, keysPath);
+        exit(0);
+    }
+
+    eventTransport = new UDPTransport(0.0, 0.0, 0, false);
+    client = new tapirstore::AsyncClient(configPath, nShards, closestReplica,
+                                         eventTransport, TrueTime(skew, error));
+    idle = nClients;
+
+    eventTransport->Timer(0, []() {
+        stats = new LatencyStats(stderr, interval);
+        startTime = Clock::now();
+        endTime = startTime + chrono::seconds(duration);
+        if (rate > 0) {
+            nextArrival = startTime;
+            Tick();
+        } else {
+            for (int i = 0; i < nClients; i++) {
+                StartTransaction(Clock::now());
+            }
+            eventTransport->Timer(duration * 1000, Stop);
+        }
+    });
+    eventTransport->Run();
+
+    stats->Finish();
+
+    double elapsed = chrono::duration<double>(endTime - startTime).count();
+    uint64_t nCommitted = stats->Count("txn.commit");
+    uint64_t nTransactions = nCommitted + stats->Count("txn.abort");
+    fprintf(stderr, "# Offered_Rate: %lf\n", rate);
+    fprintf(stderr, "# Virtual_Clients: %d\n", nClients);
+    fprintf(stderr, "# Throughput: %lf\n", nCommitted / elapsed);
+    fprintf(stderr, "# Commit_Ratio: %lf\n",
+            (double)nCommitted / max<uint64_t>(1, nTransactions));
+    fprintf(stderr, "# Incomplete: %lu\n", stats->Count("txn.incomplete"));
+
+    delete stats;
+    delete client;
+    delete eventTransport;
+    return 0;
+}
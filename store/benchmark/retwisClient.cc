@@ -6,6 +6,9 @@
  *
  **********************************************************************/
 
+#include "store/benchmark/latencystats.h"
+#include "store/benchmark/workload.h"
+#include "store/common/keyset.h"
 #include "store/common/truetime.h"
 #include "store/common/frontend/client.h"
 #include "store/strongstore/client.h"
@@ -15,14 +18,12 @@
 
 using namespace std;
 
-// Function to pick a random key according to some distribution.
-int rand_key();
-
-bool ready = false;
 double alpha = -1;
-double *zipf;
+// Picks indices into keys: zipfian with coefficient alpha, or uniform if
+// alpha is negative.
+workload::IntegerGenerator *keyChooser;
 
-vector<string> keys;
+KeySet keys;
 int nKeys = 100;
 
 int
@@ -35,6 +36,7 @@ main(int argc, char **argv)
     int closestReplica = -1; // Closest replica id.
     int skew = 0; // difference between real clock and TrueTime
     int error = 0; // error bars
+    int interval = 1; // Seconds between latency reports.
 
     Client *client;
     enum {
@@ -48,7 +50,7 @@ main(int argc, char **argv)
     strongstore::Mode strongmode;
 
     int opt;
-    while ((opt = getopt(argc, argv, "c:d:N:k:f:m:e:s:z:r:")) != -1) {
+    while ((opt = getopt(argc, argv, "c:d:N:k:f:m:e:s:z:r:i:")) != -1) {
         switch (opt) {
         case 'c': // Configuration path
         { 
@@ -143,6 +145,17 @@ main(int argc, char **argv)
             break;
         }
 
+        case 'i': // Seconds between latency reports.
+        {
+            char *strtolPtr;
+            interval = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') ||
+                (interval <= 0)) {
+                fprintf(stderr, "option -i requires a numeric arg\n");
+            }
+            break;
+        }
+
         case 'm': // Mode to run in [occ/lock/...]
         {
             if (strcasecmp(optarg, "txn-l") == 0) {
@@ -190,46 +203,47 @@ main(int argc, char **argv)
         exit(0);
     }
 
+    keyChooser = workload::NewKeyChooser(nKeys, alpha);
+
     // Read in the keys from a file.
-    string key, value;
-    ifstream in;
-    in.open(keysPath);
-    if (!in) {
-        fprintf(stderr, "Could not read keys from: %s\n", keysPath);
+    if (!keys.Open(keysPath) || (int)keys.Size() < nKeys) {
+        fprintf(stderr, "Could not read %d keys from: %s\n", nKeys, keysPath);
         exit(0);
     }
-    for (int i = 0; i < nKeys; i++) {
-        getline(in, key);
-        keys.push_back(key);
-    }
-    in.close();
+    string key, value;
+
+    // Latencies of each type of transaction, and of all of them, by
+    // outcome.
+    static const char *ttypeNames[] = {
+        "", "add_user", "follow", "post_tweet", "get_timeline"
+    };
+    LatencyStats stats(stderr, interval);
 
-    struct timeval t0, t1, t2;
-    int nTransactions = 0; // Number of transactions attempted.
+    typedef chrono::steady_clock Clock;
+    Clock::time_point t0, t1, t2;
     int ttype; // Transaction type.
     int ret;
     bool status;
     vector<int> keyIdx;
 
-    gettimeofday(&t0, NULL);
-    srand(t0.tv_sec + t0.tv_usec);
+    t0 = Clock::now();
 
     while (1) {
         keyIdx.clear();
             
         // Begin a transaction.
         client->Begin();
-        gettimeofday(&t1, NULL);
+        t1 = Clock::now();
         status = true;
 
         // Decide which type of retwis transaction it is going to be.
-        ttype = rand() % 100;
+        ttype = workload::RandomInt(0, 99);
 
         if (ttype < 5) {
             // 5% - Add user transaction. 1,3
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
             sort(keyIdx.begin(), keyIdx.end());
             
             if ((ret = client->Get(keys[keyIdx[0]], value))) {
@@ -243,8 +257,8 @@ main(int argc, char **argv)
             ttype = 1;
         } else if (ttype < 20) {
             // 15% - Follow/Unfollow transaction. 2,2
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
             sort(keyIdx.begin(), keyIdx.end());
 
             for (int i = 0; i < 2 && status; i++) {
@@ -257,11 +271,11 @@ main(int argc, char **argv)
             ttype = 2;
         } else if (ttype < 50) {
             // 30% - Post tweet transaction. 3,5
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
-            keyIdx.push_back(rand_key());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
+            keyIdx.push_back(keyChooser->Next());
             sort(keyIdx.begin(), keyIdx.end());
 
             for (int i = 0; i < 3 && status; i++) {
@@ -277,17 +291,19 @@ main(int argc, char **argv)
             ttype = 3;
         } else {
             // 50% - Get followers/timeline transaction. rand(1,10),0
-            int nGets = 1 + rand() % 10;
+            int nGets = workload::RandomInt(1, 10);
             for (int i = 0; i < nGets; i++) {
-                keyIdx.push_back(rand_key());
+                keyIdx.push_back(keyChooser->Next());
             }
 
             sort(keyIdx.begin(), keyIdx.end());
-            for (int i = 0; i < nGets && status; i++) {
-                if ((ret = client->Get(keys[keyIdx[i]], value))) {
-                    Warning("Aborting due to %s %d", keys[keyIdx[i]].c_str(), ret);
-                    status = false;
-                }
+            vector<string> getKeys, values;
+            for (int i = 0; i < nGets; i++) {
+                getKeys.push_back(keys[keyIdx[i]]);
+            }
+            if ((ret = client->MultiGet(getKeys, values))) {
+                Warning("Aborting due to multi-get of %d keys %d", nGets, ret);
+                status = false;
             }
             ttype = 4;
         }
@@ -297,68 +313,20 @@ main(int argc, char **argv)
         } else {
             Debug("Aborting transaction due to failed Read");
         }
-        gettimeofday(&t2, NULL);
-        
-        long latency = (t2.tv_sec - t1.tv_sec) * 1000000 + (t2.tv_usec - t1.tv_usec);
-
-        int retries = 0;
-        if (!client->Stats().empty()) {
-            retries = client->Stats()[0];
-        }
+        t2 = Clock::now();
 
-        fprintf(stderr, "%d %ld.%06ld %ld.%06ld %ld %d %d %d", ++nTransactions, t1.tv_sec,
-                t1.tv_usec, t2.tv_sec, t2.tv_usec, latency, status?1:0, ttype, retries);
-        fprintf(stderr, "\n");
+        uint64_t latency =
+            chrono::duration_cast<chrono::microseconds>(t2 - t1).count();
+        const char *outcome = status ? ".commit" : ".abort";
+        stats.Record(string(ttypeNames[ttype]) + outcome, latency);
+        stats.Record(string("txn") + outcome, latency);
+        stats.Tick();
 
-        if (((t2.tv_sec-t0.tv_sec)*1000000 + (t2.tv_usec-t0.tv_usec)) > duration*1000000) 
+        if (t2 - t0 > chrono::seconds(duration))
             break;
     }
+    stats.Finish();
 
     fprintf(stderr, "# Client exiting..\n");
     return 0;
 }
-
-int rand_key()
-{
-    if (alpha < 0) {
-        // Uniform selection of keys.
-        return (rand() % nKeys);
-    } else {
-        // Zipf-like selection of keys.
-        if (!ready) {
-            zipf = new double[nKeys];
-
-            double c = 0.0;
-            for (int i = 1; i <= nKeys; i++) {
-                c = c + (1.0 / pow((double) i, alpha));
-            }
-            c = 1.0 / c;
-
-            double sum = 0.0;
-            for (int i = 1; i <= nKeys; i++) {
-                sum += (c / pow((double) i, alpha));
-                zipf[i-1] = sum;
-            }
-            ready = true;
-        }
-
-        double random = 0.0;
-        while (random == 0.0 || random == 1.0) {
-            random = (1.0 + rand())/RAND_MAX;
-        }
-
-        // binary search to find key;
-        int l = 0, r = nKeys, mid;
-        while (l < r) {
-            mid = (l + r) / 2;
-            if (random > zipf[mid]) {
-                l = mid + 1;
-            } else if (random < zipf[mid]) {
-                r = mid - 1;
-            } else {
-                break;
-            }
-        }
-        return mid;
-    } 
-}
@@ -0,0 +1,13 @@
+d := $(dir $(lastword $(MAKEFILE_LIST)))
+
+#
+# gtest-based tests
+#
+GTEST_SRCS += $(addprefix $(d), \
+		workload-test.cc ycsb-test.cc)
+
+$(d)workload-test: $(o)workload-test.o $(LIB-workload) $(LIB-message) $(GTEST_MAIN)
+
+$(d)ycsb-test: $(o)ycsb-test.o $(OBJS-ycsb) $(LIB-message) $(GTEST_MAIN)
+
+TEST_BINS += $(d)workload-test $(d)ycsb-test
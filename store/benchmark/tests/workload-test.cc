@@ -0,0 +1,182 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/tests/workload-test.cc:
+ *   test cases for benchmark workload generators
+ *
+ **********************************************************************/
+
+#include "store/benchmark/workload.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace workload;
+
+static double
+ExactZeta(uint64_t n, double theta)
+{
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) {
+        sum += 1 / pow(i, theta);
+    }
+    return sum;
+}
+
+TEST(FastRandom, Deterministic)
+{
+    FastRandom a(42), b(42), c(43);
+    bool differs = false;
+    for (int i = 0; i < 100; i++) {
+        uint64_t x = a();
+        EXPECT_EQ(x, b());
+        differs |= x != c();
+    }
+    EXPECT_TRUE(differs);
+}
+
+TEST(FastRandom, Ranges)
+{
+    FastRandom gen(1);
+    std::vector<int> counts(10);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t v = gen.NextInt(5, 14);
+        ASSERT_GE(v, 5);
+        ASSERT_LE(v, 14);
+        counts[v - 5]++;
+
+        double d = gen.NextDouble();
+        ASSERT_GE(d, 0.0);
+        ASSERT_LT(d, 1.0);
+    }
+    for (int count : counts) {
+        EXPECT_NEAR(10000, count, 500);
+    }
+    EXPECT_EQ(7, gen.NextInt(7, 7));
+}
+
+TEST(Zipfian, ZetaMatchesExactSum)
+{
+    for (double theta : {0.0, 0.5, 0.75, 0.99}) {
+        for (uint64_t n : {1, 100, 1024, 1025, 5000, 1000000}) {
+            EXPECT_NEAR(ExactZeta(n, theta),
+                        ZipfianGenerator::Zeta(n, theta),
+                        1e-9 * ExactZeta(n, theta))
+                << "n " << n << " theta " << theta;
+        }
+    }
+}
+
+TEST(Zipfian, ZetaIncremental)
+{
+    double theta = ZipfianGenerator::ZIPFIAN_CONSTANT;
+    double zeta = ZipfianGenerator::Zeta(1000, theta);
+    EXPECT_NEAR(ZipfianGenerator::Zeta(3000000, theta),
+                ZipfianGenerator::Zeta(3000000, theta, 1000, zeta), 1e-9);
+    EXPECT_NEAR(ZipfianGenerator::Zeta(1010, theta),
+                ZipfianGenerator::Zeta(1010, theta, 1000, zeta), 1e-12);
+}
+
+TEST(Zipfian, ScrambledConstant)
+{
+    // The zeta YCSB precomputes for scrambled zipfian.
+    EXPECT_NEAR(26.46902820178302,
+                ZipfianGenerator::Zeta(10000000000ULL, 0.99), 1e-9);
+}
+
+TEST(Zipfian, Distribution)
+{
+    const uint64_t n = 1000;
+    const int samples = 1000000;
+    double theta = 0.9;
+    ZipfianGenerator gen(10, 10 + n - 1, theta);
+    std::vector<int> counts(n);
+    for (int i = 0; i < samples; i++) {
+        uint64_t v = gen.Next();
+        ASSERT_GE(v, 10);
+        ASSERT_LT(v, 10 + n);
+        counts[v - 10]++;
+    }
+
+    // Gray's method is exact for the two most popular items, and only
+    // approximate after them.
+    double zetan = ExactZeta(n, theta);
+    for (int i = 0; i < 2; i++) {
+        double expected = samples / pow(i + 1, theta) / zetan;
+        EXPECT_NEAR(expected, counts[i], expected * 0.05) << "item " << i;
+    }
+    EXPECT_GT(counts[0], counts[10]);
+    EXPECT_GT(counts[10], counts[500]);
+}
+
+TEST(Zipfian, TableForLargeTheta)
+{
+    const uint64_t n = 100;
+    const int samples = 200000;
+    double theta = 1.2;
+    ZipfianTableGenerator gen(5, 5 + n - 1, theta);
+    std::vector<int> counts(n);
+    for (int i = 0; i < samples; i++) {
+        uint64_t v = gen.Next();
+        ASSERT_GE(v, 5);
+        ASSERT_LT(v, 5 + n);
+        EXPECT_EQ(v, gen.Last());
+        counts[v - 5]++;
+    }
+
+    double zetan = ExactZeta(n, theta);
+    for (int i = 0; i < 3; i++) {
+        double expected = samples / pow(i + 1, theta) / zetan;
+        EXPECT_NEAR(expected, counts[i], expected * 0.05) << "item " << i;
+    }
+}
+
+TEST(Zipfian, KeyChooser)
+{
+    // Each coefficient gets a generator that stays within the keys.
+    for (double theta : { -1.0, 0.0, 0.99, 1.0, 2.0 }) {
+        std::unique_ptr<IntegerGenerator> gen(NewKeyChooser(10, theta));
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_LT(gen->Next(), 10U) << "theta " << theta;
+        }
+    }
+}
+
+TEST(Zipfian, Scrambled)
+{
+    ScrambledZipfianGenerator gen(100, 199);
+    std::vector<int> counts(100);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t v = gen.Next();
+        ASSERT_GE(v, 100);
+        ASSERT_LE(v, 199);
+        counts[v - 100]++;
+    }
+    // The most popular item is not simply the first.
+    int hottest = 0;
+    for (int i = 1; i < 100; i++) {
+        if (counts[i] > counts[hottest]) {
+            hottest = i;
+        }
+    }
+    EXPECT_NE(0, hottest);
+}
+
+TEST(Generators, Latest)
+{
+    CounterGenerator counter(0);
+    for (int i = 0; i < 100; i++) {
+        counter.Next();
+    }
+    SkewedLatestGenerator gen(counter);
+    int recent = 0;
+    for (int i = 0; i < 10000; i++) {
+        uint64_t v = gen.Next();
+        ASSERT_LE(v, 99);
+        recent += v >= 90;
+    }
+    EXPECT_GT(recent, 5000);
+}
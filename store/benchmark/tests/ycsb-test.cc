@@ -0,0 +1,190 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/tests/ycsb-test.cc:
+ *   test cases for the YCSB properties, records and key choice
+ *
+ **********************************************************************/
+
+#include "store/benchmark/ycsb.h"
+#include "store/common/transaction.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace ycsb;
+using std::map;
+using std::string;
+
+// A store in memory whose reads and commits can be made to fail.
+class MemoryClient : public Client
+{
+public:
+    map<string, string> store;
+    int failGets = REPLY_OK;
+    bool failCommits = false;
+
+    void Begin() { writes.clear(); }
+    int Get(const string &key, string &value) {
+        if (failGets != REPLY_OK) {
+            return failGets;
+        }
+        auto it = writes.find(key);
+        if (it == writes.end()) {
+            it = store.find(key);
+            if (it == store.end()) {
+                return REPLY_FAIL;
+            }
+        }
+        value = it->second;
+        return REPLY_OK;
+    }
+    int Put(const string &key, const string &value) {
+        writes[key] = value;
+        return REPLY_OK;
+    }
+    bool Commit() {
+        if (failCommits) {
+            return false;
+        }
+        for (auto &w : writes) {
+            store[w.first] = w.second;
+        }
+        return true;
+    }
+    void Abort() { writes.clear(); }
+    std::vector<int> Stats() { return std::vector<int>(); }
+
+private:
+    map<string, string> writes;
+};
+
+TEST(YCSB, Properties)
+{
+    char name[] = "/tmp/ycsb-test-XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    FILE *f = fopen(name, "w");
+    fputs("# comment\n! also a comment\n\n"
+          " recordcount = 1000 \nreadproportion=0.5\n"
+          "readallfields=TRUE\ntable=t=1\n", f);
+    fclose(f);
+
+    Properties props;
+    ASSERT_TRUE(props.Load(name));
+    unlink(name);
+    EXPECT_EQ(1000, props.GetInt("recordcount", 0));
+    EXPECT_DOUBLE_EQ(0.5, props.GetDouble("readproportion", 0));
+    EXPECT_TRUE(props.GetBool("readallfields", false));
+    EXPECT_EQ("t=1", props.Get("table", ""));
+    EXPECT_EQ(7, props.GetInt("missing", 7));
+
+    // Later settings override earlier ones.
+    EXPECT_TRUE(props.Set("recordcount=5"));
+    EXPECT_EQ(5, props.GetInt("recordcount", 0));
+    EXPECT_FALSE(props.Set("no assignment"));
+    EXPECT_FALSE(props.Set("=value"));
+    EXPECT_FALSE(props.Load("/nonexistent/ycsb-properties"));
+}
+
+TEST(YCSB, RecordEncoding)
+{
+    Workload::Record record;
+    record["field0"] = "value with spaces";
+    record["field1"] = "";
+    record["field2"] = "x";
+
+    Workload::Record decoded;
+    ASSERT_TRUE(Workload::Decode(Workload::Encode(record), decoded));
+    EXPECT_EQ(record, decoded);
+
+    Workload::Record empty;
+    EXPECT_TRUE(Workload::Decode("", empty));
+    EXPECT_TRUE(empty.empty());
+
+    Workload::Record bad;
+    EXPECT_FALSE(Workload::Decode("field0\tvalue", bad));
+    EXPECT_FALSE(Workload::Decode("field0 value\n", bad));
+    EXPECT_FALSE(Workload::Decode("a\nb\tc\n", bad));
+}
+
+TEST(YCSB, AbortedInsertsAreNotRead)
+{
+    Properties props;
+    props.Set("recordcount=10");
+    props.Set("fieldcount=2");
+    props.Set("fieldlength=4");
+    props.Set("requestdistribution=latest");
+    Workload workload(props);
+
+    MemoryClient client;
+    workload.Load(&client);
+    EXPECT_EQ(10U, client.store.size());
+
+    // An insert that aborts leaves its key unread, and the next insert
+    // takes the same key.
+    client.failCommits = true;
+    EXPECT_FALSE(workload.DoTransaction(&client, INSERT));
+    EXPECT_EQ(10U, client.store.size());
+    client.failCommits = false;
+    EXPECT_TRUE(workload.DoTransaction(&client, INSERT));
+    EXPECT_EQ(11U, client.store.size());
+
+    // With the latest distribution, reads favour the newest keys, but
+    // never one whose insert has not committed.
+    client.failCommits = true;
+    EXPECT_FALSE(workload.DoTransaction(&client, INSERT));
+    client.failCommits = false;
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(workload.DoTransaction(&client, READ));
+    }
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(workload.DoTransaction(&client, SCAN));
+    }
+}
+
+TEST(YCSB, AbortedReadFailsInsert)
+{
+    Properties props;
+    props.Set("recordcount=10");
+    props.Set("fieldcount=2");
+    Workload workload(props);
+
+    MemoryClient client;
+    workload.Load(&client);
+
+    // A read the store aborted is not a missing key, so the insert must
+    // not go on to write the record.
+    client.failGets = REPLY_ABORTED;
+    EXPECT_FALSE(workload.DoTransaction(&client, INSERT));
+    EXPECT_EQ(10U, client.store.size());
+
+    // A missing key is, and the insert writes it.
+    client.failGets = REPLY_OK;
+    EXPECT_TRUE(workload.DoTransaction(&client, INSERT));
+    EXPECT_EQ(11U, client.store.size());
+}
+
+TEST(YCSB, AcknowledgedCounter)
+{
+    workload::AcknowledgedCounterGenerator counter(10);
+    EXPECT_EQ(9U, counter.Last());
+    EXPECT_EQ(10U, counter.Next());
+    EXPECT_EQ(11U, counter.Next());
+    EXPECT_EQ(12U, counter.Next());
+    EXPECT_EQ(9U, counter.Last());
+
+    counter.Acknowledge(11);
+    EXPECT_EQ(9U, counter.Last());
+    counter.Acknowledge(10);
+    EXPECT_EQ(11U, counter.Last());
+    counter.Acknowledge(12);
+    EXPECT_EQ(12U, counter.Last());
+}
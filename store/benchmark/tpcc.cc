@@ -0,0 +1,1002 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/tpcc.cc:
+ *   TPC-C schema, loader and transactions over the key-value Client
+ *   interface.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/loadbatch.h"
+#include "store/benchmark/tpcc.h"
+#include "store/common/transaction.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <set>
+#include <utility>
+
+using namespace std;
+
+namespace tpcc {
+
+namespace {
+
+// The constants for NURand. C_LAST_RUN - C_LAST_LOAD is within the range
+// the specification allows.
+const int C_LAST_LOAD = 157;
+const int C_LAST_RUN = 223;
+const int C_ID = 259;
+const int C_ITEM_ID = 7911;
+
+// Keys.
+
+string
+Prefix(int w)
+{
+    return "{" + to_string(w) + "}";
+}
+
+string
+WarehouseKey(int w)
+{
+    return Prefix(w) + "w";
+}
+
+string
+DistrictKey(int w, int d)
+{
+    return Prefix(w) + "d/" + to_string(d);
+}
+
+string
+CustomerKey(int w, int d, int c)
+{
+    return Prefix(w) + "c/" + to_string(d) + "/" + to_string(c);
+}
+
+// The customers of a district with the given last name, by first name.
+string
+CustomerNameKey(int w, int d, const string &last)
+{
+    return Prefix(w) + "cn/" + to_string(d) + "/" + last;
+}
+
+// The id of the last order of a customer.
+string
+LastOrderKey(int w, int d, int c)
+{
+    return Prefix(w) + "co/" + to_string(d) + "/" + to_string(c);
+}
+
+string
+HistoryKey(int w, uint64_t clientId, uint64_t n)
+{
+    return Prefix(w) + "h/" + to_string(clientId) + "/" + to_string(n);
+}
+
+string
+NewOrderKey(int w, int d, int o)
+{
+    return Prefix(w) + "no/" + to_string(d) + "/" + to_string(o);
+}
+
+// The id of the oldest undelivered order of a district.
+string
+NewOrderHeadKey(int w, int d)
+{
+    return Prefix(w) + "noh/" + to_string(d);
+}
+
+string
+OrderKey(int w, int d, int o)
+{
+    return Prefix(w) + "o/" + to_string(d) + "/" + to_string(o);
+}
+
+string
+OrderLineKey(int w, int d, int o, int n)
+{
+    return Prefix(w) + "ol/" + to_string(d) + "/" + to_string(o) + "/" +
+        to_string(n);
+}
+
+string
+ItemKey(int w, int i)
+{
+    return Prefix(w) + "i/" + to_string(i);
+}
+
+string
+StockKey(int w, int i)
+{
+    return Prefix(w) + "s/" + to_string(i);
+}
+
+// Rows are their fields separated by '|', which the generated strings
+// never contain.
+
+class RowWriter
+{
+public:
+    RowWriter() : first(true) { }
+
+    RowWriter &Add(const string &field) {
+        if (!first) {
+            row += '|';
+        }
+        row += field;
+        first = false;
+        return *this;
+    }
+    RowWriter &Add(int64_t field) { return Add(to_string(field)); }
+    const string &str() const { return row; }
+
+private:
+    string row;
+    bool first;
+};
+
+class RowReader
+{
+public:
+    RowReader(const string &row) : row(row), pos(0), ok(true) { }
+
+    string Next() {
+        if (pos > row.size()) {
+            ok = false;
+            return "";
+        }
+        size_t end = row.find('|', pos);
+        if (end == string::npos) {
+            end = row.size();
+        }
+        string field = row.substr(pos, end - pos);
+        pos = end + 1;
+        return field;
+    }
+
+    int64_t NextInt() {
+        string field = Next();
+        char *end;
+        int64_t value = strtoll(field.c_str(), &end, 10);
+        if (field.empty() || *end != '\0') {
+            ok = false;
+        }
+        return value;
+    }
+
+    // Whether every field was there, and nothing more.
+    bool Done() const { return ok && pos == row.size() + 1; }
+
+private:
+    const string &row;
+    size_t pos;
+    bool ok;
+};
+
+template <class Row> bool
+ReadRow(Client *client, const string &key, Row &row)
+{
+    string value;
+    return client->Get(key, value) == REPLY_OK && row.Decode(value);
+}
+
+} // namespace
+
+int
+Random::Uniform(int lo, int hi)
+{
+    return gen.NextInt(lo, hi);
+}
+
+int
+Random::NURand(int A, int C, int lo, int hi)
+{
+    return (((Uniform(0, A) | Uniform(lo, hi)) + C) % (hi - lo + 1)) + lo;
+}
+
+string
+Random::AString(int minLen, int maxLen)
+{
+    static const char chars[] =
+        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    int len = Uniform(minLen, maxLen);
+    string s(len, ' ');
+    for (int i = 0; i < len; i++) {
+        s[i] = chars[Uniform(0, sizeof(chars) - 2)];
+    }
+    return s;
+}
+
+string
+Random::NString(int minLen, int maxLen)
+{
+    int len = Uniform(minLen, maxLen);
+    string s(len, ' ');
+    for (int i = 0; i < len; i++) {
+        s[i] = '0' + Uniform(0, 9);
+    }
+    return s;
+}
+
+// Item and stock data, of which a tenth contains "ORIGINAL".
+string
+Random::Data(int minLen, int maxLen)
+{
+    static const string original = "ORIGINAL";
+    string s = AString(minLen, maxLen);
+    if (Uniform(1, 10) == 1) {
+        s.replace(Uniform(0, s.size() - original.size()), original.size(),
+                  original);
+    }
+    return s;
+}
+
+string
+Random::Zip()
+{
+    return NString(4, 4) + "11111";
+}
+
+string
+Random::LastName(int number)
+{
+    static const char *syllables[] = {
+        "BAR", "OUGHT", "ABLE", "PRI", "PRES",
+        "ESE", "ANTI", "CALLY", "ATION", "EING"
+    };
+    return string(syllables[number / 100]) + syllables[(number / 10) % 10] +
+        syllables[number % 10];
+}
+
+string
+Warehouse::Encode() const
+{
+    return RowWriter().Add(name).Add(street1).Add(street2).Add(city)
+        .Add(state).Add(zip).Add(tax).Add(ytd).str();
+}
+
+bool
+Warehouse::Decode(const string &s)
+{
+    RowReader r(s);
+    name = r.Next();
+    street1 = r.Next();
+    street2 = r.Next();
+    city = r.Next();
+    state = r.Next();
+    zip = r.Next();
+    tax = r.NextInt();
+    ytd = r.NextInt();
+    return r.Done();
+}
+
+string
+District::Encode() const
+{
+    return RowWriter().Add(name).Add(street1).Add(street2).Add(city)
+        .Add(state).Add(zip).Add(tax).Add(ytd).Add(nextOrderId).str();
+}
+
+bool
+District::Decode(const string &s)
+{
+    RowReader r(s);
+    name = r.Next();
+    street1 = r.Next();
+    street2 = r.Next();
+    city = r.Next();
+    state = r.Next();
+    zip = r.Next();
+    tax = r.NextInt();
+    ytd = r.NextInt();
+    nextOrderId = r.NextInt();
+    return r.Done();
+}
+
+string
+Customer::Encode() const
+{
+    return RowWriter().Add(first).Add(middle).Add(last).Add(street1)
+        .Add(street2).Add(city).Add(state).Add(zip).Add(phone).Add(credit)
+        .Add(data).Add(since).Add(creditLimit).Add(discount).Add(balance)
+        .Add(ytdPayment).Add(paymentCount).Add(deliveryCount).str();
+}
+
+bool
+Customer::Decode(const string &s)
+{
+    RowReader r(s);
+    first = r.Next();
+    middle = r.Next();
+    last = r.Next();
+    street1 = r.Next();
+    street2 = r.Next();
+    city = r.Next();
+    state = r.Next();
+    zip = r.Next();
+    phone = r.Next();
+    credit = r.Next();
+    data = r.Next();
+    since = r.NextInt();
+    creditLimit = r.NextInt();
+    discount = r.NextInt();
+    balance = r.NextInt();
+    ytdPayment = r.NextInt();
+    paymentCount = r.NextInt();
+    deliveryCount = r.NextInt();
+    return r.Done();
+}
+
+string
+Order::Encode() const
+{
+    return RowWriter().Add(customerId).Add(entryTime).Add(carrierId)
+        .Add(lineCount).Add(allLocal).str();
+}
+
+bool
+Order::Decode(const string &s)
+{
+    RowReader r(s);
+    customerId = r.NextInt();
+    entryTime = r.NextInt();
+    carrierId = r.NextInt();
+    lineCount = r.NextInt();
+    allLocal = r.NextInt();
+    return r.Done();
+}
+
+string
+OrderLine::Encode() const
+{
+    return RowWriter().Add(itemId).Add(supplyWarehouseId).Add(deliveryTime)
+        .Add(quantity).Add(amount).Add(distInfo).str();
+}
+
+bool
+OrderLine::Decode(const string &s)
+{
+    RowReader r(s);
+    itemId = r.NextInt();
+    supplyWarehouseId = r.NextInt();
+    deliveryTime = r.NextInt();
+    quantity = r.NextInt();
+    amount = r.NextInt();
+    distInfo = r.Next();
+    return r.Done();
+}
+
+string
+Item::Encode() const
+{
+    return RowWriter().Add(imageId).Add(name).Add(price).Add(data).str();
+}
+
+bool
+Item::Decode(const string &s)
+{
+    RowReader r(s);
+    imageId = r.NextInt();
+    name = r.Next();
+    price = r.NextInt();
+    data = r.Next();
+    return r.Done();
+}
+
+string
+Stock::Encode() const
+{
+    RowWriter w;
+    w.Add(quantity);
+    for (int d = 0; d < DISTRICTS_PER_WAREHOUSE; d++) {
+        w.Add(dist[d]);
+    }
+    return w.Add(ytd).Add(orderCount).Add(remoteCount).Add(data).str();
+}
+
+bool
+Stock::Decode(const string &s)
+{
+    RowReader r(s);
+    quantity = r.NextInt();
+    for (int d = 0; d < DISTRICTS_PER_WAREHOUSE; d++) {
+        dist[d] = r.Next();
+    }
+    ytd = r.NextInt();
+    orderCount = r.NextInt();
+    remoteCount = r.NextInt();
+    data = r.Next();
+    return r.Done();
+}
+
+void
+Load(Client *client, const Scale &scale, int w, Random &random)
+{
+    LoadBatch batch(client);
+    int64_t now = time(NULL);
+    int nCustomers = scale.customersPerDistrict;
+
+    for (int i = 1; i <= scale.items; i++) {
+        Item item;
+        item.imageId = random.Uniform(1, 10000);
+        item.name = random.AString(14, 24);
+        item.price = random.Uniform(100, 10000);
+        item.data = random.Data(26, 50);
+        batch.Put(ItemKey(w, i), item.Encode());
+    }
+
+    Warehouse warehouse;
+    warehouse.name = random.AString(6, 10);
+    warehouse.street1 = random.AString(10, 20);
+    warehouse.street2 = random.AString(10, 20);
+    warehouse.city = random.AString(10, 20);
+    warehouse.state = random.AString(2, 2);
+    warehouse.zip = random.Zip();
+    warehouse.tax = random.Uniform(0, 2000);
+    warehouse.ytd = 30000000;
+    batch.Put(WarehouseKey(w), warehouse.Encode());
+
+    for (int i = 1; i <= scale.items; i++) {
+        Stock stock;
+        stock.quantity = random.Uniform(10, 100);
+        for (int d = 0; d < DISTRICTS_PER_WAREHOUSE; d++) {
+            stock.dist[d] = random.AString(24, 24);
+        }
+        stock.ytd = 0;
+        stock.orderCount = 0;
+        stock.remoteCount = 0;
+        stock.data = random.Data(26, 50);
+        batch.Put(StockKey(w, i), stock.Encode());
+    }
+
+    // The initial orders are the first 70% delivered and the rest new.
+    int firstNewOrder = nCustomers - nCustomers * 3 / 10 + 1;
+
+    for (int d = 1; d <= DISTRICTS_PER_WAREHOUSE; d++) {
+        District district;
+        district.name = random.AString(6, 10);
+        district.street1 = random.AString(10, 20);
+        district.street2 = random.AString(10, 20);
+        district.city = random.AString(10, 20);
+        district.state = random.AString(2, 2);
+        district.zip = random.Zip();
+        district.tax = random.Uniform(0, 2000);
+        district.ytd = 3000000;
+        district.nextOrderId = nCustomers + 1;
+        batch.Put(DistrictKey(w, d), district.Encode());
+
+        map<string, vector<pair<string, int> > > byName;
+        for (int c = 1; c <= nCustomers; c++) {
+            Customer customer;
+            customer.first = random.AString(8, 16);
+            customer.middle = "OE";
+            customer.last = Random::LastName(c <= 1000 ? c - 1 :
+                random.NURand(255, C_LAST_LOAD, 0, 999));
+            customer.street1 = random.AString(10, 20);
+            customer.street2 = random.AString(10, 20);
+            customer.city = random.AString(10, 20);
+            customer.state = random.AString(2, 2);
+            customer.zip = random.Zip();
+            customer.phone = random.NString(16, 16);
+            customer.credit = random.Uniform(1, 10) == 1 ? "BC" : "GC";
+            customer.data = random.AString(300, 500);
+            customer.since = now;
+            customer.creditLimit = 5000000;
+            customer.discount = random.Uniform(0, 5000);
+            customer.balance = -1000;
+            customer.ytdPayment = 1000;
+            customer.paymentCount = 1;
+            customer.deliveryCount = 0;
+            batch.Put(CustomerKey(w, d, c), customer.Encode());
+            byName[customer.last].push_back(make_pair(customer.first, c));
+
+            batch.Put(HistoryKey(w, 0, (uint64_t)d * nCustomers + c),
+                      RowWriter().Add(c).Add(d).Add(w).Add(d).Add(w)
+                      .Add(now).Add(1000).Add(random.AString(12, 24))
+                      .str());
+        }
+
+        for (auto &name : byName) {
+            sort(name.second.begin(), name.second.end());
+            string ids;
+            for (auto &customer : name.second) {
+                if (!ids.empty()) {
+                    ids += ',';
+                }
+                ids += to_string(customer.second);
+            }
+            batch.Put(CustomerNameKey(w, d, name.first), ids);
+        }
+
+        // Every customer places one of the initial orders, in a random
+        // order.
+        vector<int> customers;
+        for (int c = 1; c <= nCustomers; c++) {
+            customers.push_back(c);
+        }
+        for (int i = nCustomers - 1; i > 0; i--) {
+            swap(customers[i], customers[random.Uniform(0, i)]);
+        }
+
+        for (int o = 1; o <= nCustomers; o++) {
+            bool delivered = o < firstNewOrder;
+            Order order;
+            order.customerId = customers[o - 1];
+            order.entryTime = now;
+            order.carrierId = delivered ? random.Uniform(1, 10) : 0;
+            order.lineCount = random.Uniform(5, 15);
+            order.allLocal = true;
+            batch.Put(OrderKey(w, d, o), order.Encode());
+            batch.Put(LastOrderKey(w, d, order.customerId), to_string(o));
+
+            for (int n = 1; n <= order.lineCount; n++) {
+                OrderLine line;
+                line.itemId = random.Uniform(1, scale.items);
+                line.supplyWarehouseId = w;
+                line.deliveryTime = delivered ? now : 0;
+                line.quantity = 5;
+                line.amount = delivered ? 0 : random.Uniform(1, 999999);
+                line.distInfo = random.AString(24, 24);
+                batch.Put(OrderLineKey(w, d, o, n), line.Encode());
+            }
+
+            if (!delivered) {
+                batch.Put(NewOrderKey(w, d, o), "");
+            }
+        }
+        batch.Put(NewOrderHeadKey(w, d), to_string(firstNewOrder));
+    }
+
+    batch.Sync();
+}
+
+Driver::Driver(Client *client, const Scale &scale, Random &random,
+               uint64_t clientId)
+    : client(client), scale(scale), random(random), clientId(clientId),
+      historyCount(0)
+{
+    // Client id 0 is the loader's.
+    ASSERT(clientId != 0);
+}
+
+// A warehouse other than w, if there is one.
+int
+Driver::RemoteWarehouse(int w)
+{
+    if (scale.warehouses == 1) {
+        return w;
+    }
+    int remote = random.Uniform(1, scale.warehouses - 1);
+    return remote >= w ? remote + 1 : remote;
+}
+
+// The customer in the middle, by first name, of those with the given
+// last name, or 0 if the read failed.
+int
+Driver::CustomerByName(int w, int d, const string &last)
+{
+    string ids;
+    if (client->Get(CustomerNameKey(w, d, last), ids) != REPLY_OK) {
+        return 0;
+    }
+
+    vector<int> customers;
+    size_t start = 0;
+    while (start <= ids.size()) {
+        size_t end = ids.find(',', start);
+        if (end == string::npos) {
+            end = ids.size();
+        }
+        customers.push_back(atoi(ids.substr(start, end - start).c_str()));
+        start = end + 1;
+    }
+    return customers[(customers.size() - 1) / 2];
+}
+
+// Pick a customer, by last name three times in five and otherwise by id.
+bool
+Driver::SelectCustomer(int w, int d, int &c)
+{
+    int nCustomers = scale.customersPerDistrict;
+    if (random.Uniform(1, 100) <= 60) {
+        // Only the first thousand customers are sure to cover every name.
+        int maxName = min(999, nCustomers - 1);
+        c = CustomerByName(w, d, Random::LastName(
+            random.NURand(255, C_LAST_RUN, 0, maxName)));
+        return c != 0;
+    }
+    c = random.NURand(1023, C_ID, 1, nCustomers);
+    return true;
+}
+
+Outcome
+Driver::Finish(bool ok)
+{
+    if (!ok) {
+        client->Abort();
+        return ABORTED;
+    }
+    return client->Commit() ? COMMITTED : ABORTED;
+}
+
+Outcome
+Driver::NewOrder(int w)
+{
+    int d = random.Uniform(1, DISTRICTS_PER_WAREHOUSE);
+    int c = random.NURand(1023, C_ID, 1, scale.customersPerDistrict);
+    int nLines = min(random.Uniform(5, 15), scale.items);
+    bool rollback = random.Uniform(1, 100) == 1;
+
+    // Distinct items, so that no stock row is updated twice; the order
+    // to roll back ends with one that does not exist.
+    vector<int> itemIds, supplyIds, quantities;
+    bool allLocal = true;
+    for (int n = 0; n < nLines; n++) {
+        int i;
+        if (rollback && n == nLines - 1) {
+            i = scale.items + 1;
+        } else {
+            do {
+                i = random.NURand(8191, C_ITEM_ID, 1, scale.items);
+            } while (find(itemIds.begin(), itemIds.end(), i) !=
+                     itemIds.end());
+        }
+        itemIds.push_back(i);
+
+        int supply = w;
+        if (random.Uniform(1, 100) == 1) {
+            supply = RemoteWarehouse(w);
+        }
+        allLocal = allLocal && supply == w;
+        supplyIds.push_back(supply);
+        quantities.push_back(random.Uniform(1, 10));
+    }
+
+    client->Begin();
+
+    // Nothing read depends on anything else read, so it all goes out in
+    // one batch, with the missing item, if any, last.
+    vector<string> keys, values;
+    keys.push_back(WarehouseKey(w));
+    keys.push_back(DistrictKey(w, d));
+    keys.push_back(CustomerKey(w, d, c));
+    for (int n = 0; n < nLines; n++) {
+        if (itemIds[n] <= scale.items) {
+            keys.push_back(StockKey(supplyIds[n], itemIds[n]));
+        }
+    }
+    for (int n = 0; n < nLines; n++) {
+        keys.push_back(ItemKey(w, itemIds[n]));
+    }
+
+    int status = client->MultiGet(keys, values);
+    if (rollback) {
+        if (status != REPLY_FAIL) {
+            return Finish(false);
+        }
+        client->Abort();
+        return ROLLED_BACK;
+    }
+
+    Warehouse warehouse;
+    District district;
+    Customer customer;
+    if (status != REPLY_OK || !warehouse.Decode(values[0]) ||
+        !district.Decode(values[1]) || !customer.Decode(values[2])) {
+        return Finish(false);
+    }
+
+    int o = district.nextOrderId;
+    district.nextOrderId++;
+    client->Put(DistrictKey(w, d), district.Encode());
+
+    for (int n = 0; n < nLines; n++) {
+        Stock stock;
+        Item item;
+        if (!stock.Decode(values[3 + n]) ||
+            !item.Decode(values[3 + nLines + n])) {
+            return Finish(false);
+        }
+
+        if (stock.quantity >= quantities[n] + 10) {
+            stock.quantity -= quantities[n];
+        } else {
+            stock.quantity += 91 - quantities[n];
+        }
+        stock.ytd += quantities[n];
+        stock.orderCount++;
+        if (supplyIds[n] != w) {
+            stock.remoteCount++;
+        }
+        client->Put(StockKey(supplyIds[n], itemIds[n]), stock.Encode());
+
+        OrderLine line;
+        line.itemId = itemIds[n];
+        line.supplyWarehouseId = supplyIds[n];
+        line.deliveryTime = 0;
+        line.quantity = quantities[n];
+        line.amount = quantities[n] * item.price;
+        line.distInfo = stock.dist[d - 1];
+        client->Put(OrderLineKey(w, d, o, n + 1), line.Encode());
+    }
+
+    Order order;
+    order.customerId = c;
+    order.entryTime = time(NULL);
+    order.carrierId = 0;
+    order.lineCount = nLines;
+    order.allLocal = allLocal;
+    client->Put(OrderKey(w, d, o), order.Encode());
+    client->Put(NewOrderKey(w, d, o), "");
+    client->Put(LastOrderKey(w, d, c), to_string(o));
+
+    return Finish(true);
+}
+
+Outcome
+Driver::Payment(int w)
+{
+    int d = random.Uniform(1, DISTRICTS_PER_WAREHOUSE);
+    int64_t amount = random.Uniform(100, 500000);
+
+    // The customer is from a remote warehouse 15% of the time.
+    int cw = w, cd = d;
+    if (random.Uniform(1, 100) > 85) {
+        cw = RemoteWarehouse(w);
+        cd = random.Uniform(1, DISTRICTS_PER_WAREHOUSE);
+    }
+
+    client->Begin();
+
+    int c;
+    if (!SelectCustomer(cw, cd, c)) {
+        return Finish(false);
+    }
+
+    vector<string> keys, values;
+    keys.push_back(WarehouseKey(w));
+    keys.push_back(DistrictKey(w, d));
+    keys.push_back(CustomerKey(cw, cd, c));
+
+    Warehouse warehouse;
+    District district;
+    Customer customer;
+    if (client->MultiGet(keys, values) != REPLY_OK ||
+        !warehouse.Decode(values[0]) || !district.Decode(values[1]) ||
+        !customer.Decode(values[2])) {
+        return Finish(false);
+    }
+
+    warehouse.ytd += amount;
+    client->Put(WarehouseKey(w), warehouse.Encode());
+    district.ytd += amount;
+    client->Put(DistrictKey(w, d), district.Encode());
+
+    customer.balance -= amount;
+    customer.ytdPayment += amount;
+    customer.paymentCount++;
+    if (customer.credit == "BC") {
+        string data = to_string(c) + " " + to_string(cd) + " " +
+            to_string(cw) + " " + to_string(d) + " " + to_string(w) + " " +
+            to_string(amount) + " " + customer.data;
+        customer.data = data.substr(0, 500);
+    }
+    client->Put(CustomerKey(cw, cd, c), customer.Encode());
+
+    client->Put(HistoryKey(w, clientId, ++historyCount),
+                RowWriter().Add(c).Add(cd).Add(cw).Add(d).Add(w)
+                .Add(time(NULL)).Add(amount)
+                .Add(warehouse.name + "    " + district.name).str());
+
+    return Finish(true);
+}
+
+Outcome
+Driver::OrderStatus(int w)
+{
+    int d = random.Uniform(1, DISTRICTS_PER_WAREHOUSE);
+
+    client->BeginReadOnly();
+
+    int c;
+    if (!SelectCustomer(w, d, c)) {
+        return Finish(false);
+    }
+
+    vector<string> keys, values;
+    keys.push_back(CustomerKey(w, d, c));
+    keys.push_back(LastOrderKey(w, d, c));
+    Customer customer;
+    if (client->MultiGet(keys, values) != REPLY_OK ||
+        !customer.Decode(values[0])) {
+        return Finish(false);
+    }
+
+    int o = atoi(values[1].c_str());
+    Order order;
+    if (!ReadRow(client, OrderKey(w, d, o), order)) {
+        return Finish(false);
+    }
+
+    keys.clear();
+    for (int n = 1; n <= order.lineCount; n++) {
+        keys.push_back(OrderLineKey(w, d, o, n));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    for (auto &value : values) {
+        OrderLine line;
+        if (!line.Decode(value)) {
+            return Finish(false);
+        }
+    }
+
+    return Finish(true);
+}
+
+Outcome
+Driver::Delivery(int w)
+{
+    int carrierId = random.Uniform(1, 10);
+
+    client->Begin();
+
+    vector<string> keys, values;
+    for (int d = 1; d <= DISTRICTS_PER_WAREHOUSE; d++) {
+        keys.push_back(NewOrderHeadKey(w, d));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+
+    // The oldest undelivered order of each district that has one.
+    vector<pair<int, int> > deliveries;
+    for (int d = 1; d <= DISTRICTS_PER_WAREHOUSE; d++) {
+        int o = atoi(values[d - 1].c_str());
+        string unused;
+        int status = client->Get(NewOrderKey(w, d, o), unused);
+        if (status == REPLY_FAIL) {
+            continue;
+        } else if (status != REPLY_OK) {
+            return Finish(false);
+        }
+        deliveries.push_back(make_pair(d, o));
+        client->Put(NewOrderHeadKey(w, d), to_string(o + 1));
+    }
+    if (deliveries.empty()) {
+        return Finish(true);
+    }
+
+    keys.clear();
+    for (auto &delivery : deliveries) {
+        keys.push_back(OrderKey(w, delivery.first, delivery.second));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    vector<Order> orders(deliveries.size());
+    for (size_t i = 0; i < deliveries.size(); i++) {
+        if (!orders[i].Decode(values[i])) {
+            return Finish(false);
+        }
+        orders[i].carrierId = carrierId;
+        client->Put(keys[i], orders[i].Encode());
+    }
+
+    keys.clear();
+    for (size_t i = 0; i < deliveries.size(); i++) {
+        for (int n = 1; n <= orders[i].lineCount; n++) {
+            keys.push_back(OrderLineKey(w, deliveries[i].first,
+                                        deliveries[i].second, n));
+        }
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    vector<int64_t> totals(deliveries.size(), 0);
+    int64_t now = time(NULL);
+    size_t k = 0;
+    for (size_t i = 0; i < deliveries.size(); i++) {
+        for (int n = 1; n <= orders[i].lineCount; n++, k++) {
+            OrderLine line;
+            if (!line.Decode(values[k])) {
+                return Finish(false);
+            }
+            line.deliveryTime = now;
+            totals[i] += line.amount;
+            client->Put(keys[k], line.Encode());
+        }
+    }
+
+    keys.clear();
+    for (size_t i = 0; i < deliveries.size(); i++) {
+        keys.push_back(CustomerKey(w, deliveries[i].first,
+                                   orders[i].customerId));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    for (size_t i = 0; i < deliveries.size(); i++) {
+        Customer customer;
+        if (!customer.Decode(values[i])) {
+            return Finish(false);
+        }
+        customer.balance += totals[i];
+        customer.deliveryCount++;
+        client->Put(keys[i], customer.Encode());
+    }
+
+    return Finish(true);
+}
+
+Outcome
+Driver::StockLevel(int w, int d)
+{
+    int threshold = random.Uniform(10, 20);
+
+    client->BeginReadOnly();
+
+    District district;
+    if (!ReadRow(client, DistrictKey(w, d), district)) {
+        return Finish(false);
+    }
+
+    // The items of the last twenty orders.
+    vector<string> keys, values;
+    int firstOrder = max(1, district.nextOrderId - 20);
+    for (int o = firstOrder; o < district.nextOrderId; o++) {
+        keys.push_back(OrderKey(w, d, o));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    vector<string> lineKeys;
+    for (int o = firstOrder; o < district.nextOrderId; o++) {
+        Order order;
+        if (!order.Decode(values[o - firstOrder])) {
+            return Finish(false);
+        }
+        for (int n = 1; n <= order.lineCount; n++) {
+            lineKeys.push_back(OrderLineKey(w, d, o, n));
+        }
+    }
+    if (client->MultiGet(lineKeys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    set<int> itemIds;
+    for (auto &value : values) {
+        OrderLine line;
+        if (!line.Decode(value)) {
+            return Finish(false);
+        }
+        itemIds.insert(line.itemId);
+    }
+
+    keys.clear();
+    for (int i : itemIds) {
+        keys.push_back(StockKey(w, i));
+    }
+    if (client->MultiGet(keys, values) != REPLY_OK) {
+        return Finish(false);
+    }
+    int lowStock = 0;
+    for (auto &value : values) {
+        Stock stock;
+        if (!stock.Decode(value)) {
+            return Finish(false);
+        }
+        if (stock.quantity < threshold) {
+            lowStock++;
+        }
+    }
+    Debug("%d items below %d in stock", lowStock, threshold);
+
+    return Finish(true);
+}
+
+} // namespace tpcc
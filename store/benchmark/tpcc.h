@@ -0,0 +1,194 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/tpcc.h:
+ *   TPC-C schema, loader and transactions over the key-value Client
+ *   interface.
+ *
+ **********************************************************************/
+
+#ifndef _BENCHMARK_TPCC_H_
+#define _BENCHMARK_TPCC_H_
+
+#include "store/benchmark/workload.h"
+#include "store/common/frontend/client.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace tpcc {
+
+// Every row lives under a key prefixed with the partition number of its
+// warehouse, "{w}", so that Client::key_to_shard puts all of a
+// warehouse's rows on the same shard. The read-only item table is copied
+// into every warehouse, which keeps New-Order local to its home
+// warehouse unless it orders from a remote one.
+//
+// There are no range scans, so the tables the specification scans are
+// reached through extra rows kept up to date by the transactions: the
+// customers of each last name, the last order of each customer, and the
+// oldest undelivered order of each district.
+//
+// Money is in cents and tax and discount rates in hundredths of a
+// percent.
+
+const int DISTRICTS_PER_WAREHOUSE = 10;
+
+// Table sizes. The specification's are the defaults; smaller ones make
+// for faster loading.
+struct Scale
+{
+    int warehouses;
+    int customersPerDistrict;
+    int items;
+
+    Scale() : warehouses(1), customersPerDistrict(3000), items(100000) { }
+};
+
+// The random number and string generators of the specification.
+class Random
+{
+public:
+    Random(uint64_t seed) : gen(seed) { }
+
+    int Uniform(int lo, int hi);
+    int NURand(int A, int C, int lo, int hi);
+    std::string AString(int minLen, int maxLen);
+    std::string NString(int minLen, int maxLen);
+    std::string Data(int minLen, int maxLen);
+    std::string Zip();
+
+    // The last name for number 0 to 999.
+    static std::string LastName(int number);
+
+private:
+    workload::FastRandom gen;
+};
+
+// Rows of the tables the transactions update.
+
+struct Warehouse
+{
+    std::string name, street1, street2, city, state, zip;
+    int tax;
+    int64_t ytd;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct District
+{
+    std::string name, street1, street2, city, state, zip;
+    int tax;
+    int64_t ytd;
+    int nextOrderId;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct Customer
+{
+    std::string first, middle, last, street1, street2, city, state, zip;
+    std::string phone, credit, data;
+    int64_t since, creditLimit;
+    int discount;
+    int64_t balance, ytdPayment;
+    int paymentCount, deliveryCount;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct Order
+{
+    int customerId;
+    int64_t entryTime;
+    int carrierId;
+    int lineCount;
+    bool allLocal;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct OrderLine
+{
+    int itemId;
+    int supplyWarehouseId;
+    int64_t deliveryTime;
+    int quantity;
+    int64_t amount;
+    std::string distInfo;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct Item
+{
+    int imageId;
+    std::string name;
+    int64_t price;
+    std::string data;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+struct Stock
+{
+    int quantity;
+    std::string dist[DISTRICTS_PER_WAREHOUSE];
+    int64_t ytd;
+    int orderCount, remoteCount;
+    std::string data;
+
+    std::string Encode() const;
+    bool Decode(const std::string &s);
+};
+
+// Populate warehouse w, with its copy of the item table, in transactions
+// of a bounded number of writes.
+void Load(Client *client, const Scale &scale, int w, Random &random);
+
+// What became of a transaction. New-Order rolls back one order in a
+// hundred on purpose, which the specification counts as completed.
+enum Outcome {
+    COMMITTED,
+    ABORTED,
+    ROLLED_BACK
+};
+
+class Driver
+{
+public:
+    // clientId must be unique among the drivers running against the same
+    // data, since it keeps the history rows they insert apart.
+    Driver(Client *client, const Scale &scale, Random &random,
+           uint64_t clientId);
+
+    Outcome NewOrder(int w);
+    Outcome Payment(int w);
+    Outcome OrderStatus(int w);
+    Outcome Delivery(int w);
+    Outcome StockLevel(int w, int d);
+
+private:
+    Client *client;
+    Scale scale;
+    Random &random;
+    uint64_t clientId;
+    uint64_t historyCount;
+
+    int RemoteWarehouse(int w);
+    int CustomerByName(int w, int d, const std::string &last);
+    bool SelectCustomer(int w, int d, int &c);
+    Outcome Finish(bool ok);
+};
+
+} // namespace tpcc
+
+#endif /* _BENCHMARK_TPCC_H_ */
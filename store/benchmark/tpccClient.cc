@@ -0,0 +1,240 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/tpccClient.cc:
+ *   TPC-C benchmarking client, and loader, for a distributed
+ *   transactional store.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/latencystats.h"
+#include "store/benchmark/tpcc.h"
+#include "store/common/truetime.h"
+#include "store/common/frontend/client.h"
+#include "store/strongstore/client.h"
+#include "store/weakstore/client.h"
+#include "store/tapirstore/client.h"
+
+#include <random>
+
+using namespace std;
+
+int
+main(int argc, char **argv)
+{
+    const char *configPath = NULL;
+    int duration = 10;
+    int nShards = 1;
+    int closestReplica = -1; // Closest replica id.
+    int skew = 0; // difference between real clock and TrueTime
+    int error = 0; // error bars
+    int interval = 1; // Seconds between latency reports.
+    int home = 0; // Home warehouse; 0 picks one for every transaction.
+    bool load = false;
+    tpcc::Scale scale;
+
+    Client *client;
+    enum {
+        MODE_UNKNOWN,
+        MODE_TAPIR,
+        MODE_WEAK,
+        MODE_STRONG
+    } mode = MODE_UNKNOWN;
+
+    // Mode for strongstore.
+    strongstore::Mode strongmode;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:N:m:e:s:r:i:W:H:C:I:L")) != -1) {
+        switch (opt) {
+        case 'c': // Configuration path
+            configPath = optarg;
+            break;
+
+        case 'L': // Load the data and exit.
+            load = true;
+            break;
+
+        case 'N': // Number of shards.
+        case 'd': // Duration in seconds to run.
+        case 's': // Simulated clock skew.
+        case 'e': // Simulated clock error.
+        case 'r': // Preferred closest replica.
+        case 'i': // Seconds between latency reports.
+        case 'W': // Number of warehouses.
+        case 'H': // Home warehouse.
+        case 'C': // Customers per district.
+        case 'I': // Number of items.
+        {
+            char *strtolPtr;
+            long value = strtol(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (value < 0)) {
+                fprintf(stderr, "option -%c requires a numeric arg\n", opt);
+                exit(0);
+            }
+            switch (opt) {
+            case 'N': nShards = value; break;
+            case 'd': duration = value; break;
+            case 's': skew = value; break;
+            case 'e': error = value; break;
+            case 'r': closestReplica = value; break;
+            case 'i': interval = value; break;
+            case 'W': scale.warehouses = value; break;
+            case 'H': home = value; break;
+            case 'C': scale.customersPerDistrict = value; break;
+            case 'I': scale.items = value; break;
+            }
+            break;
+        }
+
+        case 'm': // Mode to run in [occ/lock/...]
+        {
+            if (strcasecmp(optarg, "txn-l") == 0) {
+                mode = MODE_TAPIR;
+            } else if (strcasecmp(optarg, "txn-s") == 0) {
+                mode = MODE_TAPIR;
+            } else if (strcasecmp(optarg, "qw") == 0) {
+                mode = MODE_WEAK;
+            } else if (strcasecmp(optarg, "occ") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_OCC;
+            } else if (strcasecmp(optarg, "lock") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_LOCK;
+            } else if (strcasecmp(optarg, "span-occ") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_SPAN_OCC;
+            } else if (strcasecmp(optarg, "span-lock") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_SPAN_LOCK;
+            } else {
+                fprintf(stderr, "unknown mode '%s'\n", optarg);
+                exit(0);
+            }
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            break;
+        }
+    }
+
+    if (scale.warehouses <= 0 || scale.customersPerDistrict <= 0 ||
+        scale.items <= 0 || home > scale.warehouses) {
+        fprintf(stderr, "options -W, -C and -I must be positive, and -H "
+                "at most -W\n");
+        exit(0);
+    }
+
+    if (mode == MODE_TAPIR) {
+        client = new tapirstore::Client(configPath, nShards,
+                    closestReplica, TrueTime(skew, error));
+    } else if (mode == MODE_WEAK) {
+        client = new weakstore::Client(configPath, nShards,
+                    closestReplica);
+    } else if (mode == MODE_STRONG) {
+        client = new strongstore::Client(strongmode, configPath,
+                    nShards, closestReplica, TrueTime(skew, error));
+    } else {
+        fprintf(stderr, "option -m is required\n");
+        exit(0);
+    }
+
+    random_device seed;
+    tpcc::Random random(((uint64_t)seed() << 32) | seed());
+
+    // Load the home warehouse, or all of them, so that several loaders
+    // can share the work.
+    if (load) {
+        for (int w = 1; w <= scale.warehouses; w++) {
+            if (home == 0 || w == home) {
+                tpcc::Load(client, scale, w, random);
+                fprintf(stderr, "# Loaded warehouse %d\n", w);
+            }
+        }
+        return 0;
+    }
+
+    uint64_t clientId;
+    do {
+        clientId = ((uint64_t)seed() << 32) | seed();
+    } while (clientId == 0);
+    tpcc::Driver driver(client, scale, random, clientId);
+
+    // The mix of transactions, as the specification's minimum
+    // percentages of all but New-Order.
+    enum {
+        NEW_ORDER, PAYMENT, ORDER_STATUS, DELIVERY, STOCK_LEVEL
+    };
+    static const char *ttypeNames[] = {
+        "new_order", "payment", "order_status", "delivery", "stock_level"
+    };
+    LatencyStats stats(stderr, interval);
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point t0, t1, t2;
+    t0 = Clock::now();
+
+    while (1) {
+        int w = home != 0 ? home : random.Uniform(1, scale.warehouses);
+        int roll = random.Uniform(1, 100);
+        int ttype;
+        if (roll <= 4) {
+            ttype = ORDER_STATUS;
+        } else if (roll <= 8) {
+            ttype = DELIVERY;
+        } else if (roll <= 12) {
+            ttype = STOCK_LEVEL;
+        } else if (roll <= 55) {
+            ttype = PAYMENT;
+        } else {
+            ttype = NEW_ORDER;
+        }
+
+        t1 = Clock::now();
+        tpcc::Outcome outcome;
+        switch (ttype) {
+        case NEW_ORDER:
+            outcome = driver.NewOrder(w);
+            break;
+        case PAYMENT:
+            outcome = driver.Payment(w);
+            break;
+        case ORDER_STATUS:
+            outcome = driver.OrderStatus(w);
+            break;
+        case DELIVERY:
+            outcome = driver.Delivery(w);
+            break;
+        default:
+            outcome = driver.StockLevel(w, random.Uniform(1,
+                tpcc::DISTRICTS_PER_WAREHOUSE));
+            break;
+        }
+        t2 = Clock::now();
+
+        // Rolled back New-Orders complete as far as the totals go.
+        uint64_t latency =
+            chrono::duration_cast<chrono::microseconds>(t2 - t1).count();
+        const char *result = outcome == tpcc::COMMITTED ? ".commit" :
+            outcome == tpcc::ROLLED_BACK ? ".rollback" : ".abort";
+        stats.Record(string(ttypeNames[ttype]) + result, latency);
+        stats.Record(outcome == tpcc::ABORTED ? "txn.abort" : "txn.commit",
+                     latency);
+        stats.Tick();
+
+        if (t2 - t0 > chrono::seconds(duration))
+            break;
+    }
+    stats.Finish();
+
+    double elapsed = chrono::duration<double>(t2 - t0).count();
+    uint64_t nCommitted = stats.Count("txn.commit");
+    uint64_t nTransactions = nCommitted + stats.Count("txn.abort");
+    fprintf(stderr, "# Commit_Ratio: %lf\n", (double)nCommitted/nTransactions);
+    fprintf(stderr, "# tpmC: %lf\n",
+            stats.Count("new_order.commit") * 60.0 / elapsed);
+
+    return 0;
+}
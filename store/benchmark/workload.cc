@@ -0,0 +1,250 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/workload.cc:
+ *   Random number and key generators for benchmark workloads.
+ *
+ **********************************************************************/
+
+#include "lib/message.h"
+#include "store/benchmark/workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace workload {
+
+namespace {
+
+// zeta(10^10, 0.99), so that scrambled zipfian need not compute it.
+const uint64_t SCRAMBLED_ITEM_COUNT = 10000000000ULL;
+const double SCRAMBLED_ZETAN = 26.46902820178302;
+
+// The sum of 1/i^theta for i in [a, b], by the Euler-Maclaurin formula
+// up to the first derivative term. With a at least ZETA_EXACT_TERMS the
+// next term is below 10^-11.
+double
+ZetaTail(double a, double b, double theta)
+{
+    double integral = theta == 1.0 ? log(b / a) :
+        (pow(b, 1 - theta) - pow(a, 1 - theta)) / (1 - theta);
+    double ends = (pow(a, -theta) + pow(b, -theta)) / 2;
+    double slopes = theta * (pow(a, -theta - 1) - pow(b, -theta - 1)) / 12;
+    return integral + ends + slopes;
+}
+
+} // namespace
+
+FastRandom &
+ThreadRandom()
+{
+    static thread_local FastRandom gen(
+        ((uint64_t)std::random_device{}() << 32) | std::random_device{}());
+    return gen;
+}
+
+uint64_t
+FNVHash64(uint64_t val)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < 8; i++) {
+        hash ^= val & 0xff;
+        hash *= 1099511628211ULL;
+        val >>= 8;
+    }
+    // YCSB takes the absolute value of the signed hash.
+    int64_t signedHash = (int64_t)hash;
+    return signedHash < 0 ? -(uint64_t)signedHash : signedHash;
+}
+
+uint64_t
+UniformGenerator::Next()
+{
+    last = RandomInt(lo, hi);
+    return last;
+}
+
+uint64_t
+CounterGenerator::Next()
+{
+    last = next++;
+    return last;
+}
+
+uint64_t
+AcknowledgedCounterGenerator::Next()
+{
+    return next++;
+}
+
+void
+AcknowledgedCounterGenerator::Acknowledge(uint64_t value)
+{
+    acknowledged.insert(value);
+    auto it = acknowledged.begin();
+    while (it != acknowledged.end() && *it == last + 1) {
+        last = *it;
+        it = acknowledged.erase(it);
+    }
+}
+
+ZipfianGenerator::ZipfianGenerator(uint64_t lo, uint64_t hi, double theta)
+    : ZipfianGenerator(lo, hi, theta, Zeta(hi - lo + 1, theta))
+{
+}
+
+ZipfianGenerator::ZipfianGenerator(uint64_t lo, uint64_t hi, double theta,
+                                   double zetan)
+    : items(hi - lo + 1), base(lo), theta(theta), zetan(zetan),
+      countForZeta(items)
+{
+    if (theta < 0 || theta >= 1) {
+        Panic("Zipfian constant %f is not in [0, 1)", theta);
+    }
+    zeta2theta = Zeta(2, theta);
+    alpha = 1.0 / (1.0 - theta);
+    eta = (1 - pow(2.0 / items, 1 - theta)) / (1 - zeta2theta / zetan);
+    Next();
+}
+
+double
+ZipfianGenerator::Zeta(uint64_t n, double theta, uint64_t start,
+                       double initialSum)
+{
+    double sum = initialSum;
+    uint64_t i = start;
+    if (n > start + ZETA_EXACT_TERMS) {
+        for (; i < ZETA_EXACT_TERMS; i++) {
+            sum += 1 / pow(i + 1, theta);
+        }
+        return sum + ZetaTail(i + 1, n, theta);
+    }
+    for (; i < n; i++) {
+        sum += 1 / pow(i + 1, theta);
+    }
+    return sum;
+}
+
+uint64_t
+ZipfianGenerator::Next()
+{
+    return Next(items);
+}
+
+uint64_t
+ZipfianGenerator::Next(uint64_t itemCount)
+{
+    if (itemCount > countForZeta) {
+        zetan = Zeta(itemCount, theta, countForZeta, zetan);
+        countForZeta = itemCount;
+        eta = (1 - pow(2.0 / itemCount, 1 - theta)) /
+            (1 - zeta2theta / zetan);
+    }
+
+    double u = RandomDouble();
+    double uz = u * zetan;
+    uint64_t offset;
+    if (uz < 1.0) {
+        offset = 0;
+    } else if (uz < 1.0 + pow(0.5, theta)) {
+        offset = 1;
+    } else {
+        offset = itemCount * pow(eta * u - eta + 1, alpha);
+    }
+    if (offset >= itemCount) {
+        offset = itemCount - 1;
+    }
+
+    last = base + offset;
+    return last;
+}
+
+ZipfianTableGenerator::ZipfianTableGenerator(uint64_t lo, uint64_t hi,
+                                             double theta)
+    : lo(lo), cdf(hi - lo + 1)
+{
+    double sum = 0;
+    for (size_t i = 0; i < cdf.size(); i++) {
+        sum += 1.0 / pow((double)(i + 1), theta);
+        cdf[i] = sum;
+    }
+    for (double &c : cdf) {
+        c /= sum;
+    }
+    // So that every draw in [0, 1) falls within the table.
+    cdf.back() = 1.0;
+}
+
+uint64_t
+ZipfianTableGenerator::Next()
+{
+    double u = RandomDouble();
+    last = lo + (std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin());
+    return last;
+}
+
+IntegerGenerator *
+NewKeyChooser(uint64_t n, double theta)
+{
+    if (theta < 0) {
+        return new UniformGenerator(0, n - 1);
+    } else if (theta < 1) {
+        return new ZipfianGenerator(0, n - 1, theta);
+    } else {
+        return new ZipfianTableGenerator(0, n - 1, theta);
+    }
+}
+
+ScrambledZipfianGenerator::ScrambledZipfianGenerator(uint64_t lo,
+                                                     uint64_t hi)
+    : gen(0, SCRAMBLED_ITEM_COUNT - 1, ZipfianGenerator::ZIPFIAN_CONSTANT,
+          SCRAMBLED_ZETAN),
+      lo(lo), itemCount(hi - lo + 1)
+{
+}
+
+uint64_t
+ScrambledZipfianGenerator::Next()
+{
+    last = lo + FNVHash64(gen.Next()) % itemCount;
+    return last;
+}
+
+SkewedLatestGenerator::SkewedLatestGenerator(CounterGenerator &basis)
+    : basis(basis), zipfian(0, basis.Last())
+{
+    Next();
+}
+
+uint64_t
+SkewedLatestGenerator::Next()
+{
+    uint64_t max = basis.Last();
+    last = max == 0 ? 0 : max - zipfian.Next(max);
+    return last;
+}
+
+HotspotGenerator::HotspotGenerator(uint64_t lo, uint64_t hi,
+                                   double hotSetFraction,
+                                   double hotOpnFraction)
+    : lo(lo), hotOpnFraction(hotOpnFraction)
+{
+    uint64_t interval = hi - lo + 1;
+    hotInterval = interval * hotSetFraction;
+    coldInterval = interval - hotInterval;
+}
+
+uint64_t
+HotspotGenerator::Next()
+{
+    if (coldInterval == 0 ||
+        (hotInterval > 0 && RandomDouble() < hotOpnFraction)) {
+        last = lo + RandomInt(0, hotInterval - 1);
+    } else {
+        last = lo + hotInterval + RandomInt(0, coldInterval - 1);
+    }
+    return last;
+}
+
+} // namespace workload
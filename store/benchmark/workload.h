@@ -0,0 +1,277 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/workload.h:
+ *   Random number and key generators for benchmark workloads.
+ *
+ **********************************************************************/
+
+#ifndef _BENCHMARK_WORKLOAD_H_
+#define _BENCHMARK_WORKLOAD_H_
+
+#include <stdint.h>
+#include <limits>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace workload {
+
+// xoshiro256** (Blackman and Vigna), seeded by splitmix64: a few
+// shifts and multiplies per value and 32 bytes of state, against
+// mt19937_64's 2.5KB. It works with the <random> distributions, but
+// NextDouble and NextInt are cheaper.
+class FastRandom
+{
+public:
+    typedef uint64_t result_type;
+
+    explicit FastRandom(uint64_t seed) { Seed(seed); }
+
+    void Seed(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    uint64_t operator()() {
+        uint64_t result = Rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+        return result;
+    }
+
+    // In [0, 1).
+    double NextDouble() {
+        return ((*this)() >> 11) * (1.0 / (1ULL << 53));
+    }
+
+    // In [lo, hi], without modulo bias, by Lemire's multiply-and-shift.
+    uint64_t NextInt(uint64_t lo, uint64_t hi) {
+        uint64_t range = hi - lo + 1;
+        if (range == 0) {
+            return (*this)();
+        }
+        unsigned __int128 m = (unsigned __int128)(*this)() * range;
+        if ((uint64_t)m < range) {
+            uint64_t threshold = -range % range;
+            while ((uint64_t)m < threshold) {
+                m = (unsigned __int128)(*this)() * range;
+            }
+        }
+        return lo + (uint64_t)(m >> 64);
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t Rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// Uniform random numbers from a FastRandom private to the calling
+// thread, seeded from std::random_device.
+FastRandom &ThreadRandom();
+inline double RandomDouble() { return ThreadRandom().NextDouble(); }
+inline uint64_t RandomInt(uint64_t lo, uint64_t hi) {
+    return ThreadRandom().NextInt(lo, hi);
+}
+
+// The 64-bit FNV-1 hash of the bytes of val, as YCSB scrambles keys.
+uint64_t FNVHash64(uint64_t val);
+
+// Generators of integers with some distribution, as in YCSB. Last is
+// the value Next most recently returned.
+class IntegerGenerator
+{
+public:
+    IntegerGenerator() : last(0) { }
+    virtual ~IntegerGenerator() { }
+
+    virtual uint64_t Next() = 0;
+    uint64_t Last() const { return last; }
+
+protected:
+    uint64_t last;
+};
+
+class UniformGenerator : public IntegerGenerator
+{
+public:
+    UniformGenerator(uint64_t lo, uint64_t hi) : lo(lo), hi(hi) { }
+    uint64_t Next();
+
+private:
+    uint64_t lo, hi;
+};
+
+// Counts up from start. Last is the value most recently handed out,
+// start - 1 before the first.
+class CounterGenerator : public IntegerGenerator
+{
+public:
+    CounterGenerator(uint64_t start) : next(start) { last = start - 1; }
+    uint64_t Next();
+
+protected:
+    uint64_t next;
+};
+
+// Counts up from start, but Last is the highest value that has been
+// acknowledged along with every value before it, as YCSB tracks which
+// inserts have completed. Values may be acknowledged in any order.
+class AcknowledgedCounterGenerator : public CounterGenerator
+{
+public:
+    AcknowledgedCounterGenerator(uint64_t start) : CounterGenerator(start) { }
+    // The next value, which Last does not cover until it is acknowledged.
+    uint64_t Next();
+    void Acknowledge(uint64_t value);
+
+private:
+    // Values acknowledged past Last, waiting for those before them.
+    std::set<uint64_t> acknowledged;
+};
+
+// Zipfian over [lo, hi] with item lo the most popular, by the method of
+// Gray et al., "Quickly Generating Billion-Record Synthetic Databases".
+// Theta must be in [0, 1). Both setting up and each value take constant
+// time: past the first ZETA_EXACT_TERMS terms, zeta(n) is approximated
+// by the Euler-Maclaurin formula, to within about 10^-11.
+class ZipfianGenerator : public IntegerGenerator
+{
+public:
+    static constexpr double ZIPFIAN_CONSTANT = 0.99;
+    static const uint64_t ZETA_EXACT_TERMS = 1024;
+
+    ZipfianGenerator(uint64_t lo, uint64_t hi,
+                     double theta = ZIPFIAN_CONSTANT);
+    ZipfianGenerator(uint64_t lo, uint64_t hi, double theta, double zetan);
+
+    uint64_t Next();
+
+    // A value from the first itemCount items, for item counts that only
+    // grow, extending zeta(n) as they do.
+    uint64_t Next(uint64_t itemCount);
+
+    // The sum of 1/i^theta for i in (start, n], plus initialSum.
+    static double Zeta(uint64_t n, double theta, uint64_t start = 0,
+                       double initialSum = 0);
+
+private:
+    uint64_t items;
+    uint64_t base;
+    double theta, alpha, zetan, eta, zeta2theta;
+    uint64_t countForZeta;
+};
+
+// Zipfian over [lo, hi] with item lo the most popular, for any theta, by
+// binary search of the cumulative distribution. Setting up takes time
+// and memory in proportion to the number of items, so it is only for
+// the coefficients of 1 or more that ZipfianGenerator cannot take.
+class ZipfianTableGenerator : public IntegerGenerator
+{
+public:
+    ZipfianTableGenerator(uint64_t lo, uint64_t hi, double theta);
+    uint64_t Next();
+
+private:
+    uint64_t lo;
+    std::vector<double> cdf;
+};
+
+// Picks among [0, n): uniformly if theta is negative, otherwise zipfian
+// with coefficient theta, as the benchmark drivers' -z option does.
+IntegerGenerator *NewKeyChooser(uint64_t n, double theta);
+
+// Zipfian with the popular items spread out over [lo, hi] by hashing,
+// rather than clustered at lo. As in YCSB, the zipfian underneath is
+// over a fixed 10^10 items whose zeta is precomputed, so the hashed
+// values cover any range of up to that many keys.
+class ScrambledZipfianGenerator : public IntegerGenerator
+{
+public:
+    ScrambledZipfianGenerator(uint64_t lo, uint64_t hi);
+    uint64_t Next();
+
+private:
+    ZipfianGenerator gen;
+    uint64_t lo;
+    uint64_t itemCount;
+};
+
+// Zipfian favouring the most recent values handed out by basis.
+class SkewedLatestGenerator : public IntegerGenerator
+{
+public:
+    SkewedLatestGenerator(CounterGenerator &basis);
+    uint64_t Next();
+
+private:
+    CounterGenerator &basis;
+    ZipfianGenerator zipfian;
+};
+
+// Values in [lo, hi], where a fraction hotOpnFraction of them fall
+// uniformly within the first hotSetFraction of the range and the rest
+// uniformly over the remainder.
+class HotspotGenerator : public IntegerGenerator
+{
+public:
+    HotspotGenerator(uint64_t lo, uint64_t hi, double hotSetFraction,
+                     double hotOpnFraction);
+    uint64_t Next();
+
+private:
+    uint64_t lo;
+    uint64_t hotInterval, coldInterval;
+    double hotOpnFraction;
+};
+
+// Picks one of several values with the given weights.
+template <class T>
+class DiscreteGenerator
+{
+public:
+    DiscreteGenerator() : sum(0) { }
+
+    void Add(double weight, const T &value) {
+        values.push_back(std::make_pair(weight, value));
+        sum += weight;
+    }
+
+    const T &Next() const {
+        double r = RandomDouble() * sum;
+        for (auto &value : values) {
+            if (r < value.first) {
+                return value.second;
+            }
+            r -= value.first;
+        }
+        return values.back().second;
+    }
+
+private:
+    std::vector<std::pair<double, T> > values;
+    double sum;
+};
+
+} // namespace workload
+
+#endif /* _BENCHMARK_WORKLOAD_H_ */
@@ -0,0 +1,473 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/ycsb.cc:
+ *   The YCSB core workload over the key-value Client interface.
+ *
+ **********************************************************************/
+
+#include "lib/message.h"
+#include "store/benchmark/loadbatch.h"
+#include "store/benchmark/ycsb.h"
+#include "store/common/transaction.h"
+
+#include <strings.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+using namespace workload;
+
+namespace ycsb {
+
+static string
+Trim(const string &s)
+{
+    size_t start = s.find_first_not_of(" \t\r");
+    if (start == string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(start, end - start + 1);
+}
+
+bool
+Properties::Load(const string &path)
+{
+    ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    string line;
+    while (getline(in, line)) {
+        line = Trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == '!') {
+            continue;
+        }
+        if (!Set(line)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+Properties::Set(const string &assignment)
+{
+    size_t eq = assignment.find('=');
+    if (eq == string::npos || Trim(assignment.substr(0, eq)).empty()) {
+        return false;
+    }
+    props[Trim(assignment.substr(0, eq))] = Trim(assignment.substr(eq + 1));
+    return true;
+}
+
+string
+Properties::Get(const string &name, const string &def) const
+{
+    auto it = props.find(name);
+    return it == props.end() ? def : it->second;
+}
+
+int64_t
+Properties::GetInt(const string &name, int64_t def) const
+{
+    auto it = props.find(name);
+    if (it == props.end()) {
+        return def;
+    }
+    char *end;
+    int64_t value = strtoll(it->second.c_str(), &end, 10);
+    if (it->second.empty() || *end != '\0') {
+        Panic("Property %s=%s is not an integer", name.c_str(),
+              it->second.c_str());
+    }
+    return value;
+}
+
+double
+Properties::GetDouble(const string &name, double def) const
+{
+    auto it = props.find(name);
+    if (it == props.end()) {
+        return def;
+    }
+    char *end;
+    double value = strtod(it->second.c_str(), &end);
+    if (it->second.empty() || *end != '\0') {
+        Panic("Property %s=%s is not a number", name.c_str(),
+              it->second.c_str());
+    }
+    return value;
+}
+
+bool
+Properties::GetBool(const string &name, bool def) const
+{
+    auto it = props.find(name);
+    if (it == props.end()) {
+        return def;
+    }
+    return strcasecmp(it->second.c_str(), "true") == 0;
+}
+
+const char *
+OperationName(Operation op)
+{
+    switch (op) {
+    case READ: return "read";
+    case UPDATE: return "update";
+    case INSERT: return "insert";
+    case SCAN: return "scan";
+    case READ_MODIFY_WRITE: return "read_modify_write";
+    }
+    NOT_REACHABLE();
+    return "";
+}
+
+Workload::Workload(const Properties &props)
+{
+    string workload = props.Get("workload", "CoreWorkload");
+    if (workload.size() < 12 ||
+        workload.compare(workload.size() - 12, 12, "CoreWorkload") != 0) {
+        Panic("Only the core workload is supported, not %s",
+              workload.c_str());
+    }
+
+    table = props.Get("table", "usertable");
+    fieldCount = props.GetInt("fieldcount", 10);
+    readAllFields = props.GetBool("readallfields", true);
+    writeAllFields = props.GetBool("writeallfields", false);
+    orderedInserts = props.Get("insertorder", "hashed") != "hashed";
+    int64_t records = props.GetInt("recordcount", 0);
+    int64_t start = props.GetInt("insertstart", 0);
+    int64_t inserts = props.GetInt("insertcount", records);
+    if (fieldCount <= 0 || records <= 0) {
+        Panic("fieldcount and recordcount must be positive");
+    }
+    if (start < 0 || inserts < 0) {
+        Panic("insertstart and insertcount must not be negative");
+    }
+    recordCount = records;
+    uint64_t insertStart = start;
+    insertCount = inserts;
+
+    int64_t length = props.GetInt("fieldlength", 100);
+    string lengthDistribution =
+        props.Get("fieldlengthdistribution", "constant");
+    if (lengthDistribution == "constant") {
+        fieldLength = new UniformGenerator(length, length);
+    } else if (lengthDistribution == "uniform") {
+        fieldLength = new UniformGenerator(1, length);
+    } else if (lengthDistribution == "zipfian") {
+        fieldLength = new ZipfianGenerator(1, length);
+    } else {
+        Panic("Unknown field length distribution \"%s\"",
+              lengthDistribution.c_str());
+    }
+    fieldChooser = new UniformGenerator(0, fieldCount - 1);
+
+    double readProportion = props.GetDouble("readproportion", 0.95);
+    double updateProportion = props.GetDouble("updateproportion", 0.05);
+    double insertProportion = props.GetDouble("insertproportion", 0.0);
+    double scanProportion = props.GetDouble("scanproportion", 0.0);
+    double rmwProportion =
+        props.GetDouble("readmodifywriteproportion", 0.0);
+    if (readProportion > 0) {
+        operationChooser.Add(readProportion, READ);
+    }
+    if (updateProportion > 0) {
+        operationChooser.Add(updateProportion, UPDATE);
+    }
+    if (insertProportion > 0) {
+        operationChooser.Add(insertProportion, INSERT);
+    }
+    if (scanProportion > 0) {
+        operationChooser.Add(scanProportion, SCAN);
+    }
+    if (rmwProportion > 0) {
+        operationChooser.Add(rmwProportion, READ_MODIFY_WRITE);
+    }
+    if (readProportion + updateProportion + insertProportion +
+        scanProportion + rmwProportion <= 0) {
+        Panic("No operations have a positive proportion");
+    }
+
+    keySequence = new CounterGenerator(insertStart);
+    insertKeySequence = new AcknowledgedCounterGenerator(recordCount);
+
+    string distribution = props.Get("requestdistribution", "uniform");
+    if (distribution == "uniform") {
+        keyChooser = new UniformGenerator(0, recordCount - 1);
+    } else if (distribution == "zipfian") {
+        // Leave room in the key space for the records that will be
+        // inserted, so that inserting them does not change which keys
+        // are popular.
+        int64_t opCount = props.GetInt("operationcount", 0);
+        uint64_t newKeys = opCount * insertProportion * 2.0;
+        keyChooser = new ScrambledZipfianGenerator(0,
+            recordCount + newKeys - 1);
+    } else if (distribution == "latest") {
+        keyChooser = new SkewedLatestGenerator(*insertKeySequence);
+    } else if (distribution == "hotspot") {
+        keyChooser = new HotspotGenerator(0, recordCount - 1,
+            props.GetDouble("hotspotdatafraction", 0.2),
+            props.GetDouble("hotspotopnfraction", 0.8));
+    } else {
+        Panic("Unknown request distribution \"%s\"", distribution.c_str());
+    }
+
+    int64_t maxScanLength = props.GetInt("maxscanlength", 1000);
+    string scanDistribution = props.Get("scanlengthdistribution", "uniform");
+    if (scanDistribution == "uniform") {
+        scanLength = new UniformGenerator(1, maxScanLength);
+    } else if (scanDistribution == "zipfian") {
+        scanLength = new ZipfianGenerator(1, maxScanLength);
+    } else {
+        Panic("Unknown scan length distribution \"%s\"",
+              scanDistribution.c_str());
+    }
+}
+
+Workload::~Workload()
+{
+    delete fieldLength;
+    delete fieldChooser;
+    delete keyChooser;
+    delete scanLength;
+    delete keySequence;
+    delete insertKeySequence;
+}
+
+string
+Workload::KeyName(uint64_t keynum) const
+{
+    if (!orderedInserts) {
+        keynum = FNVHash64(keynum);
+    }
+    return table + "user" + to_string(keynum);
+}
+
+// A key that has been inserted.
+uint64_t
+Workload::NextKeynum()
+{
+    uint64_t keynum;
+    do {
+        keynum = keyChooser->Next();
+    } while (keynum > insertKeySequence->Last());
+    return keynum;
+}
+
+// The key for an insert: one whose insert aborted, if any, so that no
+// gaps are left below the acknowledged inserts.
+uint64_t
+Workload::NextInsertKeynum()
+{
+    if (abortedInserts.empty()) {
+        return insertKeySequence->Next();
+    }
+    uint64_t keynum = abortedInserts.back();
+    abortedInserts.pop_back();
+    return keynum;
+}
+
+static string
+RandomValue(uint64_t length)
+{
+    string value(length, ' ');
+    for (uint64_t i = 0; i < length; i++) {
+        value[i] = RandomInt(' ', '~');
+    }
+    return value;
+}
+
+Workload::Record
+Workload::BuildValues()
+{
+    Record record;
+    for (int i = 0; i < fieldCount; i++) {
+        record["field" + to_string(i)] = RandomValue(fieldLength->Next());
+    }
+    return record;
+}
+
+Workload::Record
+Workload::BuildUpdate()
+{
+    Record record;
+    record["field" + to_string(fieldChooser->Next())] =
+        RandomValue(fieldLength->Next());
+    return record;
+}
+
+string
+Workload::Encode(const Record &record)
+{
+    string s;
+    for (auto &field : record) {
+        s += field.first + "\t" + field.second + "\n";
+    }
+    return s;
+}
+
+bool
+Workload::Decode(const string &s, Record &record)
+{
+    size_t start = 0;
+    while (start < s.size()) {
+        size_t end = s.find('\n', start);
+        size_t tab = s.find('\t', start);
+        if (end == string::npos || tab == string::npos || tab > end) {
+            return false;
+        }
+        record[s.substr(start, tab - start)] =
+            s.substr(tab + 1, end - tab - 1);
+        start = end + 1;
+    }
+    return true;
+}
+
+void
+Workload::Load(Client *client)
+{
+    LoadBatch batch(client);
+    for (uint64_t i = 0; i < insertCount; i++) {
+        batch.Put(KeyName(keySequence->Next()), Encode(BuildValues()));
+    }
+    batch.Sync();
+}
+
+bool
+Workload::Read(Client *client, const string &key)
+{
+    string value;
+    if (client->Get(key, value) != REPLY_OK) {
+        return false;
+    }
+    if (readAllFields) {
+        return true;
+    }
+
+    Record record;
+    return Decode(value, record) &&
+        record.count("field" + to_string(fieldChooser->Next())) > 0;
+}
+
+bool
+Workload::Update(Client *client, const string &key)
+{
+    string value;
+    Record record;
+    if (client->Get(key, value) != REPLY_OK || !Decode(value, record)) {
+        return false;
+    }
+
+    Record values = writeAllFields ? BuildValues() : BuildUpdate();
+    for (auto &field : values) {
+        auto it = record.find(field.first);
+        if (it == record.end()) {
+            return false;
+        }
+        it->second = field.second;
+    }
+    return client->Put(key, Encode(record)) == REPLY_OK;
+}
+
+// Insert a new record, or merge into it if another client already did.
+bool
+Workload::Insert(Client *client, uint64_t keynum)
+{
+    string key = KeyName(keynum);
+    string value;
+    Record record;
+    int status = client->Get(key, value);
+    if (status == REPLY_OK) {
+        if (!Decode(value, record)) {
+            return false;
+        }
+    } else if (status != REPLY_FAIL) {
+        return false;
+    }
+
+    for (auto &field : BuildValues()) {
+        record[field.first] = field.second;
+    }
+    return client->Put(key, Encode(record)) == REPLY_OK;
+}
+
+bool
+Workload::Scan(Client *client)
+{
+    uint64_t start = NextKeynum();
+    uint64_t length = scanLength->Next();
+
+    vector<string> keys, values;
+    for (uint64_t keynum = start;
+         keynum < start + length && keynum <= insertKeySequence->Last();
+         keynum++) {
+        keys.push_back(KeyName(keynum));
+    }
+
+    // Records that are missing end the scan early, rather than fail it.
+    int status = client->MultiGet(keys, values);
+    return status == REPLY_OK || status == REPLY_FAIL;
+}
+
+bool
+Workload::DoTransaction(Client *client, Operation op)
+{
+    if (op == READ || op == SCAN) {
+        client->BeginReadOnly();
+    } else {
+        client->Begin();
+    }
+
+    bool ok;
+    uint64_t insertKeynum = 0;
+    switch (op) {
+    case READ:
+        ok = Read(client, KeyName(NextKeynum()));
+        break;
+    case UPDATE:
+        ok = Update(client, KeyName(NextKeynum()));
+        break;
+    case INSERT:
+        insertKeynum = NextInsertKeynum();
+        ok = Insert(client, insertKeynum);
+        break;
+    case SCAN:
+        ok = Scan(client);
+        break;
+    case READ_MODIFY_WRITE:
+    {
+        string key = KeyName(NextKeynum());
+        ok = Read(client, key) && Update(client, key);
+        break;
+    }
+    default:
+        NOT_REACHABLE();
+    }
+
+    bool committed;
+    if (ok) {
+        committed = client->Commit();
+    } else {
+        client->Abort();
+        committed = false;
+    }
+
+    if (op == INSERT) {
+        if (committed) {
+            insertKeySequence->Acknowledge(insertKeynum);
+        } else {
+            abortedInserts.push_back(insertKeynum);
+        }
+    }
+    return committed;
+}
+
+} // namespace ycsb
@@ -0,0 +1,111 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/ycsb.h:
+ *   The YCSB core workload over the key-value Client interface.
+ *
+ **********************************************************************/
+
+#ifndef _BENCHMARK_YCSB_H_
+#define _BENCHMARK_YCSB_H_
+
+#include "store/benchmark/workload.h"
+#include "store/common/frontend/client.h"
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ycsb {
+
+// Workload properties, as in the YCSB property files under
+// ycsb-t/workloads.
+class Properties
+{
+public:
+    // Read "name=value" lines, skipping comments and blank lines.
+    bool Load(const std::string &path);
+    // Set one property from "name=value".
+    bool Set(const std::string &assignment);
+
+    std::string Get(const std::string &name, const std::string &def) const;
+    int64_t GetInt(const std::string &name, int64_t def) const;
+    double GetDouble(const std::string &name, double def) const;
+    bool GetBool(const std::string &name, bool def) const;
+
+private:
+    std::map<std::string, std::string> props;
+};
+
+enum Operation {
+    READ,
+    UPDATE,
+    INSERT,
+    SCAN,
+    READ_MODIFY_WRITE
+};
+
+const char *OperationName(Operation op);
+
+// The core workload of YCSB, with the properties and defaults of
+// com.yahoo.ycsb.workloads.CoreWorkload. A record is a key holding
+// "field\tvalue\n" lines, as in the YCSB-T binding, and every operation
+// runs in a transaction of its own. The stores are not ordered, so a
+// scan reads the records inserted after its first one instead of those
+// that follow it in key order.
+class Workload
+{
+public:
+    Workload(const Properties &props);
+    ~Workload();
+
+    // Insert the records of the load phase.
+    void Load(Client *client);
+
+    Operation NextOperation() const { return operationChooser.Next(); }
+
+    // Run op in a transaction. Returns whether it committed.
+    bool DoTransaction(Client *client, Operation op);
+
+    // A record's fields, by name, and their encoding as a value.
+    typedef std::map<std::string, std::string> Record;
+    static std::string Encode(const Record &record);
+    static bool Decode(const std::string &s, Record &record);
+
+private:
+
+    std::string table;
+    int fieldCount;
+    bool readAllFields;
+    bool writeAllFields;
+    bool orderedInserts;
+    uint64_t recordCount;
+    uint64_t insertCount;
+
+    workload::DiscreteGenerator<Operation> operationChooser;
+    workload::IntegerGenerator *fieldLength;
+    workload::IntegerGenerator *fieldChooser;
+    workload::IntegerGenerator *keyChooser;
+    workload::IntegerGenerator *scanLength;
+    workload::CounterGenerator *keySequence;
+    // Keys are only read once the insert of every key before them has
+    // committed; the keys of inserts that abort are inserted again.
+    workload::AcknowledgedCounterGenerator *insertKeySequence;
+    std::vector<uint64_t> abortedInserts;
+
+    std::string KeyName(uint64_t keynum) const;
+    uint64_t NextKeynum();
+    uint64_t NextInsertKeynum();
+    Record BuildValues();
+    Record BuildUpdate();
+
+    bool Read(Client *client, const std::string &key);
+    bool Update(Client *client, const std::string &key);
+    bool Insert(Client *client, uint64_t keynum);
+    bool Scan(Client *client);
+};
+
+} // namespace ycsb
+
+#endif /* _BENCHMARK_YCSB_H_ */
@@ -0,0 +1,199 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/benchmark/ycsbClient.cc:
+ *   YCSB benchmarking client, and loader, for a distributed
+ *   transactional store.
+ *
+ **********************************************************************/
+
+#include "store/benchmark/latencystats.h"
+#include "store/benchmark/ycsb.h"
+#include "store/common/truetime.h"
+#include "store/common/frontend/client.h"
+#include "store/strongstore/client.h"
+#include "store/weakstore/client.h"
+#include "store/tapirstore/client.h"
+
+#include <vector>
+
+using namespace std;
+
+int
+main(int argc, char **argv)
+{
+    const char *configPath = NULL;
+    int duration = 0; // Seconds to run; 0 runs operationcount operations.
+    int nShards = 1;
+    int closestReplica = -1; // Closest replica id.
+    int skew = 0; // difference between real clock and TrueTime
+    int error = 0; // error bars
+    int interval = 1; // Seconds between latency reports.
+    bool load = false;
+    const char *workloadPath = NULL;
+    vector<const char *> overrides;
+
+    Client *client;
+    enum {
+        MODE_UNKNOWN,
+        MODE_TAPIR,
+        MODE_WEAK,
+        MODE_STRONG
+    } mode = MODE_UNKNOWN;
+
+    // Mode for strongstore.
+    strongstore::Mode strongmode;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:N:m:e:s:r:i:P:p:L")) != -1) {
+        switch (opt) {
+        case 'c': // Configuration path
+            configPath = optarg;
+            break;
+
+        case 'P': // Workload property file.
+            workloadPath = optarg;
+            break;
+
+        case 'p': // Workload property, as name=value.
+            overrides.push_back(optarg);
+            break;
+
+        case 'L': // Load the records and exit.
+            load = true;
+            break;
+
+        case 'N': // Number of shards.
+        case 'd': // Duration in seconds to run.
+        case 's': // Simulated clock skew.
+        case 'e': // Simulated clock error.
+        case 'r': // Preferred closest replica.
+        case 'i': // Seconds between latency reports.
+        {
+            char *strtolPtr;
+            long value = strtol(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (value < 0)) {
+                fprintf(stderr, "option -%c requires a numeric arg\n", opt);
+                exit(0);
+            }
+            switch (opt) {
+            case 'N': nShards = value; break;
+            case 'd': duration = value; break;
+            case 's': skew = value; break;
+            case 'e': error = value; break;
+            case 'r': closestReplica = value; break;
+            case 'i': interval = value; break;
+            }
+            break;
+        }
+
+        case 'm': // Mode to run in [occ/lock/...]
+        {
+            if (strcasecmp(optarg, "txn-l") == 0) {
+                mode = MODE_TAPIR;
+            } else if (strcasecmp(optarg, "txn-s") == 0) {
+                mode = MODE_TAPIR;
+            } else if (strcasecmp(optarg, "qw") == 0) {
+                mode = MODE_WEAK;
+            } else if (strcasecmp(optarg, "occ") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_OCC;
+            } else if (strcasecmp(optarg, "lock") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_LOCK;
+            } else if (strcasecmp(optarg, "span-occ") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_SPAN_OCC;
+            } else if (strcasecmp(optarg, "span-lock") == 0) {
+                mode = MODE_STRONG;
+                strongmode = strongstore::MODE_SPAN_LOCK;
+            } else {
+                fprintf(stderr, "unknown mode '%s'\n", optarg);
+                exit(0);
+            }
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            break;
+        }
+    }
+
+    ycsb::Properties props;
+    if (workloadPath == NULL) {
+        fprintf(stderr, "option -P is required\n");
+        exit(0);
+    }
+    if (!props.Load(workloadPath)) {
+        fprintf(stderr, "could not read workload file %s\n", workloadPath);
+        exit(0);
+    }
+    for (const char *assignment : overrides) {
+        if (!props.Set(assignment)) {
+            fprintf(stderr, "option -p requires name=value\n");
+            exit(0);
+        }
+    }
+    ycsb::Workload workload(props);
+
+    if (mode == MODE_TAPIR) {
+        client = new tapirstore::Client(configPath, nShards,
+                    closestReplica, TrueTime(skew, error));
+    } else if (mode == MODE_WEAK) {
+        client = new weakstore::Client(configPath, nShards,
+                    closestReplica);
+    } else if (mode == MODE_STRONG) {
+        client = new strongstore::Client(strongmode, configPath,
+                    nShards, closestReplica, TrueTime(skew, error));
+    } else {
+        fprintf(stderr, "option -m is required\n");
+        exit(0);
+    }
+
+    if (load) {
+        workload.Load(client);
+        fprintf(stderr, "# Loaded %ld records\n",
+                props.GetInt("insertcount", props.GetInt("recordcount", 0)));
+        return 0;
+    }
+
+    int64_t operationCount = props.GetInt("operationcount", 0);
+    if (operationCount == 0 && duration == 0) {
+        fprintf(stderr, "operationcount or option -d must be positive\n");
+        exit(0);
+    }
+
+    LatencyStats stats(stderr, interval);
+
+    typedef chrono::steady_clock Clock;
+    Clock::time_point t0, t1, t2;
+    t0 = Clock::now();
+
+    for (int64_t n = 0; operationCount == 0 || n < operationCount; n++) {
+        ycsb::Operation op = workload.NextOperation();
+
+        t1 = Clock::now();
+        bool status = workload.DoTransaction(client, op);
+        t2 = Clock::now();
+
+        uint64_t latency =
+            chrono::duration_cast<chrono::microseconds>(t2 - t1).count();
+        stats.Record(string(ycsb::OperationName(op)) +
+                     (status ? ".commit" : ".abort"), latency);
+        stats.Record(status ? "txn.commit" : "txn.abort", latency);
+        stats.Tick();
+
+        if (duration > 0 && t2 - t0 > chrono::seconds(duration))
+            break;
+    }
+    stats.Finish();
+
+    double elapsed = chrono::duration<double>(t2 - t0).count();
+    uint64_t nCommitted = stats.Count("txn.commit");
+    uint64_t nTransactions = nCommitted + stats.Count("txn.abort");
+    fprintf(stderr, "# Commit_Ratio: %lf\n", (double)nCommitted/nTransactions);
+    fprintf(stderr, "# Throughput: %lf\n", nTransactions / elapsed);
+
+    return 0;
+}
@@ -1,8 +1,10 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
 SRCS += $(addprefix $(d), \
-				kvstore.cc lockserver.cc txnstore.cc versionstore.cc)
+				kvstore.cc lockserver.cc snapshot.cc txnstore.cc valuestore.cc \
+				versionstore.cc)
 
-LIB-store-backend := $(o)kvstore.o $(o)lockserver.o $(o)txnstore.o $(o)versionstore.o
+LIB-store-backend := $(o)kvstore.o $(o)lockserver.o $(o)snapshot.o \
+	$(o)txnstore.o $(o)valuestore.o $(o)versionstore.o
 
 include $(d)tests/Rules.mk
@@ -2,7 +2,7 @@
 /***********************************************************************
  *
  * common/kvstore.cc:
- *   Simple versioned key-value store
+ *   Simple key-value store
  *
  * Copyright 2015 Irene Zhang <iyzhang@cs.washington.edu>
  *
@@ -39,30 +39,49 @@ KVStore::~KVStore() { }
 bool
 KVStore::get(const string &key, string &value)
 {
-    // check for existence of key in store
-    if (store.find(key) == store.end() || store[key].empty()) {
-        return false;
-    } else {
-        value = store[key].back();
-	return true;
-    }
+    return store.get(key, value);
 }
 
 bool
 KVStore::put(const string &key, const string &value)
 {
-    store[key].push_back(value);
+    store.put(key, value);
     return true;
 }
 
-/* Delete the latest version of this key. */
+/* Delete this key, returning its value. */
 bool
 KVStore::remove(const string &key, string &value)
 {
-    if (store.find(key) == store.end() || store[key].empty()) {
-        return false;
-    } 
+    return store.get(key, value) && store.remove(key);
+}
+
+void
+KVStore::save(SnapshotWriter &out) const
+{
+    out.U64(store.size());
+    store.forEach([&out](const string &key, const string &value) {
+        out.String(key);
+        out.String(value);
+    });
+}
 
-    store[key].pop_back();
+bool
+KVStore::restore(SnapshotReader &in)
+{
+    store.clear();
+
+    uint64_t n;
+    if (!in.U64(n)) {
+        return false;
+    }
+    store.reserve(n);
+    string key, value;
+    for (uint64_t i = 0; i < n; i++) {
+        if (!in.String(key) || !in.String(value)) {
+            return false;
+        }
+        store.put(key, value);
+    }
     return true;
 }
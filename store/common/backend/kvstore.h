@@ -2,7 +2,7 @@
 /***********************************************************************
  *
  * store/common/backend/kvstore.h:
- *   Simple versioned key-value store
+ *   Simple key-value store
  *
  * Copyright 2015 Irene Zhang <iyzhang@cs.washington.edu>
  *
@@ -33,9 +33,10 @@
 
 #include "lib/assert.h"
 #include "lib/message.h"
+#include "store/common/backend/snapshot.h"
+#include "store/common/backend/valuestore.h"
+
 #include <string>
-#include <unordered_map>
-#include <list>
 
 class KVStore
 {
@@ -47,10 +48,17 @@ public:
     bool get(const std::string &key, std::string &value);
     bool put(const std::string &key, const std::string &value);
     bool remove(const std::string &key, std::string &value);
+    // Make room for n keys before loading them.
+    void reserve(size_t n) { store.reserve(n); }
+
+    // Write every key and value, or replace them all with those save
+    // wrote.
+    void save(SnapshotWriter &out) const;
+    bool restore(SnapshotReader &in);
 
 private:
-    /* Global store which keeps key -> (timestamp, value) list. */
-    std::unordered_map<std::string, std::list<std::string>> store;
+    /* Global store which keeps key -> latest value. */
+    ValueStore store;
 };
 
 #endif  /* _KV_STORE_H_ */
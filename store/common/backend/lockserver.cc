@@ -8,272 +8,168 @@
 
 #include "store/common/backend/lockserver.h"
 
+#include <algorithm>
+
 using namespace std;
 
-LockServer::LockServer()
-{
-    readers = 0;
-    writers = 0;
-}
-    
+LockServer::LockServer() { }
+
 LockServer::~LockServer() { }
 
 bool
-LockServer::Waiter::checkTimeout(const struct timeval &now)
+LockServer::Lock::holds(uint64_t id) const
 {
-    if (now.tv_sec > waitTime.tv_sec) {
-        return true;
-    } else {
-        ASSERT(now.tv_usec > waitTime.tv_usec && now.tv_sec == waitTime.tv_sec);
-        
-        if (now.tv_usec - waitTime.tv_usec > LOCK_WAIT_TIMEOUT)
-            return true;
+    if (state == UNLOCKED) {
+        return false;
     }
-    return false;
+    return holder == id ||
+        find(sharers.begin(), sharers.end(), id) != sharers.end();
 }
-    
-void
-LockServer::Lock::waitForLock(uint64_t requester, bool write)
-{
-    if (waiters.find(requester) != waiters.end()) {
-        // Already waiting
-        return;
-    }
 
-    Debug("[%lu] Adding me to the queue ...", requester);
-    // Otherwise
-    waiters[requester] = Waiter(write);
-    waitQ.push(requester);
+int
+LockServer::lockForRead(const string &lock, uint64_t requester)
+{
+    return this->lock(lock, requester, false);
 }
 
-bool
-LockServer::Lock::tryAcquireLock(uint64_t requester, bool write)
+int
+LockServer::lockForWrite(const string &lock, uint64_t requester)
 {
-    if (waitQ.size() == 0) {
-        return true;
-    }
-
-    Debug("[%lu] Trying to get lock for %d", requester, (int)write);
-    struct timeval now;
-    uint64_t w = waitQ.front();
-    
-    gettimeofday(&now, NULL);
-    // prune old requests out of the wait queue
-    while (waiters[w].checkTimeout(now)) {
-        waiters.erase(w);
-        waitQ.pop();
-
-        // if everyone else was old ...
-        if (waitQ.size() == 0) {
-            return true;
-        }
-
-        w = waitQ.front();
-        ASSERT(waiters.find(w) != waiters.end());
-    }
-
-    if (waitQ.front() == requester) {
-        // this lock is being reserved for the requester
-        waitQ.pop();
-        ASSERT(waiters.find(requester) != waiters.end());
-        ASSERT(waiters[requester].write == write);
-        waiters.erase(requester);
-        return true;
-    } else {
-        // otherwise, add me to the list
-        waitForLock(requester, write);
-        return false;
-    }
+    return this->lock(lock, requester, true);
 }
 
-bool
-LockServer::Lock::isWriteNext()
+int
+LockServer::lock(const string &key, uint64_t requester, bool write)
 {
-    if (waitQ.size() == 0) return false;
+    auto it = locks.find(key);
+    if (it == locks.end()) {
+        it = locks.emplace(key, Lock()).first;
+        it->second.key = &it->first;
+    }
+    Lock &l = it->second;
 
-    struct timeval now;
-    uint64_t w = waitQ.front();
-    
-    gettimeofday(&now, NULL);
-    // prune old requests out of the wait queue
-    while (waiters[w].checkTimeout(now)) {
-        waiters.erase(w);
-        waitQ.pop();
+    bool holds = l.holds(requester);
+    if (holds && (!write || l.state == LOCKED_FOR_WRITE)) {
+        return REPLY_OK;
+    }
 
-        // if everyone else was old ...
-        if (waitQ.size() == 0) {
-            return false;
+    // Find the oldest transaction in the way: the holders the request
+    // conflicts with, and an older waiter it would overtake.
+    bool conflict = false;
+    uint64_t oldest = UINT64_MAX;
+    auto conflicts = [&](uint64_t id) {
+        if (id != requester) {
+            conflict = true;
+            oldest = min(oldest, id);
+        }
+    };
+    if (l.state == LOCKED_FOR_WRITE) {
+        conflicts(l.holder);
+    } else if (l.state == LOCKED_FOR_READ && write) {
+        conflicts(l.holder);
+        for (uint64_t id : l.sharers) {
+            conflicts(id);
         }
-
-        w = waitQ.front();
-        ASSERT(waiters.find(w) != waiters.end());
+    }
+    if (l.waiting && l.waiter < requester && (write || l.waitWrite)) {
+        conflicts(l.waiter);
     }
 
-    ASSERT(waiters.find(waitQ.front()) != waiters.end());
-    return waiters[waitQ.front()].write;
-}
-
-bool
-LockServer::lockForRead(const string &lock, uint64_t requester)
-{
-    Lock &l = locks[lock];
-    Debug("Lock for Read: %s [%lu %lu %lu %lu]", lock.c_str(),
-            readers, writers, l.holders.size(), l.waiters.size());
+    bool listed = holds || (l.waiting && l.waiter == requester);
 
-    switch (l.state) {
-    case UNLOCKED:
-        // if you are next in the queue
-        if (l.tryAcquireLock(requester, false)) {
-            Debug("[%lu] I have acquired the read lock!", requester);
-            l.state = LOCKED_FOR_READ;
-            ASSERT(l.holders.size() == 0);
-            l.holders.insert(requester);
-            readers++;
-            return true;
+    if (!conflict) {
+        Debug("[%lu] Acquired %s lock: %s", requester,
+              write ? "write" : "read", key.c_str());
+        if (l.state == UNLOCKED) {
+            l.holder = requester;
+        } else if (!holds) {
+            l.sharers.push_back(requester);
         }
-        return false;
-    case LOCKED_FOR_READ:
-        // if you already hold this lock
-        if (l.holders.find(requester) != l.holders.end()) {
-            return true;
+        l.state = write ? LOCKED_FOR_WRITE : LOCKED_FOR_READ;
+        if (l.waiting && l.waiter == requester) {
+            l.waiting = false;
         }
-
-        // There is a write waiting, let's give up the lock
-        if (l.isWriteNext()) {
-	    Debug("[%lu] Waiting on lock because there is a pending write request", requester);
-            l.waitForLock(requester, false);
-            return false;
+        if (!listed) {
+            txns[requester].push_back(&l);
         }
-
-        l.holders.insert(requester);
-        readers++;
-        return true;
-    case LOCKED_FOR_WRITE:
-    case LOCKED_FOR_READ_WRITE:
-        if (l.holders.count(requester) > 0) {
-            l.state = LOCKED_FOR_READ_WRITE;
-            readers++;
-            return true;
-        }
-        ASSERT(l.holders.size() == 1);
-        Debug("Locked for write, held by %lu", *(l.holders.begin())); 
-        l.waitForLock(requester, false);
-        return false;
+        return REPLY_OK;
     }
-    NOT_REACHABLE();
-    return false;
-}
 
-bool
-LockServer::lockForWrite(const string &lock, uint64_t requester)
-{
-    Lock &l = locks[lock];
-
-    Debug("Lock for Write: %s [%lu %lu %lu %lu]", lock.c_str(),
-    readers, writers, l.holders.size(), l.waiters.size());
+    if (oldest < requester) {
+        Debug("[%lu] Dies for %lu on lock: %s", requester, oldest,
+              key.c_str());
+        return REPLY_FAIL;
+    }
 
-    switch (l.state) {
-    case UNLOCKED:
-        // Got it!
-        if (l.tryAcquireLock(requester, true)) {
-            Debug("[%lu] I have acquired the write lock!", requester);
-            l.state = LOCKED_FOR_WRITE;
-            ASSERT(l.holders.size() == 0);
-            l.holders.insert(requester);
-            writers++;
-            return true;
+    Debug("[%lu] Waits on lock: %s", requester, key.c_str());
+    if (!l.waiting || requester < l.waiter) {
+        if (l.waiting && !l.holds(l.waiter)) {
+            unlist(l.waiter, &l);
         }
-        return false;
-    case LOCKED_FOR_READ:
-        if (l.holders.size() == 1 && l.holders.count(requester) > 0) {
-            // if there is one holder of this read lock and it is the
-            // requester, then upgrade the lock
-            l.state = LOCKED_FOR_READ_WRITE;
-            writers++;
-            return true;
-        }
-
-        Debug("Locked for read by%s%lu other people", l.holders.count(requester) > 0 ? "you" : "", l.holders.size());
-        l.waitForLock(requester, true);
-        return false;
-    case LOCKED_FOR_WRITE:
-    case LOCKED_FOR_READ_WRITE:
-        ASSERT(l.holders.size() == 1);
-        if (l.holders.count(requester) > 0) {
-            return true;
+        if (!listed) {
+            txns[requester].push_back(&l);
         }
-
-        Debug("Held by %lu for %s", *(l.holders.begin()), (l.state == LOCKED_FOR_WRITE) ? "write" : "read-write" );
-        l.waitForLock(requester, true);
-        return false;
+        l.waiting = true;
+        l.waitWrite = write;
+        l.waiter = requester;
+    } else if (l.waiter == requester) {
+        l.waitWrite |= write;
     }
-    NOT_REACHABLE();
-    return false;
+    return REPLY_RETRY;
 }
 
 void
-LockServer::releaseForRead(const string &lock, uint64_t holder)
+LockServer::clear()
 {
-    if (locks.find(lock) == locks.end()) {
-        return;
-    }
-    
-    Lock &l = locks[lock];
+    txns.clear();
+    locks.clear();
+}
 
-    if (l.holders.count(holder) == 0) {
-        Warning("[%ld] Releasing unheld read lock: %s", holder, lock.c_str());
+void
+LockServer::releaseAll(uint64_t holder)
+{
+    auto t = txns.find(holder);
+    if (t == txns.end()) {
         return;
     }
 
-    switch (l.state) {
-    case UNLOCKED:
-    case LOCKED_FOR_WRITE:
-        return;
-    case LOCKED_FOR_READ:
-        readers--;
-        if (l.holders.erase(holder) < 1) {
-            Warning("[%ld] Releasing unheld read lock: %s", holder, lock.c_str()); 
+    for (Lock *l : t->second) {
+        if (l->waiting && l->waiter == holder) {
+            l->waiting = false;
         }
-        if (l.holders.empty()) {
-            l.state = UNLOCKED;
+        if (l->state != UNLOCKED && l->holder == holder) {
+            if (l->sharers.empty()) {
+                l->state = UNLOCKED;
+            } else {
+                l->holder = l->sharers.back();
+                l->sharers.pop_back();
+            }
+        } else {
+            auto s = find(l->sharers.begin(), l->sharers.end(), holder);
+            if (s != l->sharers.end()) {
+                *s = l->sharers.back();
+                l->sharers.pop_back();
+            }
+        }
+        if (l->state == UNLOCKED && !l->waiting) {
+            locks.erase(locks.find(*l->key));
         }
-	return;
-    case LOCKED_FOR_READ_WRITE:
-        readers--;
-        l.state = LOCKED_FOR_WRITE;
-        return;
     }
+    txns.erase(t);
 }
 
+/* Forget that id is waiting for l, when an older waiter displaces it. */
 void
-LockServer::releaseForWrite(const string &lock, uint64_t holder)
+LockServer::unlist(uint64_t id, Lock *l)
 {
-    if (locks.find(lock) == locks.end()) {
-        return;
-    }
-
-    Lock &l = locks[lock];
-
-    if (l.holders.count(holder) == 0) {
-        Warning("[%ld] Releasing unheld write lock: %s", holder, lock.c_str());
-        return;
-    }
-
-    switch (l.state) {
-    case UNLOCKED:
-    case LOCKED_FOR_READ:
-        return;
-    case LOCKED_FOR_WRITE:
-        writers--;
-        l.holders.erase(holder);
-        ASSERT(l.holders.size() == 0);
-        l.state = UNLOCKED;
-        return;
-    case LOCKED_FOR_READ_WRITE:
-        writers--;
-        l.state = LOCKED_FOR_READ;
-        ASSERT(l.holders.size() == 1);
-        return;
+    auto t = txns.find(id);
+    ASSERT(t != txns.end());
+    vector<Lock *> &held = t->second;
+    auto it = find(held.begin(), held.end(), l);
+    ASSERT(it != held.end());
+    *it = held.back();
+    held.pop_back();
+    if (held.empty()) {
+        txns.erase(t);
     }
 }
-
@@ -33,16 +33,20 @@
 
 #include "lib/assert.h"
 #include "lib/message.h"
+#include "store/common/transaction.h"
 
-#include <sys/time.h>
-#include <map>
-#include <queue>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
-
-#define LOCK_WAIT_TIMEOUT 5000
+#include <vector>
 
+/* A lock table for two-phase locking. Requests never block; conflicts
+ * are settled by wait-die, with requester ids as timestamps (a smaller
+ * id is an older transaction). A requester older than every transaction
+ * in its way may wait: it gets REPLY_RETRY, and the lock is reserved for
+ * it against younger requesters until it gets the lock or releases. A
+ * younger one dies: it gets REPLY_FAIL and should abort. Since only
+ * older transactions wait for younger ones, there are no deadlocks.
+ */
 class LockServer
 {
 
@@ -50,51 +54,49 @@ public:
     LockServer();
     ~LockServer();
 
-    bool lockForRead(const std::string &lock, uint64_t requester);
-    bool lockForWrite(const std::string &lock, uint64_t requester);
-    void releaseForRead(const std::string &lock, uint64_t holder);
-    void releaseForWrite(const std::string &lock, uint64_t holder);
+    // Each returns REPLY_OK, REPLY_RETRY or REPLY_FAIL, as above.
+    int lockForRead(const std::string &lock, uint64_t requester);
+    int lockForWrite(const std::string &lock, uint64_t requester);
+    // Release every lock holder holds or is waiting for.
+    void releaseAll(uint64_t holder);
+    // Release every lock, and forget every waiter.
+    void clear();
+
+    // Number of locks held or waited for.
+    size_t size() const { return locks.size(); }
 
 private:
     enum LockState {
         UNLOCKED,
         LOCKED_FOR_READ,
-        LOCKED_FOR_WRITE,
-        LOCKED_FOR_READ_WRITE
-    };
-
-    struct Waiter {
-        bool write;
-        struct timeval waitTime;
-
-        Waiter() {write = false;}
-        Waiter(bool w) {
-            gettimeofday(&waitTime, NULL);
-            write = w;
-        }
-
-        bool checkTimeout(const struct timeval &now);
+        LOCKED_FOR_WRITE
     };
 
     struct Lock {
+        // The key in locks, for freeing the entry.
+        const std::string *key;
         LockState state;
-        std::unordered_set<uint64_t> holders;
-        std::queue<uint64_t> waitQ;
-        std::map<uint64_t, Waiter> waiters;
+        // The first holder is kept inline; only shared read locks
+        // need more.
+        uint64_t holder;
+        std::vector<uint64_t> sharers;
+        // The oldest requester waiting for the lock, if any.
+        bool waiting;
+        bool waitWrite;
+        uint64_t waiter;
 
-        Lock() {
-            state = UNLOCKED;
-        };
-        void waitForLock(uint64_t requester, bool write);
-        bool tryAcquireLock(uint64_t requester, bool write);
-        bool isWriteNext();
+        Lock() : key(NULL), state(UNLOCKED), holder(0),
+                 waiting(false), waitWrite(false), waiter(0) { }
+        bool holds(uint64_t id) const;
     };
 
-    /* Global store which keep key -> (timestamp, value) list. */
-    std::unordered_map<std::string, Lock> locks;
+    int lock(const std::string &key, uint64_t requester, bool write);
+    void unlist(uint64_t id, Lock *l);
 
-    uint64_t readers;
-    uint64_t writers;
+    /* Entries exist only for locks that are held or waited for. */
+    std::unordered_map<std::string, Lock> locks;
+    /* The locks each transaction holds or is waiting for. */
+    std::unordered_map<uint64_t, std::vector<Lock *> > txns;
 };
 
 #endif /* _LOCK_SERVER_H_ */
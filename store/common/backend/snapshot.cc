@@ -0,0 +1,92 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/backend/snapshot.cc:
+ *   Binary encoding of store snapshots.
+ *
+ **********************************************************************/
+
+#include "store/common/backend/snapshot.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+void
+SnapshotWriter::U64(uint64_t v)
+{
+    ok = ok && fwrite(&v, sizeof(v), 1, f) == 1;
+}
+
+void
+SnapshotWriter::String(const string &s)
+{
+    U64(s.size());
+    ok = ok && fwrite(s.data(), 1, s.size(), f) == s.size();
+}
+
+void
+SnapshotWriter::Time(const Timestamp &t)
+{
+    U64(t.getTimestamp());
+    U64(t.getID());
+}
+
+bool
+SnapshotReader::U64(uint64_t &v)
+{
+    return fread(&v, sizeof(v), 1, f) == 1;
+}
+
+bool
+SnapshotReader::String(string &s)
+{
+    uint64_t size;
+    if (!U64(size)) {
+        return false;
+    }
+    // Read in pieces, so that a corrupt size fails at the end of the
+    // file rather than in allocating.
+    s.clear();
+    char buf[4096];
+    while (size > 0) {
+        size_t n = size < sizeof(buf) ? size : sizeof(buf);
+        if (fread(buf, 1, n, f) != n) {
+            return false;
+        }
+        s.append(buf, n);
+        size -= n;
+    }
+    return true;
+}
+
+bool
+SnapshotReader::Time(Timestamp &t)
+{
+    uint64_t timestamp, id;
+    if (!U64(timestamp) || !U64(id)) {
+        return false;
+    }
+    t = Timestamp(timestamp, id);
+    return true;
+}
+
+bool
+WriteSnapshot(const string &path,
+              const function<void (SnapshotWriter &)> &save)
+{
+    string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL) {
+        return false;
+    }
+    SnapshotWriter writer(f);
+    save(writer);
+    bool ok = writer.Ok() && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/backend/snapshot.h:
+ *   Binary encoding of store snapshots.
+ *
+ **********************************************************************/
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include "store/common/timestamp.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Writes integers, in host byte order, and length-prefixed strings to a
+// file. Errors are sticky: once a write fails, Ok is false.
+class SnapshotWriter
+{
+public:
+    SnapshotWriter(FILE *f) : f(f), ok(true) { }
+
+    void U64(uint64_t v);
+    void String(const std::string &s);
+    void Time(const Timestamp &t);
+
+    bool Ok() const { return ok; }
+
+private:
+    FILE *f;
+    bool ok;
+};
+
+// Reads what SnapshotWriter wrote. Each call returns false once the
+// file is exhausted or corrupt.
+class SnapshotReader
+{
+public:
+    SnapshotReader(FILE *f) : f(f) { }
+
+    bool U64(uint64_t &v);
+    bool String(std::string &s);
+    bool Time(Timestamp &t);
+
+private:
+    FILE *f;
+};
+
+// Write a snapshot to path by calling save, atomically: it goes to a
+// temporary file, which replaces path only once it is on disk.
+bool WriteSnapshot(const std::string &path,
+                   const std::function<void (SnapshotWriter &)> &save);
+
+#endif /* _SNAPSHOT_H_ */
@@ -6,6 +6,7 @@ d := $(dir $(lastword $(MAKEFILE_LIST)))
 GTEST_SRCS += $(addprefix $(d), \
 		kvstore-test.cc \
 		versionstore-test.cc \
+		valuestore-test.cc \
 		lockserver-test.cc)
 
 $(d)kvstore-test: $(o)kvstore-test.o $(LIB-transport) $(LIB-store-common) $(LIB-store-backend) $(GTEST_MAIN)
@@ -16,6 +17,10 @@ $(d)versionstore-test: $(o)versionstore-test.o $(LIB-transport) $(LIB-store-comm
 
 TEST_BINS += $(d)versionstore-test
 
+$(d)valuestore-test: $(o)valuestore-test.o $(LIB-transport) $(LIB-store-common) $(LIB-store-backend) $(GTEST_MAIN)
+
+TEST_BINS += $(d)valuestore-test
+
 $(d)lockserver-test: $(o)lockserver-test.o $(LIB-transport) $(LIB-store-common) $(LIB-store-backend) $(GTEST_MAIN)
 
 TEST_BINS += $(d)lockserver-test
@@ -32,6 +32,8 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+
 TEST(KVStore, Put)
 {
     KVStore store;
@@ -60,3 +62,31 @@ TEST(KVStore, Get)
     EXPECT_EQ(val, "xyz");
 }
 
+TEST(KVStore, SaveRestore)
+{
+    KVStore store;
+    std::string longValue(100, 'x');
+    store.put("short", "abc");
+    store.put("long", longValue);
+
+    FILE *f = tmpfile();
+    ASSERT_TRUE(f != NULL);
+    SnapshotWriter out(f);
+    store.save(out);
+    ASSERT_TRUE(out.Ok());
+    rewind(f);
+
+    // Restoring replaces whatever the store held.
+    KVStore restored;
+    restored.put("gone", "abc");
+    SnapshotReader in(f);
+    ASSERT_TRUE(restored.restore(in));
+    fclose(f);
+
+    std::string val;
+    EXPECT_TRUE(restored.get("short", val));
+    EXPECT_EQ("abc", val);
+    EXPECT_TRUE(restored.get("long", val));
+    EXPECT_EQ(longValue, val);
+    EXPECT_FALSE(restored.get("gone", val));
+}
@@ -36,16 +36,75 @@ TEST(LockServer, ReadLock)
 {
     LockServer s;
 
-    EXPECT_TRUE(s.lockForRead("x", 1));
-    EXPECT_TRUE(s.lockForRead("x", 2));   
-    EXPECT_FALSE(s.lockForWrite("x", 3));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 1));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 2));
+    EXPECT_EQ(REPLY_FAIL, s.lockForWrite("x", 3));
 }
 
 TEST(LockServer, WriteLock)
 {
     LockServer s;
-    
-    EXPECT_TRUE(s.lockForWrite("x", 1));
-    EXPECT_FALSE(s.lockForRead("x", 2));   
-    EXPECT_FALSE(s.lockForWrite("x", 3));    
+
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("x", 1));
+    EXPECT_EQ(REPLY_FAIL, s.lockForRead("x", 2));
+    EXPECT_EQ(REPLY_FAIL, s.lockForWrite("x", 3));
+}
+
+TEST(LockServer, WaitDie)
+{
+    LockServer s;
+
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("x", 5));
+    // Older transactions wait, younger ones die.
+    EXPECT_EQ(REPLY_RETRY, s.lockForRead("x", 3));
+    EXPECT_EQ(REPLY_FAIL, s.lockForRead("x", 7));
+
+    // The lock is kept for the oldest waiter, even once it is free.
+    EXPECT_EQ(REPLY_RETRY, s.lockForWrite("x", 2));
+    s.releaseAll(5);
+    EXPECT_EQ(REPLY_FAIL, s.lockForRead("x", 4));
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("x", 2));
+    // Transaction 3 was displaced by 2, and now dies for it.
+    EXPECT_EQ(REPLY_FAIL, s.lockForRead("x", 3));
+    s.releaseAll(2);
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 3));
+}
+
+TEST(LockServer, Upgrade)
+{
+    LockServer s;
+
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 1));
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("x", 1));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 1));
+    EXPECT_EQ(REPLY_FAIL, s.lockForRead("x", 2));
+
+    // An upgrade waits for other readers, if it is older.
+    EXPECT_EQ(REPLY_OK, s.lockForRead("y", 1));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("y", 2));
+    EXPECT_EQ(REPLY_RETRY, s.lockForWrite("y", 1));
+    EXPECT_EQ(REPLY_FAIL, s.lockForWrite("y", 2));
+    s.releaseAll(2);
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("y", 1));
+}
+
+TEST(LockServer, ReleaseAll)
+{
+    LockServer s;
+
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 1));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 2));
+    EXPECT_EQ(REPLY_OK, s.lockForRead("x", 3));
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("y", 1));
+    EXPECT_EQ(2, s.size());
+
+    // Released locks are freed, shared ones once the last reader goes.
+    s.releaseAll(1);
+    EXPECT_EQ(REPLY_FAIL, s.lockForWrite("x", 4));
+    EXPECT_EQ(1, s.size());
+    s.releaseAll(3);
+    s.releaseAll(2);
+    EXPECT_EQ(0, s.size());
+    EXPECT_EQ(REPLY_OK, s.lockForWrite("x", 4));
 }
@@ -0,0 +1,99 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/backend/tests/valuestore-test.cc:
+ *   test cases for the compact value store
+ *
+ **********************************************************************/
+
+#include "store/common/backend/valuestore.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <string>
+
+using namespace std;
+
+TEST(ValueStore, PutGet)
+{
+    ValueStore store;
+    string val;
+
+    EXPECT_FALSE(store.get("a", val));
+    store.put("a", "1");
+    store.put("", "empty key");
+    store.put(string("nul\0key", 7), string("nul\0value", 9));
+    EXPECT_EQ(3, store.size());
+
+    ASSERT_TRUE(store.get("a", val));
+    EXPECT_EQ("1", val);
+    ASSERT_TRUE(store.get("", val));
+    EXPECT_EQ("empty key", val);
+    ASSERT_TRUE(store.get(string("nul\0key", 7), val));
+    EXPECT_EQ(string("nul\0value", 9), val);
+    EXPECT_FALSE(store.get("nul", val));
+}
+
+TEST(ValueStore, Overwrite)
+{
+    ValueStore store;
+    string val;
+
+    // Across inline, slab and malloc sizes, in both directions.
+    const string key(40, 'k');
+    for (size_t size : {0, 15, 16, 17, 100, 120, 9000, 15, 64, 20000, 3}) {
+        string value(size, 'a' + size % 26);
+        store.put(key, value);
+        ASSERT_TRUE(store.get(key, val));
+        EXPECT_EQ(value, val);
+    }
+    EXPECT_EQ(1, store.size());
+}
+
+TEST(ValueStore, Remove)
+{
+    ValueStore store;
+    string val;
+
+    EXPECT_FALSE(store.remove("a"));
+    store.put("a", "1");
+    EXPECT_TRUE(store.remove("a"));
+    EXPECT_FALSE(store.remove("a"));
+    EXPECT_FALSE(store.get("a", val));
+    EXPECT_EQ(0, store.size());
+}
+
+TEST(ValueStore, Random)
+{
+    // Check against std::map, through growth and many removals that
+    // shift entries back.
+    ValueStore store;
+    map<string, string> expected;
+    mt19937 gen(1);
+    uniform_int_distribution<int> keyDist(0, 5000);
+    uniform_int_distribution<int> sizeDist(0, 200);
+
+    for (int i = 0; i < 100000; i++) {
+        string key = "key" + to_string(keyDist(gen));
+        if (gen() % 3 == 0) {
+            EXPECT_EQ(expected.erase(key) > 0, store.remove(key));
+        } else {
+            string value(sizeDist(gen), 'a' + i % 26);
+            store.put(key, value);
+            expected[key] = value;
+        }
+    }
+
+    ASSERT_EQ(expected.size(), store.size());
+    for (int k = 0; k <= 5000; k++) {
+        string key = "key" + to_string(k);
+        string val;
+        auto it = expected.find(key);
+        ASSERT_EQ(it != expected.end(), store.get(key, val));
+        if (it != expected.end()) {
+            EXPECT_EQ(it->second, val);
+        }
+    }
+}
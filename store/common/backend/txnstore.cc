@@ -92,3 +92,59 @@ TxnStore::Load(const string &key, const string &value, const Timestamp &timestam
 {
     Panic("Unimplemented LOAD");
 }
+
+void
+TxnStore::Reserve(size_t nKeys)
+{
+    // Only a hint; stores need not act on it.
+}
+
+void
+TxnStore::Save(SnapshotWriter &out) const
+{
+    Panic("Unimplemented SAVE");
+}
+
+bool
+TxnStore::Restore(SnapshotReader &in)
+{
+    Panic("Unimplemented RESTORE");
+    return false;
+}
+
+/* Write prepared transactions by id, for restorePrepared. */
+void
+TxnStore::savePrepared(SnapshotWriter &out,
+                       const map<uint64_t, Transaction> &prepared)
+{
+    out.U64(prepared.size());
+    for (auto &p : prepared) {
+        TransactionMessage txn;
+        p.second.serialize(&txn);
+        out.U64(p.first);
+        out.String(txn.SerializeAsString());
+    }
+}
+
+bool
+TxnStore::restorePrepared(SnapshotReader &in,
+                          map<uint64_t, Transaction> &prepared)
+{
+    prepared.clear();
+
+    uint64_t n;
+    if (!in.U64(n)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t id;
+        string data;
+        TransactionMessage txn;
+        if (!in.U64(id) || !in.String(data) || !txn.ParseFromString(data)) {
+            return false;
+        }
+        prepared.emplace_hint(prepared.end(), id, Transaction(txn));
+    }
+    return true;
+}
+
@@ -38,6 +38,9 @@
 #include "lib/message.h"
 #include "store/common/timestamp.h"
 #include "store/common/transaction.h"
+#include "store/common/backend/snapshot.h"
+
+#include <map>
 
 class TxnStore
 {
@@ -72,6 +75,19 @@ public:
     // load keys
     virtual void Load(const std::string &key, const std::string &value,
         const Timestamp &timestamp);
+
+    // make room for nKeys keys before loading them
+    virtual void Reserve(size_t nKeys);
+
+    // write the whole store, or replace it with one Save wrote
+    virtual void Save(SnapshotWriter &out) const;
+    virtual bool Restore(SnapshotReader &in);
+
+protected:
+    static void savePrepared(SnapshotWriter &out,
+        const std::map<uint64_t, Transaction> &prepared);
+    static bool restorePrepared(SnapshotReader &in,
+        std::map<uint64_t, Transaction> &prepared);
 };
 
 #endif /* _TXN_STORE_H_ */
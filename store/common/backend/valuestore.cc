@@ -0,0 +1,266 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/backend/valuestore.cc:
+ *   Compact hash table from string keys to string values.
+ *
+ **********************************************************************/
+
+#include "store/common/backend/valuestore.h"
+#include "lib/linearprobe.h"
+#include "lib/message.h"
+
+#include <cstdlib>
+#include <functional>
+
+using namespace std;
+
+ValueStore::Slabs::Slabs()
+    : freeLists(MAX_CHUNK / 8 + 1), next(NULL), left(0)
+{
+}
+
+ValueStore::Slabs::~Slabs()
+{
+    for (char *page : pages) {
+        ::free(page);
+    }
+}
+
+size_t
+ValueStore::Slabs::chunkSize(size_t n)
+{
+    if (n > MAX_CHUNK) {
+        return n;
+    }
+    // Round up by an eighth to a quarter of n, so that chunks waste
+    // little but there are few sizes.
+    size_t step = 8;
+    while (step * 8 < n) {
+        step *= 2;
+    }
+    return (n + step - 1) & ~(step - 1);
+}
+
+char *
+ValueStore::Slabs::alloc(size_t size)
+{
+    if (size > MAX_CHUNK) {
+        char *chunk = (char *)malloc(size);
+        if (chunk == NULL) {
+            Panic("Out of memory for a %zu byte value", size);
+        }
+        return chunk;
+    }
+
+    char *&head = freeLists[size / 8];
+    if (head != NULL) {
+        char *chunk = head;
+        memcpy(&head, chunk, sizeof(head));
+        return chunk;
+    }
+
+    if (left < size) {
+        next = (char *)malloc(PAGE_SIZE);
+        if (next == NULL) {
+            Panic("Out of memory for a value slab");
+        }
+        pages.push_back(next);
+        left = PAGE_SIZE;
+    }
+    char *chunk = next;
+    next += size;
+    left -= size;
+    return chunk;
+}
+
+void
+ValueStore::Slabs::free(char *chunk, size_t size)
+{
+    if (size > MAX_CHUNK) {
+        ::free(chunk);
+        return;
+    }
+    char *&head = freeLists[size / 8];
+    memcpy(chunk, &head, sizeof(head));
+    head = chunk;
+}
+
+ValueStore::ValueStore() : count(0) { }
+
+ValueStore::~ValueStore()
+{
+    for (Slot &s : slots) {
+        if (s.hash != 0) {
+            release(s.key);
+            release(s.value);
+        }
+    }
+}
+
+uint32_t
+ValueStore::hash(const string &key)
+{
+    uint64_t h = std::hash<string>()(key);
+    uint32_t folded = h ^ (h >> 32);
+    return folded == 0 ? 1 : folded;
+}
+
+size_t
+ValueStore::find(const string &key, uint32_t h) const
+{
+    for (size_t i = home(h); ; i = next(i)) {
+        const Slot &s = slots[i];
+        if (s.hash == 0 || (s.hash == h && s.key.equals(key))) {
+            return i;
+        }
+    }
+}
+
+bool
+ValueStore::get(const string &key, string &value) const
+{
+    if (count == 0) {
+        return false;
+    }
+    const Slot &s = slots[find(key, hash(key))];
+    if (s.hash == 0) {
+        return false;
+    }
+    value.assign(s.value.bytes(), s.value.size());
+    return true;
+}
+
+void
+ValueStore::put(const string &key, const string &value)
+{
+    // Keep the table at most three quarters full.
+    if ((count + 1) * 4 > slots.size() * 3) {
+        grow(max((size_t)16, slots.size() + slots.size() / 2));
+    }
+
+    uint32_t h = hash(key);
+    Slot &s = slots[find(key, h)];
+    if (s.hash == 0) {
+        s.hash = h;
+        assign(s.key, key);
+        count++;
+    }
+    assign(s.value, value);
+}
+
+bool
+ValueStore::remove(const string &key)
+{
+    if (count == 0) {
+        return false;
+    }
+    size_t i = find(key, hash(key));
+    if (slots[i].hash == 0) {
+        return false;
+    }
+    release(slots[i].key);
+    release(slots[i].value);
+
+    i = LinearProbeRemove(slots, i,
+        [](const Slot &s) { return s.hash == 0; },
+        [this](const Slot &s) { return home(s.hash); });
+    memset(&slots[i], 0, sizeof(Slot));
+    count--;
+    return true;
+}
+
+void
+ValueStore::reserve(size_t n)
+{
+    size_t capacity = max((size_t)16, n + n / 3 + 1);
+    if (capacity > slots.size()) {
+        grow(capacity);
+    }
+}
+
+void
+ValueStore::clear()
+{
+    for (Slot &s : slots) {
+        if (s.hash != 0) {
+            release(s.key);
+            release(s.value);
+            s.hash = 0;
+        }
+    }
+    count = 0;
+}
+
+void
+ValueStore::forEach(const function<void (const string &key,
+                                         const string &value)> &fn) const
+{
+    string key, value;
+    for (const Slot &s : slots) {
+        if (s.hash != 0) {
+            key.assign(s.key.bytes(), s.key.size());
+            value.assign(s.value.bytes(), s.value.size());
+            fn(key, value);
+        }
+    }
+}
+
+void
+ValueStore::grow(size_t capacity)
+{
+    vector<Slot> old(capacity);
+    old.swap(slots);
+
+    // Entries keep their blobs: only the slots move.
+    for (const Slot &s : old) {
+        if (s.hash == 0) {
+            continue;
+        }
+        size_t i = home(s.hash);
+        while (slots[i].hash != 0) {
+            i = next(i);
+        }
+        slots[i] = s;
+    }
+}
+
+void
+ValueStore::assign(Blob &b, const string &s)
+{
+    if (s.size() > UINT32_MAX) {
+        Panic("Value of %zu bytes is too large", s.size());
+    }
+
+    // Overwrite a chunk of the right size in place.
+    if (!b.isInline() && s.size() > Blob::INLINE_MAX &&
+        Slabs::chunkSize(s.size()) == Slabs::chunkSize(b.size())) {
+        memcpy((char *)b.bytes(), s.data(), s.size());
+        uint32_t n = s.size();
+        memcpy(b.data + sizeof(char *), &n, sizeof(n));
+        return;
+    }
+
+    release(b);
+    if (s.size() <= Blob::INLINE_MAX) {
+        memcpy(b.data, s.data(), s.size());
+        b.data[15] = (char)s.size();
+        return;
+    }
+
+    char *chunk = slabs.alloc(Slabs::chunkSize(s.size()));
+    memcpy(chunk, s.data(), s.size());
+    uint32_t n = s.size();
+    memcpy(b.data, &chunk, sizeof(chunk));
+    memcpy(b.data + sizeof(chunk), &n, sizeof(n));
+    b.data[15] = (char)Blob::OUT_OF_LINE;
+}
+
+void
+ValueStore::release(Blob &b)
+{
+    if (!b.isInline()) {
+        slabs.free((char *)b.bytes(), Slabs::chunkSize(b.size()));
+    }
+    memset(b.data, 0, sizeof(b.data));
+}
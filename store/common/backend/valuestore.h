@@ -0,0 +1,133 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/backend/valuestore.h:
+ *   Compact hash table from string keys to string values.
+ *
+ **********************************************************************/
+
+#ifndef _VALUE_STORE_H_
+#define _VALUE_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A hash table from keys to values laid out to keep the memory per key
+// small: one array of 36-byte slots, probed linearly, with no node per
+// entry. The array grows by half, not double, and the hash is scaled to
+// its size. Keys and values of up to 15 bytes are stored in the slot
+// itself; longer ones go in chunks carved from large slabs, with a free
+// list per chunk size. Removal shifts later entries back, so the table
+// never fills up with tombstones.
+class ValueStore
+{
+public:
+    ValueStore();
+    ~ValueStore();
+
+    bool get(const std::string &key, std::string &value) const;
+    void put(const std::string &key, const std::string &value);
+    bool remove(const std::string &key);
+    // Make room for n keys.
+    void reserve(size_t n);
+    size_t size() const { return count; }
+    // Remove every key, keeping the room made for them.
+    void clear();
+    // Call fn on every key and its value, in no particular order.
+    void forEach(const std::function<void (const std::string &key,
+                                           const std::string &value)> &fn)
+        const;
+
+private:
+    // Up to INLINE_MAX bytes in place, with their length in the last
+    // byte; or a pointer to a chunk and the length, marked OUT_OF_LINE.
+    struct Blob {
+        static const size_t INLINE_MAX = 15;
+        static const unsigned char OUT_OF_LINE = 0xff;
+
+        char data[16];
+
+        bool isInline() const {
+            return (unsigned char)data[15] != OUT_OF_LINE;
+        }
+        size_t size() const {
+            if (isInline()) {
+                return (unsigned char)data[15];
+            }
+            uint32_t n;
+            memcpy(&n, data + sizeof(char *), sizeof(n));
+            return n;
+        }
+        const char *bytes() const {
+            if (isInline()) {
+                return data;
+            }
+            char *p;
+            memcpy(&p, data, sizeof(p));
+            return p;
+        }
+        bool equals(const std::string &s) const {
+            return size() == s.size() &&
+                memcmp(bytes(), s.data(), s.size()) == 0;
+        }
+    };
+
+    // A slot is empty if its hash is 0; hashes of 0 are stored as 1.
+    struct Slot {
+        uint32_t hash;
+        Blob key;
+        Blob value;
+    };
+
+    // Chunks of up to MAX_CHUNK bytes come from PAGE_SIZE slabs; larger
+    // ones from malloc.
+    class Slabs
+    {
+    public:
+        static const size_t MAX_CHUNK = 8192;
+        static const size_t PAGE_SIZE = 1 << 18;
+
+        Slabs();
+        ~Slabs();
+
+        // The size of the chunk that holds n bytes.
+        static size_t chunkSize(size_t n);
+        char *alloc(size_t size);
+        void free(char *chunk, size_t size);
+
+    private:
+        // Free chunks of each size, by size / 8, linked through their
+        // first bytes.
+        std::vector<char *> freeLists;
+        std::vector<char *> pages;
+        char *next;
+        size_t left;
+    };
+
+    std::vector<Slot> slots;
+    size_t count;
+    Slabs slabs;
+
+    static uint32_t hash(const std::string &key);
+    // The slot an entry with hash h is placed from.
+    size_t home(uint32_t h) const {
+        return ((uint64_t)h * slots.size()) >> 32;
+    }
+    size_t next(size_t i) const {
+        return i + 1 == slots.size() ? 0 : i + 1;
+    }
+    // The slot holding key, or the empty slot it would go in.
+    size_t find(const std::string &key, uint32_t h) const;
+    void grow(size_t capacity);
+    void assign(Blob &b, const std::string &s);
+    void release(Blob &b);
+
+    ValueStore(const ValueStore &) = delete;
+    ValueStore &operator=(const ValueStore &) = delete;
+};
+
+#endif /* _VALUE_STORE_H_ */
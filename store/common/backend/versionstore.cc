@@ -114,6 +114,78 @@ VersionedKVStore::put(const string &key, const string &value, const Timestamp &t
     store[key].insert(VersionedValue(t, value));
 }
 
+void
+VersionedKVStore::save(SnapshotWriter &out) const
+{
+    out.U64(store.size());
+    for (auto &kv : store) {
+        out.String(kv.first);
+        out.U64(kv.second.size());
+        for (auto &version : kv.second) {
+            out.Time(version.write);
+            out.String(version.value);
+        }
+    }
+
+    out.U64(lastReads.size());
+    for (auto &kv : lastReads) {
+        out.String(kv.first);
+        out.U64(kv.second.size());
+        for (auto &read : kv.second) {
+            out.Time(read.first);
+            out.Time(read.second);
+        }
+    }
+}
+
+bool
+VersionedKVStore::restore(SnapshotReader &in)
+{
+    store.clear();
+    lastReads.clear();
+
+    uint64_t nKeys, n;
+    string key;
+    if (!in.U64(nKeys)) {
+        return false;
+    }
+    store.reserve(nKeys);
+    for (uint64_t i = 0; i < nKeys; i++) {
+        if (!in.String(key) || !in.U64(n)) {
+            return false;
+        }
+        set<VersionedValue> &versions = store[key];
+        for (uint64_t j = 0; j < n; j++) {
+            Timestamp write;
+            string value;
+            if (!in.Time(write) || !in.String(value)) {
+                return false;
+            }
+            // Versions were written in order, so each goes at the end.
+            versions.emplace_hint(versions.end(), write, value);
+        }
+    }
+
+    if (!in.U64(nKeys)) {
+        return false;
+    }
+    lastReads.reserve(nKeys);
+    for (uint64_t i = 0; i < nKeys; i++) {
+        if (!in.String(key) || !in.U64(n)) {
+            return false;
+        }
+        map<Timestamp, Timestamp> &reads = lastReads[key];
+        for (uint64_t j = 0; j < n; j++) {
+            Timestamp version, read;
+            if (!in.Time(version) || !in.Time(read)) {
+                return false;
+            }
+            reads.emplace_hint(reads.end(), version, read);
+        }
+    }
+    return true;
+}
+
 /*
  * Commit a read by updating the timestamp of the latest read txn for
  * the version of the key that the txn read.
@@ -127,12 +199,10 @@ VersionedKVStore::commitGet(const string &key, const Timestamp &readTime, const
         getValue(key, readTime, it);
         
         if (it != store[key].end()) {
-            // figure out if anyone has read this version before
-            if (lastReads.find(key) != lastReads.end() &&
-                lastReads[key].find((*it).write) != lastReads[key].end()) {
-                if (lastReads[key][(*it).write] < commit) {
-                    lastReads[key][(*it).write] = commit;
-                }
+            // remember the latest commit that read this version
+            Timestamp &lastRead = lastReads[key][(*it).write];
+            if (lastRead < commit) {
+                lastRead = commit;
             }
         }
     } // otherwise, ignore the read
@@ -34,6 +34,7 @@
 #include "lib/assert.h"
 #include "lib/message.h"
 #include "store/common/timestamp.h"
+#include "store/common/backend/snapshot.h"
 
 #include <set>
 #include <map>
@@ -52,6 +53,13 @@ public:
     bool getLastRead(const std::string &key, const Timestamp &t, Timestamp &readTime);
     void put(const std::string &key, const std::string &value, const Timestamp &t);
     void commitGet(const std::string &key, const Timestamp &readTime, const Timestamp &commit);
+    // Make room for n keys before loading them.
+    void reserve(size_t n) { store.reserve(n); }
+
+    // Write every version and read marker, or replace them all with
+    // those save wrote.
+    void save(SnapshotWriter &out) const;
+    bool restore(SnapshotReader &in);
 
 private:
     struct VersionedValue {
@@ -78,6 +78,63 @@ BufferClient::Get(const string &key, Promise *promise)
     }
 }
 
+void
+BufferClient::Get(const string &key, const Timestamp &timestamp,
+                  Promise *promise)
+{
+    txnclient->Get(tid, key, timestamp, promise);
+}
+
+void
+BufferClient::MultiGet(const vector<string> &keys,
+                       const vector<Promise *> &promises)
+{
+    vector<string> fetchKeys;
+    vector<Promise *> fetchPromises;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        const string &key = keys[i];
+
+        // Read your own writes, check the write set first.
+        auto w = txn.getWriteSet().find(key);
+        if (w != txn.getWriteSet().end()) {
+            promises[i]->Reply(REPLY_OK, w->second);
+            continue;
+        }
+
+        // Consistent reads, read from the server at same timestamp.
+        auto r = txn.getReadSet().find(key);
+        if (r != txn.getReadSet().end()) {
+            txnclient->Get(tid, key, r->second, promises[i]);
+            continue;
+        }
+
+        fetchKeys.push_back(key);
+        fetchPromises.push_back(promises[i]);
+    }
+
+    // Otherwise, get latest values from server.
+    if (!fetchKeys.empty()) {
+        txnclient->MultiGet(tid, fetchKeys, fetchPromises);
+    }
+}
+
+void
+BufferClient::FinishMultiGet(const vector<string> &keys,
+                             const vector<Promise *> &promises)
+{
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (promises[i]->GetReply() != REPLY_OK ||
+            txn.getWriteSet().find(keys[i]) != txn.getWriteSet().end() ||
+            txn.getReadSet().find(keys[i]) != txn.getReadSet().end()) {
+            continue;
+        }
+        Debug("Adding [%s] with ts %lu", keys[i].c_str(),
+              promises[i]->GetTimestamp().getTimestamp());
+        txn.addReadSet(keys[i], promises[i]->GetTimestamp());
+    }
+}
+
 /* Set value for a key. (Always succeeds).
  * Returns 0 on success, else -1. */
 void
@@ -95,6 +152,19 @@ BufferClient::Prepare(const Timestamp &timestamp, Promise *promise)
     txnclient->Prepare(tid, txn, timestamp, promise);
 }
 
+bool
+BufferClient::IsReadOnly() const
+{
+    return txn.getWriteSet().empty();
+}
+
+/* Validate the reads of a read-only transaction. */
+void
+BufferClient::Validate(const Timestamp &timestamp, Promise *promise)
+{
+    txnclient->Validate(tid, txn, timestamp, promise);
+}
+
 void
 BufferClient::Commit(uint64_t timestamp, Promise *promise)
 {
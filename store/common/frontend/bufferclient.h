@@ -49,12 +49,31 @@ public:
     // Get value corresponding to key.
     void Get(const string &key, Promise *promise = NULL);
 
+    // Get the version of key at timestamp, as a snapshot read: it is not
+    // added to the read set.
+    void Get(const string &key, const Timestamp &timestamp, Promise *promise);
+
+    // Get values for several keys, replying to promises[i] for keys[i].
+    // Keys not already read or written go to the shard in a single batch.
+    // Returns without waiting; FinishMultiGet waits for the replies and
+    // adds the versions read to the read set.
+    void MultiGet(const std::vector<std::string> &keys,
+                  const std::vector<Promise *> &promises);
+    void FinishMultiGet(const std::vector<std::string> &keys,
+                        const std::vector<Promise *> &promises);
+
     // Put value for given key.
     void Put(const string &key, const string &value, Promise *promise = NULL);
 
     // Prepare (Spanner requires a prepare timestamp)
     void Prepare(const Timestamp &timestamp = Timestamp(), Promise *promise = NULL); 
 
+    // Is the ongoing transaction read-only so far?
+    bool IsReadOnly() const;
+
+    // Validate and commit the ongoing read-only transaction.
+    void Validate(const Timestamp &timestamp, Promise *promise = NULL);
+
     // Commit the ongoing transaction.
     void Commit(uint64_t timestamp = 0, Promise *promise = NULL);
 
@@ -11,7 +11,9 @@
 
 #include "lib/assert.h"
 #include "lib/message.h"
+#include "store/common/transaction.h"
 
+#include <cctype>
 #include <string>
 #include <vector>
 
@@ -24,9 +26,33 @@ public:
     // Begin a transaction.
     virtual void Begin() = 0;
 
+    // Begin a transaction that will only read. Stores that can serve
+    // one from a snapshot, without locking, do so; the rest run it like
+    // any other.
+    virtual void BeginReadOnly() { Begin(); }
+
     // Get the value corresponding to key.
     virtual int Get(const std::string &key, std::string &value) = 0;
 
+    // Get the values corresponding to several keys. Stores that cannot
+    // batch reads fetch them one at a time. Returns REPLY_ABORTED if any
+    // read was aborted, or else the status of the first read that failed,
+    // if any.
+    virtual int MultiGet(const std::vector<std::string> &keys,
+                         std::vector<std::string> &values) {
+        int status = 0;
+        values.clear();
+        for (const std::string &key : keys) {
+            std::string value;
+            int ret = Get(key, value);
+            if (status == 0 || ret == REPLY_ABORTED) {
+                status = ret;
+            }
+            values.push_back(value);
+        }
+        return status;
+    }
+
     // Set the value for the given key.
     virtual int Put(const std::string &key, const std::string &value) = 0;
 
@@ -39,8 +65,22 @@ public:
     // Returns statistics (vector of integers) about most recent transaction.
     virtual std::vector<int> Stats() = 0;
 
-    // Sharding logic: Given key, generates a number b/w 0 to nshards-1
-    uint64_t key_to_shard(const std::string &key, uint64_t nshards) {
+    // Sharding logic: Given key, generates a number b/w 0 to nshards-1.
+    // Keys that start with a partition number in braces, "{n}...", go to
+    // shard n % nshards, so workloads can place related keys together.
+    static uint64_t key_to_shard(const std::string &key, uint64_t nshards) {
+        if (key.length() > 2 && key[0] == '{') {
+            uint64_t partition = 0;
+            unsigned int i = 1;
+            while (i < key.length() && isdigit((unsigned char)key[i])) {
+                partition = partition * 10 + (key[i] - '0');
+                i++;
+            }
+            if (i > 1 && i < key.length() && key[i] == '}') {
+                return (partition % nshards);
+            }
+        }
+
         uint64_t hash = 5381;
         const char* str = key.c_str();
         for (unsigned int i = 0; i < key.length(); i++) {
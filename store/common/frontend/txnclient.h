@@ -32,11 +32,13 @@
 #ifndef _TXN_CLIENT_H_
 #define _TXN_CLIENT_H_
 
+#include "lib/message.h"
 #include "store/common/promise.h"
 #include "store/common/timestamp.h"
 #include "store/common/transaction.h"
 
 #include <string>
+#include <vector>
 
 #define DEFAULT_TIMEOUT_MS 250
 #define DEFAULT_MULTICAST_TIMEOUT_MS 500
@@ -74,6 +76,17 @@ public:
                      const Timestamp &timestamp,
                      Promise *promise = NULL) = 0;
 
+    // Get the latest values of several keys, replying to promises[i] for
+    // keys[i]. Stores that cannot batch reads fetch one key at a time.
+    virtual void MultiGet(uint64_t id,
+                          const std::vector<std::string> &keys,
+                          const std::vector<Promise *> &promises) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            Get(id, keys[i], promises[i]);
+            promises[i]->GetReply();
+        }
+    }
+
     // Set the value for the given key.
     virtual void Put(uint64_t id,
                      const std::string &key,
@@ -86,6 +99,16 @@ public:
                          const Timestamp &timestamp = Timestamp(),
                          Promise *promise = NULL) = 0;
 
+    // Validate the reads of a read-only transaction at the given timestamp,
+    // committing it if they are still valid. Only stores with a read-only
+    // fast path support this.
+    virtual void Validate(uint64_t id,
+                          const Transaction &txn,
+                          const Timestamp &timestamp,
+                          Promise *promise = NULL) {
+        Panic("Unimplemented VALIDATE");
+    }
+
     // Commit all Get(s) and Put(s) since Begin().
     virtual void Commit(uint64_t id,
                         const Transaction &txn = Transaction(), 
@@ -0,0 +1,254 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/keyset.cc:
+ *   Memory-mapped sets of keys for servers to preload and benchmark
+ *   clients to pick from.
+ *
+ **********************************************************************/
+
+#include "store/common/keyset.h"
+#include "store/common/frontend/client.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[8] = { 'K', 'E', 'Y', 'S', 'E', 'T', '0', '1' };
+
+struct Header
+{
+    char magic[8];
+    uint32_t nShards;
+    uint32_t unused;
+    uint64_t nKeys;
+};
+
+size_t
+ShardsSize(uint64_t nKeys)
+{
+    return (nKeys * sizeof(uint32_t) + 7) & ~(size_t)7;
+}
+
+// Run f(lo, hi) over [0, n) in one chunk per core.
+void
+ParallelFor(size_t n, const function<void (size_t, size_t)> &f)
+{
+    size_t nThreads = max(1u, thread::hardware_concurrency());
+    size_t chunk = (n + nThreads - 1) / nThreads;
+    vector<thread> threads;
+    for (size_t lo = 0; lo < n; lo += chunk) {
+        threads.emplace_back(f, lo, min(n, lo + chunk));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+} // namespace
+
+KeySet::KeySet()
+    : map(NULL), mapSize(0), nKeys(0), offsets(NULL), data(NULL),
+      shards(NULL), mappedShards(0), separator(0)
+{
+}
+
+KeySet::~KeySet()
+{
+    Close();
+}
+
+void
+KeySet::Close()
+{
+    if (map != NULL) {
+        munmap(map, mapSize);
+    }
+    map = NULL;
+    mapSize = 0;
+    nKeys = 0;
+    offsets = NULL;
+    data = NULL;
+    shards = NULL;
+    mappedShards = 0;
+    textOffsets.clear();
+}
+
+bool
+KeySet::Open(const string &path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    mapSize = st.st_size;
+    map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        map = NULL;
+        return false;
+    }
+    madvise(map, mapSize, MADV_SEQUENTIAL);
+    const char *base = (const char *)map;
+
+    const Header *header = (const Header *)base;
+    if (mapSize >= sizeof(Header) &&
+        memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0) {
+        // Check the count before sizing anything by it, so that a
+        // corrupt one cannot overflow the sizes.
+        uint64_t n = header->nKeys;
+        if (n > mapSize / sizeof(uint64_t)) {
+            Close();
+            return false;
+        }
+        size_t offsetsSize = (n + 1) * sizeof(uint64_t);
+        size_t dataStart = sizeof(Header) + offsetsSize + ShardsSize(n);
+        if (dataStart > mapSize) {
+            Close();
+            return false;
+        }
+
+        // Every key must lie within the key bytes, in order, so that
+        // indexing a truncated or corrupt file cannot read past them.
+        const uint64_t *o = (const uint64_t *)(base + sizeof(Header));
+        if (o[0] != 0 || o[n] != mapSize - dataStart) {
+            Close();
+            return false;
+        }
+        for (uint64_t i = 0; i < n; i++) {
+            if (o[i + 1] < o[i]) {
+                Close();
+                return false;
+            }
+        }
+
+        nKeys = n;
+        offsets = o;
+        shards = (const uint32_t *)(base + sizeof(Header) + offsetsSize);
+        mappedShards = header->nShards;
+        data = base + dataStart;
+        return true;
+    }
+
+    // A text file: one key per line, the last perhaps unterminated.
+    separator = 1;
+    data = base;
+    textOffsets.push_back(0);
+    const char *p = base, *end = base + mapSize;
+    while (p < end) {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        p = eol == NULL ? end : eol;
+        textOffsets.push_back(p - base + 1);
+        p++;
+    }
+    nKeys = textOffsets.size() - 1;
+    offsets = textOffsets.data();
+    return true;
+}
+
+uint64_t
+KeySet::Shard(size_t i, uint64_t nShards) const
+{
+    if (shards != NULL && mappedShards == nShards) {
+        return shards[i];
+    }
+    return Client::key_to_shard((*this)[i], nShards);
+}
+
+void
+KeySet::Load(size_t n, uint64_t nShards, uint64_t first, uint64_t count,
+             const function<void (uint64_t, size_t)> &reserve,
+             const function<void (uint64_t, const string &)> &load) const
+{
+    n = min(n, nKeys);
+
+    // Place the keys, unless the file already has.
+    vector<uint32_t> placed;
+    const uint32_t *shardOf = shards;
+    if (shards == NULL || mappedShards != nShards) {
+        placed.resize(n);
+        ParallelFor(n, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+                placed[i] = Shard(i, nShards);
+            }
+        });
+        shardOf = placed.data();
+    }
+
+    vector<size_t> counts(count);
+    for (size_t i = 0; i < n; i++) {
+        if (shardOf[i] >= first && shardOf[i] < first + count) {
+            counts[shardOf[i] - first]++;
+        }
+    }
+
+    vector<thread> threads;
+    for (uint64_t shard = first; shard < first + count; shard++) {
+        threads.emplace_back([&, shard]() {
+            reserve(shard, counts[shard - first]);
+            for (size_t i = 0; i < n; i++) {
+                if (shardOf[i] == shard) {
+                    load(shard, (*this)[i]);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+bool
+KeySet::Write(const string &path, const vector<string> &keys,
+              uint64_t nShards)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == NULL) {
+        return false;
+    }
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.nShards = nShards;
+    header.unused = 0;
+    header.nKeys = keys.size();
+
+    vector<uint64_t> offsets(keys.size() + 1);
+    vector<uint32_t> shards(ShardsSize(keys.size()) / sizeof(uint32_t));
+    for (size_t i = 0; i < keys.size(); i++) {
+        offsets[i + 1] = offsets[i] + keys[i].size();
+        shards[i] = Client::key_to_shard(keys[i], nShards);
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+        fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), f) ==
+            offsets.size() &&
+        fwrite(shards.data(), sizeof(uint32_t), shards.size(), f) ==
+            shards.size();
+    for (size_t i = 0; ok && i < keys.size(); i++) {
+        ok = fwrite(keys[i].data(), 1, keys[i].size(), f) == keys[i].size();
+    }
+    return fclose(f) == 0 && ok;
+}
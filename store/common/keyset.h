@@ -0,0 +1,80 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/keyset.h:
+ *   Memory-mapped sets of keys for servers to preload and benchmark
+ *   clients to pick from.
+ *
+ **********************************************************************/
+
+#ifndef _KEYSET_H_
+#define _KEYSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A list of keys read from a file, either text with one key per line or
+// the binary format Write produces. A binary key set is mapped into
+// memory and used in place: it holds the offset of each key and the
+// shard each key falls in for some number of shards, so opening one
+// costs nothing per key. The format is in host byte order.
+//
+//   magic "KEYSET01", uint32 nShards, uint32 0, uint64 nKeys,
+//   uint64 offsets[nKeys + 1] into the key bytes,
+//   uint32 shards[nKeys], padded to 8 bytes, then the key bytes.
+class KeySet
+{
+public:
+    KeySet();
+    ~KeySet();
+
+    // Open path, in place of whatever the set held before.
+    bool Open(const std::string &path);
+
+    size_t Size() const { return nKeys; }
+    std::string operator[](size_t i) const {
+        return std::string(data + offsets[i],
+                           offsets[i + 1] - offsets[i] - separator);
+    }
+
+    // The shard key i falls in, as Client::key_to_shard places it.
+    uint64_t Shard(size_t i, uint64_t nShards) const;
+
+    // Call load(shard, key) for each of the first n keys that falls in
+    // shards [first, first + count) of nShards. Each shard is loaded
+    // by a thread of its own, after reserve(shard, nKeys) is called with
+    // the number of keys it will get.
+    void Load(size_t n, uint64_t nShards, uint64_t first, uint64_t count,
+              const std::function<void (uint64_t, size_t)> &reserve,
+              const std::function<void (uint64_t, const std::string &)> &load)
+        const;
+
+    static bool Write(const std::string &path,
+                      const std::vector<std::string> &keys,
+                      uint64_t nShards);
+
+private:
+    void *map;
+    size_t mapSize;
+    size_t nKeys;
+    const uint64_t *offsets;
+    const char *data;
+    // Precomputed shards, for mappedShards shards; NULL if none.
+    const uint32_t *shards;
+    uint64_t mappedShards;
+    // Offsets of the lines of a text file, whose keys are each followed
+    // by a one-byte separator.
+    std::vector<uint64_t> textOffsets;
+    size_t separator;
+
+    // Unmap the file, if any, and empty the set.
+    void Close();
+
+    KeySet(const KeySet &) = delete;
+    KeySet &operator=(const KeySet &) = delete;
+};
+
+#endif /* _KEYSET_H_ */
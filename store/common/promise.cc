@@ -46,6 +46,22 @@ Promise::Promise(int timeoutMS)
     timeout = timeoutMS;
 }
 
+Promise::Promise(int timeoutMS, PromiseQueue *queue)
+{
+    done = false;
+    reply = 0;
+    timeout = timeoutMS;
+    continuation = [queue](Promise *p) { queue->Push(p); };
+}
+
+Promise::Promise(int timeoutMS, function<void (Promise *)> continuation)
+{
+    done = false;
+    reply = 0;
+    timeout = timeoutMS;
+    this->continuation = continuation;
+}
+
 Promise::~Promise() { }
 
 // Get configured timeout, return after this period
@@ -64,36 +80,65 @@ Promise::ReplyInternal(int r)
     cv.notify_all();
 }
 
+// Run the continuation, if any. Called without holding the lock, and with
+// hasContinuation read beforehand: once replied to, a promise may be
+// deleted by its continuation or, if it has none, by the thread that was
+// waiting on it.
+void
+Promise::Notify(bool hasContinuation)
+{
+    if (hasContinuation) {
+        function<void (Promise *)> k = std::move(continuation);
+        k(this);
+    }
+}
+
 void
 Promise::Reply(int r)
 {
-    lock_guard<mutex> l(lock);
-    ReplyInternal(r);
+    bool k = (bool)continuation;
+    {
+        lock_guard<mutex> l(lock);
+        ReplyInternal(r);
+    }
+    Notify(k);
 }
 
 void
 Promise::Reply(int r, Timestamp t)
 {
-    lock_guard<mutex> l(lock);
-    timestamp = t;
-    ReplyInternal(r);
+    bool k = (bool)continuation;
+    {
+        lock_guard<mutex> l(lock);
+        timestamp = t;
+        ReplyInternal(r);
+    }
+    Notify(k);
 }
 
 void
 Promise::Reply(int r, string v)
 {
-    lock_guard<mutex> l(lock);
-    value = v;
-    ReplyInternal(r);
+    bool k = (bool)continuation;
+    {
+        lock_guard<mutex> l(lock);
+        value = v;
+        ReplyInternal(r);
+    }
+    Notify(k);
 }
 
 void
 Promise::Reply(int r, Timestamp t, string v)
 {
-    lock_guard<mutex> l(lock);
-    value = v;
-    timestamp = t;
-    ReplyInternal(r);
+    bool k = (bool)continuation;
+    {
+        lock_guard<mutex> l(lock);
+        value = v;
+        timestamp = t;
+        ReplyInternal(r);
+    }
+    Notify(k);
 }
 
 // Functions for getting a reply from the promise
@@ -126,3 +171,23 @@ Promise::GetValue()
     }
     return value;
 }
+
+void
+PromiseQueue::Push(Promise *promise)
+{
+    lock_guard<mutex> l(lock);
+    replied.push_back(promise);
+    cv.notify_all();
+}
+
+Promise *
+PromiseQueue::Pop()
+{
+    unique_lock<mutex> l(lock);
+    while (replied.empty()) {
+        cv.wait(l);
+    }
+    Promise *promise = replied.front();
+    replied.pop_front();
+    return promise;
+}
@@ -38,8 +38,12 @@
 #include "store/common/transaction.h"
 
 #include <condition_variable>
+#include <deque>
+#include <functional>
 #include <mutex>
 
+class PromiseQueue;
+
 class Promise
 {
 private:
@@ -50,12 +54,19 @@ private:
     std::string value;
     std::mutex lock;
     std::condition_variable cv;
+    std::function<void (Promise *)> continuation;
 
     void ReplyInternal(int r);
+    void Notify(bool hasContinuation);
 
 public:
     Promise();
     Promise(int timeoutMS); // timeout in milliseconds
+    // also hand this promise to queue once it is replied to
+    Promise(int timeoutMS, PromiseQueue *queue);
+    // also run continuation, on the replying thread, once replied to; the
+    // continuation is then responsible for deleting the promise
+    Promise(int timeoutMS, std::function<void (Promise *)> continuation);
     ~Promise();
 
     // reply to this promise and unblock any waiting threads
@@ -73,4 +84,20 @@ public:
     std::string GetValue();
 };
 
+// Collects promises in the order they are replied to, so that a thread
+// waiting on several of them can handle each reply as it arrives.
+class PromiseQueue
+{
+private:
+    std::deque<Promise *> replied;
+    std::mutex lock;
+    std::condition_variable cv;
+
+public:
+    void Push(Promise *promise);
+
+    // block until some promise has been replied to and return it
+    Promise *Pop();
+};
+
 #endif /* _PROMISE_H_ */
@@ -0,0 +1,11 @@
+d := $(dir $(lastword $(MAKEFILE_LIST)))
+
+#
+# gtest-based tests
+#
+GTEST_SRCS += $(addprefix $(d), \
+		keyset-test.cc)
+
+$(d)keyset-test: $(o)keyset-test.o $(LIB-message) $(LIB-store-common) $(GTEST_MAIN)
+
+TEST_BINS += $(d)keyset-test
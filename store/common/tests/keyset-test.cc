@@ -0,0 +1,177 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/common/tests/keyset-test.cc:
+ *   test cases for KeySet
+ *
+ **********************************************************************/
+
+#include "store/common/keyset.h"
+#include "store/common/frontend/client.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class KeySetTest : public ::testing::Test
+{
+protected:
+    string path;
+    vector<string> keys;
+
+    virtual void SetUp() {
+        char name[] = "/tmp/keyset-test-XXXXXX";
+        int fd = mkstemp(name);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path = name;
+
+        for (int i = 0; i < 1000; i++) {
+            keys.push_back("key" + to_string(i * 7919));
+        }
+        keys.push_back("{3}pinned");
+    }
+
+    virtual void TearDown() {
+        unlink(path.c_str());
+    }
+
+    void WriteText(const string &text) {
+        FILE *f = fopen(path.c_str(), "w");
+        fputs(text.c_str(), f);
+        fclose(f);
+    }
+};
+
+TEST_F(KeySetTest, Text)
+{
+    WriteText("alpha\nbeta\n\ngamma");
+    KeySet set;
+    ASSERT_TRUE(set.Open(path));
+    ASSERT_EQ(4, set.Size());
+    EXPECT_EQ("alpha", set[0]);
+    EXPECT_EQ("beta", set[1]);
+    EXPECT_EQ("", set[2]);
+    EXPECT_EQ("gamma", set[3]);
+}
+
+TEST_F(KeySetTest, Empty)
+{
+    WriteText("");
+    KeySet set;
+    ASSERT_TRUE(set.Open(path));
+    EXPECT_EQ(0, set.Size());
+}
+
+TEST_F(KeySetTest, Reopen)
+{
+    WriteText("alpha\nbeta\n");
+    KeySet set;
+    ASSERT_TRUE(set.Open(path));
+    ASSERT_EQ(2, set.Size());
+
+    WriteText("gamma\n");
+    ASSERT_TRUE(set.Open(path));
+    ASSERT_EQ(1, set.Size());
+    EXPECT_EQ("gamma", set[0]);
+}
+
+TEST_F(KeySetTest, Missing)
+{
+    KeySet set;
+    EXPECT_FALSE(set.Open(path + ".missing"));
+}
+
+TEST_F(KeySetTest, BinaryRoundTrip)
+{
+    ASSERT_TRUE(KeySet::Write(path, keys, 5));
+    KeySet set;
+    ASSERT_TRUE(set.Open(path));
+    ASSERT_EQ(keys.size(), set.Size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        EXPECT_EQ(keys[i], set[i]);
+        // Precomputed, and recomputed for another shard count.
+        EXPECT_EQ(Client::key_to_shard(keys[i], 5), set.Shard(i, 5));
+        EXPECT_EQ(Client::key_to_shard(keys[i], 3), set.Shard(i, 3));
+    }
+}
+
+TEST_F(KeySetTest, Truncated)
+{
+    ASSERT_TRUE(KeySet::Write(path, keys, 5));
+    ASSERT_EQ(0, truncate(path.c_str(), 100));
+    KeySet set;
+    EXPECT_FALSE(set.Open(path));
+}
+
+TEST_F(KeySetTest, CorruptOffsets)
+{
+    // The offsets follow the 24-byte header.
+    const long firstOffset = 24;
+    struct { long at; uint64_t value; } corruptions[] = {
+        // An offset past the key bytes.
+        { firstOffset + 10 * 8, 1ULL << 40 },
+        // An offset that goes backwards.
+        { firstOffset + 500 * 8, 3 },
+        // A first offset other than 0.
+        { firstOffset, 1 },
+        // A key count larger than the file.
+        { 16, 1ULL << 40 },
+    };
+
+    for (auto c : corruptions) {
+        ASSERT_TRUE(KeySet::Write(path, keys, 5));
+        FILE *f = fopen(path.c_str(), "r+");
+        ASSERT_TRUE(f != NULL);
+        ASSERT_EQ(0, fseek(f, c.at, SEEK_SET));
+        ASSERT_EQ(1U, fwrite(&c.value, sizeof(c.value), 1, f));
+        fclose(f);
+
+        KeySet set;
+        EXPECT_FALSE(set.Open(path)) << "corrupt at " << c.at;
+        EXPECT_EQ(0U, set.Size());
+    }
+}
+
+TEST_F(KeySetTest, Load)
+{
+    ASSERT_TRUE(KeySet::Write(path, keys, 4));
+    KeySet set;
+    ASSERT_TRUE(set.Open(path));
+
+    // Load shards 1 and 2 of 4 from the first 900 keys, with the shard
+    // count the file was written for and with another.
+    for (uint64_t nShards : {4, 6}) {
+        mutex m;
+        map<uint64_t, size_t> reserved;
+        map<uint64_t, vector<string> > loaded;
+        set.Load(900, nShards, 1, 2,
+            [&](uint64_t shard, size_t n) {
+                lock_guard<mutex> lock(m);
+                reserved[shard] = n;
+            },
+            [&](uint64_t shard, const string &key) {
+                lock_guard<mutex> lock(m);
+                loaded[shard].push_back(key);
+            });
+
+        map<uint64_t, vector<string> > expected;
+        for (size_t i = 0; i < 900; i++) {
+            uint64_t shard = Client::key_to_shard(keys[i], nShards);
+            if (shard == 1 || shard == 2) {
+                expected[shard].push_back(keys[i]);
+            }
+        }
+        EXPECT_EQ(expected, loaded);
+        EXPECT_EQ(expected[1].size(), reserved[1]);
+        EXPECT_EQ(expected[2].size(), reserved[2]);
+    }
+}
@@ -1,7 +1,7 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
 SRCS += $(addprefix $(d), occstore.cc lockstore.cc server.cc \
-					client.cc shardclient.cc)
+					server-main.cc client.cc shardclient.cc)
 
 PROTOS += $(addprefix $(d), strong-proto.proto)
 
@@ -12,6 +12,8 @@ OBJS-strong-store := $(LIB-message) $(LIB-strong-store) $(LIB-store-common) \
 
 OBJS-strong-client := $(OBJS-vr-client) $(LIB-udptransport) $(LIB-store-frontend) $(LIB-store-common) $(o)strong-proto.o $(o)shardclient.o $(o)client.o
 
-$(d)server: $(LIB-udptransport) $(OBJS-vr-replica) $(OBJS-strong-store)
+$(d)server: $(LIB-udptransport) $(OBJS-vr-replica) $(OBJS-strong-store) \
+	$(o)server-main.o
 
 BINS += $(d)server
+include $(d)tests/Rules.mk
@@ -47,7 +47,10 @@ Client::Client(Mode mode, string configPath, int nShards,
         uniform_int_distribution<uint64_t> dis;
         client_id = dis(gen);
     }
-    t_id = (client_id/10000)*10000;
+    t_id = 0;
+    aborted = false;
+    readOnly = false;
+    snapshot = 0;
 
     nshards = nShards;
     bclient.reserve(nshards);
@@ -106,14 +109,53 @@ void
 Client::Begin()
 {
     Debug("BEGIN Transaction");
-    t_id++;
+
+    // Transaction ids are timestamps for the lock server's wait-die: the
+    // start time, above low bits of the client id that keep ids from
+    // different clients apart. A client that starts transactions faster
+    // than the time advances runs ahead of it, so that they look a little
+    // younger than they are.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    uint64_t start = 0;
+    if ((uint64_t)now.tv_sec > TXNID_EPOCH_SEC) {
+        start = ((uint64_t)(now.tv_sec - TXNID_EPOCH_SEC) * 1000000 +
+                 now.tv_usec) / TXNID_TIME_UNIT_US;
+    }
+    t_id = max(t_id + (1ul << TXNID_CLIENT_BITS),
+               (start << TXNID_CLIENT_BITS) |
+               (client_id & ((1ul << TXNID_CLIENT_BITS) - 1)));
     participants.clear();
     commit_sleep = -1;
+    aborted = false;
+    readOnly = false;
     for (int i = 0; i < nshards; i++) {
         bclient[i]->Begin(t_id);
     }
 }
 
+/* Begins a read-only transaction. In span-lock mode, it reads a snapshot
+ * at the latest time it might be now, Spanner-style: commit wait puts
+ * every transaction that has already committed before it, and the
+ * shards hold reads until nothing else can commit before it. It takes
+ * no locks, and has nothing to prepare or commit.
+ */
+void
+Client::BeginReadOnly()
+{
+    Begin();
+    if (mode != MODE_SPAN_LOCK) {
+        return;
+    }
+
+    uint64_t now, err;
+    timeServer.GetTimeAndError(now, err);
+    uint64_t usec = (now & 0xffffffff) + err;
+    snapshot = (((now >> 32) + usec / 1000000) << 32) | (usec % 1000000);
+    readOnly = true;
+    Debug("BEGIN read-only Transaction at [%lu]", snapshot);
+}
+
 /* Returns the value corresponding to the supplied key. */
 int
 Client::Get(const string &key, string &value)
@@ -121,6 +163,23 @@ Client::Get(const string &key, string &value)
     // Contact the appropriate shard to get the value.
     int i = key_to_shard(key, nshards);
 
+    if (readOnly) {
+        for (int tries = 0; ; tries++) {
+            Promise promise(GET_TIMEOUT);
+            bclient[i]->Get(key, Timestamp(snapshot), &promise);
+            value = promise.GetValue();
+            int status = promise.GetReply();
+            if (status != REPLY_RETRY || tries == SNAPSHOT_RETRIES) {
+                return status;
+            }
+            usleep(SNAPSHOT_RETRY_WAIT);
+        }
+    }
+
+    if (aborted) {
+        return REPLY_ABORTED;
+    }
+
     // If needed, add this shard to set of participants and send BEGIN.
     if (participants.find(i) == participants.end()) {
         participants.insert(i);
@@ -132,13 +191,23 @@ Client::Get(const string &key, string &value)
     bclient[i]->Get(key, &promise);
     value = promise.GetValue();
 
-    return promise.GetReply();
+    int status = promise.GetReply();
+    if (status == REPLY_ABORTED) {
+        Debug("GET [%s] aborted the transaction", key.c_str());
+        aborted = true;
+    }
+    return status;
 }
 
 /* Sets the value corresponding to the supplied key. */
 int
 Client::Put(const string &key, const string &value)
 {
+    if (readOnly) {
+        Warning("PUT in a read-only transaction: %s", key.c_str());
+        return REPLY_FAIL;
+    }
+
     // Contact the appropriate shard to set the value.
     int i = key_to_shard(key, nshards);
 
@@ -211,6 +280,17 @@ Client::Prepare(uint64_t &ts)
 bool
 Client::Commit()
 {
+    // A snapshot read has nothing to commit.
+    if (readOnly) {
+        return true;
+    }
+
+    // Its reads are no longer locked, so it cannot prepare.
+    if (aborted) {
+        Abort();
+        return false;
+    }
+
     // Implementing 2 Phase Commit
     uint64_t ts = 0;
     int status;
@@ -56,6 +56,7 @@ public:
 
     // Overriding functions from ::Client
     void Begin();
+    void BeginReadOnly();
     int Get(const string &key, string &value);
     int Put(const string &key, const string &value);
     bool Commit();
@@ -77,6 +78,24 @@ private:
 
     // Ongoing transaction ID.
     uint64_t t_id;
+    static const int TXNID_CLIENT_BITS = 20;
+    // The start times in transaction ids count units of 64 microseconds
+    // since the start of 2025, which fill the 44 bits left over in about
+    // 35 years.
+    static const uint64_t TXNID_EPOCH_SEC = 1735689600;
+    static const int TXNID_TIME_UNIT_US = 64;
+
+    // Whether a shard aborted the ongoing transaction, letting go of its
+    // locks, so that it can no longer commit.
+    bool aborted;
+
+    // Whether the ongoing transaction reads a snapshot, and its timestamp.
+    bool readOnly;
+    uint64_t snapshot;
+    // How often, and how many microseconds apart, to retry a snapshot
+    // read held up by a prepared transaction.
+    static const int SNAPSHOT_RETRIES = 100;
+    static const int SNAPSHOT_RETRY_WAIT = 500;
 
     // Number of shards in SpanStore.
     long nshards;
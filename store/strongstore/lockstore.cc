@@ -36,34 +36,63 @@ using namespace std;
 
 namespace strongstore {
 
-LockStore::LockStore() : TxnStore(), store() { }
+LockStore::LockStore(bool snapshots)
+    : TxnStore(), store(), snapshots(snapshots) { }
 LockStore::~LockStore() { }
 
 int
 LockStore::Get(uint64_t id, const string &key, pair<Timestamp, string> &value)
 {
     Debug("[%lu] GET %s", id, key.c_str());
-    string val;
+    // Keep the version read, so that reading it again at its timestamp
+    // finds it.
+    pair<Timestamp, string> latest;
 
-    if (!store.get(key, val)) {
+    if (snapshots) {
+        if (!versions.get(key, latest)) {
+            return REPLY_FAIL;
+        }
+    } else if (!store.get(key, latest.second)) {
         // couldn't find the key
         return REPLY_FAIL;
     }
 
     // grab the lock (ok, if we already have it)
-    if (locks.lockForRead(key, id)) {
-        value = make_pair(Timestamp(), val);
-        return REPLY_OK;
+    int status = locks.lockForRead(key, id);
+    if (status == REPLY_OK) {
+        value = latest;
+    } else if (status == REPLY_FAIL) {
+        // Younger than a conflicting transaction: it has to abort, so
+        // let the locks it has go now. REPLY_FAIL would read as a
+        // missing key.
+        Debug("[%lu] Could not acquire read lock; aborting", id);
+        locks.releaseAll(id);
+        status = REPLY_ABORTED;
     } else {
         Debug("[%lu] Could not acquire read lock", id);
-        return REPLY_RETRY;
     }
+    return status;
 }
 
 int
 LockStore::Get(uint64_t id, const string &key, const Timestamp &timestamp, pair<Timestamp, string> &value)
 {
-    return Get(id, key, value);
+    if (!snapshots) {
+        return Get(id, key, value);
+    }
+
+    // Read from the snapshot, without locking; the server makes sure no
+    // transaction still to prepare can commit before timestamp.
+    Debug("[%lu] GET %s at %lu", id, key.c_str(), timestamp.getTimestamp());
+    if (preparedWrites.find(key) != preparedWrites.end()) {
+        Debug("[%lu] Waiting for prepared write to %s", id, key.c_str());
+        return REPLY_RETRY;
+    }
+    if (versions.get(key, timestamp, value)) {
+        return REPLY_OK;
+    } else {
+        return REPLY_FAIL;
+    }
 }
 
 int
@@ -80,14 +109,22 @@ LockStore::Prepare(uint64_t id, const Transaction &txn)
         return REPLY_OK;
     }
 
-    if (getLocks(id, txn)) {
+    int status = getLocks(id, txn);
+    if (status == REPLY_OK) {
         prepared[id] = txn;
+        if (snapshots) {
+            for (auto &write : txn.getWriteSet()) {
+                preparedWrites[write.first]++;
+            }
+        }
         Debug("[%lu] PREPARED TO COMMIT", id);
-        return REPLY_OK;
+    } else if (status == REPLY_FAIL) {
+        Debug("[%lu] Could not acquire locks; aborting", id);
+        locks.releaseAll(id);
     } else {
-        Debug("[%lu] Could not acquire write locks", id);
-        return REPLY_RETRY;
+        Debug("[%lu] Could not acquire locks", id);
     }
+    return status;
 }
 
 void
@@ -99,11 +136,16 @@ LockStore::Commit(uint64_t id, uint64_t timestamp)
     Transaction txn = prepared[id];
 
     for (auto &write : txn.getWriteSet()) {
-        store.put(write.first, write.second);
+        if (snapshots) {
+            versions.put(write.first, write.second, Timestamp(timestamp));
+        } else {
+            store.put(write.first, write.second);
+        }
     }
+    dropPrepared(txn);
 
     // Drop locks.
-    dropLocks(id, txn);
+    locks.releaseAll(id);
 
     prepared.erase(id);
 }
@@ -112,42 +154,114 @@ void
 LockStore::Abort(uint64_t id, const Transaction &txn)
 {
     Debug("[%lu] ABORT", id);
-    dropLocks(id, txn);
-    prepared.erase(id);
+    // Clients abort with an empty transaction, so the lock table has to
+    // know what the transaction holds.
+    locks.releaseAll(id);
+
+    auto it = prepared.find(id);
+    if (it != prepared.end()) {
+        dropPrepared(it->second);
+        prepared.erase(it);
+    }
 }
 
 void
 LockStore::Load(const string &key, const string &value, const Timestamp &timestamp)
 {
-    store.put(key, value);
+    if (snapshots) {
+        versions.put(key, value, timestamp);
+    } else {
+        store.put(key, value);
+    }
 }
 
-/* Used on commit and abort for second phase of 2PL. */
 void
-LockStore::dropLocks(uint64_t id, const Transaction &txn)
+LockStore::Reserve(size_t nKeys)
 {
-    for (auto &write : txn.getWriteSet()) {
-        locks.releaseForWrite(write.first, id);
+    if (snapshots) {
+        versions.reserve(nKeys);
+    } else {
+        store.reserve(nKeys);
     }
+}
 
-    for (auto &read : txn.getReadSet()) {
-        locks.releaseForRead(read.first, id);
+void
+LockStore::Save(SnapshotWriter &out) const
+{
+    if (snapshots) {
+        versions.save(out);
+    } else {
+        store.save(out);
     }
+    savePrepared(out, prepared);
 }
 
+/* The lock table is rebuilt from the prepared transactions, which hold
+ * their locks until they finish. Read locks of transactions that have
+ * not prepared exist only at the leader that served their reads, as
+ * reads are not replicated, and a new leader would not have them
+ * either. */
 bool
+LockStore::Restore(SnapshotReader &in)
+{
+    locks.clear();
+    preparedWrites.clear();
+    bool ok = snapshots ? versions.restore(in) : store.restore(in);
+    if (!ok || !restorePrepared(in, prepared)) {
+        return false;
+    }
+    for (auto &p : prepared) {
+        // Prepared transactions got their locks together, so none of
+        // them waits for another.
+        if (getLocks(p.first, p.second) != REPLY_OK) {
+            return false;
+        }
+        if (snapshots) {
+            for (auto &write : p.second.getWriteSet()) {
+                preparedWrites[write.first]++;
+            }
+        }
+    }
+    return true;
+}
+
+/* Forget the prepared writes of a transaction that has finished. */
+void
+LockStore::dropPrepared(const Transaction &txn)
+{
+    if (!snapshots) {
+        return;
+    }
+    for (auto &write : txn.getWriteSet()) {
+        auto p = preparedWrites.find(write.first);
+        ASSERT(p != preparedWrites.end());
+        if (--p->second == 0) {
+            preparedWrites.erase(p);
+        }
+    }
+}
+
+/* Lock the read and write sets: REPLY_OK once all are held, REPLY_FAIL
+ * if the transaction must die for one, else REPLY_RETRY. */
+int
 LockStore::getLocks(uint64_t id, const Transaction &txn)
 {
-    bool ret = true;
+    int ret = REPLY_OK;
     // if we don't have read locks, get read locks
     for (auto &read : txn.getReadSet()) {
-        if (!locks.lockForRead(read.first, id)) {
-            ret = false;
+        int status = locks.lockForRead(read.first, id);
+        if (status == REPLY_FAIL) {
+            return status;
+        } else if (status != REPLY_OK) {
+            ret = status;
         }
     }
     for (auto &write : txn.getWriteSet()) {
-        if (!locks.lockForWrite(write.first, id)) {
-            ret = false;
+        int status = locks.lockForWrite(write.first, id);
+        if (status == REPLY_FAIL) {
+            return status;
+        } else if (status != REPLY_OK) {
+            ret = status;
         }
     }
     return ret;
@@ -40,15 +40,19 @@
 #include "store/common/backend/kvstore.h"
 #include "store/common/backend/txnstore.h"
 #include "store/common/backend/lockserver.h"
+#include "store/common/backend/versionstore.h"
 
 #include <map>
+#include <unordered_map>
 
 namespace strongstore {
 
 class LockStore : public TxnStore
 {
 public:
-    LockStore();
+    // With snapshots, the store keeps every committed version, and reads
+    // at a timestamp come from a snapshot without locking anything.
+    LockStore(bool snapshots = false);
     ~LockStore();
 
     // Overriding from TxnStore.
@@ -61,18 +65,29 @@ public:
     void Abort(uint64_t id, const Transaction &txn);
     void Load(const std::string &key, const std::string &value,
         const Timestamp &timestamp);
+    void Reserve(size_t nKeys);
+    void Save(SnapshotWriter &out) const;
+    bool Restore(SnapshotReader &in);
 
 private:
     // Data store.
     KVStore store;
 
+    // Data store with versions, instead of store, for snapshot reads.
+    bool snapshots;
+    VersionedKVStore versions;
+    // The number of prepared transactions writing each key: a snapshot
+    // read of such a key waits, since it might commit before the
+    // snapshot. Keys with none have no entry.
+    std::unordered_map<std::string, int> preparedWrites;
+
     // Locks manager.
     LockServer locks;
 
     std::map<uint64_t, Transaction> prepared;
 
-    void dropLocks(uint64_t id, const Transaction &txn);
-    bool getLocks(uint64_t id, const Transaction &txn);
+    int getLocks(uint64_t id, const Transaction &txn);
+    void dropPrepared(const Transaction &txn);
 };
 
 } // namespace strongstore
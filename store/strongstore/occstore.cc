@@ -76,10 +76,6 @@ OCCStore::Prepare(uint64_t id, const Transaction &txn)
         return REPLY_OK;
     }
 
-    // Do OCC checks.
-    set<string> pWrites = getPreparedWrites();
-    set<string> pRW = getPreparedReadWrites();
-
     // Check for conflicts with the read set.
     for (auto &read : txn.getReadSet()) {
         pair<Timestamp, string> cur;
@@ -100,7 +96,8 @@ OCCStore::Prepare(uint64_t id, const Transaction &txn)
         }
 
         // If there is a pending write for this key, abort.
-        if (pWrites.find(read.first) != pWrites.end()) {
+        auto p = preparedKeys.find(read.first);
+        if (p != preparedKeys.end() && p->second.writes > 0) {
             Debug("[%lu] ABORT rw conflict w/ prepared key:%s",
                   id, read.first.c_str());
             Abort(id);
@@ -111,7 +108,8 @@ OCCStore::Prepare(uint64_t id, const Transaction &txn)
     // Check for conflicts with the write set.
     for (auto &write : txn.getWriteSet()) {
         // If there is a pending read or write for this key, abort.
-        if (pRW.find(write.first) != pRW.end()) {
+        // Keys have an entry only while some prepared txn uses them.
+        if (preparedKeys.find(write.first) != preparedKeys.end()) {
             Debug("[%lu] ABORT ww conflict w/ prepared key:%s", id,
                     write.first.c_str());
             Abort(id);
@@ -120,7 +118,7 @@ OCCStore::Prepare(uint64_t id, const Transaction &txn)
     }
 
     // Otherwise, prepare this transaction for commit
-    prepared[id] = txn;
+    addPrepared(prepared[id] = txn);
     Debug("[%lu] PREPARED TO COMMIT", id);
     return REPLY_OK;
 }
@@ -129,9 +127,10 @@ void
 OCCStore::Commit(uint64_t id, uint64_t timestamp)
 {
     Debug("[%lu] COMMIT", id);
-    ASSERT(prepared.find(id) != prepared.end());
+    auto it = prepared.find(id);
+    ASSERT(it != prepared.end());
 
-    Transaction txn = prepared[id];
+    const Transaction &txn = it->second;
 
     for (auto &write : txn.getWriteSet()) {
         store.put(write.first, // key
@@ -139,14 +138,20 @@ OCCStore::Commit(uint64_t id, uint64_t timestamp)
                     Timestamp(timestamp)); // timestamp
     }
 
-    prepared.erase(id);
+    removePrepared(txn);
+    prepared.erase(it);
 }
 
 void
 OCCStore::Abort(uint64_t id, const Transaction &txn)
 {
     Debug("[%lu] ABORT", id);
-    prepared.erase(id);
+
+    auto it = prepared.find(id);
+    if (it != prepared.end()) {
+        removePrepared(it->second);
+        prepared.erase(it);
+    }
 }
 
 void
@@ -155,33 +160,60 @@ OCCStore::Load(const string &key, const string &value, const Timestamp &timestam
     store.put(key, value, timestamp);
 }
 
-set<string>
-OCCStore::getPreparedWrites()
+void
+OCCStore::Reserve(size_t nKeys)
 {
-    // gather up the set of all writes that we are currently prepared for
-    set<string> writes;
-    for (auto &t : prepared) {
-        for (auto &write : t.second.getWriteSet()) {
-            writes.insert(write.first);
-        }
+    store.reserve(nKeys);
+}
+
+void
+OCCStore::Save(SnapshotWriter &out) const
+{
+    store.save(out);
+    savePrepared(out, prepared);
+}
+
+bool
+OCCStore::Restore(SnapshotReader &in)
+{
+    preparedKeys.clear();
+    if (!store.restore(in) || !restorePrepared(in, prepared)) {
+        return false;
+    }
+    for (auto &p : prepared) {
+        addPrepared(p.second);
     }
-    return writes;
+    return true;
 }
 
-set<string>
-OCCStore::getPreparedReadWrites()
+void
+OCCStore::addPrepared(const Transaction &txn)
+{
+    for (auto &read : txn.getReadSet()) {
+        preparedKeys[read.first].reads++;
+    }
+    for (auto &write : txn.getWriteSet()) {
+        preparedKeys[write.first].writes++;
+    }
+}
+
+void
+OCCStore::removePrepared(const Transaction &txn)
 {
-    // gather up the set of all writes that we are currently prepared for
-    set<string> readwrites;
-    for (auto &t : prepared) {
-        for (auto &write : t.second.getWriteSet()) {
-            readwrites.insert(write.first);
+    for (auto &read : txn.getReadSet()) {
+        auto p = preparedKeys.find(read.first);
+        ASSERT(p != preparedKeys.end() && p->second.reads > 0);
+        if (--p->second.reads == 0 && p->second.writes == 0) {
+            preparedKeys.erase(p);
         }
-        for (auto &read : t.second.getReadSet()) {
-            readwrites.insert(read.first);
+    }
+    for (auto &write : txn.getWriteSet()) {
+        auto p = preparedKeys.find(write.first);
+        ASSERT(p != preparedKeys.end() && p->second.writes > 0);
+        if (--p->second.writes == 0 && p->second.reads == 0) {
+            preparedKeys.erase(p);
         }
     }
-    return readwrites;
 }
 
 } // namespace strongstore
@@ -40,6 +40,8 @@
 #include "store/common/transaction.h"
 
 #include <map>
+#include <string>
+#include <unordered_map>
 
 namespace strongstore {
 
@@ -56,6 +58,9 @@ public:
     void Commit(uint64_t id, uint64_t timestamp);
     void Abort(uint64_t id, const Transaction &txn = Transaction());
     void Load(const std::string &key, const std::string &value, const Timestamp &timestamp);
+    void Reserve(size_t nKeys);
+    void Save(SnapshotWriter &out) const;
+    bool Restore(SnapshotReader &in);
 
 private:
     // Data store.
@@ -63,8 +68,17 @@ private:
 
     std::map<uint64_t, Transaction> prepared;
 
-    std::set<std::string> getPreparedWrites();
-    std::set<std::string> getPreparedReadWrites();
+    // How many prepared transactions read and write each key, so that
+    // validation looks up only the keys of the transaction it checks.
+    // Keys no prepared transaction touches have no entry.
+    struct PreparedCount {
+        int reads;
+        int writes;
+    };
+    std::unordered_map<std::string, PreparedCount> preparedKeys;
+
+    void addPrepared(const Transaction &txn);
+    void removePrepared(const Transaction &txn);
 };
 
 } // namespace strongstore
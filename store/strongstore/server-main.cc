@@ -0,0 +1,256 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/strongstore/server-main.cc:
+ *   Command-line driver for the strongly consistent transactional server.
+ *
+ * Copyright 2015 Irene Zhang <iyzhang@cs.washington.edu>
+ *                Naveen Kr. Sharma <naveenks@cs.washington.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************/
+
+#include "store/strongstore/server.h"
+#include "store/common/keyset.h"
+
+#include <strings.h>
+#include <unistd.h>
+
+#include <fstream>
+
+using namespace std;
+
+int
+main(int argc, char **argv)
+{
+    int index = -1;
+    unsigned int myShard=0, maxShard=1, nKeys=1;
+    unsigned int batchSize = 16;
+    long checkpointInterval = -1;
+    replication::LogHashMode logHash = replication::LOG_HASH_NONE;
+    const char *configPath = NULL;
+    const char *keyPath = NULL;
+    int64_t skew = 0, error = 0;
+    strongstore::Mode mode;
+
+    // Parse arguments
+    int opt;
+    while ((opt = getopt(argc, argv, "c:i:m:e:s:f:n:N:k:b:C:H:")) != -1) {
+        switch (opt) {
+        case 'c':
+            configPath = optarg;
+            break;
+            
+        case 'i':
+        {
+            char *strtolPtr;
+            index = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (index < 0))
+            {
+                fprintf(stderr, "option -i requires a numeric arg\n");
+            }
+            break;
+        }
+        
+        case 'm':
+        {
+            if (strcasecmp(optarg, "lock") == 0) {
+                mode = strongstore::MODE_LOCK;
+            } else if (strcasecmp(optarg, "occ") == 0) {
+                mode = strongstore::MODE_OCC;
+            } else if (strcasecmp(optarg, "span-lock") == 0) {
+                mode = strongstore::MODE_SPAN_LOCK;
+            } else if (strcasecmp(optarg, "span-occ") == 0) {
+                mode = strongstore::MODE_SPAN_OCC;
+            } else {
+                fprintf(stderr, "unknown mode '%s'\n", optarg);
+            }
+            break;
+        }
+
+        case 's':
+        {
+            char *strtolPtr;
+            skew = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (skew < 0))
+            {
+                fprintf(stderr, "option -s requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'e':
+        {
+            char *strtolPtr;
+            error = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (error < 0))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'k':
+        {
+            char *strtolPtr;
+            nKeys = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'n':
+        {
+            char *strtolPtr;
+            myShard = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'N':
+        {
+            char *strtolPtr;
+            maxShard = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (maxShard <= 0))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'b':   // Most requests the VR leader prepares at once
+        {
+            char *strtolPtr;
+            batchSize = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (batchSize == 0))
+            {
+                fprintf(stderr, "option -b requires a positive arg\n");
+            }
+            break;
+        }
+
+        case 'C':   // Operations between VR checkpoints; 0 disables them
+        {
+            char *strtolPtr;
+            checkpointInterval = strtol(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') ||
+                (checkpointInterval < 0))
+            {
+                fprintf(stderr, "option -C requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'H':   // How the VR log chains entry hashes
+        {
+            if (strcasecmp(optarg, "none") == 0) {
+                logHash = replication::LOG_HASH_NONE;
+            } else if (strcasecmp(optarg, "sha1") == 0) {
+                logHash = replication::LOG_HASH_SHA1;
+            } else if (strcasecmp(optarg, "fast") == 0) {
+                logHash = replication::LOG_HASH_FAST;
+            } else {
+                fprintf(stderr, "unknown log hash '%s'\n", optarg);
+            }
+            break;
+        }
+
+        case 'f':   // Load keys from file
+        {
+            keyPath = optarg;
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+        }
+
+
+    }
+
+    if (!configPath) {
+        fprintf(stderr, "option -c is required\n");
+    }
+
+    if (index == -1) {
+        fprintf(stderr, "option -i is required\n");
+    }
+
+    if (mode == strongstore::MODE_UNKNOWN) {
+        fprintf(stderr, "option -m is required\n");
+    }
+
+    // Load configuration
+    std::ifstream configStream(configPath);
+    if (configStream.fail()) {
+        fprintf(stderr, "unable to read configuration file: %s\n", configPath);
+    }
+    transport::Configuration config(configStream);
+
+    if (index >= config.n) {
+        fprintf(stderr, "replica index %d is out of bounds; "
+                "only %d replicas defined\n", index, config.n);
+    }
+
+    // A checkpoint serializes the whole shard on the event loop, so
+    // unless told otherwise, space checkpoints out by at least as many
+    // operations as the shard holds keys to keep their cost per
+    // operation bounded.
+    if (checkpointInterval < 0) {
+        checkpointInterval =
+            replication::vr::VRReplica::DEFAULT_CHECKPOINT_INTERVAL;
+        if (keyPath && nKeys / maxShard > (unsigned long)checkpointInterval) {
+            checkpointInterval = nKeys / maxShard;
+        }
+    }
+
+    UDPTransport transport(0.0, 0.0, 0);
+
+    strongstore::Server server(mode, skew, error);
+    replication::vr::VRReplica replica(
+        config, index, &transport, batchSize, &server,
+        replication::vr::VRReplica::DEFAULT_PIPELINE_WINDOW,
+        checkpointInterval, logHash);
+    
+    if (keyPath) {
+        KeySet keys;
+        if (!keys.Open(keyPath)) {
+            fprintf(stderr, "Could not read keys from: %s\n", keyPath);
+            exit(0);
+        }
+
+        keys.Load(nKeys, maxShard, myShard, 1,
+            [&](uint64_t shard, size_t n) { server.Reserve(n); },
+            [&](uint64_t shard, const string &key) {
+                server.Load(key, "null", Timestamp());
+            });
+    }
+
+    transport.Run();
+
+    return 0;
+}
@@ -31,20 +31,29 @@
 
 #include "store/strongstore/server.h"
 
+#include <cstdio>
+#include <cstdlib>
+
 namespace strongstore {
 
 using namespace std;
 using namespace proto;
 
-Server::Server(Mode mode, uint64_t skew, uint64_t error) : mode(mode)
+static const char SNAPSHOT_MAGIC[] = "strongstore snapshot 1";
+
+Server::Server(Mode mode, uint64_t skew, uint64_t error)
+    : mode(mode), lastPrepareTime(0), appliedPrepareTime(0)
 {
     timeServer = TrueTime(skew, error);
 
     switch (mode) {
     case MODE_LOCK:
-    case MODE_SPAN_LOCK:
         store = new strongstore::LockStore();
         break;
+    case MODE_SPAN_LOCK:
+        // Read-only transactions read snapshots, Spanner-style.
+        store = new strongstore::LockStore(true);
+        break;
     case MODE_OCC:
     case MODE_SPAN_OCC:
         store = new strongstore::OCCStore();
@@ -72,24 +81,8 @@ Server::LeaderUpcall(opnum_t opnum, const string &str1, bool &replicate, string
 
     switch (request.op()) {
     case strongstore::proto::Request::GET:
-        if (request.get().has_timestamp()) {
-            pair<Timestamp, string> val;
-            status = store->Get(request.txnid(), request.get().key(),
-                               request.get().timestamp(), val);
-            if (status == 0) {
-                reply.set_value(val.second);
-            }
-        } else {
-            pair<Timestamp, string> val;
-            status = store->Get(request.txnid(), request.get().key(), val);
-            if (status == 0) {
-                reply.set_value(val.second);
-                reply.set_timestamp(val.first.getTimestamp());
-            }
-        }
+        Get(str1, str2, true);
         replicate = false;
-        reply.set_status(status);
-        reply.SerializeToString(&str2);
         break;
     case strongstore::proto::Request::PREPARE:
         // Prepare is the only case that is conditionally run at the leader
@@ -99,9 +92,12 @@ Server::LeaderUpcall(opnum_t opnum, const string &str1, bool &replicate, string
         // if prepared, then replicate result
         if (status == 0) {
             replicate = true;
-            // get a prepare timestamp and send along to replicas
+            // get a prepare timestamp and send along to replicas; it
+            // must be later than any before it, even across leaders
             if (mode == MODE_SPAN_LOCK || mode == MODE_SPAN_OCC) {
-                request.mutable_prepare()->set_timestamp(timeServer.GetTime());
+                lastPrepareTime = max(timeServer.GetTime(),
+                                      lastPrepareTime + 1);
+                request.mutable_prepare()->set_timestamp(lastPrepareTime);
             }
             request.SerializeToString(&str2);
         } else {
@@ -150,7 +146,10 @@ Server::ReplicaUpcall(opnum_t opnum,
         store->Prepare(request.txnid(),
                        Transaction(request.prepare().txn()));
         if (mode == MODE_SPAN_LOCK || mode == MODE_SPAN_OCC) {
-            reply.set_timestamp(request.prepare().timestamp());
+            uint64_t ts = request.prepare().timestamp();
+            reply.set_timestamp(ts);
+            lastPrepareTime = max(lastPrepareTime, ts);
+            appliedPrepareTime = max(appliedPrepareTime, ts);
         }
         break;
     case strongstore::proto::Request::COMMIT:
@@ -168,6 +167,18 @@ Server::ReplicaUpcall(opnum_t opnum,
 
 void
 Server::UnloggedUpcall(const string &str1, string &str2)
+{
+    Get(str1, str2, false);
+}
+
+void
+Server::LeaderUnloggedUpcall(const string &str1, string &str2)
+{
+    Get(str1, str2, true);
+}
+
+void
+Server::Get(const string &str1, string &str2, bool atLeader)
 {
     Request request;
     Reply reply;
@@ -179,8 +190,8 @@ Server::UnloggedUpcall(const string &str1, string &str2)
 
     if (request.get().has_timestamp()) {
         pair<Timestamp, string> val;
-        status = store->Get(request.txnid(), request.get().key(),
-                            request.get().timestamp(), val);
+        status = GetAt(request.txnid(), request.get().key(),
+                       request.get().timestamp(), val, atLeader);
         if (status == 0) {
             reply.set_value(val.second);
         }
@@ -197,182 +208,84 @@ Server::UnloggedUpcall(const string &str1, string &str2)
     reply.SerializeToString(&str2);
 }
 
-void
-Server::Load(const string &key, const string &value, const Timestamp timestamp)
-{
-    store->Load(key, value, timestamp);
-}
-
-} // namespace strongstore
-
+/* Read key at a timestamp. In span-lock mode, that is a snapshot read,
+ * which has to wait until no transaction can still prepare, and so
+ * commit, before the snapshot. The leader knows this once its clock has
+ * passed the snapshot, as it stamps prepares with its clock. Another
+ * replica also has to have executed a prepare stamped after it, since
+ * any before that it has not executed yet could still commit earlier. */
 int
-main(int argc, char **argv)
+Server::GetAt(uint64_t id, const string &key, const Timestamp &timestamp,
+              pair<Timestamp, string> &value, bool atLeader)
 {
-    int index = -1;
-    unsigned int myShard=0, maxShard=1, nKeys=1;
-    const char *configPath = NULL;
-    const char *keyPath = NULL;
-    int64_t skew = 0, error = 0;
-    strongstore::Mode mode;
-
-    // Parse arguments
-    int opt;
-    while ((opt = getopt(argc, argv, "c:i:m:e:s:f:n:N:k:")) != -1) {
-        switch (opt) {
-        case 'c':
-            configPath = optarg;
-            break;
-            
-        case 'i':
-        {
-            char *strtolPtr;
-            index = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0') || (index < 0))
-            {
-                fprintf(stderr, "option -i requires a numeric arg\n");
-            }
-            break;
-        }
-        
-        case 'm':
-        {
-            if (strcasecmp(optarg, "lock") == 0) {
-                mode = strongstore::MODE_LOCK;
-            } else if (strcasecmp(optarg, "occ") == 0) {
-                mode = strongstore::MODE_OCC;
-            } else if (strcasecmp(optarg, "span-lock") == 0) {
-                mode = strongstore::MODE_SPAN_LOCK;
-            } else if (strcasecmp(optarg, "span-occ") == 0) {
-                mode = strongstore::MODE_SPAN_OCC;
-            } else {
-                fprintf(stderr, "unknown mode '%s'\n", optarg);
-            }
-            break;
-        }
-
-        case 's':
-        {
-            char *strtolPtr;
-            skew = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0') || (skew < 0))
-            {
-                fprintf(stderr, "option -s requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'e':
-        {
-            char *strtolPtr;
-            error = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0') || (error < 0))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
+    if (mode == MODE_SPAN_LOCK) {
+        uint64_t ts = timestamp.getTimestamp();
+        if (ts >= timeServer.GetTime() ||
+            (!atLeader && ts >= appliedPrepareTime)) {
+            return REPLY_RETRY;
         }
-
-        case 'k':
-        {
-            char *strtolPtr;
-            nKeys = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0'))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'n':
-        {
-            char *strtolPtr;
-            myShard = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0'))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'N':
-        {
-            char *strtolPtr;
-            maxShard = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0') || (maxShard <= 0))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'f':   // Load keys from file
-        {
-            keyPath = optarg;
-            break;
-        }
-
-        default:
-            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
-        }
-
-
-    }
-
-    if (!configPath) {
-        fprintf(stderr, "option -c is required\n");
     }
+    return store->Get(id, key, timestamp, value);
+}
 
-    if (index == -1) {
-        fprintf(stderr, "option -i is required\n");
+/* The state is the store, with its prepared transactions and the locks
+ * they hold, and the prepare timestamps. It is only ever restored into
+ * a server of the same mode. */
+bool
+Server::SnapshotUpcall(string &state)
+{
+    char *buf;
+    size_t size;
+    FILE *f = open_memstream(&buf, &size);
+    if (f == NULL) {
+        return false;
     }
-
-    if (mode == strongstore::MODE_UNKNOWN) {
-        fprintf(stderr, "option -m is required\n");
+    SnapshotWriter out(f);
+    out.String(SNAPSHOT_MAGIC);
+    out.U64(mode);
+    out.U64(lastPrepareTime);
+    out.U64(appliedPrepareTime);
+    store->Save(out);
+    bool ok = out.Ok();
+    ok = fclose(f) == 0 && ok;
+    if (ok) {
+        state.assign(buf, size);
     }
+    free(buf);
+    return ok;
+}
 
-    // Load configuration
-    std::ifstream configStream(configPath);
-    if (configStream.fail()) {
-        fprintf(stderr, "unable to read configuration file: %s\n", configPath);
+void
+Server::RestoreUpcall(const string &state)
+{
+    FILE *f = fmemopen((void *)state.data(), state.size(), "rb");
+    if (f == NULL) {
+        Panic("Could not read snapshot of %zu bytes", state.size());
     }
-    transport::Configuration config(configStream);
-
-    if (index >= config.n) {
-        fprintf(stderr, "replica index %d is out of bounds; "
-                "only %d replicas defined\n", index, config.n);
-    }
-
-    UDPTransport transport(0.0, 0.0, 0);
-
-    strongstore::Server server(mode, skew, error);
-    replication::vr::VRReplica replica(config, index, &transport, 1, &server);
-    
-    if (keyPath) {
-        string key;
-        std::ifstream in;
-        in.open(keyPath);
-        if (!in) {
-            fprintf(stderr, "Could not read keys from: %s\n", keyPath);
-            exit(0);
-        }
-
-        for (unsigned int i = 0; i < nKeys; i++) {
-            getline(in, key);
-            
-            uint64_t hash = 5381;
-            const char* str = key.c_str();
-            for (unsigned int j = 0; j < key.length(); j++) {
-                hash = ((hash << 5) + hash) + (uint64_t)str[j];
-            }
-
-            if (hash % maxShard == myShard) {
-                server.Load(key, "null", Timestamp());
-            }
-        }
-        in.close();
+    SnapshotReader in(f);
+
+    string magic;
+    uint64_t savedMode;
+    bool ok = in.String(magic) && magic == SNAPSHOT_MAGIC &&
+        in.U64(savedMode) && savedMode == (uint64_t)mode &&
+        in.U64(lastPrepareTime) && in.U64(appliedPrepareTime) &&
+        store->Restore(in);
+    fclose(f);
+    if (!ok) {
+        Panic("Snapshot is corrupt or from another mode");
     }
+}
 
-    transport.Run();
+void
+Server::Load(const string &key, const string &value, const Timestamp timestamp)
+{
+    store->Load(key, value, timestamp);
+}
 
-    return 0;
+void
+Server::Reserve(size_t nKeys)
+{
+    store->Reserve(nKeys);
 }
+
+} // namespace strongstore
@@ -58,12 +58,26 @@ public:
     virtual void LeaderUpcall(opnum_t opnum, const string &str1, bool &replicate, string &str2);
     virtual void ReplicaUpcall(opnum_t opnum, const string &str1, string &str2);
     virtual void UnloggedUpcall(const string &str1, string &str2);
+    virtual void LeaderUnloggedUpcall(const string &str1, string &str2);
+    virtual bool SnapshotUpcall(string &state);
+    virtual void RestoreUpcall(const string &state);
     void Load(const string &key, const string &value, const Timestamp timestamp);
+    void Reserve(size_t nKeys);
 
 private:
+    void Get(const string &str1, string &str2, bool atLeader);
+    int GetAt(uint64_t id, const string &key, const Timestamp &timestamp,
+              std::pair<Timestamp, std::string> &value, bool atLeader);
+
     Mode mode;
     TxnStore *store;
     TrueTime timeServer;
+    // Latest prepare timestamp assigned or seen, which the next one
+    // assigned here as leader must exceed.
+    uint64_t lastPrepareTime;
+    // Latest prepare timestamp executed here: no transaction prepared
+    // from now on can commit before it.
+    uint64_t appliedPrepareTime;
 };
 
 } // namespace strongstore
@@ -39,7 +39,7 @@ using namespace proto;
 ShardClient::ShardClient(Mode mode, const string &configPath,
                        Transport *transport, uint64_t client_id, int
                        shard, int closestReplica)
-    : transport(transport), client_id(client_id), shard(shard)
+    : mode(mode), transport(transport), client_id(client_id), shard(shard)
 { 
     ifstream configStream(configPath);
     if (configStream.fail()) {
@@ -50,16 +50,14 @@ ShardClient::ShardClient(Mode mode, const string &configPath,
 
     client = new replication::vr::VRClient(config, transport);
 
-    if (mode == MODE_OCC || mode == MODE_SPAN_OCC) {
-        if (closestReplica == -1) {
-            replica = client_id % config.n;
-        } else {
-            replica = closestReplica;
-        }
-        Debug("Sending unlogged to replica %i", replica);
+    // Locking reads go to the leader, which holds the locks; the rest
+    // spread over the replicas.
+    if (closestReplica == -1) {
+        replica = client_id % config.n;
     } else {
-        replica = 0;
+        replica = closestReplica;
     }
+    Debug("Sending unlogged to replica %i", replica);
 
     waiting = NULL;
     blockingBegin = NULL;
@@ -104,6 +102,19 @@ ShardClient::Get(uint64_t id, const string &key, Promise *promise)
 
     transport->Timer(0, [=]() {
 	    waiting = promise;    
+        if (mode == MODE_LOCK || mode == MODE_SPAN_LOCK) {
+            // Under the leader's lease, so no other replica can have
+            // become leader and granted a conflicting lock.
+            client->InvokeUnloggedAtLeader(request_str,
+                                           bind(&ShardClient::GetCallback,
+                                                this,
+                                                placeholders::_1,
+                                                placeholders::_2),
+                                           bind(&ShardClient::GetTimeout,
+                                                this),
+                                           timeout); // timeout in ms
+            return;
+        }
         client->InvokeUnlogged(replica,
                                request_str,
                                bind(&ShardClient::GetCallback,
@@ -137,6 +148,19 @@ ShardClient::Get(uint64_t id, const string &key,
 
     transport->Timer(0, [=]() {
 	    waiting = promise;
+            if (mode == MODE_SPAN_LOCK) {
+                client->InvokeUnlogged(replica,
+                                       request_str,
+                                       bind(&ShardClient::SnapshotGetCallback,
+                                            this,
+                                            placeholders::_1,
+                                            placeholders::_2,
+                                            timeout),
+                                       bind(&ShardClient::GetTimeout,
+                                            this),
+                                       timeout); // timeout in ms
+                return;
+            }
             client->InvokeUnlogged(replica,
                                    request_str,
                                    bind(&ShardClient::GetCallback,
@@ -266,6 +290,34 @@ ShardClient::GetCallback(const string &request_str, const string &reply_str)
     }
 }
 
+/* Callback from any replica on a snapshot read. A replica that has not
+ * yet seen a prepare after the snapshot cannot tell whether one before
+ * it is still to come, so it asks for a retry; the leader can tell from
+ * its clock, so ask it instead. */
+void
+ShardClient::SnapshotGetCallback(const string &request_str,
+                                 const string &reply_str, uint32_t timeout)
+{
+    Reply reply;
+    reply.ParseFromString(reply_str);
+
+    if (reply.status() != REPLY_RETRY) {
+        GetCallback(request_str, reply_str);
+        return;
+    }
+
+    Debug("[shard %i] Snapshot GET not yet safe at replica %i; "
+          "asking the leader", shard, replica);
+    client->InvokeUnloggedAtLeader(request_str,
+                                   bind(&ShardClient::GetCallback,
+                                        this,
+                                        placeholders::_1,
+                                        placeholders::_2),
+                                   bind(&ShardClient::GetTimeout,
+                                        this),
+                                   timeout); // timeout in ms
+}
+
 /* Callback from a shard replica on prepare operation completion. */
 void
 ShardClient::PrepareCallback(const string &request_str, const string &reply_str)
@@ -90,10 +90,11 @@ public:
                Promise *promise = NULL);
 
 private:
+    Mode mode; // Concurrency control mode.
     Transport *transport; // Transport layer.
     uint64_t client_id; // Unique ID for this client.
     int shard; // which shard this client accesses
-    int replica; // which replica to use for reads
+    int replica; // which replica to use for reads any replica can serve
 
     replication::vr::VRClient *client; // Client proxy.
     Promise *waiting; // waiting thread
@@ -104,6 +105,8 @@ private:
 
     /* Callbacks for hearing back from a shard for an operation. */
     void GetCallback(const std::string &, const std::string &);
+    void SnapshotGetCallback(const std::string &, const std::string &,
+                             uint32_t timeout);
     void PrepareCallback(const std::string &, const std::string &);
     void CommitCallback(const std::string &, const std::string &);
     void AbortCallback(const std::string &, const std::string &);
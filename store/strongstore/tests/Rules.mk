@@ -0,0 +1,31 @@
+d := $(dir $(lastword $(MAKEFILE_LIST)))
+
+#
+# gtest-based tests
+#
+GTEST_SRCS += $(addprefix $(d), \
+		lockstore-test.cc \
+		occstore-test.cc \
+		server-test.cc)
+
+$(d)lockstore-test: $(o)lockstore-test.o $(LIB-transport) $(LIB-message) \
+	$(LIB-strong-store) $(LIB-store-common) $(LIB-store-backend) $(GTEST_MAIN)
+
+TEST_BINS += $(d)lockstore-test
+
+$(d)occstore-test: $(o)occstore-test.o $(LIB-transport) $(LIB-message) \
+	$(LIB-strong-store) $(LIB-store-common) $(LIB-store-backend) $(GTEST_MAIN)
+
+TEST_BINS += $(d)occstore-test
+
+$(d)server-test: $(o)server-test.o $(OBJS-strong-store) $(OBJS-vr-replica) \
+	$(OBJS-vr-client) $(LIB-simtransport) $(GTEST_MAIN)
+
+TEST_BINS += $(d)server-test
+
+SRCS += $(d)occstore-benchmark.cc
+
+$(d)occstore-benchmark: $(o)occstore-benchmark.o $(LIB-transport) \
+	$(LIB-message) $(LIB-strong-store) $(LIB-store-common) $(LIB-store-backend)
+
+BINS += $(d)occstore-benchmark
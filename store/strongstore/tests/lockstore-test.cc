@@ -0,0 +1,95 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/strongstore/tests/lockstore-test.cc:
+ *   test cases for the 2PL transactional store
+ *
+ **********************************************************************/
+
+#include "store/strongstore/lockstore.h"
+
+#include <gtest/gtest.h>
+
+using namespace strongstore;
+
+static Transaction
+Write(const std::string &key, const std::string &value)
+{
+    Transaction txn;
+    txn.addWriteSet(key, value);
+    return txn;
+}
+
+TEST(LockStore, ReadLocks)
+{
+    LockStore store;
+    store.Load("a", "1", Timestamp());
+
+    // Without snapshots, reads at a timestamp lock like any other.
+    std::pair<Timestamp, std::string> value;
+    ASSERT_EQ(REPLY_OK, store.Get(1, "a", Timestamp(10), value));
+    EXPECT_EQ("1", value.second);
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(2, Write("a", "2")));
+}
+
+TEST(LockStore, WaitDieRead)
+{
+    LockStore store;
+    store.Load("a", "1", Timestamp());
+    store.Load("b", "1", Timestamp());
+
+    ASSERT_EQ(REPLY_OK, store.Prepare(3, Write("a", "2")));
+
+    // An older reader waits for the writer, and a younger one dies, which
+    // reads differently from a missing key.
+    std::pair<Timestamp, std::string> value;
+    EXPECT_EQ(REPLY_RETRY, store.Get(2, "a", value));
+    EXPECT_EQ(REPLY_FAIL, store.Get(4, "missing", value));
+    ASSERT_EQ(REPLY_OK, store.Get(4, "b", value));
+    EXPECT_EQ(REPLY_ABORTED, store.Get(4, "a", value));
+
+    // Dying let go of the read lock on b.
+    EXPECT_EQ(REPLY_OK, store.Prepare(5, Write("b", "2")));
+}
+
+TEST(LockStore, SnapshotRead)
+{
+    LockStore store(true);
+    store.Load("a", "1", Timestamp());
+
+    ASSERT_EQ(REPLY_OK, store.Prepare(2, Write("a", "2")));
+
+    // The prepared write might commit before the snapshot.
+    std::pair<Timestamp, std::string> value;
+    EXPECT_EQ(REPLY_RETRY, store.Get(1, "a", Timestamp(10), value));
+
+    store.Commit(2, 20);
+    ASSERT_EQ(REPLY_OK, store.Get(1, "a", Timestamp(10), value));
+    EXPECT_EQ("1", value.second);
+    ASSERT_EQ(REPLY_OK, store.Get(3, "a", Timestamp(30), value));
+    EXPECT_EQ("2", value.second);
+    EXPECT_EQ(Timestamp(20), value.first);
+
+    // Aborted writes don't hold reads up.
+    ASSERT_EQ(REPLY_OK, store.Prepare(4, Write("a", "3")));
+    store.Abort(4, Transaction());
+    ASSERT_EQ(REPLY_OK, store.Get(5, "a", Timestamp(40), value));
+    EXPECT_EQ("2", value.second);
+}
+
+TEST(LockStore, SnapshotTakesNoLocks)
+{
+    LockStore store(true);
+    store.Load("a", "1", Timestamp());
+
+    std::pair<Timestamp, std::string> value;
+    ASSERT_EQ(REPLY_OK, store.Get(1, "a", Timestamp(10), value));
+    EXPECT_EQ(REPLY_OK, store.Prepare(2, Write("a", "2")));
+
+    // Read-write transactions still lock, and read the latest version.
+    store.Commit(2, 20);
+    ASSERT_EQ(REPLY_OK, store.Get(3, "a", value));
+    EXPECT_EQ("2", value.second);
+    EXPECT_EQ(Timestamp(20), value.first);
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(4, Write("a", "3")));
+}
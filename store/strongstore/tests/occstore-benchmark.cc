@@ -0,0 +1,107 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/strongstore/tests/occstore-benchmark.cc:
+ *   Measures how fast the OCC store validates transactions while many
+ *   others are prepared and waiting to commit.
+ *
+ **********************************************************************/
+
+#include "store/strongstore/occstore.h"
+
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace strongstore;
+
+namespace {
+
+bool
+ParseArg(int opt, const char *arg, uint64_t &value)
+{
+    char *strtolPtr;
+    value = strtoull(arg, &strtolPtr, 10);
+    if ((*arg == '\0') || (*strtolPtr != '\0') || (value == 0)) {
+        fprintf(stderr, "option -%c requires a positive integer\n", opt);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    uint64_t numPrepared = 500;
+    uint64_t numKeys = 1000000;
+    uint64_t txnKeys = 10;
+    uint64_t numTxns = 1000000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:k:t:n:")) != -1) {
+        uint64_t *value;
+        switch (opt) {
+        case 'p': value = &numPrepared; break; // Txns kept prepared.
+        case 'k': value = &numKeys; break;     // Keys in the store.
+        case 't': value = &txnKeys; break;     // Keys read and written per txn.
+        case 'n': value = &numTxns; break;     // Txns to prepare.
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+            return 1;
+        }
+        if (!ParseArg(opt, optarg, *value)) {
+            return 1;
+        }
+    }
+
+    OCCStore store;
+    store.Reserve(numKeys);
+    std::vector<std::string> keys;
+    keys.reserve(numKeys);
+    for (uint64_t i = 0; i < numKeys; i++) {
+        keys.push_back("key" + std::to_string(i));
+        store.Load(keys.back(), "value", Timestamp(1));
+    }
+
+    // Build the transactions up front, each reading and writing txnKeys
+    // random keys, so that only the store is timed.
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<uint64_t> pick(0, numKeys - 1);
+    std::vector<Transaction> txns(numTxns);
+    for (Transaction &txn : txns) {
+        for (uint64_t i = 0; i < txnKeys; i++) {
+            txn.addReadSet(keys[pick(gen)], Timestamp(1));
+            txn.addWriteSet(keys[pick(gen)], "value");
+        }
+    }
+
+    // Each transaction stays prepared until numPrepared more have been
+    // tried, then commits; so once warmed up, every prepare is checked
+    // against numPrepared others (less those that aborted).
+    std::vector<bool> ok(numTxns);
+    uint64_t committed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t id = 0; id < numTxns; id++) {
+        ok[id] = store.Prepare(id + 1, txns[id]) == REPLY_OK;
+        if (id >= numPrepared && ok[id - numPrepared]) {
+            store.Commit(id - numPrepared + 1, 1);
+            committed++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("Prepared %" PRIu64 " txns of %" PRIu64 " keys against %" PRIu64
+           " prepared in %.1f ms (%.1f us/txn, %" PRIu64 " committed)\n",
+           numTxns, 2 * txnKeys, numPrepared, ms, ms * 1e3 / numTxns,
+           committed);
+    return 0;
+}
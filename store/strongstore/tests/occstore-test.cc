@@ -0,0 +1,105 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/strongstore/tests/occstore-test.cc:
+ *   test cases for the OCC transactional store
+ *
+ **********************************************************************/
+
+#include "store/strongstore/occstore.h"
+
+#include <gtest/gtest.h>
+
+using namespace strongstore;
+
+class OCCStoreTest : public ::testing::Test
+{
+protected:
+    OCCStore store;
+
+    virtual void SetUp() {
+        store.Load("a", "1", Timestamp(10));
+        store.Load("b", "2", Timestamp(10));
+    }
+
+    static Transaction Read(const std::string &key) {
+        Transaction txn;
+        txn.addReadSet(key, Timestamp(10));
+        return txn;
+    }
+
+    static Transaction Write(const std::string &key) {
+        Transaction txn;
+        txn.addWriteSet(key, "x");
+        return txn;
+    }
+};
+
+TEST_F(OCCStoreTest, StaleRead)
+{
+    store.Load("a", "3", Timestamp(12));
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(1, Read("a")));
+}
+
+TEST_F(OCCStoreTest, ReadPreparedWrite)
+{
+    ASSERT_EQ(REPLY_OK, store.Prepare(1, Write("a")));
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(2, Read("a")));
+    EXPECT_EQ(REPLY_OK, store.Prepare(3, Read("b")));
+}
+
+TEST_F(OCCStoreTest, WritePreparedReadOrWrite)
+{
+    ASSERT_EQ(REPLY_OK, store.Prepare(1, Read("a")));
+    ASSERT_EQ(REPLY_OK, store.Prepare(2, Write("b")));
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(3, Write("a")));
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(4, Write("b")));
+
+    // Prepared reads don't conflict with each other.
+    EXPECT_EQ(REPLY_OK, store.Prepare(5, Read("a")));
+}
+
+TEST_F(OCCStoreTest, AlreadyPrepared)
+{
+    ASSERT_EQ(REPLY_OK, store.Prepare(1, Write("a")));
+    EXPECT_EQ(REPLY_OK, store.Prepare(1, Write("a")));
+
+    // Preparing twice holds the key once: one abort releases it.
+    store.Abort(1);
+    EXPECT_EQ(REPLY_OK, store.Prepare(2, Write("a")));
+}
+
+TEST_F(OCCStoreTest, CommitReleasesKeys)
+{
+    ASSERT_EQ(REPLY_OK, store.Prepare(1, Read("a")));
+    ASSERT_EQ(REPLY_OK, store.Prepare(2, Read("a")));
+    ASSERT_EQ(REPLY_OK, store.Prepare(3, Write("b")));
+
+    // The key stays held until its last reader finishes.
+    store.Commit(1, 20);
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(4, Write("a")));
+    store.Abort(2);
+    EXPECT_EQ(REPLY_OK, store.Prepare(4, Write("a")));
+
+    store.Commit(3, 20);
+    std::pair<Timestamp, std::string> value;
+    ASSERT_EQ(REPLY_OK, store.Get(5, "b", value));
+    EXPECT_EQ(Timestamp(20), value.first);
+    EXPECT_EQ("x", value.second);
+
+    Transaction txn;
+    txn.addReadSet("b", Timestamp(20));
+    EXPECT_EQ(REPLY_OK, store.Prepare(6, txn));
+}
+
+TEST_F(OCCStoreTest, FailedPrepareHoldsNothing)
+{
+    Transaction txn;
+    txn.addReadSet("a", Timestamp(10));
+    txn.addWriteSet("b", "x");
+    ASSERT_EQ(REPLY_OK, store.Prepare(1, Write("a")));
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(2, txn));
+
+    // Transaction 2 did not hold b.
+    EXPECT_EQ(REPLY_OK, store.Prepare(3, Write("b")));
+}
@@ -0,0 +1,221 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/strongstore/tests/server-test.cc:
+ *   test cases for the strong store server replicated by VR
+ *
+ **********************************************************************/
+
+#include "lib/configuration.h"
+#include "lib/simtransport.h"
+#include "replication/vr/client.h"
+#include "replication/vr/replica.h"
+#include "store/strongstore/server.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using google::protobuf::Message;
+using namespace strongstore;
+using namespace strongstore::proto;
+
+static const int NTXNS = 6;
+
+static std::string
+Key(int i)
+{
+    return "k" + std::to_string(i);
+}
+
+static std::string
+Value(int i)
+{
+    return "v" + std::to_string(i);
+}
+
+static std::string
+PrepareRequest(uint64_t id, const std::string &key, const std::string &value)
+{
+    Transaction txn;
+    txn.addWriteSet(key, value);
+    Request request;
+    request.set_op(Request::PREPARE);
+    request.set_txnid(id);
+    txn.serialize(request.mutable_prepare()->mutable_txn());
+    return request.SerializeAsString();
+}
+
+static std::string
+CommitRequest(uint64_t id, uint64_t timestamp)
+{
+    Request request;
+    request.set_op(Request::COMMIT);
+    request.set_txnid(id);
+    request.mutable_commit()->set_timestamp(timestamp);
+    return request.SerializeAsString();
+}
+
+class ServerTest : public ::testing::TestWithParam<Mode>
+{
+protected:
+    static const opnum_t CHECKPOINT_INTERVAL = 4;
+
+    std::unique_ptr<transport::Configuration> config;
+    SimulatedTransport transport;
+    std::vector<std::unique_ptr<Server>> servers;
+    std::vector<std::unique_ptr<replication::vr::VRReplica>> replicas;
+    std::unique_ptr<replication::vr::VRClient> client;
+
+    virtual void SetUp() {
+        std::vector<transport::ReplicaAddress> replicaAddrs =
+            { { "localhost", "12370" },
+              { "localhost", "12371" },
+              { "localhost", "12372" }};
+        config = std::unique_ptr<transport::Configuration>(
+            new transport::Configuration(3, 1, replicaAddrs));
+
+        for (int i = 0; i < config->n; i++) {
+            servers.emplace_back(new Server(GetParam(), 0, 0));
+            replicas.emplace_back(new replication::vr::VRReplica(
+                *config, i, &transport, 1, servers.back().get(),
+                replication::vr::VRReplica::DEFAULT_PIPELINE_WINDOW,
+                CHECKPOINT_INTERVAL));
+        }
+        client = std::unique_ptr<replication::vr::VRClient>(
+            new replication::vr::VRClient(*config, &transport));
+    }
+
+    virtual void TearDown() {
+        client.reset();
+        replicas.clear();
+    }
+
+    // Read key at one replica, as an unlogged GET would.
+    std::string Read(int idx, const std::string &key) {
+        Request request;
+        request.set_op(Request::GET);
+        request.set_txnid(1000);
+        request.mutable_get()->set_key(key);
+        std::string str;
+        servers[idx]->UnloggedUpcall(request.SerializeAsString(), str);
+        Reply reply;
+        reply.ParseFromString(str);
+        EXPECT_EQ(REPLY_OK, reply.status()) << key << " at " << idx;
+        return reply.value();
+    }
+
+    // Commit transactions from first to last, each writing one key.
+    void Commit(int first, int last, std::function<void ()> then) {
+        if (first > last) {
+            then();
+            return;
+        }
+        client->Invoke(PrepareRequest(first, Key(first), Value(first)),
+            [=](const string &req, const string &reply) {
+                client->Invoke(CommitRequest(first, first),
+                    [=](const string &req, const string &reply) {
+                        Commit(first + 1, last, then);
+                    });
+            });
+    }
+};
+
+TEST_P(ServerTest, CatchUpFromCheckpoint)
+{
+    // Cut replica 2 off while the others commit past several
+    // checkpoints and truncate their logs.
+    bool fromCheckpoint = false;
+    transport.AddFilter(10, [](TransportReceiver *src, int srcIdx,
+                               TransportReceiver *dst, int dstIdx,
+                               Message &m, uint64_t &delay) {
+                            return srcIdx != 2 && dstIdx != 2;
+                        });
+    transport.AddFilter(20, [&](TransportReceiver *src, int srcIdx,
+                                TransportReceiver *dst, int dstIdx,
+                                Message &m, uint64_t &delay) {
+        if (dstIdx == 2 && m.GetTypeName() ==
+            "replication.vr.proto.StateTransferMessage") {
+            auto &st =
+                dynamic_cast<replication::vr::proto::StateTransferMessage &>(m);
+            fromCheckpoint |= st.has_checkpoint();
+        }
+        return true;
+    });
+
+    // Two transactions prepare before the checkpoints, so replica 2
+    // learns of them only from one; one commits once it is back.
+    client->Invoke(PrepareRequest(100, "p", "pending"),
+        [&](const string &req, const string &reply) {
+            client->Invoke(PrepareRequest(101, "q", "held"),
+                [&](const string &req, const string &reply) {
+                    Commit(1, NTXNS, [&]() {
+                        transport.RemoveFilter(10);
+                        client->Invoke(CommitRequest(100, 100),
+                            [&](const string &req, const string &reply) {
+                                Commit(NTXNS + 1, NTXNS + 4, [&]() {
+                                    transport.CancelAllTimers();
+                                });
+                            });
+                    });
+                });
+        });
+    transport.Run();
+
+    EXPECT_TRUE(fromCheckpoint);
+    for (int i = 0; i < config->n; i++) {
+        for (int j = 1; j <= NTXNS + 4; j++) {
+            EXPECT_EQ(Value(j), Read(i, Key(j))) << "at " << i;
+        }
+        EXPECT_EQ("pending", Read(i, "p")) << "at " << i;
+
+        // Transaction 101 still holds q.
+        bool replicate = true;
+        std::string str;
+        servers[i]->LeaderUpcall(0, PrepareRequest(200, "q", "other"),
+                                 replicate, str);
+        Reply reply;
+        reply.ParseFromString(str);
+        EXPECT_FALSE(replicate) << "at " << i;
+        EXPECT_NE(REPLY_OK, reply.status()) << "at " << i;
+    }
+}
+
+TEST_P(ServerTest, SnapshotRoundTrip)
+{
+    Server server(GetParam(), 0, 0);
+    server.Load("a", "1", Timestamp(1));
+    std::string reply;
+    server.ReplicaUpcall(1, PrepareRequest(1, "b", "2"), reply);
+    server.ReplicaUpcall(2, CommitRequest(1, 2), reply);
+    server.ReplicaUpcall(3, PrepareRequest(2, "c", "3"), reply);
+
+    std::string state;
+    ASSERT_TRUE(server.SnapshotUpcall(state));
+    servers[0]->RestoreUpcall(state);
+
+    EXPECT_EQ("1", Read(0, "a"));
+    EXPECT_EQ("2", Read(0, "b"));
+    servers[0]->ReplicaUpcall(4, CommitRequest(2, 3), reply);
+    EXPECT_EQ("3", Read(0, "c"));
+
+    // Restoring replaces what was there.
+    Server empty(GetParam(), 0, 0);
+    ASSERT_TRUE(empty.SnapshotUpcall(state));
+    servers[0]->RestoreUpcall(state);
+    Request request;
+    request.set_op(Request::GET);
+    request.set_txnid(1000);
+    request.mutable_get()->set_key("a");
+    servers[0]->UnloggedUpcall(request.SerializeAsString(), reply);
+    Reply r;
+    r.ParseFromString(reply);
+    EXPECT_EQ(REPLY_FAIL, r.status());
+}
+
+INSTANTIATE_TEST_CASE_P(Modes, ServerTest,
+                        ::testing::Values(MODE_LOCK, MODE_OCC,
+                                          MODE_SPAN_LOCK, MODE_SPAN_OCC));
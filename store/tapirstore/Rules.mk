@@ -1,7 +1,7 @@
 d := $(dir $(lastword $(MAKEFILE_LIST)))
 
 SRCS += $(addprefix $(d), client.cc shardclient.cc \
-	server.cc store.cc)
+	asyncclient.cc server.cc server-main.cc store.cc)
 
 PROTOS += $(addprefix $(d), tapir-proto.proto)
 
@@ -11,7 +11,12 @@ OBJS-tapir-store := $(LIB-message) $(LIB-store-common) $(LIB-store-backend) \
 OBJS-tapir-client := $(OBJS-ir-client)  $(LIB-udptransport) $(LIB-store-frontend) $(LIB-store-common) $(o)tapir-proto.o \
 		$(o)shardclient.o $(o)client.o
 
-$(d)server: $(LIB-udptransport) $(OBJS-ir-replica) \
-		$(OBJS-tapir-store) $(o)server.o
+OBJS-tapir-async-client := $(OBJS-tapir-client) $(o)asyncclient.o
+
+OBJS-tapir-server := $(OBJS-ir-replica) $(OBJS-tapir-store) $(o)server.o
+
+$(d)server: $(LIB-udptransport) $(OBJS-tapir-server) $(o)server-main.o
 
 BINS += $(d)server
+
+include $(d)tests/Rules.mk
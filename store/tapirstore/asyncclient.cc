@@ -0,0 +1,308 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/asyncclient.cc:
+ *   Tapir client with a non-blocking interface, for running many
+ *   transactions at once from a single thread.
+ *
+ **********************************************************************/
+
+#include "store/tapirstore/asyncclient.h"
+
+#include "store/common/frontend/client.h"
+
+#include <random>
+
+namespace tapirstore {
+
+using namespace std;
+
+// A multi-key read in progress.
+struct AsyncClient::GetState
+{
+    Txn *txn;
+    vector<string> keys;
+    vector<string> values;
+    // Whether keys[i] was read at its latest version, which then has to
+    // be added to the read set.
+    vector<bool> latest;
+    // Replies still to come, plus one while requests are being sent.
+    size_t outstanding;
+    int status;
+    get_continuation_t continuation;
+};
+
+AsyncClient::AsyncClient(const string &configPath, int nShards,
+                         int closestReplica, Transport *transport,
+                         TrueTime timeServer)
+    : nshards(nShards), timeServer(timeServer)
+{
+    client_id = 0;
+    while (client_id == 0) {
+        random_device rd;
+        mt19937_64 gen(rd());
+        uniform_int_distribution<uint64_t> dis;
+        client_id = dis(gen);
+    }
+    t_id = (client_id/10000)*10000;
+
+    for (uint64_t i = 0; i < nshards; i++) {
+        string shardConfigPath = configPath + to_string(i) + ".config";
+        sclient.push_back(new ShardClient(shardConfigPath, transport,
+                                          client_id, i, closestReplica));
+    }
+
+    Debug("Async tapir client [%lu] created! %lu", client_id, nshards);
+}
+
+AsyncClient::~AsyncClient()
+{
+    for (auto s : sclient) {
+        delete s;
+    }
+}
+
+AsyncClient::Txn *
+AsyncClient::Begin()
+{
+    Txn *txn = new Txn();
+    txn->id = ++t_id;
+    txn->readOnly = true;
+    txn->round = 0;
+    txn->pending = 0;
+    txn->decided = false;
+
+    Debug("BEGIN [%lu]", txn->id);
+    return txn;
+}
+
+void
+AsyncClient::Get(Txn *txn, const vector<string> &keys,
+                 get_continuation_t continuation)
+{
+    Debug("GET [%lu : %lu keys]", txn->id, keys.size());
+
+    shared_ptr<GetState> state = make_shared<GetState>();
+    state->txn = txn;
+    state->keys = keys;
+    state->values.resize(keys.size());
+    state->latest.resize(keys.size(), false);
+    state->outstanding = keys.size() + 1;
+    state->status = REPLY_OK;
+    state->continuation = continuation;
+
+    map<int, vector<string>> fetchKeys;
+    map<int, vector<Promise *>> fetchPromises;
+    for (size_t i = 0; i < keys.size(); i++) {
+        const string &key = keys[i];
+        int s = ::Client::key_to_shard(key, nshards);
+        const Transaction &t = txn->shards[s];
+
+        Promise *promise = new Promise(GET_TIMEOUT,
+            [this, state, i](Promise *p) { GetDone(state, i, p); });
+
+        // Read your own writes, check the write set first.
+        auto w = t.getWriteSet().find(key);
+        if (w != t.getWriteSet().end()) {
+            promise->Reply(REPLY_OK, w->second);
+            continue;
+        }
+
+        // Consistent reads, read from the server at same timestamp.
+        auto r = t.getReadSet().find(key);
+        if (r != t.getReadSet().end()) {
+            sclient[s]->Get(txn->id, key, r->second, promise);
+            continue;
+        }
+
+        // Otherwise, get latest value from server.
+        state->latest[i] = true;
+        fetchKeys[s].push_back(key);
+        fetchPromises[s].push_back(promise);
+    }
+
+    for (auto &f : fetchKeys) {
+        sclient[f.first]->MultiGet(txn->id, f.second,
+                                   fetchPromises[f.first]);
+    }
+    GetDone(state, keys.size(), NULL);
+}
+
+void
+AsyncClient::GetDone(shared_ptr<GetState> state, size_t i, Promise *promise)
+{
+    if (promise != NULL) {
+        int reply = promise->GetReply();
+        state->values[i] = promise->GetValue();
+        if (reply == REPLY_OK && state->latest[i]) {
+            const string &key = state->keys[i];
+            Transaction &t =
+                state->txn->shards[::Client::key_to_shard(key, nshards)];
+            if (t.getReadSet().find(key) == t.getReadSet().end()) {
+                t.addReadSet(key, promise->GetTimestamp());
+            }
+        }
+        if (state->status == REPLY_OK) {
+            state->status = reply;
+        }
+        delete promise;
+    }
+
+    if (--state->outstanding == 0) {
+        state->continuation(state->status, state->values);
+    }
+}
+
+void
+AsyncClient::Put(Txn *txn, const string &key, const string &value)
+{
+    Debug("PUT [%lu : %s]", txn->id, key.c_str());
+
+    int s = ::Client::key_to_shard(key, nshards);
+    txn->shards[s].addWriteSet(key, value);
+}
+
+void
+AsyncClient::Commit(Txn *txn, commit_continuation_t continuation)
+{
+    txn->continuation = continuation;
+
+    // A transaction that accessed nothing trivially commits.
+    if (txn->shards.empty()) {
+        Finish(txn, true);
+        return;
+    }
+
+    // Read-only transactions are validated instead, in a single round.
+    txn->readOnly = true;
+    for (auto &s : txn->shards) {
+        txn->readOnly = txn->readOnly && s.second.getWriteSet().empty();
+    }
+
+    txn->timestamp = Timestamp(timeServer.GetTime(), client_id);
+    txn->retries = 0;
+    Prepare(txn);
+}
+
+void
+AsyncClient::Prepare(Txn *txn)
+{
+    Debug("%s [%lu] at %lu", txn->readOnly ? "VALIDATE" : "PREPARE",
+          txn->id, txn->timestamp.getTimestamp());
+
+    int round = ++txn->round;
+    txn->outstanding = txn->shards.size();
+    txn->status = REPLY_OK;
+    txn->proposed = 0;
+
+    for (auto &s : txn->shards) {
+        txn->pending++;
+        Promise *promise = new Promise(PREPARE_TIMEOUT,
+            [this, txn, round](Promise *p) { HandleVote(txn, round, p); });
+        if (txn->readOnly) {
+            sclient[s.first]->Validate(txn->id, s.second, txn->timestamp,
+                                       promise);
+        } else {
+            sclient[s.first]->Prepare(txn->id, s.second, txn->timestamp,
+                                      promise);
+        }
+    }
+}
+
+void
+AsyncClient::HandleVote(Txn *txn, int round, Promise *promise)
+{
+    int reply = promise->GetReply();
+    uint64_t t = promise->GetTimestamp().getTimestamp();
+    delete promise;
+    txn->pending--;
+
+    // Late vote for an attempt that was already decided.
+    if (txn->decided || round != txn->round) {
+        Release(txn);
+        return;
+    }
+
+    switch (reply) {
+    case REPLY_OK:
+        Debug("PREPARE [%lu] OK", txn->id);
+        break;
+    case REPLY_FAIL:
+        // abort without waiting for the other votes.
+        Debug("PREPARE [%lu] ABORT", txn->id);
+        Finish(txn, false);
+        return;
+    case REPLY_RETRY:
+        txn->status = REPLY_RETRY;
+        if (t > txn->proposed) {
+            txn->proposed = t;
+        }
+        break;
+    case REPLY_TIMEOUT:
+        txn->status = REPLY_RETRY;
+        break;
+    default:
+        // just ignore abstains
+        break;
+    }
+
+    if (--txn->outstanding > 0) {
+        return;
+    }
+
+    if (txn->status != REPLY_RETRY) {
+        Finish(txn, true);
+    } else if (++txn->retries < COMMIT_RETRIES) {
+        uint64_t now = timeServer.GetTime();
+        txn->timestamp.setTimestamp(now > txn->proposed ? now : txn->proposed);
+        Debug("RETRY [%lu] at [%lu]", txn->id, txn->timestamp.getTimestamp());
+        Prepare(txn);
+    } else {
+        Finish(txn, false);
+    }
+}
+
+void
+AsyncClient::Finish(Txn *txn, bool committed)
+{
+    Debug("%s [%lu]", committed ? "COMMIT" : "ABORT", txn->id);
+    txn->decided = true;
+
+    // Nothing was prepared for a read-only transaction, so there is
+    // nothing to commit or abort.
+    if (!txn->readOnly) {
+        for (auto &s : txn->shards) {
+            if (committed) {
+                sclient[s.first]->Commit(txn->id, s.second, 0);
+            } else {
+                sclient[s.first]->Abort(txn->id, Transaction());
+            }
+        }
+    }
+
+    commit_continuation_t continuation = std::move(txn->continuation);
+    Release(txn);
+    continuation(committed);
+}
+
+void
+AsyncClient::Abort(Txn *txn)
+{
+    Debug("ABORT [%lu]", txn->id);
+
+    for (auto &s : txn->shards) {
+        sclient[s.first]->Abort(txn->id, Transaction());
+    }
+    txn->decided = true;
+    Release(txn);
+}
+
+void
+AsyncClient::Release(Txn *txn)
+{
+    if (txn->decided && txn->pending == 0) {
+        delete txn;
+    }
+}
+
+} // namespace tapirstore
@@ -0,0 +1,105 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/asyncclient.h:
+ *   Tapir client with a non-blocking interface, for running many
+ *   transactions at once from a single thread.
+ *
+ **********************************************************************/
+
+#ifndef _TAPIR_ASYNC_CLIENT_H_
+#define _TAPIR_ASYNC_CLIENT_H_
+
+#include "lib/transport.h"
+#include "store/common/promise.h"
+#include "store/common/timestamp.h"
+#include "store/common/transaction.h"
+#include "store/common/truetime.h"
+#include "store/tapirstore/shardclient.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tapirstore {
+
+// Unlike Client, which blocks the caller on every operation, this client
+// returns immediately and runs a continuation once the operation is done.
+// All calls must be made on the transport thread, which is also where the
+// continuations run. A transaction may only have one operation in flight.
+class AsyncClient
+{
+public:
+    typedef std::function<void (int status,
+                                const std::vector<std::string> &values)>
+        get_continuation_t;
+    typedef std::function<void (bool committed)> commit_continuation_t;
+
+    // An ongoing transaction.
+    struct Txn
+    {
+        uint64_t id;
+        // Read and write sets of each participant shard.
+        std::map<int, Transaction> shards;
+        bool readOnly;
+        Timestamp timestamp;
+        int retries;
+        // Prepare attempt, to tell late votes of earlier ones apart.
+        int round;
+        // Votes the current attempt still waits for.
+        int outstanding;
+        // Votes of any attempt still in flight; the transaction is
+        // only freed once there are none.
+        int pending;
+        int status;
+        uint64_t proposed;
+        bool decided;
+        commit_continuation_t continuation;
+    };
+
+    AsyncClient(const std::string &configPath, int nShards,
+                int closestReplica, Transport *transport,
+                TrueTime timeServer = TrueTime(0, 0));
+    ~AsyncClient();
+
+    // Start a transaction.
+    Txn *Begin();
+
+    // Read keys, then run continuation with the first failed status, if
+    // any, and the values in the order of keys. The keys of a shard are
+    // read with a single request.
+    void Get(Txn *txn, const std::vector<std::string> &keys,
+             get_continuation_t continuation);
+
+    // Buffer a write, which always succeeds.
+    void Put(Txn *txn, const std::string &key, const std::string &value);
+
+    // Try to commit txn, then run continuation with the outcome. The
+    // transaction must not be used afterwards.
+    void Commit(Txn *txn, commit_continuation_t continuation);
+
+    // Abort txn, which must not be used afterwards.
+    void Abort(Txn *txn);
+
+private:
+    struct GetState;
+
+    uint64_t client_id;
+    uint64_t nshards;
+    uint64_t t_id; // Last transaction ID handed out.
+    TrueTime timeServer;
+    std::vector<ShardClient *> sclient;
+
+    void GetDone(std::shared_ptr<GetState> state, std::size_t i,
+                 Promise *promise);
+    void Prepare(Txn *txn);
+    void HandleVote(Txn *txn, int round, Promise *promise);
+    void Finish(Txn *txn, bool committed);
+    void Release(Txn *txn);
+};
+
+} // namespace tapirstore
+
+#endif /* _TAPIR_ASYNC_CLIENT_H_ */
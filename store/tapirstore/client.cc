@@ -76,6 +76,11 @@ Client::~Client()
         delete b;
     }
     clientTransport->join();
+
+    // With the event loop stopped, no late vote can still be replied to.
+    for (auto p : lateVotes) {
+        delete p;
+    }
 }
 
 /* Runs the transport event loop. */
@@ -129,6 +134,51 @@ Client::Get(const string &key)
     return value;
 }
 
+/* Returns the values corresponding to the supplied keys, reading all the
+ * keys of a shard with a single request and all shards in parallel. */
+int
+Client::MultiGet(const vector<string> &keys, vector<string> &values)
+{
+    Debug("MULTI_GET [%lu : %lu keys]", t_id, keys.size());
+
+    // Group the keys by shard, each with its own promise.
+    vector<Promise *> promises;
+    map<int, vector<string>> shardKeys;
+    map<int, vector<Promise *>> shardPromises;
+    for (const string &key : keys) {
+        int i = key_to_shard(key, nshards);
+
+        // If needed, add this shard to set of participants and send BEGIN.
+        if (participants.find(i) == participants.end()) {
+            participants.insert(i);
+            bclient[i]->Begin(t_id);
+        }
+
+        promises.push_back(new Promise(GET_TIMEOUT));
+        shardKeys[i].push_back(key);
+        shardPromises[i].push_back(promises.back());
+    }
+
+    // Send every shard its batch before waiting on any of them.
+    for (const auto &s : shardKeys) {
+        bclient[s.first]->MultiGet(s.second, shardPromises[s.first]);
+    }
+    for (const auto &s : shardKeys) {
+        bclient[s.first]->FinishMultiGet(s.second, shardPromises[s.first]);
+    }
+
+    int status = REPLY_OK;
+    values.clear();
+    for (Promise *p : promises) {
+        values.push_back(p->GetValue());
+        if (status == REPLY_OK) {
+            status = p->GetReply();
+        }
+        delete p;
+    }
+    return status;
+}
+
 /* Sets the value corresponding to the supplied key. */
 int
 Client::Put(const string &key, const string &value)
@@ -152,41 +202,59 @@ Client::Put(const string &key, const string &value)
 }
 
 int
-Client::Prepare(Timestamp &timestamp)
+Client::Prepare(Timestamp &timestamp, bool readOnly)
 {
-    // 1. Send commit-prepare to all shards.
+    // 1. Send commit-prepare (or validate) to all shards.
     uint64_t proposed = 0;
-    list<Promise *> promises;
+    set<Promise *> promises;
 
-    Debug("PREPARE [%lu] at %lu", t_id, timestamp.getTimestamp());
+    Debug("%s [%lu] at %lu", readOnly ? "VALIDATE" : "PREPARE", t_id,
+          timestamp.getTimestamp());
     ASSERT(participants.size() > 0);
 
     for (auto p : participants) {
-        promises.push_back(new Promise(PREPARE_TIMEOUT));
-        bclient[p]->Prepare(timestamp, promises.back());
+        Promise *promise = new Promise(PREPARE_TIMEOUT, &prepareReplies);
+        promises.insert(promise);
+        if (readOnly) {
+            bclient[p]->Validate(timestamp, promise);
+        } else {
+            bclient[p]->Prepare(timestamp, promise);
+        }
     }
 
     int status = REPLY_OK;
-    uint64_t ts;
-    // 3. If all votes YES, send commit to all shards.
-    // If any abort, then abort. Collect any retry timestamps.
-    for (auto p : promises) {
-        uint64_t proposed = p->GetTimestamp().getTimestamp();
+    // 3. Handle the votes in the order they arrive. If all votes YES,
+    // send commit to all shards. If any abort, then abort without waiting
+    // for the rest. Collect any retry timestamps along the way.
+    while (!promises.empty()) {
+        Promise *p = prepareReplies.Pop();
+        if (promises.erase(p) == 0) {
+            // Late vote for an earlier prepare that was already decided.
+            lateVotes.erase(p);
+            delete p;
+            continue;
+        }
 
-        switch(p->GetReply()) {
+        int reply = p->GetReply();
+        uint64_t t = p->GetTimestamp().getTimestamp();
+        delete p;
+
+        switch(reply) {
         case REPLY_OK:
             Debug("PREPARE [%lu] OK", t_id);
             continue;
         case REPLY_FAIL:
-            // abort!
+            // abort! Shards that have yet to vote reject the prepare
+            // once they have seen the abort.
             Debug("PREPARE [%lu] ABORT", t_id);
+            lateVotes.insert(promises.begin(), promises.end());
             return REPLY_FAIL;
         case REPLY_RETRY:
             status = REPLY_RETRY;
-                if (proposed > ts) {
-                    ts = proposed;
-                }
-                break;
+            if (t > proposed) {
+                proposed = t;
+            }
+            break;
         case REPLY_TIMEOUT:
             status = REPLY_RETRY;
             break;
@@ -196,7 +264,6 @@ Client::Prepare(Timestamp &timestamp)
         default:
             break;
         }
-        delete p;
     }
 
     if (status == REPLY_RETRY) {
@@ -217,12 +284,24 @@ Client::Prepare(Timestamp &timestamp)
 bool
 Client::Commit()
 {
+    // A transaction that accessed nothing trivially commits.
+    if (participants.empty()) {
+        return true;
+    }
+
+    // A read-only transaction needs no prepare phase: a single round
+    // validates its reads at a timestamp and commits it.
+    bool readOnly = true;
+    for (auto p : participants) {
+        readOnly = readOnly && bclient[p]->IsReadOnly();
+    }
+
     // Implementing 2 Phase Commit
     Timestamp timestamp(timeServer.GetTime(), client_id);
     int status;
 
     for (retries = 0; retries < COMMIT_RETRIES; retries++) {
-        status = Prepare(timestamp);
+        status = Prepare(timestamp, readOnly);
         if (status == REPLY_RETRY) {
             continue;
         } else {
@@ -230,6 +309,13 @@ Client::Commit()
         }
     }
 
+    if (readOnly) {
+        // Nothing was prepared, so there is nothing to commit or abort.
+        Debug("%s [%lu] read-only", status == REPLY_OK ? "COMMIT" : "ABORT",
+              t_id);
+        return status == REPLY_OK;
+    }
+
     if (status == REPLY_OK) {
         Debug("COMMIT [%lu]", t_id);
         
@@ -60,6 +60,8 @@ public:
     int Get(const std::string &key, std::string &value);
     // Interface added for Java bindings
     std::string Get(const std::string &key);
+    int MultiGet(const std::vector<std::string> &keys,
+                 std::vector<std::string> &values);
     int Put(const std::string &key, const std::string &value);
     bool Commit();
     void Abort();
@@ -93,8 +95,17 @@ private:
     // TrueTime server.
     TrueTime timeServer;
 
-    // Prepare function
-    int Prepare(Timestamp &timestamp);
+    // Prepare votes, in the order they arrive.
+    PromiseQueue prepareReplies;
+
+    // Votes still outstanding when a prepare was decided early. They are
+    // dropped as they arrive during later prepares, or when the client
+    // goes away.
+    std::set<Promise *> lateVotes;
+
+    // Prepare function. A read-only transaction is validated instead, which
+    // commits it at the same time.
+    int Prepare(Timestamp &timestamp, bool readOnly);
 
     // Runs the transport event loop.
     void run_client();
@@ -0,0 +1,307 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/server-main.cc:
+ *   Command-line driver for the transactional key-value server.
+ *
+ * Copyright 2015 Irene Zhang <iyzhang@cs.washington.edu>
+ *                Naveen Kr. Sharma <naveenks@cs.washington.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************/
+
+#include "store/tapirstore/server.h"
+#include "store/common/keyset.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int
+main(int argc, char **argv)
+{
+    int index = -1;
+    unsigned int myShard = 0, maxShard = 1, nKeys = 1, nHosted = 0;
+    const char *configPath = NULL;
+    const char *keyPath = NULL;
+    const char *snapshotPrefix = NULL;
+    unsigned int snapshotInterval = 0;
+    bool linearizable = true;
+
+    // Parse arguments
+    int opt;
+    while ((opt = getopt(argc, argv, "c:i:m:e:s:f:n:N:k:p:S:T:")) != -1) {
+        switch (opt) {
+        case 'c':
+            configPath = optarg;
+            break;
+
+        case 'i':
+        {
+            char *strtolPtr;
+            index = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (index < 0))
+            {
+                fprintf(stderr, "option -i requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'm':
+        {
+            if (strcasecmp(optarg, "txn-l") == 0) {
+                linearizable = true;
+            } else if (strcasecmp(optarg, "txn-s") == 0) {
+                linearizable = false;
+            } else {
+                fprintf(stderr, "unknown mode '%s'\n", optarg);
+            }
+            break;
+        }
+
+        case 'k':
+        {
+            char *strtolPtr;
+            nKeys = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'n':
+        {
+            char *strtolPtr;
+            myShard = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'N':
+        {
+            char *strtolPtr;
+            maxShard = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -e requires a numeric arg\n");
+            }
+            break;
+        }
+
+        case 'p':   // Host the replicas of shards myShard..myShard+p-1
+        {
+            char *strtolPtr;
+            nHosted = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0') || (nHosted == 0))
+            {
+                fprintf(stderr, "option -p requires a positive integer\n");
+            }
+            break;
+        }
+
+        case 'f':   // Load keys from file
+        {
+            keyPath = optarg;
+            break;
+        }
+
+        case 'S':   // Restore from and write snapshots with this prefix
+        {
+            snapshotPrefix = optarg;
+            break;
+        }
+
+        case 'T':   // Seconds between snapshots
+        {
+            char *strtolPtr;
+            snapshotInterval = strtoul(optarg, &strtolPtr, 10);
+            if ((*optarg == '\0') || (*strtolPtr != '\0'))
+            {
+                fprintf(stderr, "option -T requires a numeric arg\n");
+            }
+            break;
+        }
+
+        default:
+            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+        }
+    }
+
+    if (!configPath) {
+        fprintf(stderr, "option -c is required\n");
+    }
+
+    if (index == -1) {
+        fprintf(stderr, "option -i is required\n");
+    }
+
+    // With -p, this process hosts our replica of each of nHosted shards,
+    // each driven by its own transport on its own core, and -c is the
+    // prefix of the shard configurations, as for clients. Shards share
+    // nothing, so throughput scales with the number of cores.
+    const bool multiShard = nHosted > 0;
+    if (!multiShard) {
+        nHosted = 1;
+    }
+    if (myShard + nHosted > maxShard) {
+        fprintf(stderr, "shards %u to %u are out of bounds; "
+                "only %u shards defined\n", myShard, myShard + nHosted - 1,
+                maxShard);
+    }
+
+    std::vector<std::unique_ptr<transport::Configuration>> configs;
+    std::vector<std::unique_ptr<UDPTransport>> transports;
+    std::vector<std::unique_ptr<tapirstore::Server>> servers;
+    std::vector<std::unique_ptr<replication::ir::IRReplica>> replicas;
+    for (unsigned int i = 0; i < nHosted; i++) {
+        // Load configuration
+        string shardConfigPath = configPath;
+        if (multiShard) {
+            shardConfigPath += std::to_string(myShard + i) + ".config";
+        }
+        std::ifstream configStream(shardConfigPath);
+        if (configStream.fail()) {
+            fprintf(stderr, "unable to read configuration file: %s\n",
+                    shardConfigPath.c_str());
+        }
+        configs.emplace_back(new transport::Configuration(configStream));
+
+        if (index >= configs.back()->n) {
+            fprintf(stderr, "replica index %d is out of bounds; "
+                    "only %d replicas defined\n", index, configs.back()->n);
+        }
+
+        // Only the transport run by the main thread handles signals.
+        transports.emplace_back(new UDPTransport(0.0, 0.0, 0, i == 0));
+        servers.emplace_back(new tapirstore::Server(linearizable));
+        replicas.emplace_back(new replication::ir::IRReplica(
+            *configs.back(), index, transports.back().get(),
+            servers.back().get()));
+    }
+
+    // Each shard's snapshot, if there is one, replaces loading its keys.
+    auto snapshotPath = [&](unsigned int i) {
+        return string(snapshotPrefix) + std::to_string(myShard + i) + "." +
+            std::to_string(index) + ".snap";
+    };
+    std::vector<bool> restored(nHosted);
+    if (snapshotPrefix) {
+        for (unsigned int i = 0; i < nHosted; i++) {
+            string path = snapshotPath(i);
+            if (access(path.c_str(), F_OK) != 0) {
+                continue;
+            }
+            if (!servers[i]->Restore(path)) {
+                Panic("Could not restore snapshot %s", path.c_str());
+            }
+            Notice("Restored snapshot %s", path.c_str());
+            restored[i] = true;
+        }
+    }
+
+    if (keyPath) {
+        KeySet keys;
+        if (!keys.Open(keyPath)) {
+            fprintf(stderr, "Could not read keys from: %s\n", keyPath);
+            exit(0);
+        }
+
+        // Each hosted shard loads its keys on a thread of its own.
+        keys.Load(nKeys, maxShard, myShard, nHosted,
+            [&](uint64_t shard, size_t n) {
+                if (!restored[shard - myShard]) {
+                    servers[shard - myShard]->Reserve(n);
+                }
+            },
+            [&](uint64_t shard, const string &key) {
+                if (!restored[shard - myShard]) {
+                    servers[shard - myShard]->Load(key, "null", Timestamp());
+                }
+            });
+    }
+
+    // Each shard's own thread takes its snapshots, so that its store is
+    // not changing when it forks.
+    std::vector<std::function<void ()>> snapshotTimers(nHosted);
+    if (snapshotPrefix && snapshotInterval > 0) {
+        for (unsigned int i = 0; i < nHosted; i++) {
+            snapshotTimers[i] = [&, i]() {
+                servers[i]->Snapshot(snapshotPath(i));
+                transports[i]->Timer(snapshotInterval * 1000,
+                                     snapshotTimers[i]);
+            };
+            transports[i]->Timer(snapshotInterval * 1000, snapshotTimers[i]);
+        }
+    }
+
+    // Pin each shard's transport to its own core. The main thread runs the
+    // first one, and stops the others when it exits.
+    const unsigned int nCores = std::max(1u, std::thread::hardware_concurrency());
+    auto pin = [nCores](pthread_t thread, unsigned int core) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(core % nCores, &cpuset);
+        if (pthread_setaffinity_np(thread, sizeof(cpuset), &cpuset) != 0) {
+            Warning("Could not pin shard thread to core %u", core % nCores);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nHosted; i++) {
+        UDPTransport *transport = transports[i].get();
+        threads.emplace_back([transport]() { transport->Run(); });
+        pin(threads.back().native_handle(), i);
+    }
+    if (multiShard) {
+        pin(pthread_self(), 0);
+    }
+
+    transports[0]->Run();
+
+    for (unsigned int i = 1; i < nHosted; i++) {
+        transports[i]->Stop();
+        threads[i - 1].join();
+    }
+
+    // Nothing is running now, so write the final snapshots in place.
+    if (snapshotPrefix) {
+        for (unsigned int i = 0; i < nHosted; i++) {
+            if (!servers[i]->Snapshot(snapshotPath(i), false)) {
+                Warning("Could not write snapshot %s",
+                        snapshotPath(i).c_str());
+            }
+        }
+    }
+
+    return 0;
+}
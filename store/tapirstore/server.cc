@@ -31,12 +31,15 @@
 
 #include "store/tapirstore/server.h"
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace tapirstore {
 
 using namespace std;
 using namespace proto;
 
-Server::Server(bool linearizable)
+Server::Server(bool linearizable) : snapshotPid(0)
 {
     store = new Store(linearizable);
 }
@@ -91,6 +94,17 @@ Server::ExecConsensusUpcall(const string &str1, string &str2)
         }
         reply.SerializeToString(&str2);
         break;
+    case tapirstore::proto::Request::VALIDATE:
+        status = store->Validate(request.txnid(),
+                                 Transaction(request.validate().txn()),
+                                 Timestamp(request.validate().timestamp()),
+                                 proposed);
+        reply.set_status(status);
+        if (proposed.isValid()) {
+            proposed.serialize(reply.mutable_timestamp());
+        }
+        reply.SerializeToString(&str2);
+        break;
     default:
         Panic("Unrecognized consensus operation.");
     }
@@ -104,28 +118,20 @@ Server::UnloggedUpcall(const string &str1, string &str2)
 
     Request request;
     Reply reply;
-    int status;
 
     request.ParseFromString(str1);
 
     switch (request.op()) {
     case tapirstore::proto::Request::GET:
-        if (request.get().has_timestamp()) {
-            pair<Timestamp, string> val;
-            status = store->Get(request.txnid(), request.get().key(),
-                               request.get().timestamp(), val);
-            if (status == 0) {
-                reply.set_value(val.second);
-            }
-        } else {
-            pair<Timestamp, string> val;
-            status = store->Get(request.txnid(), request.get().key(), val);
-            if (status == 0) {
-                reply.set_value(val.second);
-                val.first.serialize(reply.mutable_timestamp());
-            }
+        Get(request.txnid(), request.get(), &reply);
+        reply.SerializeToString(&str2);
+        break;
+    case tapirstore::proto::Request::MULTI_GET:
+        // Answer every key in one reply; the batch itself always succeeds.
+        for (const GetMessage &get : request.multiget().get()) {
+            Get(request.txnid(), get, reply.add_multiget());
         }
-        reply.set_status(status);
+        reply.set_status(REPLY_OK);
         reply.SerializeToString(&str2);
         break;
     default:
@@ -133,6 +139,27 @@ Server::UnloggedUpcall(const string &str1, string &str2)
     }
 }
 
+void
+Server::Get(uint64_t txnid, const GetMessage &get, Reply *reply)
+{
+    int status;
+    pair<Timestamp, string> val;
+
+    if (get.has_timestamp()) {
+        status = store->Get(txnid, get.key(), get.timestamp(), val);
+        if (status == 0) {
+            reply->set_value(val.second);
+        }
+    } else {
+        status = store->Get(txnid, get.key(), val);
+        if (status == 0) {
+            reply->set_value(val.second);
+            val.first.serialize(reply->mutable_timestamp());
+        }
+    }
+    reply->set_status(status);
+}
+
 void
 Server::Sync(const std::map<opid_t, RecordEntry>& record)
 {
@@ -140,8 +167,8 @@ Server::Sync(const std::map<opid_t, RecordEntry>& record)
 }
 
 std::map<opid_t, std::string>
-Server::Merge(const std::map<opid_t, std::vector<RecordEntry>> &d,
-              const std::map<opid_t, std::vector<RecordEntry>> &u,
+Server::Merge(const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+              const std::map<opid_t, std::vector<const RecordEntry *>> &u,
               const std::map<opid_t, std::string> &majority_results_in_d)
 {
     Panic("Unimplemented!");
@@ -153,145 +180,52 @@ Server::Load(const string &key, const string &value, const Timestamp timestamp)
     store->Load(key, value, timestamp);
 }
 
-} // namespace tapirstore
-
-
-int
-main(int argc, char **argv)
+void
+Server::Reserve(size_t nKeys)
 {
-    int index = -1;
-    unsigned int myShard = 0, maxShard = 1, nKeys = 1;
-    const char *configPath = NULL;
-    const char *keyPath = NULL;
-    bool linearizable = true;
-
-    // Parse arguments
-    int opt;
-    while ((opt = getopt(argc, argv, "c:i:m:e:s:f:n:N:k:")) != -1) {
-        switch (opt) {
-        case 'c':
-            configPath = optarg;
-            break;
-
-        case 'i':
-        {
-            char *strtolPtr;
-            index = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0') || (index < 0))
-            {
-                fprintf(stderr, "option -i requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'm':
-        {
-            if (strcasecmp(optarg, "txn-l") == 0) {
-                linearizable = true;
-            } else if (strcasecmp(optarg, "txn-s") == 0) {
-                linearizable = false;
-            } else {
-                fprintf(stderr, "unknown mode '%s'\n", optarg);
-            }
-            break;
-        }
-
-        case 'k':
-        {
-            char *strtolPtr;
-            nKeys = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0'))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'n':
-        {
-            char *strtolPtr;
-            myShard = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0'))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
-
-        case 'N':
-        {
-            char *strtolPtr;
-            maxShard = strtoul(optarg, &strtolPtr, 10);
-            if ((*optarg == '\0') || (*strtolPtr != '\0'))
-            {
-                fprintf(stderr, "option -e requires a numeric arg\n");
-            }
-            break;
-        }
+    store->Reserve(nKeys);
+}
 
-        case 'f':   // Load keys from file
-        {
-            keyPath = optarg;
-            break;
+bool
+Server::Snapshot(const string &path, bool background)
+{
+    if (snapshotPid > 0) {
+        int status;
+        pid_t pid = waitpid(snapshotPid, &status, background ? WNOHANG : 0);
+        if (pid == 0) {
+            Warning("Not starting snapshot %s; the last is still being "
+                    "written", path.c_str());
+            return false;
         }
-
-        default:
-            fprintf(stderr, "Unknown argument %s\n", argv[optind]);
+        if (pid == snapshotPid &&
+            !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            Warning("Writing a snapshot failed");
         }
+        snapshotPid = 0;
     }
 
-    if (!configPath) {
-        fprintf(stderr, "option -c is required\n");
-    }
-
-    if (index == -1) {
-        fprintf(stderr, "option -i is required\n");
-    }
-
-    // Load configuration
-    std::ifstream configStream(configPath);
-    if (configStream.fail()) {
-        fprintf(stderr, "unable to read configuration file: %s\n", configPath);
+    if (!background) {
+        return store->Save(path);
     }
-    transport::Configuration config(configStream);
 
-    if (index >= config.n) {
-        fprintf(stderr, "replica index %d is out of bounds; "
-                "only %d replicas defined\n", index, config.n);
+    pid_t pid = fork();
+    if (pid < 0) {
+        Warning("Could not fork to write snapshot %s", path.c_str());
+        return false;
     }
-
-    UDPTransport transport(0.0, 0.0, 0);
-
-    tapirstore::Server server(linearizable);
-
-    replication::ir::IRReplica replica(config, index, &transport, &server);
-
-    if (keyPath) {
-        string key;
-        std::ifstream in;
-        in.open(keyPath);
-        if (!in) {
-            fprintf(stderr, "Could not read keys from: %s\n", keyPath);
-            exit(0);
-        }
-
-        for (unsigned int i = 0; i < nKeys; i++) {
-            getline(in, key);
-
-            uint64_t hash = 5381;
-            const char* str = key.c_str();
-            for (unsigned int j = 0; j < key.length(); j++) {
-                hash = ((hash << 5) + hash) + (uint64_t)str[j];
-            }
-
-            if (hash % maxShard == myShard) {
-                server.Load(key, "null", Timestamp());
-            }
-        }
-        in.close();
+    if (pid == 0) {
+        // Only this thread changes the store, and it is here, so the
+        // child's copy is consistent whatever other shards are doing.
+        _exit(store->Save(path) ? 0 : 1);
     }
+    snapshotPid = pid;
+    return true;
+}
 
-    transport.Run();
-
-    return 0;
+bool
+Server::Restore(const string &path)
+{
+    return store->Restore(path);
 }
+
+} // namespace tapirstore
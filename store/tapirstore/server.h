@@ -63,14 +63,28 @@ public:
 
     // Merge
     std::map<opid_t, std::string> Merge(
-        const std::map<opid_t, std::vector<RecordEntry>> &d,
-        const std::map<opid_t, std::vector<RecordEntry>> &u,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &d,
+        const std::map<opid_t, std::vector<const RecordEntry *>> &u,
         const std::map<opid_t, std::string> &majority_results_in_d) override;
 
     void Load(const string &key, const string &value, const Timestamp timestamp);
+    void Reserve(size_t nKeys);
+
+    // Write a snapshot of the store to path. In the background, a child
+    // process writes it from its copy-on-write view of the store as of
+    // now, while this one carries on serving. Returns false if it could
+    // not start, or if the previous snapshot is still being written.
+    bool Snapshot(const std::string &path, bool background = true);
+    bool Restore(const std::string &path);
 
 private:
-    TxnStore *store;
+    Store *store;
+    // The child writing a snapshot, if any.
+    pid_t snapshotPid;
+
+    // Serve one read of a GET or MULTI_GET into reply.
+    void Get(uint64_t txnid, const proto::GetMessage &get,
+             proto::Reply *reply);
 };
 
 } // namespace tapirstore
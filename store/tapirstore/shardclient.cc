@@ -36,35 +36,46 @@ namespace tapirstore {
 using namespace std;
 using namespace proto;
 
+/* Answer promise with the result of a single read. */
+static void
+ReplyGet(const Reply &reply, Promise *promise)
+{
+    if (reply.has_timestamp()) {
+        promise->Reply(reply.status(), Timestamp(reply.timestamp()),
+                       reply.value());
+    } else {
+        promise->Reply(reply.status(), reply.value());
+    }
+}
+
 ShardClient::ShardClient(const string &configPath,
                        Transport *transport, uint64_t client_id, int
                        shard, int closestReplica)
-    : client_id(client_id), transport(transport), shard(shard)
+    : client_id(client_id), transport(transport), shard(shard),
+      lastReqId(0)
 {
     ifstream configStream(configPath);
     if (configStream.fail()) {
         Panic("Unable to read configuration file: %s\n", configPath.c_str());
     }
 
-    transport::Configuration config(configStream);
-    this->config = &config;
+    // TapirDecide needs the configuration for as long as we live.
+    config = new transport::Configuration(configStream);
 
-    client = new replication::ir::IRClient(config, transport, client_id);
+    client = new replication::ir::IRClient(*config, transport, client_id);
 
     if (closestReplica == -1) {
-        replica = client_id % config.n;
+        replica = client_id % config->n;
     } else {
         replica = closestReplica;
     }
     Debug("Sending unlogged to replica %i", replica);
-
-    waiting = NULL;
-    blockingBegin = NULL;
 }
 
 ShardClient::~ShardClient()
 {
     delete client;
+    delete config;
 }
 
 void
@@ -72,12 +83,48 @@ ShardClient::Begin(uint64_t id)
 {
     Debug("[shard %i] BEGIN: %lu", shard, id);
 
-    // Wait for any previous pending requests.
-    if (blockingBegin != NULL) {
-        blockingBegin->GetReply();
-        delete blockingBegin;
-        blockingBegin = NULL;
+    // Nothing to wait for: the COMMIT or ABORT of the previous
+    // transaction stays in flight while this one starts reading.
+}
+
+uint64_t
+ShardClient::StartRequest(Promise *promise)
+{
+    uint64_t reqId = ++lastReqId;
+    pendingReqs[reqId] = promise;
+    return reqId;
+}
+
+bool
+ShardClient::FinishRequest(uint64_t reqId, Promise *&promise)
+{
+    auto it = pendingReqs.find(reqId);
+    if (it == pendingReqs.end()) {
+        return false;
+    }
+    promise = it->second;
+    pendingReqs.erase(it);
+    return true;
+}
+
+uint64_t
+ShardClient::StartRequest(const vector<Promise *> &promises)
+{
+    uint64_t reqId = ++lastReqId;
+    pendingMultiGets[reqId] = promises;
+    return reqId;
+}
+
+bool
+ShardClient::FinishRequest(uint64_t reqId, vector<Promise *> &promises)
+{
+    auto it = pendingMultiGets.find(reqId);
+    if (it == pendingMultiGets.end()) {
+        return false;
     }
+    promises = std::move(it->second);
+    pendingMultiGets.erase(it);
+    return true;
 }
 
 void
@@ -98,15 +145,15 @@ ShardClient::Get(uint64_t id, const string &key, Promise *promise)
     int timeout = (promise != NULL) ? promise->GetTimeout() : 1000;
 
     transport->Timer(0, [=]() {
-	    waiting = promise;
+        uint64_t reqId = StartRequest(promise);
         client->InvokeUnlogged(replica,
                                request_str,
                                bind(&ShardClient::GetCallback,
-                                    this,
+                                    this, reqId,
                                     placeholders::_1,
                                     placeholders::_2),
                                bind(&ShardClient::GetTimeout,
-                                    this),
+                                    this, reqId),
                                timeout); // timeout in ms
     });
 }
@@ -131,14 +178,49 @@ ShardClient::Get(uint64_t id, const string &key,
     int timeout = (promise != NULL) ? promise->GetTimeout() : 1000;
 
     transport->Timer(0, [=]() {
-	    waiting = promise;
+        uint64_t reqId = StartRequest(promise);
+        client->InvokeUnlogged(
+            replica,
+            request_str,
+            bind(&ShardClient::GetCallback, this, reqId,
+                placeholders::_1,
+                placeholders::_2),
+            bind(&ShardClient::GetTimeout, this, reqId),
+            timeout); // timeout in ms
+    });
+}
+
+void
+ShardClient::MultiGet(uint64_t id, const vector<string> &keys,
+                      const vector<Promise *> &promises)
+{
+    // Send all the GETs to the shard in one request.
+    Debug("[shard %i] Sending MULTI_GET [%lu : %lu keys]", shard, id,
+          keys.size());
+
+    // create request
+    string request_str;
+    Request request;
+    request.set_op(Request::MULTI_GET);
+    request.set_txnid(id);
+    for (const string &key : keys) {
+        request.mutable_multiget()->add_get()->set_key(key);
+    }
+    request.SerializeToString(&request_str);
+
+    // set to 1 second by default
+    int timeout = (!promises.empty() && promises.front() != NULL) ?
+        promises.front()->GetTimeout() : 1000;
+
+    transport->Timer(0, [=]() {
+        uint64_t reqId = StartRequest(promises);
         client->InvokeUnlogged(
             replica,
             request_str,
-            bind(&ShardClient::GetCallback, this,
+            bind(&ShardClient::MultiGetCallback, this, reqId,
                 placeholders::_1,
                 placeholders::_2),
-            bind(&ShardClient::GetTimeout, this),
+            bind(&ShardClient::MultiGetTimeout, this, reqId),
             timeout); // timeout in ms
     });
 }
@@ -169,12 +251,40 @@ ShardClient::Prepare(uint64_t id, const Transaction &txn,
     request.SerializeToString(&request_str);
 
     transport->Timer(0, [=]() {
-        waiting = promise;
+        uint64_t reqId = StartRequest(promise);
+        client->InvokeConsensus(
+            request_str,
+            bind(&ShardClient::TapirDecide, this,
+                placeholders::_1),
+            bind(&ShardClient::PrepareCallback, this, reqId,
+                placeholders::_1,
+                placeholders::_2));
+    });
+}
+
+void
+ShardClient::Validate(uint64_t id, const Transaction &txn,
+                      const Timestamp &timestamp, Promise *promise)
+{
+    Debug("[shard %i] Sending VALIDATE [%lu]", shard, id);
+
+    // create validate request
+    string request_str;
+    Request request;
+    request.set_op(Request::VALIDATE);
+    request.set_txnid(id);
+    txn.serialize(request.mutable_validate()->mutable_txn());
+    timestamp.serialize(request.mutable_validate()->mutable_timestamp());
+    request.SerializeToString(&request_str);
+
+    // A validation is decided and answered just like a prepare.
+    transport->Timer(0, [=]() {
+        uint64_t reqId = StartRequest(promise);
         client->InvokeConsensus(
             request_str,
             bind(&ShardClient::TapirDecide, this,
                 placeholders::_1),
-            bind(&ShardClient::PrepareCallback, this,
+            bind(&ShardClient::PrepareCallback, this, reqId,
                 placeholders::_1,
                 placeholders::_2));
     });
@@ -233,12 +343,11 @@ ShardClient::Commit(uint64_t id, const Transaction &txn,
     request.mutable_commit()->set_timestamp(timestamp);
     request.SerializeToString(&request_str);
 
-    blockingBegin = new Promise(COMMIT_TIMEOUT);
     transport->Timer(0, [=]() {
-        waiting = promise;
+        uint64_t reqId = StartRequest(promise);
         client->InvokeInconsistent(
             request_str,
-            bind(&ShardClient::CommitCallback, this,
+            bind(&ShardClient::CommitCallback, this, reqId,
                 placeholders::_1,
                 placeholders::_2));
     });
@@ -257,59 +366,95 @@ ShardClient::Abort(uint64_t id, const Transaction &txn, Promise *promise)
     txn.serialize(request.mutable_abort()->mutable_txn());
     request.SerializeToString(&request_str);
 
-    blockingBegin = new Promise(ABORT_TIMEOUT);
     transport->Timer(0, [=]() {
-	    waiting = promise;
-	    client->InvokeInconsistent(
+        uint64_t reqId = StartRequest(promise);
+        client->InvokeInconsistent(
             request_str,
-            bind(&ShardClient::AbortCallback, this,
+            bind(&ShardClient::AbortCallback, this, reqId,
                 placeholders::_1,
                 placeholders::_2));
     });
 }
 
 void
-ShardClient::GetTimeout()
+ShardClient::GetTimeout(uint64_t reqId)
 {
-    if (waiting != NULL) {
-        Promise *w = waiting;
-        waiting = NULL;
+    Promise *w;
+    if (FinishRequest(reqId, w) && w != NULL) {
         w->Reply(REPLY_TIMEOUT);
     }
 }
 
+void
+ShardClient::MultiGetTimeout(uint64_t reqId)
+{
+    vector<Promise *> promises;
+    if (!FinishRequest(reqId, promises)) {
+        return;
+    }
+
+    for (Promise *w : promises) {
+        if (w != NULL) {
+            w->Reply(REPLY_TIMEOUT);
+        }
+    }
+}
+
 /* Callback from a shard replica on get operation completion. */
 void
-ShardClient::GetCallback(const string &request_str, const string &reply_str)
+ShardClient::GetCallback(uint64_t reqId, const string &request_str,
+                         const string &reply_str)
 {
     /* Replies back from a shard. */
     Reply reply;
     reply.ParseFromString(reply_str);
 
     Debug("[shard %lu:%i] GET callback [%d]", client_id, shard, reply.status());
-    if (waiting != NULL) {
-        Promise *w = waiting;
-        waiting = NULL;
-        if (reply.has_timestamp()) {
-            w->Reply(reply.status(), Timestamp(reply.timestamp()), reply.value());
+    Promise *w;
+    if (FinishRequest(reqId, w) && w != NULL) {
+        ReplyGet(reply, w);
+    }
+}
+
+/* Callback from a shard replica on multi-get operation completion. */
+void
+ShardClient::MultiGetCallback(uint64_t reqId, const string &request_str,
+                              const string &reply_str)
+{
+    Reply reply;
+    reply.ParseFromString(reply_str);
+
+    Debug("[shard %lu:%i] MULTI_GET callback [%d keys]", client_id, shard,
+          reply.multiget_size());
+    vector<Promise *> promises;
+    if (!FinishRequest(reqId, promises)) {
+        return;
+    }
+
+    for (size_t i = 0; i < promises.size(); i++) {
+        if (promises[i] == NULL) {
+            continue;
+        }
+        if (i < (size_t)reply.multiget_size()) {
+            ReplyGet(reply.multiget(i), promises[i]);
         } else {
-            w->Reply(reply.status(), reply.value());
+            promises[i]->Reply(REPLY_FAIL);
         }
     }
 }
 
 /* Callback from a shard replica on prepare operation completion. */
 void
-ShardClient::PrepareCallback(const string &request_str, const string &reply_str)
+ShardClient::PrepareCallback(uint64_t reqId, const string &request_str,
+                             const string &reply_str)
 {
     Reply reply;
 
     reply.ParseFromString(reply_str);
     Debug("[shard %lu:%i] PREPARE callback [%d]", client_id, shard, reply.status());
 
-    if (waiting != NULL) {
-        Promise *w = waiting;
-        waiting = NULL;
+    Promise *w;
+    if (FinishRequest(reqId, w) && w != NULL) {
         if (reply.has_timestamp()) {
             w->Reply(reply.status(), Timestamp(reply.timestamp()));
         } else {
@@ -320,30 +465,26 @@ ShardClient::PrepareCallback(const string &request_str, const string &reply_str)
 
 /* Callback from a shard replica on commit operation completion. */
 void
-ShardClient::CommitCallback(const string &request_str, const string &reply_str)
+ShardClient::CommitCallback(uint64_t reqId, const string &request_str,
+                            const string &reply_str)
 {
     // COMMITs always succeed.
-
-    ASSERT(blockingBegin != NULL);
-    blockingBegin->Reply(0);
-
-    if (waiting != NULL) {
-        waiting = NULL;
+    Promise *w;
+    if (FinishRequest(reqId, w) && w != NULL) {
+        w->Reply(REPLY_OK);
     }
     Debug("[shard %lu:%i] COMMIT callback", client_id, shard);
 }
 
 /* Callback from a shard replica on abort operation completion. */
 void
-ShardClient::AbortCallback(const string &request_str, const string &reply_str)
+ShardClient::AbortCallback(uint64_t reqId, const string &request_str,
+                           const string &reply_str)
 {
     // ABORTs always succeed.
-
-    ASSERT(blockingBegin != NULL);
-    blockingBegin->Reply(0);
-
-    if (waiting != NULL) {
-        waiting = NULL;
+    Promise *w;
+    if (FinishRequest(reqId, w) && w != NULL) {
+        w->Reply(REPLY_OK);
     }
     Debug("[shard %lu:%i] ABORT callback", client_id, shard);
 }
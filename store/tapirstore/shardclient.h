@@ -44,6 +44,7 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
 
 namespace tapirstore {
 
@@ -67,6 +68,9 @@ public:
             const std::string &key,
             const Timestamp &timestamp,
             Promise *promise = NULL);
+    void MultiGet(uint64_t id,
+                  const std::vector<std::string> &keys,
+                  const std::vector<Promise *> &promises);
     void Put(uint64_t id,
 	     const std::string &key,
 	     const std::string &value,
@@ -75,6 +79,10 @@ public:
                  const Transaction &txn,
                  const Timestamp &timestamp = Timestamp(),
                  Promise *promise = NULL);
+    void Validate(uint64_t id,
+                  const Transaction &txn,
+                  const Timestamp &timestamp,
+                  Promise *promise = NULL);
     void Commit(uint64_t id,
                 const Transaction &txn,
                 uint64_t timestamp,
@@ -91,27 +99,34 @@ private:
     int replica; // which replica to use for reads
 
     replication::ir::IRClient *client; // Client proxy.
-    Promise *waiting; // waiting thread
-    Promise *blockingBegin; // block until finished
+
+    /* Operations in flight and the promises (possibly NULL) waiting for
+     * them, by request id. Only accessed on the transport thread. */
+    uint64_t lastReqId;
+    std::unordered_map<uint64_t, Promise *> pendingReqs;
+    std::unordered_map<uint64_t, std::vector<Promise *>> pendingMultiGets;
 
     /* Tapir's Decide Function. */
     std::string TapirDecide(const std::map<std::string, std::size_t> &results);
 
     /* Timeout for Get requests, which only go to one replica. */
-    void GetTimeout();
+    void GetTimeout(uint64_t reqId);
+    void MultiGetTimeout(uint64_t reqId);
 
     /* Callbacks for hearing back from a shard for an operation. */
-    void GetCallback(const std::string &, const std::string &);
-    void PrepareCallback(const std::string &, const std::string &);
-    void CommitCallback(const std::string &, const std::string &);
-    void AbortCallback(const std::string &, const std::string &);
+    void GetCallback(uint64_t reqId, const std::string &, const std::string &);
+    void MultiGetCallback(uint64_t reqId, const std::string &,
+                          const std::string &);
+    void PrepareCallback(uint64_t reqId, const std::string &, const std::string &);
+    void CommitCallback(uint64_t reqId, const std::string &, const std::string &);
+    void AbortCallback(uint64_t reqId, const std::string &, const std::string &);
 
-    /* Helper Functions for starting and finishing requests */
-    void StartRequest();
-    void WaitForResponse();
-    void FinishRequest(const std::string &reply_str);
-    void FinishRequest();
-    int SendGet(const std::string &request_str);
+    /* Helper functions for starting and finishing requests. A MULTI_GET
+     * takes an id from the same sequence for its batch of promises. */
+    uint64_t StartRequest(Promise *promise);
+    uint64_t StartRequest(const std::vector<Promise *> &promises);
+    bool FinishRequest(uint64_t reqId, Promise *&promise);
+    bool FinishRequest(uint64_t reqId, std::vector<Promise *> &promises);
 };
 
 } // namespace tapirstore
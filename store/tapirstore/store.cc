@@ -35,6 +35,8 @@ namespace tapirstore {
 
 using namespace std;
 
+static const char SNAPSHOT_MAGIC[] = "tapirstore snapshot 2";
+
 Store::Store(bool linearizable) : linearizable(linearizable), store() { }
 
 Store::~Store() { }
@@ -71,6 +73,11 @@ Store::Prepare(uint64_t id, const Transaction &txn, const Timestamp &timestamp,
 {   
     Debug("[%lu] START PREPARE", id);
 
+    if (aborted.find(id) != aborted.end()) {
+        Debug("[%lu] ABORT already aborted", id);
+        return REPLY_FAIL;
+    }
+
     if (prepared.find(id) != prepared.end()) {
         if (prepared[id].first == timestamp) {
             Warning("[%lu] Already Prepared!", id);
@@ -88,53 +95,9 @@ Store::Prepare(uint64_t id, const Transaction &txn, const Timestamp &timestamp,
     GetPreparedReads(pReads);
 
     // check for conflicts with the read set
-    for (auto &read : txn.getReadSet()) {
-        pair<Timestamp, Timestamp> range;
-        bool ret = store.getRange(read.first, read.second, range);
-
-        // if we don't have this key then no conflicts for read
-        if (!ret) continue;
-
-        // if we don't have this version then no conflicts for read
-        if (range.first != read.second) continue;
-
-        // if the value is still valid
-        if (!range.second.isValid()) {
-            // check pending writes.
-            if ( pWrites.find(read.first) != pWrites.end() && 
-                 (linearizable || 
-                  pWrites[read.first].upper_bound(timestamp) != pWrites[read.first].begin()) ) {
-                Debug("[%lu] ABSTAIN rw conflict w/ prepared key:%s",
-                      id, read.first.c_str());
-                return REPLY_ABSTAIN;
-            }
-
-        } else if (linearizable || timestamp > range.second) {
-            /* if value is not still valid, if we are running linearizable, then abort.
-             *  Else check validity range. if
-             * proposed timestamp not within validity range, then
-             * conflict and abort
-             */
-            ASSERT(timestamp > range.first);
-            Debug("[%lu] ABORT rw conflict key:%s",
-                  id, read.first.c_str());
-            return REPLY_FAIL;
-        } else {
-            /* there may be a pending write in the past.  check
-             * pending writes again.  If proposed transaction is
-             * earlier, abstain
-             */
-            if (pWrites.find(read.first) != pWrites.end()) {
-                for (auto &writeTime : pWrites[read.first]) {
-                    if (writeTime > range.first && 
-                        writeTime < timestamp) {
-                        Debug("[%lu] ABSTAIN rw conflict w/ prepared key:%s",
-                              id, read.first.c_str());
-                        return REPLY_ABSTAIN;
-                    }
-                }
-            }
-        }
+    int status = CheckReadSet(id, txn, timestamp, pWrites);
+    if (status != REPLY_OK) {
+        return status;
     }
 
     // check for conflicts with the write set
@@ -207,6 +170,101 @@ Store::Prepare(uint64_t id, const Transaction &txn, const Timestamp &timestamp,
     return REPLY_OK;
 }
     
+int
+Store::Validate(uint64_t id, const Transaction &txn, const Timestamp &timestamp,
+                Timestamp &proposedTimestamp)
+{
+    Debug("[%lu] START VALIDATE", id);
+    ASSERT(txn.getWriteSet().empty());
+
+    // We can only serialize the transaction at a timestamp after every
+    // version it read.
+    bool retry = false;
+    for (auto &read : txn.getReadSet()) {
+        if (read.second > timestamp &&
+            (!retry || read.second > proposedTimestamp)) {
+            proposedTimestamp = read.second;
+            retry = true;
+        }
+    }
+    if (retry) {
+        Debug("[%lu] RETRY read version after validation timestamp", id);
+        return REPLY_RETRY;
+    }
+
+    unordered_map<string, set<Timestamp>> pWrites;
+    GetPreparedWrites(pWrites);
+    int status = CheckReadSet(id, txn, timestamp, pWrites);
+    if (status != REPLY_OK) {
+        return status;
+    }
+
+    // The reads are valid at timestamp. Nothing needs to be prepared, but
+    // recording them now makes any later write that would invalidate them
+    // retry at a later timestamp.
+    Commit(timestamp, txn);
+    Debug("[%lu] VALIDATED", id);
+
+    return REPLY_OK;
+}
+
+int
+Store::CheckReadSet(uint64_t id, const Transaction &txn,
+                    const Timestamp &timestamp,
+                    unordered_map<string, set<Timestamp>> &pWrites)
+{
+    for (auto &read : txn.getReadSet()) {
+        pair<Timestamp, Timestamp> range;
+        bool ret = store.getRange(read.first, read.second, range);
+
+        // if we don't have this key then no conflicts for read
+        if (!ret) continue;
+
+        // if we don't have this version then no conflicts for read
+        if (range.first != read.second) continue;
+
+        // if the value is still valid
+        if (!range.second.isValid()) {
+            // check pending writes.
+            if ( pWrites.find(read.first) != pWrites.end() && 
+                 (linearizable || 
+                  pWrites[read.first].upper_bound(timestamp) != pWrites[read.first].begin()) ) {
+                Debug("[%lu] ABSTAIN rw conflict w/ prepared key:%s",
+                      id, read.first.c_str());
+                return REPLY_ABSTAIN;
+            }
+
+        } else if (linearizable || timestamp > range.second) {
+            /* if value is not still valid, if we are running linearizable, then abort.
+             *  Else check validity range. if
+             * proposed timestamp not within validity range, then
+             * conflict and abort
+             */
+            ASSERT(timestamp > range.first);
+            Debug("[%lu] ABORT rw conflict key:%s",
+                  id, read.first.c_str());
+            return REPLY_FAIL;
+        } else {
+            /* there may be a pending write in the past.  check
+             * pending writes again.  If proposed transaction is
+             * earlier, abstain
+             */
+            if (pWrites.find(read.first) != pWrites.end()) {
+                for (auto &writeTime : pWrites[read.first]) {
+                    if (writeTime > range.first && 
+                        writeTime < timestamp) {
+                        Debug("[%lu] ABSTAIN rw conflict w/ prepared key:%s",
+                              id, read.first.c_str());
+                        return REPLY_ABSTAIN;
+                    }
+                }
+            }
+        }
+    }
+
+    return REPLY_OK;
+}
+
 void
 Store::Commit(uint64_t id, uint64_t timestamp)
 {
@@ -249,6 +307,7 @@ Store::Abort(uint64_t id, const Transaction &txn)
     if (prepared.find(id) != prepared.end()) {
         prepared.erase(id);
     }
+    aborted.insert(id);
 }
 
 void
@@ -257,6 +316,72 @@ Store::Load(const string &key, const string &value, const Timestamp &timestamp)
     store.put(key, value, timestamp);
 }
 
+void
+Store::Reserve(size_t nKeys)
+{
+    store.reserve(nKeys);
+}
+
+bool
+Store::Save(const string &path) const
+{
+    return WriteSnapshot(path, [this](SnapshotWriter &out) {
+        out.String(SNAPSHOT_MAGIC);
+        store.save(out);
+        out.U64(prepared.size());
+        for (auto &p : prepared) {
+            TransactionMessage txn;
+            p.second.second.serialize(&txn);
+            out.U64(p.first);
+            out.Time(p.second.first);
+            out.String(txn.SerializeAsString());
+        }
+        out.U64(aborted.size());
+        for (uint64_t id : aborted) {
+            out.U64(id);
+        }
+    });
+}
+
+bool
+Store::Restore(const string &path)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (f == NULL) {
+        return false;
+    }
+    SnapshotReader in(f);
+
+    string magic;
+    uint64_t nPrepared;
+    bool ok = in.String(magic) && magic == SNAPSHOT_MAGIC &&
+        store.restore(in) && in.U64(nPrepared);
+    prepared.clear();
+    for (uint64_t i = 0; ok && i < nPrepared; i++) {
+        uint64_t id;
+        Timestamp timestamp;
+        string data;
+        TransactionMessage txn;
+        ok = in.U64(id) && in.Time(timestamp) && in.String(data) &&
+            txn.ParseFromString(data);
+        if (ok) {
+            prepared[id] = make_pair(timestamp, Transaction(txn));
+        }
+    }
+    uint64_t nAborted;
+    ok = ok && in.U64(nAborted);
+    aborted.clear();
+    for (uint64_t i = 0; ok && i < nAborted; i++) {
+        uint64_t id;
+        ok = in.U64(id);
+        if (ok) {
+            aborted.insert(id);
+        }
+    }
+    fclose(f);
+    return ok;
+}
+
 void
 Store::GetPreparedWrites(unordered_map<string, set<Timestamp>> &writes)
 {
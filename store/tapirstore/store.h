@@ -36,11 +36,13 @@
 #include "lib/message.h"
 #include "store/common/timestamp.h"
 #include "store/common/transaction.h"
+#include "store/common/backend/snapshot.h"
 #include "store/common/backend/txnstore.h"
 #include "store/common/backend/versionstore.h"
 
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace tapirstore {
 
@@ -56,9 +58,18 @@ public:
     int Get(uint64_t id, const std::string &key, std::pair<Timestamp, std::string> &value);
     int Get(uint64_t id, const std::string &key, const Timestamp &timestamp, std::pair<Timestamp, std::string> &value);
     int Prepare(uint64_t id, const Transaction &txn, const Timestamp &timestamp, Timestamp &proposed);
+    // Check that the reads of a read-only transaction are still valid at
+    // timestamp and, if so, commit it at once.
+    int Validate(uint64_t id, const Transaction &txn, const Timestamp &timestamp, Timestamp &proposed);
     void Commit(uint64_t id, uint64_t timestamp = 0);
     void Abort(uint64_t id, const Transaction &txn = Transaction());
     void Load(const std::string &key, const std::string &value, const Timestamp &timestamp);
+    void Reserve(size_t nKeys);
+
+    // Write the versioned data, read markers, and prepared and aborted
+    // transactions to a snapshot at path, or replace them with those of one.
+    bool Save(const std::string &path) const;
+    bool Restore(const std::string &path);
 
 private:
     // Are we running in linearizable (vs serializable) mode?
@@ -69,9 +80,15 @@ private:
 
     // TODO: comment this.
     std::unordered_map<uint64_t, std::pair<Timestamp, Transaction>> prepared;
+
+    // Transactions that have been aborted. A prepare that arrives after
+    // the abort, late or retransmitted, must not leave them prepared.
+    std::unordered_set<uint64_t> aborted;
     
     void GetPreparedWrites(std::unordered_map< std::string, std::set<Timestamp> > &writes);
     void GetPreparedReads(std::unordered_map< std::string, std::set<Timestamp> > &reads);
+    int CheckReadSet(uint64_t id, const Transaction &txn, const Timestamp &timestamp,
+                     std::unordered_map< std::string, std::set<Timestamp> > &pWrites);
     void Commit(const Timestamp &timestamp, const Transaction &txn);
 };
 
@@ -0,0 +1,22 @@
+d := $(dir $(lastword $(MAKEFILE_LIST)))
+
+#
+# gtest-based tests
+#
+GTEST_SRCS += $(addprefix $(d), \
+		store-test.cc server-test.cc shardclient-test.cc \
+		asyncclient-test.cc)
+
+$(d)store-test: $(o)store-test.o $(LIB-transport) $(OBJS-tapir-store) $(GTEST_MAIN)
+
+$(d)server-test: $(o)server-test.o $(OBJS-tapir-server) $(LIB-simtransport) \
+	$(GTEST_MAIN)
+
+$(d)shardclient-test: $(o)shardclient-test.o $(OBJS-tapir-server) \
+	$(OBJS-tapir-client) $(LIB-simtransport) $(GTEST_MAIN)
+
+$(d)asyncclient-test: $(o)asyncclient-test.o $(OBJS-tapir-server) \
+	$(OBJS-tapir-async-client) $(LIB-simtransport) $(GTEST_MAIN)
+
+TEST_BINS += $(d)store-test $(d)server-test $(d)shardclient-test \
+	$(d)asyncclient-test
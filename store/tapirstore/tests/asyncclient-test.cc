@@ -0,0 +1,196 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/tests/asyncclient-test.cc:
+ *   test cases for the asynchronous TAPIR client against simulated
+ *   replicas of two shards
+ *
+ **********************************************************************/
+
+#include "lib/simtransport.h"
+#include "store/common/frontend/client.h"
+#include "store/tapirstore/asyncclient.h"
+#include "store/tapirstore/tests/shard.h"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tapirstore;
+
+static const int NSHARDS = 2;
+static const char *CONFIG_PREFIX = "asyncclient-test-shard";
+
+class AsyncClientTest : public ::testing::Test
+{
+protected:
+    SimulatedTransport transport;
+    std::vector<std::unique_ptr<TestShard>> shards;
+    std::unique_ptr<AsyncClient> client;
+
+    virtual void SetUp() {
+        for (int s = 0; s < NSHARDS; s++) {
+            shards.emplace_back(new TestShard(
+                transport, CONFIG_PREFIX + std::to_string(s) + ".config",
+                12360 + 3 * s, [s](Server &server) {
+                    for (const std::string key : {"a", "b", "c", "d"}) {
+                        if (::Client::key_to_shard(key, NSHARDS) ==
+                            (uint64_t)s) {
+                            server.Load(key, key + "0", Timestamp(10, 1));
+                        }
+                    }
+                }));
+        }
+
+        client = std::unique_ptr<AsyncClient>(
+            new AsyncClient(CONFIG_PREFIX, NSHARDS, 0, &transport));
+    }
+
+    virtual void TearDown() {
+        client.reset();
+        shards.clear();
+    }
+
+    // Run fn after ms of virtual time. Each step of a test gets a slot of
+    // its own, and nothing it sends is held up that long.
+    void At(uint64_t ms, std::function<void ()> fn) {
+        transport.Timer(ms, fn);
+    }
+
+    // Deliver everything sent within ms of virtual time. The simulated
+    // transport can only be run once.
+    void Run(uint64_t ms = 1000) {
+        transport.Timer(ms, [this]() { transport.CancelAllTimers(); });
+        transport.Run();
+    }
+
+    // Read keys into values in a transaction of their own, and commit it.
+    void Read(const std::vector<std::string> &keys,
+              std::vector<std::string> *values) {
+        AsyncClient::Txn *txn = client->Begin();
+        client->Get(txn, keys,
+            [=](int status, const std::vector<std::string> &v) {
+                EXPECT_EQ(REPLY_OK, status);
+                *values = v;
+                client->Commit(txn, [](bool committed) {
+                    EXPECT_TRUE(committed);
+                });
+            });
+    }
+};
+
+TEST_F(AsyncClientTest, GetAcrossShards)
+{
+    // The keys should not all live on one shard.
+    ASSERT_NE(::Client::key_to_shard("a", NSHARDS),
+              ::Client::key_to_shard("b", NSHARDS));
+
+    std::vector<std::string> values;
+    Read({"a", "b", "c", "d"}, &values);
+    Run();
+    EXPECT_EQ(std::vector<std::string>({"a0", "b0", "c0", "d0"}), values);
+}
+
+TEST_F(AsyncClientTest, GetMissingKey)
+{
+    int status = -1;
+    std::vector<std::string> values;
+    AsyncClient::Txn *txn = client->Begin();
+    client->Get(txn, {"a", "missing"},
+        [&](int s, const std::vector<std::string> &v) {
+            status = s;
+            values = v;
+            client->Abort(txn);
+        });
+    Run();
+
+    EXPECT_EQ(REPLY_FAIL, status);
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ("a0", values[0]);
+}
+
+TEST_F(AsyncClientTest, ReadOwnWrites)
+{
+    bool done = false;
+    AsyncClient::Txn *txn = client->Begin();
+    client->Put(txn, "a", "a1");
+    client->Get(txn, {"a", "b"},
+        [&](int status, const std::vector<std::string> &values) {
+            EXPECT_EQ(REPLY_OK, status);
+            EXPECT_EQ(std::vector<std::string>({"a1", "b0"}), values);
+            done = true;
+            client->Abort(txn);
+        });
+
+    // The aborted write is not visible.
+    std::vector<std::string> after;
+    At(100, [&]() { Read({"a"}, &after); });
+    Run();
+
+    EXPECT_TRUE(done);
+    EXPECT_EQ(std::vector<std::string>({"a0"}), after);
+}
+
+TEST_F(AsyncClientTest, CommitWrites)
+{
+    int outcome = -1;
+    AsyncClient::Txn *txn = client->Begin();
+    client->Get(txn, {"a"},
+        [&](int status, const std::vector<std::string> &values) {
+            EXPECT_EQ(REPLY_OK, status);
+            client->Put(txn, "a", "a1");
+            client->Put(txn, "b", "b1");
+            client->Commit(txn, [&](bool committed) {
+                outcome = committed;
+            });
+        });
+
+    std::vector<std::string> after;
+    At(100, [&]() { Read({"a", "b"}, &after); });
+    Run();
+
+    EXPECT_EQ(1, outcome);
+    EXPECT_EQ(std::vector<std::string>({"a1", "b1"}), after);
+}
+
+TEST_F(AsyncClientTest, StaleReadAborts)
+{
+    // txn1 reads a, then txn2 overwrites it and commits first.
+    AsyncClient::Txn *txn1 = client->Begin();
+    client->Get(txn1, {"a"},
+        [](int status, const std::vector<std::string> &values) {
+            EXPECT_EQ(REPLY_OK, status);
+        });
+
+    int outcome2 = -1;
+    At(100, [&]() {
+        AsyncClient::Txn *txn2 = client->Begin();
+        client->Put(txn2, "a", "a2");
+        client->Commit(txn2, [&](bool committed) { outcome2 = committed; });
+    });
+
+    int outcome1 = -1;
+    At(200, [&]() {
+        client->Put(txn1, "a", "a1");
+        client->Commit(txn1, [&](bool committed) { outcome1 = committed; });
+    });
+
+    std::vector<std::string> after;
+    At(300, [&]() { Read({"a"}, &after); });
+    Run();
+
+    EXPECT_EQ(1, outcome2);
+    EXPECT_EQ(0, outcome1);
+    EXPECT_EQ(std::vector<std::string>({"a2"}), after);
+}
+
+TEST_F(AsyncClientTest, EmptyTransactionCommits)
+{
+    int outcome = -1;
+    AsyncClient::Txn *txn = client->Begin();
+    client->Commit(txn, [&](bool committed) { outcome = committed; });
+    EXPECT_EQ(1, outcome);
+}
@@ -0,0 +1,72 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/tests/server-test.cc:
+ *   test cases for the TAPIR server's request handling
+ *
+ **********************************************************************/
+
+#include "store/tapirstore/server.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace tapirstore;
+using namespace tapirstore::proto;
+
+TEST(Server, MultiGetWithMissingKeys)
+{
+    Server server(true);
+    server.Load("a", "1", Timestamp(10, 1));
+    server.Load("b", "2", Timestamp(10, 1));
+    server.Load("b", "3", Timestamp(20, 1));
+
+    Request request;
+    request.set_op(Request::MULTI_GET);
+    request.set_txnid(1);
+    request.mutable_multiget()->add_get()->set_key("a");
+    request.mutable_multiget()->add_get()->set_key("missing");
+    GetMessage *get = request.mutable_multiget()->add_get();
+    get->set_key("b");
+    Timestamp(15, 1).serialize(get->mutable_timestamp());
+
+    std::string request_str, reply_str;
+    request.SerializeToString(&request_str);
+    server.UnloggedUpcall(request_str, reply_str);
+
+    Reply reply;
+    ASSERT_TRUE(reply.ParseFromString(reply_str));
+    EXPECT_EQ(REPLY_OK, reply.status());
+    ASSERT_EQ(3, reply.multiget_size());
+
+    EXPECT_EQ(REPLY_OK, reply.multiget(0).status());
+    EXPECT_EQ("1", reply.multiget(0).value());
+    EXPECT_EQ(Timestamp(10, 1), Timestamp(reply.multiget(0).timestamp()));
+
+    EXPECT_EQ(REPLY_FAIL, reply.multiget(1).status());
+    EXPECT_FALSE(reply.multiget(1).has_value());
+
+    // A read at a timestamp sees the version as of then.
+    EXPECT_EQ(REPLY_OK, reply.multiget(2).status());
+    EXPECT_EQ("2", reply.multiget(2).value());
+}
+
+TEST(Server, EmptyMultiGet)
+{
+    Server server(true);
+
+    Request request;
+    request.set_op(Request::MULTI_GET);
+    request.set_txnid(1);
+    request.mutable_multiget();
+
+    std::string request_str, reply_str;
+    request.SerializeToString(&request_str);
+    server.UnloggedUpcall(request_str, reply_str);
+
+    Reply reply;
+    ASSERT_TRUE(reply.ParseFromString(reply_str));
+    EXPECT_EQ(REPLY_OK, reply.status());
+    EXPECT_EQ(0, reply.multiget_size());
+}
@@ -0,0 +1,78 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/tests/shard.h:
+ *   a shard of TAPIR replicas on the simulated transport, for tests
+ *
+ **********************************************************************/
+
+#ifndef _TAPIR_TESTS_SHARD_H_
+#define _TAPIR_TESTS_SHARD_H_
+
+#include "lib/configuration.h"
+#include "lib/simtransport.h"
+#include "replication/ir/replica.h"
+#include "store/tapirstore/server.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tapirstore {
+
+// Three replicas on consecutive ports from firstPort, each running a
+// linearizable server that load fills in. The configuration is also
+// written to configPath, where clients expect to find it. Destroying
+// the shard removes that file and the replicas' record files.
+class TestShard
+{
+public:
+    TestShard(SimulatedTransport &transport, const std::string &configPath,
+              int firstPort, std::function<void (Server &)> load)
+        : configPath(configPath) {
+        std::ofstream configStream(configPath);
+        configStream << "f 1\n";
+        for (int i = 0; i < 3; i++) {
+            transport::ReplicaAddress addr(
+                "localhost", std::to_string(firstPort + i));
+            replicaAddrs.push_back(addr);
+            configStream << "replica " << addr.host << ":" << addr.port
+                         << "\n";
+        }
+        configStream.close();
+        config = std::unique_ptr<transport::Configuration>(
+            new transport::Configuration(3, 1, replicaAddrs));
+
+        for (int i = 0; i < config->n; i++) {
+            servers.emplace_back(new Server(true));
+            load(*servers.back());
+            replicas.emplace_back(new replication::ir::IRReplica(
+                *config, i, &transport, servers.back().get()));
+        }
+    }
+
+    ~TestShard() {
+        replicas.clear();
+        for (std::size_t i = 0; i < replicaAddrs.size(); ++i) {
+            const transport::ReplicaAddress &addr = replicaAddrs[i];
+            const std::string filename =
+                addr.host + ":" + addr.port + "_" + std::to_string(i) + ".bin";
+            std::remove(filename.c_str());
+        }
+        std::remove(configPath.c_str());
+    }
+
+private:
+    std::string configPath;
+    std::vector<transport::ReplicaAddress> replicaAddrs;
+    std::unique_ptr<transport::Configuration> config;
+    std::vector<std::unique_ptr<Server>> servers;
+    std::vector<std::unique_ptr<replication::ir::IRReplica>> replicas;
+};
+
+} // namespace tapirstore
+
+#endif /* _TAPIR_TESTS_SHARD_H_ */
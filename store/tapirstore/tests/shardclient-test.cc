@@ -0,0 +1,169 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/tests/shardclient-test.cc:
+ *   test cases for the TAPIR shard client against simulated replicas
+ *
+ **********************************************************************/
+
+#include "lib/simtransport.h"
+#include "store/common/promise.h"
+#include "store/tapirstore/shardclient.h"
+#include "store/tapirstore/tests/shard.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using google::protobuf::Message;
+using namespace tapirstore;
+
+static const char *CONFIG_PATH = "shardclient-test.config";
+
+class ShardClientTest : public ::testing::Test
+{
+protected:
+    struct Answer
+    {
+        std::string key;
+        int status;
+        std::string value;
+    };
+
+    SimulatedTransport transport;
+    std::unique_ptr<TestShard> shard;
+    std::unique_ptr<ShardClient> client;
+    // Answers in the order the client delivered them.
+    std::vector<Answer> answers;
+
+    virtual void SetUp() {
+        shard = std::unique_ptr<TestShard>(new TestShard(
+            transport, CONFIG_PATH, 12355, [](Server &server) {
+                server.Load("a", "1", Timestamp(10, 1));
+                server.Load("b", "2", Timestamp(10, 1));
+            }));
+
+        client = std::unique_ptr<ShardClient>(
+            new ShardClient(CONFIG_PATH, &transport, 1, 0, 0));
+        client->Begin(1);
+    }
+
+    virtual void TearDown() {
+        client.reset();
+        shard.reset();
+    }
+
+    // A promise that records its answer for key and then deletes itself.
+    Promise *Expect(const std::string &key) {
+        return new Promise(1000, [this, key](Promise *promise) {
+            answers.push_back({key, promise->GetReply(),
+                               promise->GetValue()});
+            delete promise;
+        });
+    }
+
+    // Deliver everything sent within ms of virtual time.
+    void Run(uint64_t ms) {
+        transport.Timer(ms, [this]() { transport.CancelAllTimers(); });
+        transport.Run();
+    }
+};
+
+TEST_F(ShardClientTest, OverlappingGetsAnsweredOutOfOrder)
+{
+    // Hold back the first reply to the client, so the second GET is
+    // answered before the first.
+    bool delayed = false;
+    transport.AddFilter(1, [&](TransportReceiver *src, int srcIdx,
+                               TransportReceiver *dst, int dstIdx,
+                               Message &m, uint64_t &delay) {
+        if (dstIdx == -1 && !delayed) {
+            delayed = true;
+            delay = 10;
+        }
+        return true;
+    });
+
+    client->Get(1, "a", Expect("a"));
+    client->Get(1, "b", Expect("b"));
+    Run(100);
+
+    ASSERT_EQ(2u, answers.size());
+    EXPECT_EQ("b", answers[0].key);
+    EXPECT_EQ(REPLY_OK, answers[0].status);
+    EXPECT_EQ("2", answers[0].value);
+    EXPECT_EQ("a", answers[1].key);
+    EXPECT_EQ(REPLY_OK, answers[1].status);
+    EXPECT_EQ("1", answers[1].value);
+}
+
+TEST_F(ShardClientTest, LostGetTimesOut)
+{
+    // Drop the first reply; only its own GET times out.
+    bool dropped = false;
+    transport.AddFilter(1, [&](TransportReceiver *src, int srcIdx,
+                               TransportReceiver *dst, int dstIdx,
+                               Message &m, uint64_t &delay) {
+        if (dstIdx == -1 && !dropped) {
+            dropped = true;
+            return false;
+        }
+        return true;
+    });
+
+    client->Get(1, "a", Expect("a"));
+    client->Get(1, "b", Expect("b"));
+    Run(2000);
+
+    ASSERT_EQ(2u, answers.size());
+    EXPECT_EQ("b", answers[0].key);
+    EXPECT_EQ(REPLY_OK, answers[0].status);
+    EXPECT_EQ("a", answers[1].key);
+    EXPECT_EQ(REPLY_TIMEOUT, answers[1].status);
+}
+
+TEST_F(ShardClientTest, MultiGetWithMissingKeys)
+{
+    client->MultiGet(1, {"a", "missing", "b"},
+                     {Expect("a"), Expect("missing"), Expect("b")});
+    Run(100);
+
+    ASSERT_EQ(3u, answers.size());
+    EXPECT_EQ("a", answers[0].key);
+    EXPECT_EQ(REPLY_OK, answers[0].status);
+    EXPECT_EQ("1", answers[0].value);
+    EXPECT_EQ("missing", answers[1].key);
+    EXPECT_EQ(REPLY_FAIL, answers[1].status);
+    EXPECT_EQ("b", answers[2].key);
+    EXPECT_EQ(REPLY_OK, answers[2].status);
+    EXPECT_EQ("2", answers[2].value);
+}
+
+TEST_F(ShardClientTest, LostMultiGetTimesOut)
+{
+    // Drop the MULTI_GET's reply; a GET alongside it is unaffected.
+    bool dropped = false;
+    transport.AddFilter(1, [&](TransportReceiver *src, int srcIdx,
+                               TransportReceiver *dst, int dstIdx,
+                               Message &m, uint64_t &delay) {
+        if (dstIdx == -1 && !dropped) {
+            dropped = true;
+            return false;
+        }
+        return true;
+    });
+
+    client->MultiGet(1, {"a", "b"}, {Expect("a"), Expect("b")});
+    client->Get(1, "b", Expect("get"));
+    Run(2000);
+
+    ASSERT_EQ(3u, answers.size());
+    EXPECT_EQ("get", answers[0].key);
+    EXPECT_EQ(REPLY_OK, answers[0].status);
+    EXPECT_EQ("a", answers[1].key);
+    EXPECT_EQ(REPLY_TIMEOUT, answers[1].status);
+    EXPECT_EQ("b", answers[2].key);
+    EXPECT_EQ(REPLY_TIMEOUT, answers[2].status);
+}
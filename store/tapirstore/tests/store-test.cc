@@ -0,0 +1,165 @@
+// -*- mode: c++; c-file-style: "k&r"; c-basic-offset: 4 -*-
+/***********************************************************************
+ *
+ * store/tapirstore/tests/store-test.cc:
+ *   test cases for the TAPIR transactional store
+ *
+ **********************************************************************/
+
+#include "store/tapirstore/store.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace tapirstore;
+
+TEST(Store, ValidateReadOnly)
+{
+    Store store(true);
+    store.Load("a", "1", Timestamp(10, 1));
+    store.Load("b", "2", Timestamp(10, 1));
+
+    Transaction txn;
+    txn.addReadSet("a", Timestamp(10, 1));
+    txn.addReadSet("b", Timestamp(10, 1));
+
+    Timestamp proposed;
+    EXPECT_EQ(REPLY_OK, store.Validate(1, txn, Timestamp(20, 1), proposed));
+    EXPECT_FALSE(proposed.isValid());
+
+    // The validated reads hold off writes before their timestamp.
+    Transaction write;
+    write.addWriteSet("a", "3");
+    EXPECT_EQ(REPLY_RETRY, store.Prepare(2, write, Timestamp(15, 1), proposed));
+    EXPECT_EQ(Timestamp(20, 1), proposed);
+}
+
+TEST(Store, ValidateStaleRead)
+{
+    Store store(true);
+    store.Load("a", "1", Timestamp(10, 1));
+    store.Load("a", "2", Timestamp(12, 1));
+
+    Transaction txn;
+    txn.addReadSet("a", Timestamp(10, 1));
+
+    Timestamp proposed;
+    EXPECT_EQ(REPLY_FAIL, store.Validate(1, txn, Timestamp(20, 1), proposed));
+}
+
+TEST(Store, ValidatePreparedWrite)
+{
+    Store store(true);
+    store.Load("a", "1", Timestamp(10, 1));
+
+    Transaction write;
+    write.addWriteSet("a", "2");
+    Timestamp proposed;
+    EXPECT_EQ(REPLY_OK, store.Prepare(1, write, Timestamp(15, 1), proposed));
+
+    Transaction txn;
+    txn.addReadSet("a", Timestamp(10, 1));
+    EXPECT_EQ(REPLY_ABSTAIN, store.Validate(2, txn, Timestamp(20, 1), proposed));
+}
+
+TEST(Store, ValidateBeforeReadVersion)
+{
+    Store store(true);
+    store.Load("a", "1", Timestamp(30, 1));
+
+    Transaction txn;
+    txn.addReadSet("a", Timestamp(30, 1));
+
+    Timestamp proposed;
+    EXPECT_EQ(REPLY_RETRY, store.Validate(1, txn, Timestamp(20, 1), proposed));
+    EXPECT_EQ(Timestamp(30, 1), proposed);
+}
+
+TEST(Store, PrepareAfterAbort)
+{
+    Store store(true);
+    store.Load("a", "1", Timestamp(10, 1));
+
+    // The abort overtakes the prepare, which then must not hold a.
+    Transaction write;
+    write.addWriteSet("a", "2");
+    Timestamp proposed;
+    store.Abort(1, write);
+    EXPECT_EQ(REPLY_FAIL, store.Prepare(1, write, Timestamp(15, 1), proposed));
+
+    Transaction other;
+    other.addWriteSet("a", "3");
+    EXPECT_EQ(REPLY_OK, store.Prepare(2, other, Timestamp(16, 1), proposed));
+}
+
+TEST(Store, SnapshotRestore)
+{
+    char path[] = "/tmp/store-test-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    Store store(true);
+    store.Load("a", "1", Timestamp(10, 1));
+    store.Load("a", "2", Timestamp(12, 1));
+    store.Load("b", "3", Timestamp(10, 1));
+
+    // A committed read of b, and a prepared write of a.
+    Transaction txn;
+    txn.addReadSet("b", Timestamp(10, 1));
+    Timestamp proposed;
+    ASSERT_EQ(REPLY_OK, store.Validate(1, txn, Timestamp(20, 1), proposed));
+    Transaction write;
+    write.addWriteSet("a", "4");
+    ASSERT_EQ(REPLY_OK, store.Prepare(2, write, Timestamp(25, 1), proposed));
+    store.Abort(7);
+
+    ASSERT_TRUE(store.Save(path));
+    Store restored(true);
+    ASSERT_TRUE(restored.Restore(path));
+    unlink(path);
+
+    std::pair<Timestamp, std::string> value;
+    ASSERT_EQ(REPLY_OK, restored.Get(3, "a", value));
+    EXPECT_EQ("2", value.second);
+    EXPECT_EQ(Timestamp(12, 1), value.first);
+    ASSERT_EQ(REPLY_OK, restored.Get(3, "a", Timestamp(11, 1), value));
+    EXPECT_EQ("1", value.second);
+
+    // The read marker still holds off earlier writes to b.
+    Transaction writeB;
+    writeB.addWriteSet("b", "5");
+    EXPECT_EQ(REPLY_RETRY,
+              restored.Prepare(4, writeB, Timestamp(15, 1), proposed));
+    EXPECT_EQ(Timestamp(20, 1), proposed);
+
+    // The aborted transaction stays aborted.
+    Transaction writeC;
+    writeC.addWriteSet("c", "6");
+    EXPECT_EQ(REPLY_FAIL,
+              restored.Prepare(7, writeC, Timestamp(26, 1), proposed));
+
+    // The prepared write still conflicts, and still commits.
+    Transaction readA;
+    readA.addReadSet("a", Timestamp(12, 1));
+    EXPECT_EQ(REPLY_ABSTAIN,
+              restored.Validate(5, readA, Timestamp(30, 1), proposed));
+    restored.Commit(2, 25);
+    ASSERT_EQ(REPLY_OK, restored.Get(6, "a", value));
+    EXPECT_EQ("4", value.second);
+}
+
+TEST(Store, RestoreRejectsGarbage)
+{
+    char path[] = "/tmp/store-test-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(9, write(fd, "not a snp", 9));
+    close(fd);
+
+    Store store(true);
+    EXPECT_FALSE(store.Restore(path));
+    EXPECT_FALSE(store.Restore(std::string(path) + ".missing"));
+    unlink(path);
+}
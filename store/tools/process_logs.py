@@ -1,83 +1,77 @@
 import sys
 
-start, end = -1.0, -1.0
+# Merges the latency histograms that benchmark clients report every
+# interval ("# Interval <seconds> <name> <count> <mean> <p50> <p99> <p99.9>
+# <max> <value:count,...>") over the middle third of the run.
 
 duration = float(sys.argv[2])
 warmup = duration/3.0
+start, end = warmup, 2 * warmup
 
-tLatency = []
-sLatency = []
-fLatency = []
-
-tExtra = 0.0
-sExtra = 0.0
-fExtra = 0.0
-
-xLatency = []
+# name -> {bucket value: count}, and name -> total latency
+hists = {}
+sums = {}
 
 for line in open(sys.argv[1]):
-  if line.startswith('#') or line.strip() == "":
-    continue
-
-  line = line.strip().split()
-  if not line[0].isdigit() or len(line) < 4:
+  fields = line.strip().split()
+  if len(fields) < 10 or fields[0] != '#' or fields[1] != 'Interval':
     continue
 
-  if start == -1:
-    start = float(line[2]) + warmup
-    end = start + warmup
-
-  fts = float(line[2])
-  
-  if fts < start:
+  t = float(fields[2])
+  if t <= start or t > end:
     continue
 
-  if fts > end:
-    break
-
-  latency = int(line[3])
-  status = int(line[4])
-  ttype = -1
-  try:
-    ttype = int(line[5])
-    extra = int(line[6])
-  except:
-    extra = 0
-
-  if status == 1 and ttype == 2:
-    xLatency.append(latency)
-
-  tLatency.append(latency) 
-  tExtra += extra
-
-  if status == 1:
-    sLatency.append(latency)
-    sExtra += extra
-  else:
-    fLatency.append(latency)
-    fExtra += extra
-
-if len(tLatency) == 0:
-  print "Zero completed transactions.."
+  name = fields[3]
+  hist = hists.setdefault(name, {})
+  for pair in fields[10].split(','):
+    value, count = pair.split(':')
+    hist[int(value)] = hist.get(int(value), 0) + int(count)
+  sums[name] = sums.get(name, 0.0) + int(fields[4]) * float(fields[5])
+
+def merge(names):
+  hist = {}
+  total = 0.0
+  for name in names:
+    for value, count in hists.get(name, {}).items():
+      hist[value] = hist.get(value, 0) + count
+    total += sums.get(name, 0.0)
+  return hist, total
+
+def count(hist):
+  return sum(hist.values())
+
+def percentile(hist, p):
+  target = max(1, int(count(hist) * p / 100.0 + 0.999999))
+  seen = 0
+  for value in sorted(hist):
+    seen += hist[value]
+    if seen >= target:
+      return value
+  return 0
+
+tHist, tSum = merge(['txn.commit', 'txn.abort'])
+sHist, sSum = merge(['txn.commit'])
+fHist, fSum = merge(['txn.abort'])
+xHist, xSum = merge(['follow.commit'])
+
+if count(tHist) == 0:
+  print("Zero completed transactions..")
   sys.exit()
 
-tLatency.sort()
-sLatency.sort()
-fLatency.sort()
-
-print "Transactions(All/Success): ", len(tLatency), len(sLatency)
-print "Abort Rate: ", (float)(len(tLatency)-len(sLatency))/len(tLatency)
-print "Throughput (All/Success): ", len(tLatency)/(end-start), len(sLatency)/(end-start)
-print "Average Latency (all): ", sum(tLatency)/float(len(tLatency))
-print "Median  Latency (all): ", tLatency[len(tLatency)/2]
-print "99%tile Latency (all): ", tLatency[(len(tLatency) * 99)/100]
-print "Average Latency (success): ", sum(sLatency)/float(len(sLatency))
-print "Median  Latency (success): ", sLatency[len(sLatency)/2]
-print "99%tile Latency (success): ", sLatency[(len(sLatency) * 99)/100]
-print "Extra (all): ", tExtra
-print "Extra (success): ", sExtra
-if len(xLatency) > 0:
-  print "X Transaction Latency: ", sum(xLatency)/float(len(xLatency))
-if len(fLatency) > 0:
-  print "Average Latency (failure): ", sum(fLatency)/float(len(tLatency)-len(sLatency))
-  print "Extra (failure): ", fExtra
+print("Transactions(All/Success):  %d %d" % (count(tHist), count(sHist)))
+print("Abort Rate:  %f" % ((count(tHist) - count(sHist)) / float(count(tHist))))
+print("Throughput (All/Success):  %f %f" %
+      (count(tHist) / (end - start), count(sHist) / (end - start)))
+print("Average Latency (all):  %f" % (tSum / count(tHist)))
+print("Median  Latency (all):  %d" % percentile(tHist, 50))
+print("99%%tile Latency (all):  %d" % percentile(tHist, 99))
+print("99.9%%tile Latency (all):  %d" % percentile(tHist, 99.9))
+if count(sHist) > 0:
+  print("Average Latency (success):  %f" % (sSum / count(sHist)))
+  print("Median  Latency (success):  %d" % percentile(sHist, 50))
+  print("99%%tile Latency (success):  %d" % percentile(sHist, 99))
+  print("99.9%%tile Latency (success):  %d" % percentile(sHist, 99.9))
+if count(xHist) > 0:
+  print("X Transaction Latency:  %f" % (xSum / count(xHist)))
+if count(fHist) > 0:
+  print("Average Latency (failure):  %f" % (fSum / count(fHist)))
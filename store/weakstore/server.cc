@@ -29,6 +29,7 @@
  **********************************************************************/
 
 #include "store/weakstore/server.h"
+#include "store/common/keyset.h"
 
 namespace weakstore {
 
@@ -102,6 +103,12 @@ Server::Load(const string &key, const string &value)
     store->Load(key, value);
 }
 
+void
+Server::Reserve(size_t nKeys)
+{
+    store->Reserve(nKeys);
+}
+
 } // namespace weakstore
 
 static void Usage(const char *progName)
@@ -179,18 +186,16 @@ main(int argc, char **argv)
     server = new weakstore::Server(config, index, &transport, new weakstore::Store());
 
     if (keyPath) {
-        string key;
-	std::ifstream in;
-        in.open(keyPath);
-        if (!in) {
+        KeySet keys;
+        if (!keys.Open(keyPath)) {
             fprintf(stderr, "Could not read keys from: %s\n", keyPath);
             exit(0);
         }
-        for (int i = 0; i < 100000; i++) {
-            getline(in, key);
-            server->Load(key, key);
-        }
-        in.close();
+        keys.Load(100000, 1, 0, 1,
+            [&](uint64_t shard, size_t n) { server->Reserve(n); },
+            [&](uint64_t shard, const string &key) {
+                server->Load(key, key);
+            });
     }
 
     transport.Run();
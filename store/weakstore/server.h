@@ -68,6 +68,7 @@ public:
                    const proto::PutMessage &msg);
 
     void Load(const std::string &key, const std::string &value);
+    void Reserve(size_t nKeys);
 
 };
 
@@ -64,4 +64,10 @@ Store::Load(const string &key, const string &value)
     store.put(key, value);
 }
 
+void
+Store::Reserve(size_t nKeys)
+{
+    store.reserve(nKeys);
+}
+
 } // namespace weakstore
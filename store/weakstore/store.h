@@ -33,6 +33,9 @@ public:
 
     // load keys
     virtual void Load(const std::string &key, const std::string &value);
+
+    // make room for nKeys keys before loading them
+    virtual void Reserve(size_t nKeys);
 };
 
 } // namespace weakstore
@@ -33,6 +33,19 @@ TimeStampServer::ReplicaUpcall(opnum_t opnum,
     str2 = newTimeStamp();
 }
 
+bool
+TimeStampServer::SnapshotUpcall(string &state)
+{
+    state = to_string(ts);
+    return true;
+}
+
+void
+TimeStampServer::RestoreUpcall(const string &state)
+{
+    ts = stol(state);
+}
+
 static void
 Usage(const char *progName)
 {
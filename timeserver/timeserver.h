@@ -25,6 +25,8 @@ public:
     ~TimeStampServer();
 
     void ReplicaUpcall(opnum_t opnum, const string &str1, string &str2);
+    bool SnapshotUpcall(string &state);
+    void RestoreUpcall(const string &state);
 
 private:
     long ts;